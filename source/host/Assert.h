@@ -0,0 +1,15 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+extern void ASSERT_FAILED(const char* file, int line);
+
+#define ASSERT(x) do { if (!(x)) ASSERT_FAILED(__FILE__, __LINE__); } while (0)
+
+
+#ifdef __cplusplus
+}
+#endif
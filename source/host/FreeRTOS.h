@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * The subset of the FreeRTOS kernel interface used by the drivers, implemented by rlm3-host-kernel.c.
+ */
+
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFUL)
+#define portTICK_PERIOD_MS ((TickType_t)1)
+
+#define configTICK_RATE_HZ 1000
+#define configMAX_PRIORITIES 56
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void vPortYieldFromISR(BaseType_t higher_priority_task_woken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define portYIELD_FROM_ISR(x) vPortYieldFromISR(x)
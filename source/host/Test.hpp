@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Assert.h"
+
+
+/*
+ * Registers test cases for the host test runner.  Cases run one at a time from a normal priority task, and every
+ * teardown runs after each case.
+ */
+
+
+class TestCase
+{
+public:
+	typedef void (*TestFn)();
+
+	TestCase(const char* name, TestFn fn);
+
+	static bool RunAll();
+
+private:
+	const char* m_name;
+	TestFn m_fn;
+	TestCase* m_next;
+};
+
+class TestTeardown
+{
+public:
+	typedef void (*TeardownFn)();
+
+	TestTeardown(const char* name, TeardownFn fn);
+
+	static void RunAll();
+
+private:
+	const char* m_name;
+	TeardownFn m_fn;
+	TestTeardown* m_next;
+};
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static TestCase g_test_case_##name(#name, name); \
+	static void name()
+
+#define TEST_TEARDOWN(name) \
+	static void name(); \
+	static TestTeardown g_test_teardown_##name(#name, name); \
+	static void name()
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * The subset of CMSIS-RTOS2 used by the tests, mapped onto the host kernel the same way the FreeRTOS wrapper maps it.
+ */
+
+
+typedef void* osThreadId_t;
+typedef void (*osThreadFunc_t)(void* argument);
+
+typedef enum
+{
+	osOK = 0,
+	osError = -1,
+} osStatus_t;
+
+typedef enum
+{
+	osPriorityNone = 0,
+	osPriorityIdle = 1,
+	osPriorityLow = 8,
+	osPriorityBelowNormal = 16,
+	osPriorityNormal = 24,
+	osPriorityAboveNormal = 32,
+	osPriorityHigh = 40,
+	osPriorityRealtime = 48,
+} osPriority_t;
+
+typedef struct
+{
+	const char* name;
+	uint32_t attr_bits;
+	void* cb_mem;
+	uint32_t cb_size;
+	void* stack_mem;
+	uint32_t stack_size;
+	osPriority_t priority;
+	uint32_t tz_module;
+	uint32_t reserved;
+} osThreadAttr_t;
+
+extern osStatus_t osKernelInitialize();
+extern osStatus_t osKernelStart();
+extern uint32_t osKernelGetTickCount();
+
+extern osThreadId_t osThreadNew(osThreadFunc_t func, void* argument, const osThreadAttr_t* attr);
+extern osStatus_t osThreadYield();
+extern void osThreadExit() __attribute__((noreturn));
+extern osStatus_t osDelay(uint32_t ticks);
+extern osStatus_t osDelayUntil(uint32_t ticks);
+
+
+#ifdef __cplusplus
+}
+#endif
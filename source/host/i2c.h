@@ -0,0 +1,19 @@
+#pragma once
+
+#include "stm32f4xx_hal_i2c.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// The board's I2C1 handle and its generated initialization, for the host-test build.
+extern I2C_HandleTypeDef hi2c1;
+
+extern void MX_I2C1_Init(void);
+
+
+#ifdef __cplusplus
+}
+#endif
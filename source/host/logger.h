@@ -0,0 +1,23 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+extern void HostLog(const char* zone, const char* level, const char* format, ...);
+
+#define LOGGER_ZONE(zone) static const char* g_logger_zone __attribute__((unused)) = #zone
+
+#define LOG_FATAL(...) HostLog(g_logger_zone, "FATAL", __VA_ARGS__)
+#define LOG_ERROR(...) HostLog(g_logger_zone, "ERROR", __VA_ARGS__)
+#define LOG_WARN(...) HostLog(g_logger_zone, "WARN", __VA_ARGS__)
+#define LOG_INFO(...) HostLog(g_logger_zone, "INFO", __VA_ARGS__)
+#define LOG_DEBUG(...) HostLog(g_logger_zone, "DEBUG", __VA_ARGS__)
+#define LOG_TRACE(...) HostLog(g_logger_zone, "TRACE", __VA_ARGS__)
+#define LOG_ALWAYS(...) HostLog(g_logger_zone, "ALWAYS", __VA_ARGS__)
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "stm32f4xx_hal.h"
+
+
+#define WIFI_TX_Pin GPIO_PIN_0
+#define WIFI_TX_GPIO_Port GPIOA
+#define WIFI_RX_Pin GPIO_PIN_1
+#define WIFI_RX_GPIO_Port GPIOA
+#define GPS_TX_Pin GPIO_PIN_2
+#define GPS_TX_GPIO_Port GPIOA
+#define GPS_RX_Pin GPIO_PIN_3
+#define GPS_RX_GPIO_Port GPIOA
@@ -0,0 +1,74 @@
+#include "rlm3-base.h"
+#include "rlm3-host.h"
+#include "stm32f4xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+static const uint8_t g_device_id[12] = { 'R', 'L', 'M', '3', '-', 'H', 'O', 'S', 'T', '-', '0', '1' };
+static volatile bool g_is_simulated_cycle_count = false;
+
+
+extern bool RLM3_IsIRQ()
+{
+	return RLM3_Host_IsISR();
+}
+
+extern bool RLM3_IsSchedulerRunning()
+{
+	return (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
+}
+
+extern bool RLM3_IsDebugOutput()
+{
+	return true;
+}
+
+extern void RLM3_DebugOutput(uint8_t c)
+{
+	fputc(c, stdout);
+}
+
+extern bool RLM3_DebugOutputFromISR(uint8_t c)
+{
+	fputc(c, stdout);
+	return true;
+}
+
+extern void RLM3_GetUniqueDeviceId(uint8_t id_out[12])
+{
+	for (size_t i = 0; i < 12; i++)
+		id_out[i] = g_device_id[i];
+}
+
+extern uint32_t RLM3_GetUniqueDeviceShortId()
+{
+	uint32_t hash = 0;
+	for (size_t i = 0; i < 12; i++)
+		hash = hash * 65599 + g_device_id[i];
+	return hash;
+}
+
+extern uint32_t RLM3_GetCycleCount()
+{
+	if (g_is_simulated_cycle_count)
+		return (uint32_t)((unsigned __int128)RLM3_Host_GetTimeNs() * HAL_RCC_GetHCLKFreq() / 1000000000ULL);
+	// Benchmarks measure the code on the host CPU rather than the simulated time.
+#if defined(__x86_64__) || defined(__i386__)
+	return (uint32_t)__rdtsc();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec);
+#endif
+}
+
+extern void RLM3_Host_SetSimulatedCycleCount(bool is_simulated)
+{
+	g_is_simulated_cycle_count = is_simulated;
+}
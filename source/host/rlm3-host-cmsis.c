@@ -0,0 +1,61 @@
+#include "cmsis_os2.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Assert.h"
+
+
+extern osStatus_t osKernelInitialize()
+{
+	return osOK;
+}
+
+extern osStatus_t osKernelStart()
+{
+	vTaskStartScheduler();
+	return osError;
+}
+
+extern uint32_t osKernelGetTickCount()
+{
+	return xTaskGetTickCount();
+}
+
+extern osThreadId_t osThreadNew(osThreadFunc_t func, void* argument, const osThreadAttr_t* attr)
+{
+	const char* name = (attr != NULL) ? attr->name : NULL;
+	uint32_t stack_size = (attr != NULL) ? attr->stack_size : 0;
+	osPriority_t priority = (attr != NULL && attr->priority != osPriorityNone) ? attr->priority : osPriorityNormal;
+
+	TaskHandle_t task = NULL;
+	if (xTaskCreate(func, name, stack_size / 4, argument, priority, &task) != pdPASS)
+		return NULL;
+	return task;
+}
+
+extern osStatus_t osThreadYield()
+{
+	taskYIELD();
+	return osOK;
+}
+
+extern void osThreadExit()
+{
+	vTaskDelete(NULL);
+	for (;;);
+}
+
+extern osStatus_t osDelay(uint32_t ticks)
+{
+	if (ticks != 0)
+		vTaskDelay(ticks);
+	return osOK;
+}
+
+extern osStatus_t osDelayUntil(uint32_t ticks)
+{
+	TickType_t current = xTaskGetTickCount();
+	TickType_t delay = ticks - current;
+	if (delay != 0 && (delay & 0x80000000U) == 0)
+		vTaskDelayUntil(&current, delay);
+	return osOK;
+}
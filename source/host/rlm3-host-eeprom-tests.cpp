@@ -0,0 +1,198 @@
+#include "Test.hpp"
+#include "rlm3-host-peripherals.h"
+#include "rlm3-host.h"
+#include "rlm3-eeprom.h"
+#include "rlm3-i2c.h"
+#include "rlm3-task.h"
+#include "logger.h"
+
+
+LOGGER_ZONE(TEST_HOST_EEPROM);
+
+
+// A 2 Kbit part with 8 byte pages.  Its write cycles take 3 ms, under the 5 ms the datasheet allows.
+#define TEST_EEPROM_CAPACITY 256
+#define TEST_EEPROM_PAGE_SIZE 8
+#define TEST_EEPROM_WRITE_CYCLE_US 3000
+#define TEST_EEPROM_WRITE_CYCLE_MS 5
+
+
+static RLM3_EEPROM g_eeprom;
+
+
+static void AttachEeprom(bool is_write_back)
+{
+	RLM3_Host_EEPROM_Attach(RLM3_EEPROM_ADDRESS, TEST_EEPROM_CAPACITY, TEST_EEPROM_PAGE_SIZE, 1, TEST_EEPROM_WRITE_CYCLE_US);
+	RLM3_EEPROM_Config config = { RLM3_EEPROM_ADDRESS, 1, TEST_EEPROM_PAGE_SIZE, TEST_EEPROM_CAPACITY, TEST_EEPROM_WRITE_CYCLE_MS, is_write_back };
+	RLM3_EEPROM_Init(&g_eeprom, &config);
+}
+
+static void DetachEeprom()
+{
+	ASSERT(RLM3_EEPROM_Deinit(&g_eeprom));
+	RLM3_Host_EEPROM_Detach();
+}
+
+
+TEST_CASE(Host_EEPROM_Write_SplitsPages)
+{
+	AttachEeprom(false);
+	uint8_t data[19];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t)(0x40 + i);
+
+	ASSERT(RLM3_EEPROM_Write(&g_eeprom, 5, data, sizeof(data)));
+	uint8_t read[32];
+	ASSERT(RLM3_EEPROM_Read(&g_eeprom, 0, read, sizeof(read)));
+	RLM3_EEPROM_Stats stats;
+	RLM3_EEPROM_GetStats(&g_eeprom, &stats);
+	DetachEeprom();
+
+	// Three pages, and nothing wrapped back to the start of one.
+	ASSERT(RLM3_Host_EEPROM_GetWriteCycleCount() == 3);
+	ASSERT(stats.write_cycle_count == 3 && stats.written_bytes == sizeof(data));
+	const uint8_t* memory = RLM3_Host_EEPROM_GetMemory();
+	for (size_t i = 0; i < sizeof(read); i++)
+	{
+		uint8_t expected = (i >= 5 && i < 5 + sizeof(data)) ? data[i - 5] : 0xFF;
+		ASSERT(memory[i] == expected);
+		ASSERT(read[i] == expected);
+	}
+}
+
+TEST_CASE(Host_EEPROM_AckPolling_EndsWithWriteCycle)
+{
+	AttachEeprom(false);
+	const uint8_t data[] = { 1, 2, 3, 4 };
+	uint8_t read[4] = { 0 };
+
+	ASSERT(RLM3_EEPROM_Write(&g_eeprom, 0x10, data, sizeof(data)));
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	ASSERT(RLM3_EEPROM_Read(&g_eeprom, 0x10, read, sizeof(read)));
+	uint64_t elapsed_ns = RLM3_Host_GetTimeNs() - start_ns;
+	RLM3_EEPROM_Stats stats;
+	RLM3_EEPROM_GetStats(&g_eeprom, &stats);
+	DetachEeprom();
+
+	ASSERT(read[0] == 1 && read[3] == 4);
+	ASSERT(stats.poll_count > 0);
+	ASSERT(RLM3_Host_EEPROM_GetBusyNackCount() == stats.poll_count);
+	// The read goes out within a poll of the end of the write cycle, well before the longest one allowed.
+	LOG_ALWAYS("Read after write in %u us, %u polls", (unsigned)(elapsed_ns / 1000), (unsigned)stats.poll_count);
+	ASSERT(elapsed_ns >= TEST_EEPROM_WRITE_CYCLE_US * 1000ULL && elapsed_ns < TEST_EEPROM_WRITE_CYCLE_MS * 1000000ULL);
+}
+
+TEST_CASE(Host_EEPROM_Read_Sequential)
+{
+	AttachEeprom(false);
+	uint8_t* memory = RLM3_Host_EEPROM_GetMemory();
+	for (size_t i = 0; i < TEST_EEPROM_CAPACITY; i++)
+		memory[i] = (uint8_t)(i * 7);
+
+	uint8_t read[200];
+	RLM3_I2C1_Counters before, after;
+	RLM3_I2C1_GetCounters(&before);
+	ASSERT(RLM3_EEPROM_Read(&g_eeprom, 30, read, sizeof(read)));
+	RLM3_I2C1_GetCounters(&after);
+	DetachEeprom();
+
+	ASSERT(after.transaction_count - before.transaction_count == 1);
+	for (size_t i = 0; i < sizeof(read); i++)
+		ASSERT(read[i] == (uint8_t)((30 + i) * 7));
+}
+
+TEST_CASE(Host_EEPROM_Cache_CoalescesWrites)
+{
+	AttachEeprom(true);
+	uint8_t* memory = RLM3_Host_EEPROM_GetMemory();
+	for (size_t i = 0; i < TEST_EEPROM_CAPACITY; i++)
+		memory[i] = (uint8_t)i;
+
+	// Byte writes across one page go out together.
+	for (uint8_t i = 0; i < TEST_EEPROM_PAGE_SIZE; i++)
+	{
+		uint8_t value = (uint8_t)(0xA0 + i);
+		ASSERT(RLM3_EEPROM_Write(&g_eeprom, 16 + i, &value, 1));
+	}
+	// Two changes with a gap between them still take one write cycle.
+	const uint8_t first = 0x55, second = 0x66;
+	ASSERT(RLM3_EEPROM_Write(&g_eeprom, 33, &first, 1));
+	ASSERT(RLM3_EEPROM_Write(&g_eeprom, 38, &second, 1));
+
+	// Reads see the cached changes before they are written.
+	uint8_t read[24];
+	ASSERT(RLM3_EEPROM_Read(&g_eeprom, 16, read, sizeof(read)));
+	ASSERT(RLM3_Host_EEPROM_GetWriteCycleCount() == 0);
+	ASSERT(read[0] == 0xA0 && read[7] == 0xA7 && read[8] == 24);
+	ASSERT(read[17] == 0x55 && read[18] == 34 && read[22] == 0x66);
+
+	ASSERT(RLM3_EEPROM_Flush(&g_eeprom));
+	RLM3_EEPROM_Stats stats;
+	RLM3_EEPROM_GetStats(&g_eeprom, &stats);
+	ASSERT(RLM3_Host_EEPROM_GetWriteCycleCount() == 2);
+	// Every byte write after the first in the page, and the second change beside the gap.
+	ASSERT(stats.coalesced_count == TEST_EEPROM_PAGE_SIZE);
+	ASSERT(stats.gap_fill_count == 1);
+	ASSERT(memory[16] == 0xA0 && memory[23] == 0xA7);
+	ASSERT(memory[32] == 32 && memory[33] == 0x55 && memory[34] == 34 && memory[37] == 37 && memory[38] == 0x66 && memory[39] == 39);
+
+	// One page more than the cache holds pushes out the oldest.
+	for (uint8_t i = 0; i <= RLM3_EEPROM_CACHE_LINES; i++)
+	{
+		uint8_t value = i;
+		ASSERT(RLM3_EEPROM_Write(&g_eeprom, 64 + i * TEST_EEPROM_PAGE_SIZE, &value, 1));
+	}
+	RLM3_EEPROM_GetStats(&g_eeprom, &stats);
+	ASSERT(stats.eviction_count == 1);
+	ASSERT(memory[64] == 0 && memory[72] == 72);
+	DetachEeprom();
+
+	ASSERT(memory[72] == 1 && memory[64 + RLM3_EEPROM_CACHE_LINES * TEST_EEPROM_PAGE_SIZE] == RLM3_EEPROM_CACHE_LINES);
+}
+
+TEST_CASE(Host_EEPROM_Write_Throughput_Benchmark)
+{
+	// The same 256 bytes of 4 byte records, written the old way with a fixed delay after each record, then through the
+	// driver without and with the cache.
+	const size_t record_size = 4;
+	uint8_t record[1 + record_size];
+	uint64_t elapsed_ns[3];
+
+	AttachEeprom(false);
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	for (size_t address = 0; address < TEST_EEPROM_CAPACITY; address += record_size)
+	{
+		record[0] = (uint8_t)address;
+		for (size_t i = 0; i < record_size; i++)
+			record[1 + i] = (uint8_t)(address + i);
+		ASSERT(RLM3_I2C1_Transmit(RLM3_EEPROM_ADDRESS, record, sizeof(record)));
+		RLM3_Delay(TEST_EEPROM_WRITE_CYCLE_MS);
+	}
+	elapsed_ns[0] = RLM3_Host_GetTimeNs() - start_ns;
+	DetachEeprom();
+
+	for (size_t pass = 1; pass < 3; pass++)
+	{
+		AttachEeprom(pass == 2);
+		start_ns = RLM3_Host_GetTimeNs();
+		for (size_t address = 0; address < TEST_EEPROM_CAPACITY; address += record_size)
+		{
+			for (size_t i = 0; i < record_size; i++)
+				record[1 + i] = (uint8_t)(address + i);
+			ASSERT(RLM3_EEPROM_Write(&g_eeprom, address, record + 1, record_size));
+		}
+		ASSERT(RLM3_EEPROM_Flush(&g_eeprom) && RLM3_EEPROM_WaitReady(&g_eeprom));
+		elapsed_ns[pass] = RLM3_Host_GetTimeNs() - start_ns;
+		DetachEeprom();
+
+		const uint8_t* memory = RLM3_Host_EEPROM_GetMemory();
+		for (size_t i = 0; i < TEST_EEPROM_CAPACITY; i++)
+			ASSERT(memory[i] == (uint8_t)i);
+	}
+
+	static const char* const names[3] = { "fixed delay", "ACK polling", "write-back" };
+	for (size_t pass = 0; pass < 3; pass++)
+		LOG_ALWAYS("EEPROM %s: %u bytes/s", names[pass], (unsigned)(TEST_EEPROM_CAPACITY * 1000000000ULL / elapsed_ns[pass]));
+	ASSERT(elapsed_ns[1] < elapsed_ns[0]);
+	ASSERT(elapsed_ns[2] * 3 / 2 < elapsed_ns[1]);
+}
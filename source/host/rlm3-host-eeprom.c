@@ -0,0 +1,129 @@
+#include "rlm3-host-peripherals.h"
+#include "rlm3-host.h"
+#include "Assert.h"
+
+
+#define EEPROM_MAX_CAPACITY 0x10000
+#define EEPROM_MAX_PAGE_SIZE 256
+
+
+typedef struct
+{
+	uint8_t address;
+	size_t capacity;
+	size_t page_size;
+	size_t address_size;
+	uint64_t write_cycle_ns;
+
+	uint64_t busy_until_ns;
+	bool is_write;
+	size_t address_bytes;
+	size_t pointer;
+	size_t latched_count;
+	bool is_latched[EEPROM_MAX_PAGE_SIZE];
+	uint8_t latched[EEPROM_MAX_PAGE_SIZE];
+
+	size_t write_cycle_count;
+	size_t busy_nack_count;
+} EepromModel;
+
+
+static uint8_t g_eeprom_memory[EEPROM_MAX_CAPACITY];
+static EepromModel g_eeprom;
+
+
+static bool EepromStart(void* context, bool is_read)
+{
+	if (RLM3_Host_GetTimeNs() < g_eeprom.busy_until_ns)
+	{
+		g_eeprom.busy_nack_count++;
+		return false;
+	}
+	g_eeprom.is_write = !is_read;
+	g_eeprom.address_bytes = 0;
+	g_eeprom.latched_count = 0;
+	for (size_t i = 0; i < g_eeprom.page_size; i++)
+		g_eeprom.is_latched[i] = false;
+	return true;
+}
+
+static bool EepromWrite(void* context, uint8_t data)
+{
+	if (g_eeprom.address_bytes < g_eeprom.address_size)
+	{
+		size_t high = (g_eeprom.address_bytes == 0) ? 0 : g_eeprom.pointer << 8;
+		g_eeprom.pointer = (high | data) % g_eeprom.capacity;
+		g_eeprom.address_bytes++;
+		return true;
+	}
+
+	// Data bytes are latched into the page and wrap at its end rather than moving on to the next page.
+	size_t page_start = g_eeprom.pointer - g_eeprom.pointer % g_eeprom.page_size;
+	size_t offset = g_eeprom.pointer % g_eeprom.page_size;
+	g_eeprom.latched[offset] = data;
+	g_eeprom.is_latched[offset] = true;
+	g_eeprom.latched_count++;
+	g_eeprom.pointer = page_start + (offset + 1) % g_eeprom.page_size;
+	return true;
+}
+
+static uint8_t EepromRead(void* context)
+{
+	// Sequential reads run on through the whole array.
+	uint8_t data = g_eeprom_memory[g_eeprom.pointer];
+	g_eeprom.pointer = (g_eeprom.pointer + 1) % g_eeprom.capacity;
+	return data;
+}
+
+static void EepromStop(void* context)
+{
+	if (!g_eeprom.is_write || g_eeprom.latched_count == 0)
+		return;
+	size_t page_start = g_eeprom.pointer - g_eeprom.pointer % g_eeprom.page_size;
+	for (size_t i = 0; i < g_eeprom.page_size; i++)
+		if (g_eeprom.is_latched[i])
+			g_eeprom_memory[page_start + i] = g_eeprom.latched[i];
+	g_eeprom.latched_count = 0;
+	g_eeprom.write_cycle_count++;
+	g_eeprom.busy_until_ns = RLM3_Host_GetTimeNs() + g_eeprom.write_cycle_ns;
+}
+
+static const RLM3_Host_I2C_Device g_eeprom_device = { EepromStart, EepromWrite, EepromRead, EepromStop, NULL };
+
+
+extern void RLM3_Host_EEPROM_Attach(uint8_t address, size_t capacity, size_t page_size, size_t address_size, uint32_t write_cycle_us)
+{
+	ASSERT(capacity > 0 && capacity <= EEPROM_MAX_CAPACITY);
+	ASSERT(page_size > 0 && page_size <= EEPROM_MAX_PAGE_SIZE && capacity % page_size == 0);
+	ASSERT(address_size == 1 || address_size == 2);
+
+	g_eeprom = (EepromModel){ 0 };
+	g_eeprom.address = address;
+	g_eeprom.capacity = capacity;
+	g_eeprom.page_size = page_size;
+	g_eeprom.address_size = address_size;
+	g_eeprom.write_cycle_ns = write_cycle_us * 1000ULL;
+	for (size_t i = 0; i < capacity; i++)
+		g_eeprom_memory[i] = 0xFF;
+	RLM3_Host_I2C_Attach(address, &g_eeprom_device);
+}
+
+extern void RLM3_Host_EEPROM_Detach()
+{
+	RLM3_Host_I2C_Detach(g_eeprom.address);
+}
+
+extern uint8_t* RLM3_Host_EEPROM_GetMemory()
+{
+	return g_eeprom_memory;
+}
+
+extern size_t RLM3_Host_EEPROM_GetWriteCycleCount()
+{
+	return g_eeprom.write_cycle_count;
+}
+
+extern size_t RLM3_Host_EEPROM_GetBusyNackCount()
+{
+	return g_eeprom.busy_nack_count;
+}
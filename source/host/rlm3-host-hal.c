@@ -0,0 +1,167 @@
+#include "stm32f4xx_hal.h"
+#include "rlm3-host-peripherals.h"
+#include "Assert.h"
+
+
+#define TIM_CCER_CCxE_MASK (TIM_CCER_CC1E | (TIM_CCER_CC1E << 4) | (TIM_CCER_CC1E << 8) | (TIM_CCER_CC1E << 12))
+
+
+RCC_TypeDef RLM3_Host_RCC = { .CFGR = (0x5UL << RCC_CFGR_PPRE1_Pos) | (0x4UL << RCC_CFGR_PPRE2_Pos) };
+GPIO_TypeDef RLM3_Host_GPIO[9];
+EXTI_TypeDef RLM3_Host_EXTI;
+SYSCFG_TypeDef RLM3_Host_SYSCFG;
+
+const uint8_t APBPrescTable[8] = { 0, 0, 0, 0, 1, 2, 3, 4 };
+
+static volatile bool g_irq_enabled[RLM3_HOST_INTERRUPT_COUNT];
+
+
+extern bool RLM3_Host_IsIRQEnabled(IRQn_Type irq)
+{
+	ASSERT(irq >= 0 && irq < RLM3_HOST_INTERRUPT_COUNT);
+	return g_irq_enabled[irq];
+}
+
+extern uint32_t HAL_RCC_GetHCLKFreq()
+{
+	return RLM3_HOST_HCLK_HZ;
+}
+
+extern uint32_t HAL_RCC_GetPCLK1Freq()
+{
+	return HAL_RCC_GetHCLKFreq() >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+}
+
+extern uint32_t HAL_RCC_GetPCLK2Freq()
+{
+	return HAL_RCC_GetHCLKFreq() >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> RCC_CFGR_PPRE2_Pos];
+}
+
+extern void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority)
+{
+	// Simulated interrupts do not nest, so priorities have nothing to order.
+	ASSERT(irq >= 0 && irq < RLM3_HOST_INTERRUPT_COUNT);
+	ASSERT(preempt_priority < 16 && sub_priority == 0);
+}
+
+extern void HAL_NVIC_EnableIRQ(IRQn_Type irq)
+{
+	ASSERT(irq >= 0 && irq < RLM3_HOST_INTERRUPT_COUNT);
+	g_irq_enabled[irq] = true;
+}
+
+extern void HAL_NVIC_DisableIRQ(IRQn_Type irq)
+{
+	ASSERT(irq >= 0 && irq < RLM3_HOST_INTERRUPT_COUNT);
+	g_irq_enabled[irq] = false;
+}
+
+extern void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init)
+{
+	for (size_t pin = 0; pin < 16; pin++)
+	{
+		if ((init->Pin & (1UL << pin)) == 0)
+			continue;
+		MODIFY_REG(port->MODER, 0x3UL << (2 * pin), (init->Mode & 0x3UL) << (2 * pin));
+		MODIFY_REG(port->PUPDR, 0x3UL << (2 * pin), (init->Pull & 0x3UL) << (2 * pin));
+		MODIFY_REG(port->OSPEEDR, 0x3UL << (2 * pin), (init->Speed & 0x3UL) << (2 * pin));
+		MODIFY_REG(port->OTYPER, 0x1UL << pin, ((init->Mode >> 4) & 0x1UL) << pin);
+		if ((init->Mode & 0x3UL) == GPIO_MODE_AF_PP)
+			MODIFY_REG(port->AFR[pin / 8], 0xFUL << (4 * (pin % 8)), (init->Alternate & 0xFUL) << (4 * (pin % 8)));
+	}
+}
+
+extern void HAL_GPIO_DeInit(GPIO_TypeDef* port, uint32_t pins)
+{
+	for (size_t pin = 0; pin < 16; pin++)
+	{
+		if ((pins & (1UL << pin)) == 0)
+			continue;
+		CLEAR_BIT(port->MODER, 0x3UL << (2 * pin));
+		CLEAR_BIT(port->PUPDR, 0x3UL << (2 * pin));
+		CLEAR_BIT(port->OSPEEDR, 0x3UL << (2 * pin));
+		CLEAR_BIT(port->OTYPER, 0x1UL << pin);
+		CLEAR_BIT(port->AFR[pin / 8], 0xFUL << (4 * (pin % 8)));
+	}
+	RLM3_Host_GPIO_Changed(port);
+}
+
+extern void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+	if (state != GPIO_PIN_RESET)
+		SET_BIT(port->ODR, pin);
+	else
+		CLEAR_BIT(port->ODR, pin);
+	RLM3_Host_GPIO_Changed(port);
+}
+
+extern GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin)
+{
+	return ((port->IDR & pin) != 0) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+extern HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim)
+{
+	if (htim == NULL)
+		return HAL_ERROR;
+	htim->State = HAL_TIM_STATE_BUSY;
+
+	TIM_TypeDef* timer = htim->Instance;
+	uint32_t cr1 = timer->CR1;
+	MODIFY_REG(cr1, TIM_CR1_DIR | TIM_CR1_CMS, htim->Init.CounterMode);
+	MODIFY_REG(cr1, TIM_CR1_CKD, htim->Init.ClockDivision);
+	MODIFY_REG(cr1, TIM_CR1_ARPE, htim->Init.AutoReloadPreload);
+	timer->CR1 = cr1;
+	timer->ARR = htim->Init.Period;
+	timer->PSC = htim->Init.Prescaler;
+
+	// Loads the prescaler right away instead of at the first update event, then clears the update flag that sets.  The
+	// model acts on the event now, the way the hardware does, so the flag is there to clear.
+	timer->EGR = TIM_EGR_UG;
+	RLM3_Host_PollPeripherals();
+	if ((timer->SR & TIM_SR_UIF) != 0)
+		CLEAR_BIT(timer->SR, TIM_SR_UIF);
+
+	htim->State = HAL_TIM_STATE_READY;
+	return HAL_OK;
+}
+
+extern HAL_StatusTypeDef HAL_TIM_Base_DeInit(TIM_HandleTypeDef* htim)
+{
+	htim->State = HAL_TIM_STATE_BUSY;
+	if ((htim->Instance->CCER & TIM_CCER_CCxE_MASK) == 0)
+		CLEAR_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+	htim->State = HAL_TIM_STATE_RESET;
+	return HAL_OK;
+}
+
+extern HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim)
+{
+	SET_BIT(htim->Instance->DIER, TIM_DIER_UIE);
+	SET_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+	return HAL_OK;
+}
+
+extern HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim)
+{
+	CLEAR_BIT(htim->Instance->DIER, TIM_DIER_UIE);
+	if ((htim->Instance->CCER & TIM_CCER_CCxE_MASK) == 0)
+		CLEAR_BIT(htim->Instance->CR1, TIM_CR1_CEN);
+	return HAL_OK;
+}
+
+extern HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef* htim, TIM_ClockConfigTypeDef* config)
+{
+	// Only the internal clock is modelled.
+	if (config->ClockSource != TIM_CLOCKSOURCE_INTERNAL)
+		return HAL_ERROR;
+	CLEAR_BIT(htim->Instance->SMCR, TIM_SMCR_SMS | TIM_SMCR_TS | TIM_SMCR_ETF | TIM_SMCR_ETPS | TIM_SMCR_ECE | TIM_SMCR_ETP);
+	return HAL_OK;
+}
+
+extern HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef* htim, TIM_MasterConfigTypeDef* config)
+{
+	MODIFY_REG(htim->Instance->CR2, TIM_CR2_MMS, config->MasterOutputTrigger);
+	MODIFY_REG(htim->Instance->SMCR, TIM_SMCR_MSM, config->MasterSlaveMode);
+	return HAL_OK;
+}
@@ -0,0 +1,281 @@
+#include "Test.hpp"
+#include "rlm3-host-peripherals.h"
+#include "rlm3-host.h"
+#include "rlm3-i2c.h"
+#include "rlm3-i2c-poll.h"
+#include "rlm3-timer.h"
+#include "rlm3-task.h"
+#include "stm32f4xx_hal.h"
+#include "logger.h"
+#include "cmsis_os2.h"
+
+
+LOGGER_ZONE(TEST_HOST_I2C_POLL);
+
+
+#define TEST_SENSOR_ADDRESS 0x1E
+#define TEST_OTHER_SENSOR_ADDRESS 0x1F
+#define TEST_BUS_ADDRESS 0x50
+
+
+// A sensor whose registers count up each time they are read, so every sample is different.
+struct TestSensor
+{
+	uint8_t data[256];
+	uint8_t index;
+	bool is_indexed;
+	size_t read_count;
+};
+
+static TestSensor g_sensor;
+static TestSensor g_other_sensor;
+static TestSensor g_bus_device;
+
+static bool SensorStart(void* context, bool is_read)
+{
+	TestSensor* sensor = (TestSensor*)context;
+	sensor->is_indexed = is_read;
+	return true;
+}
+
+static bool SensorWrite(void* context, uint8_t data)
+{
+	TestSensor* sensor = (TestSensor*)context;
+	if (!sensor->is_indexed)
+		sensor->index = data;
+	else
+		sensor->data[sensor->index++] = data;
+	sensor->is_indexed = true;
+	return true;
+}
+
+static uint8_t SensorRead(void* context)
+{
+	TestSensor* sensor = (TestSensor*)context;
+	sensor->read_count++;
+	return sensor->data[sensor->index++]++;
+}
+
+static void SensorStop(void* context)
+{
+}
+
+static const RLM3_Host_I2C_Device g_sensor_device = { SensorStart, SensorWrite, SensorRead, SensorStop, &g_sensor };
+static const RLM3_Host_I2C_Device g_other_sensor_device = { SensorStart, SensorWrite, SensorRead, SensorStop, &g_other_sensor };
+static const RLM3_Host_I2C_Device g_bus_device_device = { SensorStart, SensorWrite, SensorRead, SensorStop, &g_bus_device };
+
+
+static void AttachSensors()
+{
+	g_sensor = TestSensor();
+	g_other_sensor = TestSensor();
+	g_bus_device = TestSensor();
+	RLM3_Host_I2C_Attach(TEST_SENSOR_ADDRESS, &g_sensor_device);
+	RLM3_Host_I2C_Attach(TEST_OTHER_SENSOR_ADDRESS, &g_other_sensor_device);
+	RLM3_Host_I2C_Attach(TEST_BUS_ADDRESS, &g_bus_device_device);
+	RLM3_I2C1_Init(RLM3_I2C1_DEVICE_MAGNETIC);
+	RLM3_Timer2_Wheel_Init();
+	RLM3_Host_SetSimulatedCycleCount(true);
+}
+
+static void DetachSensors()
+{
+	RLM3_Host_SetSimulatedCycleCount(false);
+	RLM3_Timer2_Wheel_Deinit();
+	RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE_MAGNETIC);
+	RLM3_Host_I2C_Detach(TEST_SENSOR_ADDRESS);
+	RLM3_Host_I2C_Detach(TEST_OTHER_SENSOR_ADDRESS);
+	RLM3_Host_I2C_Detach(TEST_BUS_ADDRESS);
+	RLM3_I2C1_Poll_Init(1000);
+	while (RLM3_TakeWithTimeout(0))
+		;
+}
+
+static RLM3_I2C1_PollJob MakeJob(uint8_t addr, uint32_t rate_hz, RLM3_I2C1_PollBuffer* buffer)
+{
+	RLM3_I2C1_PollBuffer_Init(buffer);
+	RLM3_I2C1_PollJob job = { addr, 0x03, 6, rate_hz, buffer, NULL };
+	return job;
+}
+
+static void AssertScheduleDisjoint(const size_t* ids, size_t count)
+{
+	uint32_t hyperperiod = RLM3_I2C1_Poll_GetHyperperiodSlots();
+	size_t owners[RLM3_I2C1_POLL_MAX_SLOTS];
+	for (size_t i = 0; i < hyperperiod; i++)
+		owners[i] = SIZE_MAX;
+	for (size_t i = 0; i < count; i++)
+	{
+		RLM3_I2C1_PollStats stats;
+		RLM3_I2C1_Poll_GetStats(ids[i], &stats);
+		ASSERT(hyperperiod % stats.period_slots == 0);
+		for (uint32_t slot = stats.offset_slots; slot < hyperperiod; slot += stats.period_slots)
+		{
+			ASSERT(owners[slot] == SIZE_MAX);
+			owners[slot] = ids[i];
+		}
+	}
+}
+
+
+TEST_CASE(Host_I2C1_Poll_Allocate_Slots)
+{
+	RLM3_I2C1_PollBuffer buffers[4];
+	size_t ids[4];
+	RLM3_I2C1_Poll_Init(1000);
+
+	RLM3_I2C1_PollJob job_50 = MakeJob(TEST_SENSOR_ADDRESS, 50, &buffers[0]);
+	RLM3_I2C1_PollJob job_200 = MakeJob(TEST_SENSOR_ADDRESS, 200, &buffers[1]);
+	RLM3_I2C1_PollJob job_100 = MakeJob(TEST_OTHER_SENSOR_ADDRESS, 100, &buffers[2]);
+	ASSERT(RLM3_I2C1_Poll_Add(&job_50, &ids[0]));
+	ASSERT(RLM3_I2C1_Poll_Add(&job_200, &ids[1]));
+	ASSERT(RLM3_I2C1_Poll_Add(&job_100, &ids[2]));
+	ASSERT(RLM3_I2C1_Poll_GetHyperperiodSlots() == 20);
+	AssertScheduleDisjoint(ids, 3);
+
+	// The most frequent job gets the first slot.
+	RLM3_I2C1_PollStats stats;
+	RLM3_I2C1_Poll_GetStats(ids[1], &stats);
+	ASSERT(stats.offset_slots == 0 && stats.period_slots == 5);
+
+	// A period that is not a whole number of slots, and one that cannot fit between the others.
+	RLM3_I2C1_PollJob job_300 = MakeJob(TEST_SENSOR_ADDRESS, 300, &buffers[3]);
+	RLM3_I2C1_PollJob job_500 = MakeJob(TEST_SENSOR_ADDRESS, 500, &buffers[3]);
+	ASSERT(!RLM3_I2C1_Poll_Add(&job_300, &ids[3]));
+	ASSERT(!RLM3_I2C1_Poll_Add(&job_500, &ids[3]));
+	AssertScheduleDisjoint(ids, 3);
+
+	// Without the 200 Hz job every other slot is free.
+	RLM3_I2C1_Poll_Remove(ids[1]);
+	ids[1] = ids[2];
+	ASSERT(RLM3_I2C1_Poll_Add(&job_500, &ids[2]));
+	AssertScheduleDisjoint(ids, 3);
+	ASSERT(!RLM3_I2C1_Poll_Add(&job_500, &ids[3]));
+
+	// Sixteen bytes at 100 kHz take longer than a 1 ms slot.
+	RLM3_I2C1_Poll_Init(1000);
+	RLM3_I2C1_PollJob job_long = MakeJob(TEST_SENSOR_ADDRESS, 100, &buffers[3]);
+	job_long.size = 16;
+	ASSERT(!RLM3_I2C1_Poll_Add(&job_long, &ids[3]));
+	job_long.size = 6;
+	ASSERT(RLM3_I2C1_Poll_Add(&job_long, &ids[3]));
+	RLM3_I2C1_Poll_Init(1000);
+}
+
+TEST_CASE(Host_I2C1_Poll_Samples_OnSchedule)
+{
+	AttachSensors();
+	RLM3_I2C1_PollBuffer fast_buffer, slow_buffer;
+	size_t fast_id, slow_id;
+	RLM3_I2C1_Poll_Init(1000);
+	RLM3_I2C1_PollJob fast_job = MakeJob(TEST_SENSOR_ADDRESS, 200, &fast_buffer);
+	RLM3_I2C1_PollJob slow_job = MakeJob(TEST_OTHER_SENSOR_ADDRESS, 100, &slow_buffer);
+	fast_job.task = RLM3_GetCurrentTask();
+	ASSERT(RLM3_I2C1_Poll_Add(&fast_job, &fast_id));
+	ASSERT(RLM3_I2C1_Poll_Add(&slow_job, &slow_id));
+
+	RLM3_I2C1_PollSample sample;
+	ASSERT(!RLM3_I2C1_PollBuffer_Read(&fast_buffer, &sample));
+	RLM3_I2C1_Poll_Start(osPriorityHigh, 256);
+	uint32_t last_time_us = 0;
+	for (size_t i = 0; i < 20; i++)
+	{
+		ASSERT(RLM3_TakeWithTimeout(10));
+		ASSERT(RLM3_I2C1_PollBuffer_Read(&fast_buffer, &sample));
+		ASSERT(sample.size == 6);
+		ASSERT(sample.sequence % 5 == 0);
+		if (i > 0)
+			ASSERT(sample.time_us - last_time_us == 5000);
+		last_time_us = sample.time_us;
+	}
+	RLM3_I2C1_Poll_Stop();
+
+	RLM3_I2C1_PollStats fast_stats, slow_stats;
+	RLM3_I2C1_Poll_GetStats(fast_id, &fast_stats);
+	RLM3_I2C1_Poll_GetStats(slow_id, &slow_stats);
+	ASSERT(RLM3_I2C1_PollBuffer_Read(&slow_buffer, &sample));
+	DetachSensors();
+
+	// Each read of the sensor counted its registers up once.
+	ASSERT(sample.data[0] == (uint8_t)(slow_stats.sample_count - 1));
+	ASSERT(fast_stats.sample_count == 20);
+	ASSERT(slow_stats.sample_count >= 9 && slow_stats.sample_count <= 10);
+	ASSERT(fast_stats.overrun_count == 0 && slow_stats.overrun_count == 0);
+	ASSERT(fast_stats.error_count == 0 && slow_stats.error_count == 0);
+	uint32_t cycles_per_us = HAL_RCC_GetHCLKFreq() / 1000000;
+	LOG_ALWAYS("Latency %u us, jitter %u us", (unsigned)(fast_stats.max_latency_cycles / cycles_per_us), (unsigned)(fast_stats.max_jitter_cycles / cycles_per_us));
+	// A read finishes its time on the wire after the slot starts.
+	ASSERT(fast_stats.max_latency_cycles < (RLM3_I2C1_GetTransferTimeUs(TEST_SENSOR_ADDRESS, 1, 6) + 50) * cycles_per_us);
+	ASSERT(fast_stats.max_jitter_cycles < 50 * cycles_per_us);
+	ASSERT(slow_stats.max_jitter_cycles < 50 * cycles_per_us);
+}
+
+TEST_CASE(Host_I2C1_Poll_Overrun_Skipped)
+{
+	AttachSensors();
+	RLM3_I2C1_PollBuffer buffer;
+	size_t id;
+	RLM3_I2C1_Poll_Init(1000);
+	RLM3_I2C1_PollJob job = MakeJob(TEST_SENSOR_ADDRESS, 500, &buffer);
+	ASSERT(RLM3_I2C1_Poll_Add(&job, &id));
+	RLM3_I2C1_Poll_Start(osPriorityHigh, 256);
+
+	// Holding the bus for about 23 ms makes the job miss its slots.
+	static uint8_t block[256] = { 0 };
+	RLM3_Delay(10);
+	ASSERT(RLM3_I2C1_Transmit(TEST_BUS_ADDRESS, block, sizeof(block)));
+	RLM3_Delay(20);
+	RLM3_I2C1_Poll_Stop();
+
+	RLM3_I2C1_PollStats stats;
+	RLM3_I2C1_Poll_GetStats(id, &stats);
+	DetachSensors();
+
+	// Every slot either produced a sample or was skipped.  None of the missed ones were made up afterwards.
+	LOG_ALWAYS("Samples %u, overruns %u", (unsigned)stats.sample_count, (unsigned)stats.overrun_count);
+	uint32_t slots = stats.sample_count + stats.overrun_count;
+	ASSERT(stats.overrun_count >= 9 && stats.overrun_count <= 12);
+	ASSERT(slots >= 25 && slots <= 28);
+	ASSERT(g_sensor.read_count == 6 * stats.sample_count);
+	// The read that was waiting for the bus finished long after its slot.
+	ASSERT(stats.max_latency_cycles > 20000 * (HAL_RCC_GetHCLKFreq() / 1000000));
+}
+
+static RLM3_Task g_stop_waiter = NULL;
+
+static void StopFn(void* param)
+{
+	RLM3_I2C1_Poll_Stop();
+	RLM3_Give(g_stop_waiter);
+	::osThreadExit();
+}
+
+TEST_CASE(Host_I2C1_Poll_Stop_DuringRead)
+{
+	AttachSensors();
+	RLM3_I2C1_PollBuffer buffer;
+	size_t id;
+	RLM3_I2C1_Poll_Init(1000);
+	RLM3_I2C1_PollJob job = MakeJob(TEST_SENSOR_ADDRESS, 500, &buffer);
+	ASSERT(RLM3_I2C1_Poll_Add(&job, &id));
+	RLM3_I2C1_Poll_Start(osPriorityHigh, 256);
+
+	// The next read stalls until it times out, and the stop request arrives while it waits.  The recovery that follows
+	// times its clocks on the cycle counter, which only runs when it is not simulated.
+	RLM3_Host_SetSimulatedCycleCount(false);
+	RLM3_Delay(10);
+	RLM3_Host_I2C_StickBus(5);
+	RLM3_Delay(3);
+	ASSERT(RLM3_Host_I2C_IsBusStuck());
+	g_stop_waiter = RLM3_GetCurrentTask();
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "stop";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityNormal;
+	ASSERT(::osThreadNew(StopFn, nullptr, &task_attributes) != nullptr);
+	bool is_stopped = RLM3_TakeWithTimeout(100);
+	ASSERT(is_stopped);
+	ASSERT(!RLM3_I2C1_Poll_IsRunning());
+	DetachSensors();
+	ASSERT(!RLM3_Host_I2C_IsBusStuck());
+}
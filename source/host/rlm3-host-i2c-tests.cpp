@@ -0,0 +1,378 @@
+#include "Test.hpp"
+#include "rlm3-host-peripherals.h"
+#include "rlm3-host.h"
+#include "rlm3-i2c.h"
+#include "rlm3-task.h"
+#include "stm32f4xx_hal.h"
+#include "logger.h"
+#include "cmsis_os2.h"
+#include <chrono>
+
+
+LOGGER_ZONE(TEST_HOST_I2C);
+
+
+#define TEST_I2C_ADDRESS 0x50
+#define TEST_I2C_MISSING_ADDRESS 0x51
+#define TEST_I2C_OTHER_ADDRESS 0x52
+
+
+// A register file: the first byte written after a START sets the register, later bytes and reads walk through it.
+struct TestRegisters
+{
+	uint8_t data[256];
+	uint8_t index;
+	bool is_indexed;
+	size_t busy_starts;
+	size_t stop_count;
+};
+
+static TestRegisters g_registers;
+static TestRegisters g_other_registers;
+
+static bool RegistersStart(void* context, bool is_read)
+{
+	TestRegisters* registers = (TestRegisters*)context;
+	if (registers->busy_starts > 0)
+	{
+		registers->busy_starts--;
+		return false;
+	}
+	registers->is_indexed = is_read;
+	return true;
+}
+
+static bool RegistersWrite(void* context, uint8_t data)
+{
+	TestRegisters* registers = (TestRegisters*)context;
+	if (!registers->is_indexed)
+		registers->index = data;
+	else
+		registers->data[registers->index++] = data;
+	registers->is_indexed = true;
+	return true;
+}
+
+static uint8_t RegistersRead(void* context)
+{
+	TestRegisters* registers = (TestRegisters*)context;
+	return registers->data[registers->index++];
+}
+
+static void RegistersStop(void* context)
+{
+	TestRegisters* registers = (TestRegisters*)context;
+	registers->stop_count++;
+}
+
+static const RLM3_Host_I2C_Device g_registers_device = { RegistersStart, RegistersWrite, RegistersRead, RegistersStop, &g_registers };
+static const RLM3_Host_I2C_Device g_other_registers_device = { RegistersStart, RegistersWrite, RegistersRead, RegistersStop, &g_other_registers };
+
+
+static void AttachRegisters()
+{
+	g_registers = TestRegisters();
+	RLM3_Host_I2C_Attach(TEST_I2C_ADDRESS, &g_registers_device);
+	RLM3_I2C1_Init(RLM3_I2C1_DEVICE_TEST);
+}
+
+static uint64_t GetHostNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void DetachRegisters()
+{
+	RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE_TEST);
+	RLM3_Host_I2C_Detach(TEST_I2C_ADDRESS);
+	RLM3_I2C1_SetPolicy(TEST_I2C_ADDRESS, NULL);
+	RLM3_Host_I2C_LoseArbitration(0);
+	RLM3_Host_I2C_ReleaseBus();
+	while (RLM3_TakeWithTimeout(0))
+		;
+}
+
+
+TEST_CASE(Host_I2C1_TransmitReceive_HappyCase)
+{
+	AttachRegisters();
+	const uint8_t write[] = { 0x10, 'a', 'b', 'c' };
+	const uint8_t select[] = { 0x10 };
+	uint8_t read[3] = { 0 };
+
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	ASSERT(RLM3_I2C1_TransmitWithTimeout(TEST_I2C_ADDRESS, write, sizeof(write), 0) == RLM3_I2C1_RESULT_OK);
+	uint64_t elapsed_ns = RLM3_Host_GetTimeNs() - start_ns;
+	ASSERT(RLM3_I2C1_TransmitReceive(TEST_I2C_ADDRESS, select, sizeof(select), read, sizeof(read)));
+	DetachRegisters();
+
+	ASSERT(read[0] == 'a' && read[1] == 'b' && read[2] == 'c');
+	ASSERT(g_registers.stop_count == 2);
+	// A START, five bytes with their acknowledge bits and a STOP at 100 kHz.
+	uint64_t expected_ns = (1 + 9 * 5 + 1) * 10000ULL;
+	ASSERT(elapsed_ns >= expected_ns && elapsed_ns <= expected_ns + 20000);
+}
+
+TEST_CASE(Host_I2C1_Nack_RetriedByPolicy)
+{
+	AttachRegisters();
+	RLM3_I2C1_Counters before, after;
+	const uint8_t write[] = { 0x00, 0x55 };
+
+	// Nobody answers at the address, and by default a NACK is final.
+	RLM3_I2C1_GetCounters(&before);
+	ASSERT(RLM3_I2C1_TransmitWithTimeout(TEST_I2C_MISSING_ADDRESS, write, sizeof(write), 0) == RLM3_I2C1_RESULT_NACK);
+	RLM3_I2C1_GetCounters(&after);
+	ASSERT(after.nack_count - before.nack_count == 1);
+	ASSERT(after.retry_count == before.retry_count);
+	ASSERT(after.recovery_count == before.recovery_count);
+
+	// A device that NACKs while busy gets retried when its policy asks for it.
+	RLM3_I2C1_Policy policy = { 0, 3, 1, true };
+	RLM3_I2C1_SetPolicy(TEST_I2C_ADDRESS, &policy);
+	g_registers.busy_starts = 2;
+	RLM3_I2C1_GetCounters(&before);
+	ASSERT(RLM3_I2C1_TransmitWithTimeout(TEST_I2C_ADDRESS, write, sizeof(write), 0) == RLM3_I2C1_RESULT_OK);
+	RLM3_I2C1_GetCounters(&after);
+	DetachRegisters();
+
+	ASSERT(g_registers.data[0x00] == 0x55);
+	ASSERT(after.nack_count - before.nack_count == 2);
+	ASSERT(after.retry_count - before.retry_count == 2);
+	ASSERT(after.transaction_count - before.transaction_count == 1);
+}
+
+TEST_CASE(Host_I2C1_ArbitrationLost_Retried)
+{
+	AttachRegisters();
+	RLM3_I2C1_Counters before, after;
+	const uint8_t write[] = { 0x20, 0x77 };
+
+	RLM3_I2C1_GetCounters(&before);
+	RLM3_Host_I2C_LoseArbitration(1);
+	ASSERT(RLM3_I2C1_TransmitWithTimeout(TEST_I2C_ADDRESS, write, sizeof(write), 0) == RLM3_I2C1_RESULT_OK);
+	RLM3_Host_I2C_LoseArbitration(2);
+	ASSERT(RLM3_I2C1_TransmitWithTimeout(TEST_I2C_ADDRESS, write, sizeof(write), 0) == RLM3_I2C1_RESULT_ARBITRATION_LOST);
+	RLM3_I2C1_GetCounters(&after);
+	DetachRegisters();
+
+	// Losing arbitration leaves the bus to the other master, so there is nothing to recover.
+	ASSERT(g_registers.data[0x20] == 0x77);
+	ASSERT(after.arbitration_lost_count - before.arbitration_lost_count == 3);
+	ASSERT(after.retry_count - before.retry_count == 2);
+	ASSERT(after.recovery_count == before.recovery_count);
+}
+
+TEST_CASE(Host_I2C1_StuckBus_RecoversAfterTimeout)
+{
+	AttachRegisters();
+	RLM3_I2C1_Counters before, after;
+	const uint8_t write[] = { 0x30, 0x99 };
+
+	RLM3_I2C1_GetCounters(&before);
+	RLM3_Host_I2C_StickBus(5);
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	ASSERT(RLM3_I2C1_TransmitWithTimeout(TEST_I2C_ADDRESS, write, sizeof(write), 5) == RLM3_I2C1_RESULT_OK);
+	uint64_t recover_ns = RLM3_Host_GetTimeNs() - start_ns;
+	RLM3_I2C1_GetCounters(&after);
+	ASSERT(!RLM3_Host_I2C_IsBusStuck());
+	DetachRegisters();
+
+	ASSERT(g_registers.data[0x30] == 0x99);
+	ASSERT(after.timeout_count - before.timeout_count == 1);
+	ASSERT(after.recovery_count - before.recovery_count == 1);
+	ASSERT(after.recovery_failed_count == before.recovery_failed_count);
+	ASSERT(after.retry_count - before.retry_count == 1);
+	ASSERT(after.last_recovery_cycles > 0);
+	// The timeout counts whole ticks from the tick the transfer started in.  The recovery and the retried transfer
+	// then take well under a millisecond.
+	LOG_ALWAYS("Recovered in %u us", (unsigned)(recover_ns / 1000));
+	ASSERT(recover_ns >= 4000000 && recover_ns <= 6000000);
+}
+
+TEST_CASE(Host_I2C1_StuckBus_Unrecoverable)
+{
+	AttachRegisters();
+	RLM3_I2C1_Counters before, after;
+	const uint8_t write[] = { 0x40, 0x11 };
+
+	RLM3_I2C1_GetCounters(&before);
+	RLM3_Host_I2C_StickBus(SIZE_MAX);
+	ASSERT(RLM3_I2C1_TransmitWithTimeout(TEST_I2C_ADDRESS, write, sizeof(write), 5) == RLM3_I2C1_RESULT_BUSY);
+	ASSERT(RLM3_Host_I2C_IsBusStuck());
+	RLM3_I2C1_GetCounters(&after);
+	ASSERT(after.timeout_count - before.timeout_count == 1);
+	ASSERT(after.busy_count - before.busy_count == 1);
+	ASSERT(after.recovery_count - before.recovery_count == 2);
+	ASSERT(after.recovery_failed_count - before.recovery_failed_count == 2);
+
+	// Once the slave lets go, the bus works again without another recovery.
+	RLM3_Host_I2C_ReleaseBus();
+	ASSERT(RLM3_I2C1_Transmit(TEST_I2C_ADDRESS, write, sizeof(write)));
+	DetachRegisters();
+	ASSERT(g_registers.data[0x40] == 0x11);
+}
+
+TEST_CASE(Host_I2C1_ComputeTiming_Registers)
+{
+	struct Case { uint32_t pclk1_hz; uint32_t clock_hz; uint32_t ccr; uint32_t trise; bool is_duty_16_9; uint32_t actual_hz; };
+	const Case cases[] = {
+		{ 45000000, 100000, 225, 46, false, 100000 },
+		{ 45000000, 400000, 38, 14, false, 394736 },
+		{ 42000000, 400000, 35, 13, false, 400000 },
+		{ 40000000, 400000, 4, 13, true, 400000 },
+		{ 42000000, 100000, 210, 43, false, 100000 },
+		{ 2000000, 100000, 10, 3, false, 100000 },
+	};
+	for (const Case& c : cases)
+	{
+		RLM3_I2C1_Timing timing;
+		ASSERT(RLM3_I2C1_ComputeTiming(c.pclk1_hz, c.clock_hz, &timing));
+		ASSERT(timing.ccr == c.ccr);
+		ASSERT(timing.trise == c.trise);
+		ASSERT(timing.is_fast == (c.clock_hz > 100000));
+		ASSERT(timing.is_duty_16_9 == c.is_duty_16_9);
+		ASSERT(timing.clock_hz == c.actual_hz);
+	}
+
+	// Too slow a bus clock, and Fast-mode Plus on a peripheral that stops at Fast mode.
+	RLM3_I2C1_Timing timing;
+	ASSERT(!RLM3_I2C1_ComputeTiming(1000000, 100000, &timing));
+	ASSERT(!RLM3_I2C1_ComputeTiming(3000000, 400000, &timing));
+	ASSERT(!RLM3_I2C1_ComputeTiming(45000000, 1000000, &timing));
+	ASSERT(RLM3_I2C1_GetSpeedHz(RLM3_I2C1_SPEED_FAST_PLUS) == RLM3_I2C1_MAX_CLOCK_HZ);
+}
+
+TEST_CASE(Host_I2C1_DeviceSpeed_SwitchesRate)
+{
+	AttachRegisters();
+	g_other_registers = TestRegisters();
+	RLM3_Host_I2C_Attach(TEST_I2C_OTHER_ADDRESS, &g_other_registers_device);
+	RLM3_I2C1_Init(RLM3_I2C1_DEVICE_FLASH);
+	RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE_FLASH, TEST_I2C_OTHER_ADDRESS, RLM3_I2C1_SPEED_FAST);
+	RLM3_I2C1_Counters before, after;
+	RLM3_I2C1_GetCounters(&before);
+	const uint8_t write[] = { 0x00, 0x12 };
+
+	const struct { uint32_t addr; RLM3_I2C1_Speed speed; } steps[] = {
+		{ TEST_I2C_ADDRESS, RLM3_I2C1_SPEED_STANDARD },
+		{ TEST_I2C_OTHER_ADDRESS, RLM3_I2C1_SPEED_FAST },
+		{ TEST_I2C_OTHER_ADDRESS, RLM3_I2C1_SPEED_FAST },
+		{ TEST_I2C_ADDRESS, RLM3_I2C1_SPEED_STANDARD },
+	};
+	for (const auto& step : steps)
+	{
+		ASSERT(RLM3_I2C1_Transmit(step.addr, write, sizeof(write)));
+		RLM3_I2C1_Timing timing;
+		ASSERT(RLM3_I2C1_ComputeTiming(HAL_RCC_GetPCLK1Freq(), RLM3_I2C1_GetSpeedHz(step.speed), &timing));
+		ASSERT((I2C1->CCR & I2C_CCR_CCR) == timing.ccr);
+		ASSERT(I2C1->TRISE == timing.trise);
+		ASSERT(RLM3_Host_I2C_GetClockHz() == timing.clock_hz);
+	}
+	RLM3_I2C1_GetCounters(&after);
+
+	// Fast-mode Plus runs at Fast mode on this peripheral.
+	RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE_FLASH, TEST_I2C_OTHER_ADDRESS, RLM3_I2C1_SPEED_FAST_PLUS);
+	ASSERT(RLM3_I2C1_Transmit(TEST_I2C_OTHER_ADDRESS, write, sizeof(write)));
+	ASSERT(RLM3_Host_I2C_GetClockHz() <= 400000);
+
+	RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE_FLASH, TEST_I2C_OTHER_ADDRESS, RLM3_I2C1_SPEED_STANDARD);
+	RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE_FLASH);
+	RLM3_Host_I2C_Detach(TEST_I2C_OTHER_ADDRESS);
+	DetachRegisters();
+
+	ASSERT(after.speed_change_count - before.speed_change_count == 2);
+	ASSERT(g_other_registers.data[0x00] == 0x12);
+}
+
+TEST_CASE(Host_I2C1_DeviceSpeed_GroupsWaitingTransactions)
+{
+	static const size_t TRANSACTION_COUNT = 32;
+	static volatile size_t g_other_count;
+	auto secondary_thread_fn = [](void* param)
+	{
+		const uint8_t write[] = { 0x00, 0x34 };
+		for (size_t i = 0; i < TRANSACTION_COUNT; i++)
+			if (RLM3_I2C1_Transmit(TEST_I2C_OTHER_ADDRESS, write, sizeof(write)))
+				g_other_count++;
+		::osThreadExit();
+	};
+
+	AttachRegisters();
+	g_other_registers = TestRegisters();
+	RLM3_Host_I2C_Attach(TEST_I2C_OTHER_ADDRESS, &g_other_registers_device);
+	RLM3_I2C1_Init(RLM3_I2C1_DEVICE_FLASH);
+	RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE_FLASH, TEST_I2C_OTHER_ADDRESS, RLM3_I2C1_SPEED_FAST);
+	RLM3_I2C1_Counters before, after;
+	RLM3_I2C1_GetCounters(&before);
+
+	g_other_count = 0;
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "secondary_thread";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityNormal;
+	ASSERT(::osThreadNew(secondary_thread_fn, NULL, &task_attributes) != nullptr);
+
+	size_t count = 0;
+	const uint8_t write[] = { 0x00, 0x56 };
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	for (size_t i = 0; i < TRANSACTION_COUNT; i++)
+		if (RLM3_I2C1_Transmit(TEST_I2C_ADDRESS, write, sizeof(write)))
+			count++;
+	while (g_other_count < TRANSACTION_COUNT)
+		::osDelay(1);
+	uint64_t elapsed_us = (RLM3_Host_GetTimeNs() - start_ns) / 1000;
+	uint64_t wire_us = TRANSACTION_COUNT * ((uint64_t)RLM3_I2C1_GetTransferTimeUs(TEST_I2C_ADDRESS, sizeof(write), 0) +
+			RLM3_I2C1_GetTransferTimeUs(TEST_I2C_OTHER_ADDRESS, sizeof(write), 0));
+	RLM3_I2C1_GetCounters(&after);
+
+	RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE_FLASH, TEST_I2C_OTHER_ADDRESS, RLM3_I2C1_SPEED_STANDARD);
+	RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE_FLASH);
+	RLM3_Host_I2C_Detach(TEST_I2C_OTHER_ADDRESS);
+	DetachRegisters();
+
+	// Taking turns would change rate on every transaction.  Batches change it once per batch.
+	uint32_t changes = after.speed_change_count - before.speed_change_count;
+	LOG_ALWAYS("%u rate changes for %u interleaved transactions in %u us, %u us on the wire", (unsigned)changes,
+			(unsigned)(2 * TRANSACTION_COUNT), (unsigned)elapsed_us, (unsigned)wire_us);
+	ASSERT(count == TRANSACTION_COUNT);
+	ASSERT(changes >= 2 && changes <= 2 * TRANSACTION_COUNT / RLM3_I2C1_SPEED_BATCH_LIMIT + 2);
+	// Waiting transactions are handed the bus rather than sleeping ticks to let a batch through.
+	ASSERT(elapsed_us * 4 < wire_us * 5);
+}
+
+TEST_CASE(Host_I2C1_Flash_Throughput_Benchmark)
+{
+	static const size_t READ_COUNT = 16;
+	static const size_t READ_SIZE = 64;
+	RLM3_Host_I2C_Attach(TEST_I2C_ADDRESS, &g_registers_device);
+	g_registers = TestRegisters();
+	RLM3_I2C1_Init(RLM3_I2C1_DEVICE_FLASH);
+
+	uint64_t bytes_per_second[RLM3_I2C1_SPEED_COUNT];
+	for (size_t speed = 0; speed < RLM3_I2C1_SPEED_COUNT; speed++)
+	{
+		RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE_FLASH, TEST_I2C_ADDRESS, (RLM3_I2C1_Speed)speed);
+		uint8_t select = 0;
+		uint8_t data[READ_SIZE];
+		uint64_t start_ns = RLM3_Host_GetTimeNs();
+		uint64_t start_host_ns = GetHostNs();
+		for (size_t i = 0; i < READ_COUNT; i++)
+			ASSERT(RLM3_I2C1_TransmitReceive(TEST_I2C_ADDRESS, &select, 1, data, sizeof(data)));
+		uint64_t elapsed_ns = RLM3_Host_GetTimeNs() - start_ns;
+		uint64_t host_ns = GetHostNs() - start_host_ns;
+		bytes_per_second[speed] = READ_COUNT * READ_SIZE * 1000000000ULL / elapsed_ns;
+		LOG_ALWAYS("FLASH %u Hz: %u bytes/s, host %u ns per read", (unsigned)RLM3_Host_I2C_GetClockHz(),
+				(unsigned)bytes_per_second[speed], (unsigned)(host_ns / READ_COUNT));
+	}
+
+	RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE_FLASH, TEST_I2C_ADDRESS, RLM3_I2C1_SPEED_STANDARD);
+	RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE_FLASH);
+	RLM3_Host_I2C_Detach(TEST_I2C_ADDRESS);
+	while (RLM3_TakeWithTimeout(0))
+		;
+
+	// Nine bits a byte, less the per-transfer overhead of the address bytes and the task wakeups.
+	ASSERT(bytes_per_second[RLM3_I2C1_SPEED_STANDARD] > 100000 / 9 * 9 / 10);
+	ASSERT(bytes_per_second[RLM3_I2C1_SPEED_FAST] > 3 * bytes_per_second[RLM3_I2C1_SPEED_STANDARD]);
+}
@@ -0,0 +1,112 @@
+#include "Test.hpp"
+#include "rlm3-host-peripherals.h"
+#include "rlm3-i2c.h"
+#include "rlm3-task.h"
+#include "rlm3-log.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+LOGGER_ZONE(TEST_HOST_I2C_TRACE);
+
+
+// This file and rlm3-i2c.c are built once for each level in HOST_TRACE_LEVELS, each into its own test binary.  The
+// builds hand their results to each other through the file named by RLM3_I2C_TRACE_CYCLES_FILE, compiled in first.
+#ifndef RLM3_I2C_LOG_LEVEL
+#error "Build with -DRLM3_I2C_LOG_LEVEL set to the level rlm3-i2c.c was built at"
+#endif
+
+#define TEST_I2C_ADDRESS 0x50
+#define TEST_TRANSFER_COUNT 2000
+
+
+static uint8_t g_register = 0;
+
+static bool SensorStart(void* context, bool is_read)
+{
+	return true;
+}
+
+static bool SensorWrite(void* context, uint8_t data)
+{
+	g_register = data;
+	return true;
+}
+
+static uint8_t SensorRead(void* context)
+{
+	return g_register++;
+}
+
+static void SensorStop(void* context)
+{
+}
+
+static const RLM3_Host_I2C_Device g_sensor_device = { SensorStart, SensorWrite, SensorRead, SensorStop, nullptr };
+
+
+static uint32_t TimeTransfers(uint8_t runtime_level)
+{
+	// The quickest single transfer, so the host scheduler and cache misses in the others do not count.
+	RLM3_Log_Level = runtime_level;
+	uint32_t best = UINT32_MAX;
+	for (size_t i = 0; i < TEST_TRANSFER_COUNT; i++)
+	{
+		const uint8_t select = 0;
+		uint8_t data[4];
+		uint32_t start = RLM3_GetCycleCount();
+		ASSERT(RLM3_I2C1_TransmitReceive(TEST_I2C_ADDRESS, &select, 1, data, sizeof(data)));
+		uint32_t cycles = RLM3_GetCycleCount() - start;
+		if (cycles < best)
+			best = cycles;
+	}
+	RLM3_Log_Level = RLM3_LOG_LEVEL_TRACE;
+	return best;
+}
+
+static bool ExchangeCycles(bool is_compiled_in, uint32_t* cycles)
+{
+	const char* path = getenv("RLM3_I2C_TRACE_CYCLES_FILE");
+	if (path == NULL)
+		return false;
+	FILE* file = fopen(path, is_compiled_in ? "w" : "r");
+	if (file == NULL)
+		return false;
+	bool result = is_compiled_in ? (fprintf(file, "%u\n", (unsigned)*cycles) > 0) : (fscanf(file, "%u", cycles) == 1);
+	fclose(file);
+	return result;
+}
+
+
+TEST_CASE(Host_I2C1_Trace_Cycle_Benchmark)
+{
+	// Host CPU cycles for a whole RLM3_I2C1_TransmitReceive through the driver as built, with the run-time level left
+	// at TRACE and turned down to DEBUG.  Comparing the builds gives compiled in, filtered and compiled out.  Only the
+	// compiled out build against the compiled in one is asserted.  The filtered cost is too close to call on the host.
+	RLM3_Host_I2C_Attach(TEST_I2C_ADDRESS, &g_sensor_device);
+	RLM3_I2C1_Init(RLM3_I2C1_DEVICE_TEST);
+	RLM3_Log_FlushDeferred();
+	uint32_t dropped = RLM3_Log_GetDroppedCount();
+
+	uint32_t enabled_cycles = TimeTransfers(RLM3_LOG_LEVEL_TRACE);
+	uint32_t filtered_cycles = TimeTransfers(RLM3_LOG_LEVEL_DEBUG);
+
+	RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE_TEST);
+	RLM3_Host_I2C_Detach(TEST_I2C_ADDRESS);
+	while (RLM3_TakeWithTimeout(0))
+		;
+
+	bool is_compiled_in = (RLM3_I2C_LOG_LEVEL >= RLM3_LOG_LEVEL_TRACE);
+	LOG_ALWAYS("I2C traces compiled %s: quickest transfer %u cycles at run-time TRACE, %u at DEBUG", is_compiled_in ? "in" : "out",
+			(unsigned)enabled_cycles, (unsigned)filtered_cycles);
+	uint32_t compiled_in_cycles = enabled_cycles;
+	if (ExchangeCycles(is_compiled_in, &compiled_in_cycles) && !is_compiled_in)
+	{
+		LOG_ALWAYS("Compiled out: %u cycles against %u compiled in", (unsigned)enabled_cycles, (unsigned)compiled_in_cycles);
+		ASSERT(enabled_cycles < compiled_in_cycles);
+	}
+	// The transactions flush what the interrupt deferred, so the ring never fills.
+	ASSERT(RLM3_Log_GetDroppedCount() == dropped);
+	ASSERT(RLM3_Log_FlushDeferred() == 0);
+}
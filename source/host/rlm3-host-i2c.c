@@ -0,0 +1,355 @@
+#include "rlm3-host-peripherals.h"
+#include "rlm3-host.h"
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_hal_i2c.h"
+#include "i2c.h"
+#include "Assert.h"
+
+
+#define I2C_ADDRESS_COUNT 128
+#define I2C_RETRY_NS 1000
+#define I2C_PIN_PORT GPIOB
+#define I2C_SCL_PIN GPIO_PIN_8
+#define I2C_SDA_PIN GPIO_PIN_9
+
+
+typedef struct
+{
+	I2C_HandleTypeDef* handle;
+	bool is_transfer;
+	bool is_read;
+	bool is_stop;
+	uint8_t address;
+	uint8_t* data;
+	size_t size;
+
+	bool is_stick_pending;
+	size_t stick_release_clocks;
+	bool is_stuck;
+	size_t release_clocks;
+	bool is_scl_high;
+	size_t arbitration_loss_count;
+	bool is_frame_open;
+} I2cModel;
+
+
+I2C_TypeDef RLM3_Host_I2C1;
+I2C_HandleTypeDef hi2c1;
+
+static const RLM3_Host_I2C_Device* g_i2c_devices[I2C_ADDRESS_COUNT];
+static I2cModel g_i2c = { .is_scl_high = true };
+
+
+static bool IsPinOutput(GPIO_TypeDef* port, uint16_t pin)
+{
+	size_t index = __builtin_ctz(pin);
+	return ((port->MODER >> (2 * index)) & 0x3UL) == GPIO_MODE_OUTPUT_PP;
+}
+
+static bool IsPinDrivenLow(GPIO_TypeDef* port, uint16_t pin)
+{
+	return IsPinOutput(port, pin) && (port->ODR & pin) == 0;
+}
+
+static void I2cUpdatePins()
+{
+	// Both lines are open drain with pull-ups, so they read high unless something pulls them low.
+	bool is_scl_high = !IsPinDrivenLow(I2C_PIN_PORT, I2C_SCL_PIN);
+	bool is_sda_high = !IsPinDrivenLow(I2C_PIN_PORT, I2C_SDA_PIN) && !g_i2c.is_stuck;
+
+	// A slave stuck mid-byte lets go of SDA once the master clocks out the rest of it.
+	if (is_scl_high && !g_i2c.is_scl_high && g_i2c.is_stuck && g_i2c.release_clocks != SIZE_MAX && --g_i2c.release_clocks == 0)
+	{
+		g_i2c.is_stuck = false;
+		is_sda_high = !IsPinDrivenLow(I2C_PIN_PORT, I2C_SDA_PIN);
+	}
+	g_i2c.is_scl_high = is_scl_high;
+
+	MODIFY_REG(I2C_PIN_PORT->IDR, I2C_SCL_PIN | I2C_SDA_PIN, (is_scl_high ? I2C_SCL_PIN : 0) | (is_sda_high ? I2C_SDA_PIN : 0));
+}
+
+static uint32_t I2cClockHz()
+{
+	// SCL rise times are ignored, so the rate is the one CCR divides the bus clock down to.
+	uint32_t ccr = I2C1->CCR;
+	uint32_t divisor = ccr & I2C_CCR_CCR;
+	if ((ccr & I2C_CCR_FS) == 0)
+		divisor *= 2;
+	else
+		divisor *= ((ccr & I2C_CCR_DUTY) != 0) ? 25 : 3;
+	return (divisor == 0) ? 0 : HAL_RCC_GetPCLK1Freq() / divisor;
+}
+
+static uint32_t I2cExchange()
+{
+	const RLM3_Host_I2C_Device* device = g_i2c_devices[g_i2c.address];
+	if (g_i2c.arbitration_loss_count > 0)
+	{
+		g_i2c.arbitration_loss_count--;
+		g_i2c.is_frame_open = false;
+		return HAL_I2C_ERROR_ARLO;
+	}
+	if (device == NULL || !device->start(device->context, g_i2c.is_read))
+	{
+		g_i2c.is_frame_open = false;
+		return HAL_I2C_ERROR_AF;
+	}
+	for (size_t i = 0; i < g_i2c.size; i++)
+	{
+		if (g_i2c.is_read)
+			g_i2c.data[i] = device->read(device->context);
+		else if (!device->write(device->context, g_i2c.data[i]))
+		{
+			// The HAL ends the transfer with a STOP after a NACK.
+			device->stop(device->context);
+			g_i2c.is_frame_open = false;
+			return HAL_I2C_ERROR_AF;
+		}
+	}
+	if (g_i2c.is_stop)
+		device->stop(device->context);
+	g_i2c.is_frame_open = !g_i2c.is_stop;
+	return HAL_I2C_ERROR_NONE;
+}
+
+static void I2cInterrupt()
+{
+	if (!RLM3_Host_IsIRQEnabled(I2C1_EV_IRQn) || !RLM3_Host_IsIRQEnabled(I2C1_ER_IRQn))
+	{
+		RLM3_Host_ScheduleInterrupt(I2C1_EV_IRQn, I2cInterrupt, I2C_RETRY_NS, 0);
+		return;
+	}
+
+	I2C_HandleTypeDef* hi2c = g_i2c.handle;
+	uint32_t error = I2cExchange();
+	bool is_read = g_i2c.is_read;
+	g_i2c.is_transfer = false;
+	hi2c->ErrorCode = error;
+	hi2c->State = HAL_I2C_STATE_READY;
+	if (error != HAL_I2C_ERROR_NONE)
+		HAL_I2C_ErrorCallback(hi2c);
+	else if (is_read)
+		HAL_I2C_MasterRxCpltCallback(hi2c);
+	else
+		HAL_I2C_MasterTxCpltCallback(hi2c);
+}
+
+static HAL_StatusTypeDef I2cStart(I2C_HandleTypeDef* hi2c, uint16_t address, uint8_t* data, uint16_t size, bool is_read, bool is_stop)
+{
+	ASSERT(hi2c == &hi2c1);
+	if (hi2c->State != HAL_I2C_STATE_READY)
+		return HAL_BUSY;
+	// The HAL waits for the BUSY flag to clear before it sends a START, unless it holds the bus from the previous frame.
+	if (g_i2c.is_stuck && !g_i2c.is_frame_open)
+		return HAL_BUSY;
+
+	hi2c->State = is_read ? HAL_I2C_STATE_BUSY_RX : HAL_I2C_STATE_BUSY_TX;
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+	hi2c->Devaddress = address;
+	hi2c->pBuffPtr = data;
+	hi2c->XferSize = size;
+	g_i2c.handle = hi2c;
+	g_i2c.is_transfer = true;
+	g_i2c.is_read = is_read;
+	g_i2c.is_stop = is_stop;
+	g_i2c.address = (address >> 1) & 0x7F;
+	g_i2c.data = data;
+	g_i2c.size = size;
+
+	if (g_i2c.is_stick_pending)
+	{
+		// The slave holds SDA low part way through the transfer, so it never finishes.
+		g_i2c.is_stick_pending = false;
+		g_i2c.is_stuck = true;
+		g_i2c.release_clocks = g_i2c.stick_release_clocks;
+		I2cUpdatePins();
+		return HAL_OK;
+	}
+
+	// A START, the address and data bytes with their acknowledge bits, and a STOP.
+	size_t bytes = (g_i2c.arbitration_loss_count > 0 || g_i2c_devices[g_i2c.address] == NULL) ? 1 : 1 + size;
+	uint64_t bits = 1 + 9 * bytes + (is_stop ? 1 : 0);
+	RLM3_Host_ScheduleInterrupt(I2C1_EV_IRQn, I2cInterrupt, bits * 1000000000ULL / I2cClockHz(), 0);
+	return HAL_OK;
+}
+
+static bool IsStopFrame(uint32_t options)
+{
+	return options == I2C_FIRST_AND_LAST_FRAME || options == I2C_LAST_FRAME;
+}
+
+static void I2cMspInit(I2C_HandleTypeDef* hi2c)
+{
+	__HAL_RCC_I2C1_CLK_ENABLE();
+	GPIO_InitTypeDef init = { 0 };
+	init.Pin = I2C_SCL_PIN | I2C_SDA_PIN;
+	init.Mode = GPIO_MODE_AF_OD;
+	init.Pull = GPIO_PULLUP;
+	init.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+	init.Alternate = GPIO_AF4_I2C1;
+	HAL_GPIO_Init(I2C_PIN_PORT, &init);
+	HAL_NVIC_SetPriority(I2C1_EV_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(I2C1_EV_IRQn);
+	HAL_NVIC_SetPriority(I2C1_ER_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(I2C1_ER_IRQn);
+}
+
+static void I2cMspDeInit(I2C_HandleTypeDef* hi2c)
+{
+	__HAL_RCC_I2C1_CLK_DISABLE();
+	HAL_GPIO_DeInit(I2C_PIN_PORT, I2C_SCL_PIN | I2C_SDA_PIN);
+	HAL_NVIC_DisableIRQ(I2C1_EV_IRQn);
+	HAL_NVIC_DisableIRQ(I2C1_ER_IRQn);
+}
+
+extern void MX_I2C1_Init(void)
+{
+	hi2c1.Instance = I2C1;
+	hi2c1.Init.ClockSpeed = 100000;
+	hi2c1.Init.DutyCycle = I2C_DUTYCYCLE_2;
+	hi2c1.Init.OwnAddress1 = 0;
+	hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+	hi2c1.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+	hi2c1.Init.OwnAddress2 = 0;
+	hi2c1.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+	hi2c1.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+	HAL_StatusTypeDef status = HAL_I2C_Init(&hi2c1);
+	ASSERT(status == HAL_OK);
+}
+
+extern HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c)
+{
+	if (hi2c == NULL)
+		return HAL_ERROR;
+	ASSERT(hi2c->Instance == I2C1);
+	// The F4 peripheral stops at Fast mode, and needs a 2 MHz bus clock for Standard mode or 4 MHz for Fast mode.
+	uint32_t speed = hi2c->Init.ClockSpeed;
+	uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+	ASSERT(speed > 0 && speed <= 400000);
+	ASSERT(pclk1 >= ((speed <= 100000) ? 2000000 : 4000000));
+	if (hi2c->State == HAL_I2C_STATE_RESET)
+		I2cMspInit(hi2c);
+
+	// The same register values as the HAL's I2C_SPEED macros, which round the divisor up.
+	uint32_t freq_mhz = pclk1 / 1000000;
+	uint32_t ccr;
+	if (speed <= 100000)
+	{
+		ccr = (pclk1 - 1) / (speed * 2) + 1;
+		if (ccr < 4)
+			ccr = 4;
+	}
+	else if (hi2c->Init.DutyCycle == I2C_DUTYCYCLE_2)
+		ccr = ((pclk1 - 1) / (speed * 3) + 1) | I2C_CCR_FS;
+	else
+		ccr = ((pclk1 - 1) / (speed * 25) + 1) | I2C_CCR_DUTY | I2C_CCR_FS;
+	hi2c->Instance->CR1 = 0;
+	hi2c->Instance->CR2 = freq_mhz;
+	hi2c->Instance->TRISE = (speed <= 100000) ? freq_mhz + 1 : freq_mhz * 300 / 1000 + 1;
+	hi2c->Instance->CCR = ccr;
+	hi2c->Instance->CR1 = I2C_CR1_PE;
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+	hi2c->State = HAL_I2C_STATE_READY;
+	I2cUpdatePins();
+	return HAL_OK;
+}
+
+extern HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c)
+{
+	if (hi2c == NULL)
+		return HAL_ERROR;
+	ASSERT(hi2c->Instance == I2C1);
+	// A transfer cut short leaves the slave wherever it was.  Only a stuck slave keeps holding the bus.
+	RLM3_Host_CancelInterrupt(I2C1_EV_IRQn);
+	g_i2c.is_transfer = false;
+	g_i2c.is_frame_open = false;
+	hi2c->Instance->CR1 = 0;
+	I2cMspDeInit(hi2c);
+	hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+	hi2c->State = HAL_I2C_STATE_RESET;
+	I2cUpdatePins();
+	return HAL_OK;
+}
+
+extern HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size)
+{
+	return I2cStart(hi2c, DevAddress, pData, Size, false, true);
+}
+
+extern HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size)
+{
+	return I2cStart(hi2c, DevAddress, pData, Size, true, true);
+}
+
+extern HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size, uint32_t XferOptions)
+{
+	hi2c->XferOptions = XferOptions;
+	return I2cStart(hi2c, DevAddress, pData, Size, false, IsStopFrame(XferOptions));
+}
+
+extern HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size, uint32_t XferOptions)
+{
+	hi2c->XferOptions = XferOptions;
+	return I2cStart(hi2c, DevAddress, pData, Size, true, IsStopFrame(XferOptions));
+}
+
+extern HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c)
+{
+	return hi2c->State;
+}
+
+extern uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c)
+{
+	return hi2c->ErrorCode;
+}
+
+extern void RLM3_Host_GPIO_Changed(GPIO_TypeDef* port)
+{
+	if (port == I2C_PIN_PORT)
+		I2cUpdatePins();
+}
+
+extern void RLM3_Host_I2C_Attach(uint8_t address, const RLM3_Host_I2C_Device* device)
+{
+	ASSERT(address < I2C_ADDRESS_COUNT);
+	ASSERT(device != NULL && device->start != NULL && device->write != NULL && device->read != NULL && device->stop != NULL);
+	ASSERT(g_i2c_devices[address] == NULL);
+	g_i2c_devices[address] = device;
+}
+
+extern void RLM3_Host_I2C_Detach(uint8_t address)
+{
+	ASSERT(address < I2C_ADDRESS_COUNT);
+	g_i2c_devices[address] = NULL;
+}
+
+extern void RLM3_Host_I2C_StickBus(size_t release_clocks)
+{
+	ASSERT(release_clocks > 0);
+	g_i2c.is_stick_pending = true;
+	g_i2c.stick_release_clocks = release_clocks;
+}
+
+extern bool RLM3_Host_I2C_IsBusStuck()
+{
+	return g_i2c.is_stuck;
+}
+
+extern void RLM3_Host_I2C_ReleaseBus()
+{
+	g_i2c.is_stick_pending = false;
+	g_i2c.is_stuck = false;
+	I2cUpdatePins();
+}
+
+extern uint32_t RLM3_Host_I2C_GetClockHz()
+{
+	if ((RCC->APB1ENR & RCC_APB1ENR_I2C1EN) == 0 || (I2C1->CR1 & I2C_CR1_PE) == 0)
+		return 0;
+	return I2cClockHz();
+}
+
+extern void RLM3_Host_I2C_LoseArbitration(size_t count)
+{
+	g_i2c.arbitration_loss_count = count;
+}
@@ -0,0 +1,117 @@
+#include "Test.hpp"
+#include "rlm3-host.h"
+#include "rlm3-task.h"
+#include "cmsis_os2.h"
+#include "logger.h"
+
+
+LOGGER_ZONE(TEST_HOST_KERNEL);
+
+
+// WWDG, which nothing else in the host build raises.
+#define TEST_ISR_LINE 0
+#define TEST_WAITER_COUNT 4
+
+
+static RLM3_Task g_waiters[TEST_WAITER_COUNT] = {};
+static volatile size_t g_give_count = 0;
+static volatile bool g_stop = false;
+static volatile uint32_t g_done = 0;
+static volatile uint32_t g_wakeups = 0;
+static volatile uint64_t g_cycles_total = 0;
+static volatile uint32_t g_samples = 0;
+
+
+static void WaiterFn(void* param)
+{
+	g_waiters[(size_t)param] = RLM3_GetCurrentTask();
+	while (true)
+	{
+		RLM3_Take();
+		if (g_stop)
+			break;
+		g_wakeups++;
+	}
+	RLM3_EnterCritical();
+	g_done++;
+	RLM3_ExitCritical();
+	::osThreadExit();
+}
+
+static void BareHandler()
+{
+	uint32_t start = RLM3_GetCycleCount();
+	for (size_t i = 0; i < g_give_count; i++)
+		RLM3_GiveFromISR(g_waiters[i]);
+	g_cycles_total += RLM3_GetCycleCount() - start;
+	g_samples++;
+}
+
+static void ScopedHandler()
+{
+	uint32_t start = RLM3_GetCycleCount();
+	RLM3_ISR_Begin();
+	for (size_t i = 0; i < g_give_count; i++)
+		RLM3_GiveFromISR(g_waiters[i]);
+	RLM3_ISR_End();
+	g_cycles_total += RLM3_GetCycleCount() - start;
+	g_samples++;
+}
+
+
+TEST_CASE(Host_ISR_Scope_Benchmark)
+{
+	// The same handler giving to 1, 2 or 4 higher priority tasks, run bare and inside an RLM3_ISR_Begin/End scope.
+	g_stop = false;
+	g_done = 0;
+	for (size_t i = 0; i < TEST_WAITER_COUNT; i++)
+	{
+		osThreadAttr_t task_attributes = {};
+		task_attributes.name = "waiter";
+		task_attributes.stack_size = 128 * 4;
+		task_attributes.priority = osPriorityAboveNormal;
+		ASSERT(::osThreadNew(WaiterFn, (void*)i, &task_attributes) != nullptr);
+	}
+	RLM3_Delay(1);
+
+	static const size_t GIVES[] = { 1, 2, 4 };
+	for (size_t gives : GIVES)
+	{
+		uint32_t yields[2], switches[2], cycles[2];
+		for (size_t mode = 0; mode < 2; mode++)
+		{
+			g_give_count = gives;
+			g_cycles_total = 0;
+			g_samples = 0;
+			g_wakeups = 0;
+			uint32_t yields_before = RLM3_Host_GetYieldRequestCount();
+			uint32_t switches_before = RLM3_Host_GetContextSwitchCount();
+			RLM3_Host_ScheduleInterrupt(TEST_ISR_LINE, (mode == 0) ? BareHandler : ScopedHandler, 0, 1000000);
+			RLM3_Delay(50);
+			RLM3_Host_CancelInterrupt(TEST_ISR_LINE);
+			RLM3_Delay(1);
+			uint32_t samples = g_samples;
+			yields[mode] = RLM3_Host_GetYieldRequestCount() - yields_before;
+			switches[mode] = RLM3_Host_GetContextSwitchCount() - switches_before;
+			cycles[mode] = (uint32_t)(g_cycles_total / samples);
+
+			// Every give still wakes its task.
+			ASSERT(samples > 0);
+			ASSERT(g_wakeups == samples * gives);
+			yields[mode] /= samples;
+			switches[mode] /= samples;
+		}
+		LOG_ALWAYS("Gives: %u bare: %u yields %u switches %u cycles scoped: %u yields %u switches %u cycles", (unsigned)gives,
+				(unsigned)yields[0], (unsigned)switches[0], (unsigned)cycles[0], (unsigned)yields[1], (unsigned)switches[1], (unsigned)cycles[1]);
+		// A bare handler requests a yield for every give.  The scope requests one, and the tasks switch no more often.
+		ASSERT(yields[0] == gives);
+		ASSERT(yields[1] == 1);
+		ASSERT(switches[1] <= switches[0]);
+	}
+
+	g_stop = true;
+	for (size_t i = 0; i < TEST_WAITER_COUNT; i++)
+		RLM3_Give(g_waiters[i]);
+	while (g_done < TEST_WAITER_COUNT)
+		RLM3_Delay(1);
+}
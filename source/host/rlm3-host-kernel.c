@@ -0,0 +1,612 @@
+#include "rlm3-host.h"
+#include "rlm3-host-peripherals.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Assert.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+
+typedef enum
+{
+	TASK_READY,
+	TASK_BLOCKED,
+	TASK_DELETED,
+} TaskState;
+
+typedef enum
+{
+	NOTIFY_NONE,
+	NOTIFY_WAITING,
+	NOTIFY_RECEIVED,
+} NotifyState;
+
+struct tskTaskControlBlock
+{
+	struct tskTaskControlBlock* next;
+	pthread_t thread;
+	pthread_cond_t cond;
+	TaskFunction_t function;
+	void* parameters;
+	const char* name;
+	UBaseType_t priority;
+	TaskState state;
+	uint64_t ready_order;
+	bool has_timeout;
+	TickType_t wake_tick;
+	NotifyState notify_state;
+	uint32_t notify_value;
+	uint32_t critical_nesting;
+	void* local_storage[configNUM_THREAD_LOCAL_STORAGE_POINTERS];
+};
+typedef struct tskTaskControlBlock Task;
+
+typedef struct
+{
+	RLM3_Host_Handler handler;
+	uint64_t next_ns;
+	uint64_t period_ns;
+} Interrupt;
+
+
+static const uint64_t NEVER = UINT64_MAX;
+
+static pthread_mutex_t g_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_idle_cond = PTHREAD_COND_INITIALIZER;
+static Task* g_tasks = NULL;
+static Task* g_deleted_tasks = NULL;
+static Task* volatile g_current = NULL;
+static uint64_t g_order = 0;
+static uint64_t g_time_ns = 0;
+static TickType_t g_slice_tick = 0;
+static bool g_yield_pending = false;
+static uint32_t g_yield_request_count = 0;
+static uint32_t g_context_switch_count = 0;
+static bool g_is_started = false;
+static Interrupt g_interrupts[RLM3_HOST_INTERRUPT_COUNT];
+
+static __thread Task* t_self = NULL;
+static __thread bool t_is_isr = false;
+
+
+static TickType_t GetTick()
+{
+	return (TickType_t)(g_time_ns / 1000000ULL);
+}
+
+static void EnterKernel()
+{
+	// Called with the mutex held.  Time only moves for kernel calls made by tasks and when the CPU goes idle.
+	if (t_self != NULL && !t_is_isr)
+		g_time_ns += RLM3_HOST_KERNEL_CALL_NS;
+}
+
+static Task* SelectTask(Task* preferred)
+{
+	// Highest priority first.  Equal priorities go in the order they became ready, unless the preferred task may keep running.
+	Task* best = NULL;
+	for (Task* task = g_tasks; task != NULL; task = task->next)
+	{
+		if (task->state != TASK_READY)
+			continue;
+		if (best == NULL || task->priority > best->priority)
+			best = task;
+		else if (task->priority == best->priority && best != preferred && (task == preferred || task->ready_order < best->ready_order))
+			best = task;
+	}
+	return best;
+}
+
+static void MakeReady(Task* task)
+{
+	task->state = TASK_READY;
+	task->has_timeout = false;
+	task->ready_order = ++g_order;
+}
+
+static void WakeExpired(TickType_t tick)
+{
+	// Tasks that time out together become ready in the order they blocked, like the FreeRTOS delayed list.
+	while (true)
+	{
+		Task* first = NULL;
+		for (Task* task = g_tasks; task != NULL; task = task->next)
+			if (task->state == TASK_BLOCKED && task->has_timeout && (int32_t)(tick - task->wake_tick) >= 0)
+				if (first == NULL || task->ready_order < first->ready_order)
+					first = task;
+		if (first == NULL)
+			return;
+		MakeReady(first);
+	}
+}
+
+static void RunInterrupts()
+{
+	// The mutex is released while a handler runs so it can call back into the kernel.
+	uint64_t now = g_time_ns;
+	for (size_t i = 0; i < RLM3_HOST_INTERRUPT_COUNT; i++)
+	{
+		Interrupt* interrupt = &g_interrupts[i];
+		if (interrupt->handler == NULL || interrupt->next_ns > now)
+			continue;
+		if (interrupt->period_ns == 0)
+			interrupt->next_ns = NEVER;
+		else
+			while (interrupt->next_ns <= now)
+				interrupt->next_ns += interrupt->period_ns;
+
+		RLM3_Host_Handler handler = interrupt->handler;
+		pthread_mutex_unlock(&g_mutex);
+		bool was_isr = t_is_isr;
+		t_is_isr = true;
+		handler();
+		t_is_isr = was_isr;
+		pthread_mutex_lock(&g_mutex);
+	}
+}
+
+static void PollPeripherals()
+{
+	// The models raise their interrupt lines through this file, so the mutex is released while they run.
+	pthread_mutex_unlock(&g_mutex);
+	RLM3_Host_PollPeripherals();
+	pthread_mutex_lock(&g_mutex);
+}
+
+static void SwitchTo(Task* self, Task* next)
+{
+	// Hands over the CPU and, unless this task is gone, waits until the scheduler hands it back.
+	if (next == self)
+		return;
+	g_context_switch_count++;
+	g_current = next;
+	g_slice_tick = GetTick();
+	if (next != NULL)
+		pthread_cond_signal(&next->cond);
+	else
+		pthread_cond_signal(&g_idle_cond);
+	if (self == NULL || self->state == TASK_DELETED)
+		return;
+	while (g_current != self)
+		pthread_cond_wait(&self->cond, &g_mutex);
+}
+
+static void Yield(Task* self)
+{
+	self->ready_order = ++g_order;
+	SwitchTo(self, SelectTask(NULL));
+}
+
+static bool CanPreempt(Task* self)
+{
+	return (self != NULL && !t_is_isr && self->critical_nesting == 0 && g_is_started);
+}
+
+static void Preempt(Task* self)
+{
+	// Everything that happens between kernel calls on real hardware happens here: peripherals catching up with the
+	// clock, pending interrupts, expired timeouts, a higher priority task becoming ready and the tick ending a time slice.
+	if (!CanPreempt(self))
+		return;
+	PollPeripherals();
+	RunInterrupts();
+	TickType_t tick = GetTick();
+	WakeExpired(tick);
+	if (g_yield_pending || tick != g_slice_tick)
+	{
+		g_yield_pending = false;
+		g_slice_tick = tick;
+		Yield(self);
+	}
+	else
+		SwitchTo(self, SelectTask(self));
+}
+
+static void Block(Task* self, TickType_t ticks)
+{
+	ASSERT(self != NULL && self->critical_nesting == 0);
+	self->state = TASK_BLOCKED;
+	self->ready_order = ++g_order;
+	self->has_timeout = (ticks != portMAX_DELAY);
+	self->wake_tick = GetTick() + ticks;
+	SwitchTo(self, SelectTask(NULL));
+}
+
+static void* TaskEntry(void* parameters)
+{
+	Task* self = (Task*)parameters;
+	t_self = self;
+	pthread_mutex_lock(&g_mutex);
+	while (g_current != self)
+		pthread_cond_wait(&self->cond, &g_mutex);
+	pthread_mutex_unlock(&g_mutex);
+
+	self->function(self->parameters);
+	vTaskDelete(NULL);
+	return NULL;
+}
+
+static uint64_t GetIdleDeadline()
+{
+	uint64_t deadline = NEVER;
+	for (size_t i = 0; i < RLM3_HOST_INTERRUPT_COUNT; i++)
+		if (g_interrupts[i].handler != NULL && g_interrupts[i].next_ns < deadline)
+			deadline = g_interrupts[i].next_ns;
+	for (Task* task = g_tasks; task != NULL; task = task->next)
+	{
+		if (task->state != TASK_BLOCKED || !task->has_timeout)
+			continue;
+		uint64_t wake_ns = (uint64_t)task->wake_tick * 1000000ULL;
+		if (wake_ns < deadline)
+			deadline = wake_ns;
+	}
+	return deadline;
+}
+
+
+extern uint64_t RLM3_Host_GetTimeNs()
+{
+	pthread_mutex_lock(&g_mutex);
+	uint64_t time_ns = g_time_ns;
+	pthread_mutex_unlock(&g_mutex);
+	return time_ns;
+}
+
+extern bool RLM3_Host_IsISR()
+{
+	return t_is_isr;
+}
+
+extern void RLM3_Host_ScheduleInterrupt(size_t line, RLM3_Host_Handler handler, uint64_t delay_ns, uint64_t period_ns)
+{
+	ASSERT(line < RLM3_HOST_INTERRUPT_COUNT);
+	ASSERT(handler != NULL);
+	pthread_mutex_lock(&g_mutex);
+	g_interrupts[line].handler = handler;
+	g_interrupts[line].next_ns = g_time_ns + delay_ns;
+	g_interrupts[line].period_ns = period_ns;
+	pthread_mutex_unlock(&g_mutex);
+}
+
+extern void RLM3_Host_CancelInterrupt(size_t line)
+{
+	ASSERT(line < RLM3_HOST_INTERRUPT_COUNT);
+	pthread_mutex_lock(&g_mutex);
+	g_interrupts[line].handler = NULL;
+	pthread_mutex_unlock(&g_mutex);
+}
+
+extern bool RLM3_Host_IsInterruptScheduled(size_t line)
+{
+	ASSERT(line < RLM3_HOST_INTERRUPT_COUNT);
+	pthread_mutex_lock(&g_mutex);
+	bool result = (g_interrupts[line].handler != NULL && g_interrupts[line].next_ns != NEVER);
+	pthread_mutex_unlock(&g_mutex);
+	return result;
+}
+
+extern uint32_t RLM3_Host_GetYieldRequestCount()
+{
+	pthread_mutex_lock(&g_mutex);
+	uint32_t count = g_yield_request_count;
+	pthread_mutex_unlock(&g_mutex);
+	return count;
+}
+
+extern uint32_t RLM3_Host_GetContextSwitchCount()
+{
+	pthread_mutex_lock(&g_mutex);
+	uint32_t count = g_context_switch_count;
+	pthread_mutex_unlock(&g_mutex);
+	return count;
+}
+
+
+extern BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* parameters, UBaseType_t priority, TaskHandle_t* created_task)
+{
+	Task* task = (Task*)calloc(1, sizeof(Task));
+	if (task == NULL)
+		return pdFAIL;
+	pthread_cond_init(&task->cond, NULL);
+	task->function = function;
+	task->parameters = parameters;
+	task->name = name;
+	task->priority = priority;
+
+	pthread_mutex_lock(&g_mutex);
+	EnterKernel();
+	MakeReady(task);
+	task->next = g_tasks;
+	g_tasks = task;
+
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+	int result = pthread_create(&task->thread, &attributes, TaskEntry, task);
+	pthread_attr_destroy(&attributes);
+	ASSERT(result == 0);
+
+	if (created_task != NULL)
+		*created_task = task;
+	Preempt(t_self);
+	pthread_mutex_unlock(&g_mutex);
+	return pdPASS;
+}
+
+extern void vTaskDelete(TaskHandle_t task)
+{
+	// Only self deletion is supported.  The control block is kept so stale handles stay valid.
+	Task* self = t_self;
+	ASSERT(task == NULL || task == self);
+	ASSERT(self != NULL && self->critical_nesting == 0);
+
+	pthread_mutex_lock(&g_mutex);
+	Task** cursor = &g_tasks;
+	while (*cursor != self)
+		cursor = &(*cursor)->next;
+	*cursor = self->next;
+	self->next = g_deleted_tasks;
+	g_deleted_tasks = self;
+	self->state = TASK_DELETED;
+	SwitchTo(self, SelectTask(NULL));
+	pthread_mutex_unlock(&g_mutex);
+	pthread_exit(NULL);
+}
+
+extern void vTaskStartScheduler()
+{
+	// The calling thread becomes the idle task.  It dispatches tasks and, when none is ready, skips ahead to the next
+	// interrupt or timeout and runs it.
+	pthread_mutex_lock(&g_mutex);
+	g_is_started = true;
+	while (true)
+	{
+		while (g_current != NULL)
+			pthread_cond_wait(&g_idle_cond, &g_mutex);
+
+		PollPeripherals();
+		RunInterrupts();
+		TickType_t tick = GetTick();
+		WakeExpired(tick);
+		Task* next = SelectTask(NULL);
+		if (next != NULL)
+		{
+			SwitchTo(NULL, next);
+			continue;
+		}
+
+		// With nothing left to wake a task, the real board would hang here.
+		uint64_t deadline = GetIdleDeadline();
+		ASSERT(deadline != NEVER);
+		if (deadline > g_time_ns)
+			g_time_ns = deadline;
+	}
+}
+
+extern BaseType_t xTaskGetSchedulerState()
+{
+	return g_is_started ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+extern TickType_t xTaskGetTickCount()
+{
+	pthread_mutex_lock(&g_mutex);
+	EnterKernel();
+	Preempt(t_self);
+	TickType_t tick = GetTick();
+	pthread_mutex_unlock(&g_mutex);
+	return tick;
+}
+
+extern TickType_t xTaskGetTickCountFromISR()
+{
+	return GetTick();
+}
+
+extern void vTaskDelay(TickType_t ticks)
+{
+	pthread_mutex_lock(&g_mutex);
+	EnterKernel();
+	if (ticks == 0)
+		Yield(t_self);
+	else
+		Block(t_self, ticks);
+	Preempt(t_self);
+	pthread_mutex_unlock(&g_mutex);
+}
+
+extern void vTaskDelayUntil(TickType_t* previous_wake_time, TickType_t increment)
+{
+	pthread_mutex_lock(&g_mutex);
+	EnterKernel();
+	TickType_t target = *previous_wake_time + increment;
+	int32_t remaining = (int32_t)(target - GetTick());
+	if (remaining > 0)
+		Block(t_self, (TickType_t)remaining);
+	*previous_wake_time = target;
+	Preempt(t_self);
+	pthread_mutex_unlock(&g_mutex);
+}
+
+extern void vPortYield()
+{
+	ASSERT(!t_is_isr);
+	pthread_mutex_lock(&g_mutex);
+	EnterKernel();
+	Yield(t_self);
+	Preempt(t_self);
+	pthread_mutex_unlock(&g_mutex);
+}
+
+extern void vPortYieldFromISR(BaseType_t higher_priority_task_woken)
+{
+	if (higher_priority_task_woken == pdFALSE)
+		return;
+	pthread_mutex_lock(&g_mutex);
+	g_yield_pending = true;
+	g_yield_request_count++;
+	pthread_mutex_unlock(&g_mutex);
+}
+
+extern TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+	return g_current;
+}
+
+extern void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value)
+{
+	ASSERT(index >= 0 && index < configNUM_THREAD_LOCAL_STORAGE_POINTERS);
+	if (task == NULL)
+		task = g_current;
+	task->local_storage[index] = value;
+}
+
+extern void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index)
+{
+	ASSERT(index >= 0 && index < configNUM_THREAD_LOCAL_STORAGE_POINTERS);
+	if (task == NULL)
+		task = g_current;
+	return task->local_storage[index];
+}
+
+static BaseType_t Notify(Task* task, uint32_t value, eNotifyAction action)
+{
+	// Returns true if the notification released a task that was waiting for it.
+	NotifyState previous = task->notify_state;
+	switch (action)
+	{
+	case eNoAction:
+		break;
+	case eSetBits:
+		task->notify_value |= value;
+		break;
+	case eIncrement:
+		task->notify_value++;
+		break;
+	case eSetValueWithOverwrite:
+		task->notify_value = value;
+		break;
+	case eSetValueWithoutOverwrite:
+		if (previous == NOTIFY_RECEIVED)
+			return pdFALSE;
+		task->notify_value = value;
+		break;
+	}
+	task->notify_state = NOTIFY_RECEIVED;
+	if (previous != NOTIFY_WAITING || task->state != TASK_BLOCKED)
+		return pdFALSE;
+	MakeReady(task);
+	return pdTRUE;
+}
+
+extern BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+	ASSERT(task != NULL);
+	pthread_mutex_lock(&g_mutex);
+	EnterKernel();
+	Notify(task, value, action);
+	Preempt(t_self);
+	pthread_mutex_unlock(&g_mutex);
+	return pdPASS;
+}
+
+extern BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* higher_priority_task_woken)
+{
+	ASSERT(task != NULL);
+	pthread_mutex_lock(&g_mutex);
+	if (Notify(task, value, action) && (g_current == NULL || task->priority > g_current->priority) && higher_priority_task_woken != NULL)
+		*higher_priority_task_woken = pdTRUE;
+	pthread_mutex_unlock(&g_mutex);
+	return pdPASS;
+}
+
+extern BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value_out, TickType_t ticks_to_wait)
+{
+	Task* self = t_self;
+	ASSERT(self != NULL && !t_is_isr);
+	pthread_mutex_lock(&g_mutex);
+	EnterKernel();
+	Preempt(self);
+	if (self->notify_state != NOTIFY_RECEIVED)
+	{
+		self->notify_value &= ~clear_on_entry;
+		self->notify_state = NOTIFY_WAITING;
+		if (ticks_to_wait > 0)
+			Block(self, ticks_to_wait);
+	}
+	if (value_out != NULL)
+		*value_out = self->notify_value;
+	BaseType_t result = (self->notify_state == NOTIFY_RECEIVED) ? pdTRUE : pdFALSE;
+	if (result)
+		self->notify_value &= ~clear_on_exit;
+	self->notify_state = NOTIFY_NONE;
+	pthread_mutex_unlock(&g_mutex);
+	return result;
+}
+
+extern BaseType_t xTaskNotifyStateClear(TaskHandle_t task)
+{
+	pthread_mutex_lock(&g_mutex);
+	if (task == NULL)
+		task = t_self;
+	ASSERT(task != NULL);
+	BaseType_t result = (task->notify_state == NOTIFY_RECEIVED) ? pdTRUE : pdFALSE;
+	if (result)
+		task->notify_state = NOTIFY_NONE;
+	pthread_mutex_unlock(&g_mutex);
+	return result;
+}
+
+extern uint32_t ulTaskNotifyValueClear(TaskHandle_t task, uint32_t bits_to_clear)
+{
+	pthread_mutex_lock(&g_mutex);
+	if (task == NULL)
+		task = t_self;
+	ASSERT(task != NULL);
+	uint32_t value = task->notify_value;
+	task->notify_value &= ~bits_to_clear;
+	pthread_mutex_unlock(&g_mutex);
+	return value;
+}
+
+extern void vTaskEnterCritical()
+{
+	// Interrupts only run between kernel calls outside a critical section, so counting the nesting is enough.  The
+	// section is charged on the way in, so a tick can also end the time slice just before it the way it can on the
+	// board.  Otherwise code that only drops a lock between critical sections would keep the CPU forever.
+	if (t_is_isr)
+		return;
+	ASSERT(t_self != NULL || !g_is_started);
+	if (t_self == NULL)
+		return;
+	if (t_self->critical_nesting == 0)
+	{
+		pthread_mutex_lock(&g_mutex);
+		EnterKernel();
+		Preempt(t_self);
+		pthread_mutex_unlock(&g_mutex);
+	}
+	t_self->critical_nesting++;
+}
+
+extern void vTaskExitCritical()
+{
+	if (t_is_isr || t_self == NULL)
+		return;
+	ASSERT(t_self->critical_nesting > 0);
+	if (--t_self->critical_nesting != 0)
+		return;
+	pthread_mutex_lock(&g_mutex);
+	Preempt(t_self);
+	pthread_mutex_unlock(&g_mutex);
+}
+
+extern UBaseType_t ulPortSetInterruptMaskFromISR()
+{
+	// Simulated interrupts do not nest.
+	return 0;
+}
+
+extern void vPortClearInterruptMaskFromISR(UBaseType_t saved_level)
+{
+}
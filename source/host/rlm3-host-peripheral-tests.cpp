@@ -0,0 +1,733 @@
+#include "Test.hpp"
+#include "rlm3-host-peripherals.h"
+#include "rlm3-uart.h"
+#include "rlm3-frame.h"
+#include "rlm3-pps.h"
+#include "rlm3-host.h"
+#include "rlm3-random.h"
+#include "rlm3-timer.h"
+#include "rlm3-task.h"
+#include "logger.h"
+#include <chrono>
+
+
+LOGGER_ZONE(TEST_HOST);
+
+
+typedef void (*TimerFn)();
+extern void SetTimer2Callback(TimerFn timer_fn);
+
+
+static volatile RLM3_Task g_task = nullptr;
+static const uint8_t* volatile g_tx_buffer = nullptr;
+static volatile size_t g_tx_size = 0;
+static uint8_t* volatile g_rx_buffer = nullptr;
+static volatile size_t g_rx_size = 0;
+static volatile uint32_t g_error_flags = 0;
+
+
+static void ExpectReceive(uint8_t* buffer, size_t size)
+{
+	g_task = RLM3_GetCurrentTask();
+	g_rx_buffer = buffer;
+	g_rx_size = size;
+}
+
+static void StartTransmit(const uint8_t* buffer, size_t size)
+{
+	g_task = RLM3_GetCurrentTask();
+	g_tx_buffer = buffer;
+	g_tx_size = size;
+	RLM3_UART2_EnsureTransmit();
+}
+
+static uint64_t GetHostNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+TEST_CASE(Host_UART2_Transmit_FrameTiming)
+{
+	uint8_t buffer[26];
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		buffer[i] = 'A' + i;
+	RLM3_UART2_Init(115200);
+	uint32_t actual_baud = RLM3_Host_UART_GetBaudRate(USART2);
+	ASSERT(actual_baud >= 115200 - 1152 && actual_baud <= 115200 + 1152);
+
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	StartTransmit(buffer, sizeof(buffer));
+	ASSERT(RLM3_TakeWithTimeout(10));
+	while ((USART2->SR & USART_SR_TC) == 0)
+		RLM3_Yield();
+	uint64_t elapsed_ns = RLM3_Host_GetTimeNs() - start_ns;
+	RLM3_UART2_Deinit();
+
+	uint8_t sent[32];
+	ASSERT(RLM3_Host_UART_TakeTransmitted(USART2, sent, sizeof(sent)) == sizeof(buffer));
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		ASSERT(sent[i] == buffer[i]);
+
+	// Ten bits a frame, back to back because the data register refills while the previous byte shifts out.
+	uint64_t expected_ns = 26ULL * 10 * 1000000000ULL / actual_baud;
+	ASSERT(elapsed_ns >= expected_ns && elapsed_ns <= expected_ns + 20000);
+	ASSERT(g_error_flags == 0);
+}
+
+TEST_CASE(Host_UART2_Receive_HappyCase)
+{
+	const uint8_t expected[] = { 0xA0, 0xA1, 0x00, 0x02, 0x83, 0x10, 0x93, 0x0D, 0x0A };
+	uint8_t buffer[sizeof(expected)] = {};
+	RLM3_UART2_Init(9600);
+
+	ExpectReceive(buffer, sizeof(buffer));
+	RLM3_Host_UART_Receive(USART2, expected, sizeof(expected));
+	ASSERT(!RLM3_TakeWithTimeout(5));
+	ASSERT(RLM3_TakeWithTimeout(10));
+	RLM3_UART2_Deinit();
+
+	for (size_t i = 0; i < sizeof(expected); i++)
+		ASSERT(buffer[i] == expected[i]);
+	ASSERT(g_error_flags == 0);
+}
+
+TEST_CASE(Host_UART2_Receive_Overrun)
+{
+	const uint8_t data[] = { 1, 2, 3 };
+	uint8_t buffer[3] = {};
+	RLM3_UART2_Init(115200);
+
+	// With the interrupt masked nothing reads the data register, so the later bytes overrun the first.
+	ExpectReceive(buffer, sizeof(buffer));
+	HAL_NVIC_DisableIRQ(USART2_IRQn);
+	RLM3_Host_UART_Receive(USART2, data, sizeof(data));
+	RLM3_Delay(2);
+	HAL_NVIC_EnableIRQ(USART2_IRQn);
+	RLM3_Delay(1);
+	RLM3_UART2_Deinit();
+
+	ASSERT(g_rx_size == 2);
+	ASSERT(buffer[0] == 1);
+	ASSERT((g_error_flags & USART_SR_ORE) != 0);
+	RLM3_UART_Counters counters;
+	RLM3_UART_GetCounters(RLM3_UART_2, &counters);
+	ASSERT(counters.overrun_count >= 1);
+	ASSERT(counters.framing_count == 0 && counters.noise_count == 0 && counters.parity_count == 0);
+}
+
+TEST_CASE(Host_UART2_Statistics_Snapshot)
+{
+	uint8_t data[100];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t)i;
+	uint8_t buffer[sizeof(data)] = {};
+	const uint8_t message[] = "Hello";
+	RLM3_UART2_Init(9600);
+
+	RLM3_UART_Counters before;
+	RLM3_UART_GetCounters(RLM3_UART_2, &before);
+	// TXE is set when the transmit interrupt is enabled, so the interrupt may already have run once with nothing to send.
+	ASSERT(before.rx_byte_count == 0 && before.tx_byte_count == 0 && before.isr_count <= 1);
+	ASSERT(before.baud_rate == 9600);
+
+	// 100 bytes at 960 a second take about 104 ms.
+	ExpectReceive(buffer, sizeof(buffer));
+	RLM3_Host_UART_Receive(USART2, data, sizeof(data));
+	StartTransmit(message, sizeof(message));
+	RLM3_UART_SetReceiveLevel(RLM3_UART_2, 40);
+	RLM3_UART_SetReceiveLevel(RLM3_UART_2, 7);
+	RLM3_Delay(200);
+
+	RLM3_UART_Counters after;
+	RLM3_UART_GetCounters(RLM3_UART_2, &after);
+	RLM3_UART2_Deinit();
+	while (RLM3_TakeWithTimeout(0))
+		;
+	ASSERT(g_rx_size == 0 && g_tx_size == 0);
+	uint8_t sent[16];
+	ASSERT(RLM3_Host_UART_TakeTransmitted(USART2, sent, sizeof(sent)) == sizeof(message));
+
+	ASSERT(after.rx_byte_count == sizeof(data));
+	ASSERT(after.tx_byte_count == sizeof(message));
+	// One interrupt can take a received byte and refill the transmit register at once.
+	ASSERT(after.isr_count >= sizeof(data));
+	ASSERT(after.max_isr_cycles > 0);
+	ASSERT(after.receive_level == 7 && after.peak_receive_level == 40);
+	ASSERT(after.overrun_count == 0 && after.pause_count == 0);
+	uint32_t elapsed_ms = after.time_ms - before.time_ms;
+	ASSERT(elapsed_ms >= 200 && elapsed_ms <= 202);
+
+	RLM3_UART_Rates rates;
+	RLM3_UART_GetRates(&before, &after, &rates);
+	ASSERT(rates.rx_bytes_per_second == sizeof(data) * 1000 / elapsed_ms);
+	ASSERT(rates.tx_bytes_per_second == sizeof(message) * 1000 / elapsed_ms);
+	ASSERT(rates.rx_utilization_permille == rates.rx_bytes_per_second * 10 * 1000 / 9600);
+	ASSERT(rates.error_count == 0);
+	LOG_ALWAYS("UART2 rx %u B/s tx %u B/s isr %u/s max isr %u cycles", (int)rates.rx_bytes_per_second, (int)rates.tx_bytes_per_second, (int)rates.isr_per_second, (int)after.max_isr_cycles);
+}
+
+static void UART2_ConfigReceive(RLM3_UART_ID id, uint8_t data, void* context)
+{
+	RLM3_UART2_ReceiveCallback(data);
+}
+
+static bool UART2_ConfigTransmit(RLM3_UART_ID id, uint8_t* data_to_send, void* context)
+{
+	return RLM3_UART2_TransmitCallback(data_to_send);
+}
+
+static void UART2_ConfigError(RLM3_UART_ID id, uint32_t status_flags, void* context)
+{
+	RLM3_UART2_ErrorCallback(status_flags);
+}
+
+TEST_CASE(Host_UART2_HardwareFlowControl_HappyCase)
+{
+	const uint8_t data[] = { 1, 2, 3 };
+	uint8_t buffer[3] = {};
+	RLM3_UART_Config config = { 115200, UART2_ConfigReceive, UART2_ConfigTransmit, UART2_ConfigError, nullptr, RLM3_UART_FLOW_HARDWARE };
+	RLM3_UART_Init(RLM3_UART_2, &config);
+	ASSERT((USART2->CR3 & (USART_CR3_RTSE | USART_CR3_CTSE)) == (USART_CR3_RTSE | USART_CR3_CTSE));
+	ASSERT(((GPIOD->MODER >> (2 * 3)) & 0x3) == GPIO_MODE_AF_PP);
+	ASSERT(((GPIOD->MODER >> (2 * 4)) & 0x3) == GPIO_MODE_AF_PP);
+	ASSERT(((GPIOD->AFR[0] >> (4 * 3)) & 0xF) == 7 && ((GPIOD->AFR[0] >> (4 * 4)) & 0xF) == 7);
+
+	// The same masked interrupt that overruns without flow control.  RTS holds the sender off instead.
+	ExpectReceive(buffer, sizeof(buffer));
+	HAL_NVIC_DisableIRQ(USART2_IRQn);
+	RLM3_Host_UART_Receive(USART2, data, sizeof(data));
+	RLM3_Delay(2);
+	HAL_NVIC_EnableIRQ(USART2_IRQn);
+	ASSERT(RLM3_TakeWithTimeout(10));
+	for (size_t i = 0; i < sizeof(data); i++)
+		ASSERT(buffer[i] == data[i]);
+
+	// Nothing goes out while the other end holds CTS.
+	const uint8_t command[] = { 'A', 'B', 'C', 'D' };
+	uint8_t sent[8];
+	RLM3_Host_UART_SetCts(USART2, false);
+	StartTransmit(command, sizeof(command));
+	RLM3_Delay(2);
+	ASSERT(RLM3_Host_UART_TakeTransmitted(USART2, sent, sizeof(sent)) == 0);
+	RLM3_Host_UART_SetCts(USART2, true);
+	ASSERT(RLM3_TakeWithTimeout(10));
+	RLM3_Delay(1);
+	ASSERT(RLM3_Host_UART_TakeTransmitted(USART2, sent, sizeof(sent)) == sizeof(command));
+	for (size_t i = 0; i < sizeof(command); i++)
+		ASSERT(sent[i] == command[i]);
+
+	RLM3_UART_Counters counters;
+	RLM3_UART_GetCounters(RLM3_UART_2, &counters);
+	RLM3_UART_Deinit(RLM3_UART_2);
+	ASSERT(((GPIOD->MODER >> (2 * 4)) & 0x3) == GPIO_MODE_INPUT);
+	ASSERT(counters.overrun_count == 0);
+	ASSERT(g_error_flags == 0);
+}
+
+struct SlowConsumer
+{
+	static const size_t SIZE = 64;
+	uint8_t buffer[SIZE];
+	size_t head;
+	volatile size_t count;
+	size_t dropped;
+	bool is_flow_controlled;
+};
+
+static void SlowConsumer_Receive(RLM3_UART_ID id, uint8_t data, void* context)
+{
+	SlowConsumer* consumer = (SlowConsumer*)context;
+	if (consumer->count == SlowConsumer::SIZE)
+		consumer->dropped++;
+	else
+		consumer->buffer[(consumer->head + consumer->count++) % SlowConsumer::SIZE] = data;
+	if (consumer->is_flow_controlled)
+		RLM3_UART_SetReceiveLevel(id, consumer->count);
+}
+
+// Receives the bytes on UART4 with a task that empties its buffer 16 bytes a millisecond, well behind the line rate.
+static size_t ReceiveWithSlowConsumer(RLM3_UART_FlowControl flow_control, const uint8_t* data, size_t size, uint8_t* received, SlowConsumer* consumer)
+{
+	*consumer = SlowConsumer();
+	consumer->is_flow_controlled = (flow_control == RLM3_UART_FLOW_SOFTWARE);
+	RLM3_UART_Config config = { 921600, SlowConsumer_Receive, nullptr, nullptr, consumer, flow_control, 48, 16, GPIOB, GPIO_PIN_12 };
+	RLM3_Host_UART_SetRtsPin(UART4, GPIOB, GPIO_PIN_12);
+	RLM3_UART_Init(RLM3_UART_4, &config);
+
+	RLM3_Host_UART_Receive(UART4, data, size);
+	size_t total = 0;
+	for (size_t idle = 0; idle < 5; )
+	{
+		RLM3_Delay(1);
+		RLM3_EnterCritical();
+		size_t count = (consumer->count < 16) ? consumer->count : 16;
+		for (size_t i = 0; i < count && total < size; i++)
+			received[total++] = consumer->buffer[(consumer->head + i) % SlowConsumer::SIZE];
+		consumer->head = (consumer->head + count) % SlowConsumer::SIZE;
+		consumer->count -= count;
+		if (consumer->is_flow_controlled)
+			RLM3_UART_SetReceiveLevel(RLM3_UART_4, consumer->count);
+		RLM3_ExitCritical();
+		idle = (count == 0) ? idle + 1 : 0;
+	}
+
+	RLM3_UART_Deinit(RLM3_UART_4);
+	RLM3_Host_UART_SetRtsPin(UART4, nullptr, 0);
+	return total;
+}
+
+TEST_CASE(Host_UART4_SoftwareFlowControl_SlowConsumer)
+{
+	static uint8_t data[600];
+	static uint8_t received[sizeof(data)];
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t)(i * 7);
+	SlowConsumer consumer;
+
+	size_t unpaced = ReceiveWithSlowConsumer(RLM3_UART_FLOW_NONE, data, sizeof(data), received, &consumer);
+	ASSERT(consumer.dropped > 0);
+	ASSERT(unpaced + consumer.dropped == sizeof(data));
+
+	size_t paced = ReceiveWithSlowConsumer(RLM3_UART_FLOW_SOFTWARE, data, sizeof(data), received, &consumer);
+	ASSERT(consumer.dropped == 0);
+	ASSERT(paced == sizeof(data));
+	for (size_t i = 0; i < sizeof(data); i++)
+		ASSERT(received[i] == data[i]);
+
+	RLM3_UART_Counters counters;
+	RLM3_UART_GetCounters(RLM3_UART_4, &counters);
+	ASSERT(counters.pause_count > 0);
+	ASSERT(counters.overrun_count == 0);
+	ASSERT(!RLM3_UART_IsReceivePaused(RLM3_UART_4));
+	LOG_ALWAYS("UART4 slow consumer dropped %d without flow control, paused %d times with it", (int)(sizeof(data) - unpaced), (int)counters.pause_count);
+}
+
+static uint32_t ToCycles(uint64_t time_ns)
+{
+	return (uint32_t)((unsigned __int128)time_ns * HAL_RCC_GetHCLKFreq() / 1000000000ULL);
+}
+
+static bool IsNear(uint32_t cycles, uint32_t expected)
+{
+	// Within rounding of the character time.
+	int32_t difference = (int32_t)(cycles - expected);
+	return difference >= -2 && difference <= 2;
+}
+
+TEST_CASE(Host_UART2_ReceiveTimestamp_PPS)
+{
+	static uint8_t buffers[4][32];
+	static uint32_t queue_storage[RLM3_FRAME_DECODER_QUEUE_STORAGE_SIZE(4) / sizeof(uint32_t)];
+	static RLM3_FrameDecoder decoder;
+	RLM3_Host_SetSimulatedCycleCount(true);
+	RLM3_FrameDecoder_Init(&decoder, RLM3_FRAME_COBS, false, buffers, sizeof(buffers[0]), 4, queue_storage, sizeof(queue_storage));
+	RLM3_UART_Config config = { 115200, RLM3_FrameDecoder_UARTReceive, nullptr, RLM3_FrameDecoder_UARTError, &decoder };
+	RLM3_UART_Init(RLM3_UART_2, &config);
+
+	// The edges come a tick after a wakeup, so they are exactly a second apart.
+	RLM3_PPS pps;
+	RLM3_PPS_Init(&pps);
+	RLM3_Delay(1);
+	RLM3_Time edge_time = RLM3_GetCurrentTime();
+	RLM3_PPS_Edge(&pps, RLM3_GetCycleCount());
+	RLM3_DelayUntil(edge_time, 1000);
+	// Reading the time costs a kernel call on the way to the edge.
+	uint64_t edge_ns = RLM3_Host_GetTimeNs();
+	RLM3_PPS_Edge(&pps, RLM3_GetCycleCount());
+	RLM3_PPS_SetTime(&pps, 1234);
+	ASSERT(RLM3_PPS_IsLocked(&pps));
+
+	// Two frames as separate bursts 3 ms and 8 ms after the edge.
+	const uint8_t payloads[2][6] = { { 1, 2, 3, 4, 5, 6 }, { 7, 0, 9, 10, 11, 12 } };
+	uint64_t sent_ns[2];
+	size_t last_size = 0;
+	for (size_t i = 0; i < 2; i++)
+	{
+		uint8_t stream[16];
+		last_size = RLM3_Frame_Encode(RLM3_FRAME_COBS, false, payloads[i], sizeof(payloads[i]), stream, sizeof(stream));
+		RLM3_DelayUntil(RLM3_GetCurrentTime(), (i == 0) ? 3 : 5);
+		sent_ns[i] = RLM3_Host_GetTimeNs();
+		RLM3_Host_UART_Receive(USART2, stream, last_size);
+	}
+	RLM3_Delay(5);
+
+	RLM3_UART_Timestamp timestamp;
+	RLM3_UART_GetReceiveTimestamp(RLM3_UART_2, &timestamp);
+	ASSERT(timestamp.burst_count == 2);
+	ASSERT(timestamp.byte_index == last_size - 1);
+	ASSERT(IsNear(timestamp.burst_cycles, ToCycles(sent_ns[1])));
+	ASSERT(timestamp.byte_cycles - timestamp.burst_cycles > (last_size - 1) * (HAL_RCC_GetHCLKFreq() / 11600));
+
+	for (size_t i = 0; i < 2; i++)
+	{
+		RLM3_Frame frame;
+		ASSERT(RLM3_FrameDecoder_Take(&decoder, &frame, 0));
+		ASSERT(frame.size == sizeof(payloads[i]) && frame.data[0] == payloads[i][0]);
+		ASSERT(IsNear(frame.cycles, ToCycles(sent_ns[i])));
+		uint64_t gps_ns = 0;
+		ASSERT(RLM3_PPS_ToGpsTime(&pps, frame.cycles, &gps_ns));
+		int64_t error_ns = (int64_t)(gps_ns - 1234000000000ULL) - (int64_t)(sent_ns[i] - edge_ns);
+		ASSERT(error_ns >= -RLM3_HOST_KERNEL_CALL_NS && error_ns <= RLM3_HOST_KERNEL_CALL_NS);
+		RLM3_FrameDecoder_Return(&decoder, &frame);
+	}
+
+	RLM3_UART_Deinit(RLM3_UART_2);
+	RLM3_Host_SetSimulatedCycleCount(false);
+}
+
+TEST_CASE(Host_UART_Descriptors_HappyCase)
+{
+	struct Expected
+	{
+		RLM3_UART_ID id;
+		USART_TypeDef* uart;
+		IRQn_Type irq;
+		volatile uint32_t* clock_register;
+		uint32_t clock_bit;
+		uint32_t pclk_hz;
+		GPIO_TypeDef* tx_port;
+		size_t tx_pin;
+		GPIO_TypeDef* rx_port;
+		size_t rx_pin;
+		uint32_t alternate;
+	};
+	const Expected expected[] =
+	{
+		{ RLM3_UART_1, USART1, USART1_IRQn, &RCC->APB2ENR, RCC_APB2ENR_USART1EN, 90000000, GPIOA, 9, GPIOA, 10, 7 },
+		{ RLM3_UART_2, USART2, USART2_IRQn, &RCC->APB1ENR, RCC_APB1ENR_USART2EN, 45000000, GPIOA, 2, GPIOA, 3, 7 },
+		{ RLM3_UART_3, USART3, USART3_IRQn, &RCC->APB1ENR, RCC_APB1ENR_USART3EN, 45000000, GPIOB, 10, GPIOB, 11, 7 },
+		{ RLM3_UART_4, UART4, UART4_IRQn, &RCC->APB1ENR, RCC_APB1ENR_UART4EN, 45000000, GPIOA, 0, GPIOA, 1, 8 },
+		{ RLM3_UART_5, UART5, UART5_IRQn, &RCC->APB1ENR, RCC_APB1ENR_UART5EN, 45000000, GPIOC, 12, GPIOD, 2, 8 },
+		{ RLM3_UART_6, USART6, USART6_IRQn, &RCC->APB2ENR, RCC_APB2ENR_USART6EN, 90000000, GPIOC, 6, GPIOC, 7, 8 },
+		{ RLM3_UART_7, UART7, UART7_IRQn, &RCC->APB1ENR, RCC_APB1ENR_UART7EN, 45000000, GPIOF, 7, GPIOF, 6, 8 },
+		{ RLM3_UART_8, UART8, UART8_IRQn, &RCC->APB1ENR, RCC_APB1ENR_UART8EN, 45000000, GPIOE, 1, GPIOE, 0, 8 },
+	};
+	static_assert(sizeof(expected) / sizeof(expected[0]) == RLM3_UART_COUNT, "every port is checked");
+
+	struct Loopback
+	{
+		RLM3_UART_ID id;
+		RLM3_Task task;
+		uint8_t tx[4];
+		size_t tx_count;
+		uint8_t rx[4];
+		size_t rx_count;
+	};
+	auto receive_fn = [](RLM3_UART_ID id, uint8_t data, void* context)
+	{
+		Loopback* loopback = (Loopback*)context;
+		ASSERT(id == loopback->id);
+		if (loopback->rx_count < sizeof(loopback->rx))
+			loopback->rx[loopback->rx_count++] = data;
+		if (loopback->rx_count == sizeof(loopback->rx))
+			RLM3_GiveFromISR(loopback->task);
+	};
+	auto transmit_fn = [](RLM3_UART_ID id, uint8_t* data_to_send, void* context)
+	{
+		Loopback* loopback = (Loopback*)context;
+		ASSERT(id == loopback->id);
+		if (loopback->tx_count == sizeof(loopback->tx))
+			return false;
+		*data_to_send = loopback->tx[loopback->tx_count++];
+		return true;
+	};
+	auto error_fn = [](RLM3_UART_ID id, uint32_t status_flags, void* context)
+	{
+		g_error_flags |= status_flags;
+	};
+
+	for (const Expected& port : expected)
+	{
+		// Transmit is enabled with the interrupt, so the port is looped back before it starts.
+		Loopback loopback = { port.id, RLM3_GetCurrentTask(), { 0x55, (uint8_t)port.id, 0x00, 0xFF } };
+		RLM3_UART_Config config = { 115200, receive_fn, transmit_fn, error_fn, &loopback };
+		RLM3_Host_UART_SetLoopback(port.uart, true);
+		ASSERT(!RLM3_UART_IsInit(port.id));
+		RLM3_UART_Init(port.id, &config);
+		ASSERT(RLM3_UART_IsInit(port.id));
+
+		ASSERT((*port.clock_register & port.clock_bit) != 0);
+		ASSERT(RLM3_Host_IsIRQEnabled(port.irq));
+		ASSERT(((port.tx_port->MODER >> (2 * port.tx_pin)) & 0x3) == GPIO_MODE_AF_PP);
+		ASSERT(((port.rx_port->MODER >> (2 * port.rx_pin)) & 0x3) == GPIO_MODE_AF_PP);
+		ASSERT(((port.tx_port->AFR[port.tx_pin / 8] >> (4 * (port.tx_pin % 8))) & 0xF) == port.alternate);
+		ASSERT(((port.rx_port->AFR[port.rx_pin / 8] >> (4 * (port.rx_pin % 8))) & 0xF) == port.alternate);
+		uint32_t cr1_flags = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE | USART_CR1_RXNEIE;
+		ASSERT((port.uart->CR1 & cr1_flags) == cr1_flags);
+		ASSERT((port.uart->CR3 & USART_CR3_EIE) != 0);
+		ASSERT(port.uart->BRR == (port.pclk_hz + 115200 / 2) / 115200);
+		RLM3_UART_BaudInfo info;
+		RLM3_UART_GetBaudInfo(port.id, &info);
+		ASSERT(info.requested_baud_rate == 115200 && !info.is_oversample_8);
+		ASSERT(info.error_ppm > -1000 && info.error_ppm < 1000);
+		uint32_t actual_baud = RLM3_Host_UART_GetBaudRate(port.uart);
+		ASSERT(actual_baud >= 115200 - 1152 && actual_baud <= 115200 + 1152);
+
+		ASSERT(RLM3_TakeWithTimeout(10));
+		for (size_t i = 0; i < sizeof(loopback.tx); i++)
+			ASSERT(loopback.rx[i] == loopback.tx[i]);
+
+		RLM3_UART_Deinit(port.id);
+		RLM3_Host_UART_SetLoopback(port.uart, false);
+		uint8_t discard[8];
+		while (RLM3_Host_UART_TakeTransmitted(port.uart, discard, sizeof(discard)) > 0)
+			;
+		ASSERT(!RLM3_UART_IsInit(port.id));
+		ASSERT(!RLM3_Host_IsIRQEnabled(port.irq));
+		ASSERT(((port.tx_port->MODER >> (2 * port.tx_pin)) & 0x3) == GPIO_MODE_INPUT);
+		ASSERT(((port.rx_port->MODER >> (2 * port.rx_pin)) & 0x3) == GPIO_MODE_INPUT);
+	}
+	ASSERT(g_error_flags == 0);
+}
+
+static uint32_t GetDivisor(USART_TypeDef* uart)
+{
+	uint32_t brr = uart->BRR & (USART_BRR_DIV_Mantissa | USART_BRR_DIV_Fraction);
+	if ((uart->CR1 & USART_CR1_OVER8) == 0)
+		return brr;
+	ASSERT((brr & 0x8) == 0);
+	return 8 * (brr >> USART_BRR_DIV_Mantissa_Pos) + (brr & 0x7);
+}
+
+// Error of the divisor against the requested rate, scaled by every divisor it is compared with so none divides.
+static uint64_t GetScaledError(uint32_t pclk, uint32_t baud, uint32_t divisor)
+{
+	int64_t error = (int64_t)pclk - (int64_t)baud * divisor;
+	return (error < 0) ? -error : error;
+}
+
+TEST_CASE(Host_UART_BaudRate_Sweep)
+{
+	const uint32_t rates[] = { 9600, 19200, 38400, 57600, 115200, 230400, 250000, 460800, 921600, 1000000, 1500000,
+			2000000, 2500000, 3000000, 4000000, 4500000, 6000000, 7500000, 10500000, 11250000, 15000000, 22500000 };
+	// APB prescalers of 1, 2, 4, 8 and 16 put the bus clocks between 180 MHz and 11.25 MHz.
+	const uint32_t prescalers[] = { 0, 4, 5, 6, 7 };
+	const RLM3_UART_ID ports[] = { RLM3_UART_1, RLM3_UART_2 };
+	uint32_t saved_cfgr = RCC->CFGR;
+	size_t checked_count = 0;
+	size_t oversample_8_count = 0;
+
+	for (uint32_t prescaler : prescalers)
+	{
+		MODIFY_REG(RCC->CFGR, RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2, (prescaler << RCC_CFGR_PPRE1_Pos) | (prescaler << RCC_CFGR_PPRE2_Pos));
+		for (RLM3_UART_ID id : ports)
+		{
+			USART_TypeDef* uart = (id == RLM3_UART_1) ? USART1 : USART2;
+			uint32_t pclk = (id == RLM3_UART_1) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+			RLM3_UART_Config config = { 9600 };
+			RLM3_UART_Init(id, &config);
+
+			for (uint32_t rate : rates)
+			{
+				if (rate > pclk / 8)
+					continue;
+				RLM3_UART_SetBaudRate(id, rate);
+				RLM3_UART_BaudInfo info;
+				RLM3_UART_GetBaudInfo(id, &info);
+				uint32_t divisor = GetDivisor(uart);
+
+				// No neighbouring divisor is closer.  Neither oversampling mode has a finer step than one bus clock.
+				uint64_t error = GetScaledError(pclk, rate, divisor);
+				if (divisor > 8)
+					ASSERT(error * (divisor - 1) <= GetScaledError(pclk, rate, divisor - 1) * divisor);
+				if (divisor < 0xFFFF)
+					ASSERT(error * (divisor + 1) <= GetScaledError(pclk, rate, divisor + 1) * divisor);
+
+				ASSERT(info.is_oversample_8 == (divisor < 16));
+				ASSERT(((uart->CR1 & USART_CR1_OVER8) != 0) == info.is_oversample_8);
+				ASSERT(info.requested_baud_rate == rate);
+				ASSERT(info.actual_baud_rate == (pclk + divisor / 2) / divisor);
+				ASSERT(RLM3_Host_UART_GetBaudRate(uart) == pclk / divisor);
+				int64_t expected_ppm = ((int64_t)pclk - (int64_t)rate * divisor) * 1000000 / ((int64_t)rate * divisor);
+				ASSERT(info.error_ppm == expected_ppm);
+				checked_count++;
+				if (info.is_oversample_8)
+					oversample_8_count++;
+			}
+			RLM3_UART_Deinit(id);
+		}
+	}
+	RCC->CFGR = saved_cfgr;
+
+	ASSERT(checked_count > 100);
+	ASSERT(oversample_8_count > 0);
+}
+
+TEST_CASE(Host_UART_SetBaudRate_RuntimeChange)
+{
+	uint8_t first[8];
+	uint8_t second[26];
+	for (size_t i = 0; i < sizeof(first); i++)
+		first[i] = '0' + i;
+	for (size_t i = 0; i < sizeof(second); i++)
+		second[i] = 'A' + i;
+	RLM3_UART2_Init(115200);
+	uint32_t slow_baud = RLM3_Host_UART_GetBaudRate(USART2);
+
+	// The change waits for the bytes already queued to go out at the old rate.
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	StartTransmit(first, sizeof(first));
+	RLM3_UART_SetBaudRate(RLM3_UART_2, 3000000);
+	uint64_t first_ns = RLM3_Host_GetTimeNs() - start_ns;
+	ASSERT(first_ns >= 8ULL * 10 * 1000000000ULL / slow_baud);
+	ASSERT(RLM3_TakeWithTimeout(0));
+
+	RLM3_UART_BaudInfo info;
+	RLM3_UART_GetBaudInfo(RLM3_UART_2, &info);
+	ASSERT(info.requested_baud_rate == 3000000);
+	ASSERT(info.actual_baud_rate == 3000000);
+	ASSERT(info.error_ppm == 0);
+	ASSERT(info.is_oversample_8);
+	ASSERT(RLM3_UART2_IsInit());
+
+	start_ns = RLM3_Host_GetTimeNs();
+	StartTransmit(second, sizeof(second));
+	ASSERT(RLM3_TakeWithTimeout(10));
+	while ((USART2->SR & USART_SR_TC) == 0)
+		RLM3_Yield();
+	uint64_t second_ns = RLM3_Host_GetTimeNs() - start_ns;
+	RLM3_UART2_Deinit();
+
+	uint8_t sent[64];
+	ASSERT(RLM3_Host_UART_TakeTransmitted(USART2, sent, sizeof(sent)) == sizeof(first) + sizeof(second));
+	for (size_t i = 0; i < sizeof(first); i++)
+		ASSERT(sent[i] == first[i]);
+	for (size_t i = 0; i < sizeof(second); i++)
+		ASSERT(sent[sizeof(first) + i] == second[i]);
+	uint64_t expected_ns = 26ULL * 10 * 1000000000ULL / 3000000;
+	ASSERT(second_ns >= expected_ns && second_ns <= expected_ns + 20000);
+	ASSERT(g_error_flags == 0);
+}
+
+TEST_CASE(Host_UART2_Loopback_Benchmark)
+{
+	static const size_t COUNT = 4000;
+	static uint8_t g_tx[COUNT];
+	static uint8_t g_rx[COUNT];
+	for (size_t i = 0; i < COUNT; i++)
+		g_tx[i] = (uint8_t)(i * 7);
+
+	const uint32_t baud_rates[] = { 115200, 921600, 2812500 };
+	for (uint32_t baud_rate : baud_rates)
+	{
+		RLM3_UART2_Init(baud_rate);
+		RLM3_Host_UART_SetLoopback(USART2, true);
+
+		uint64_t start_ns = RLM3_Host_GetTimeNs();
+		uint64_t host_start_ns = GetHostNs();
+		ExpectReceive(g_rx, COUNT);
+		StartTransmit(g_tx, COUNT);
+		while (g_rx_size > 0)
+			ASSERT(RLM3_TakeWithTimeout(1000));
+		uint64_t host_ns = GetHostNs() - host_start_ns;
+		uint64_t elapsed_ns = RLM3_Host_GetTimeNs() - start_ns;
+		uint32_t actual_baud = RLM3_Host_UART_GetBaudRate(USART2);
+
+		RLM3_Host_UART_SetLoopback(USART2, false);
+		RLM3_UART2_Deinit();
+		uint8_t discard[64];
+		while (RLM3_Host_UART_TakeTransmitted(USART2, discard, sizeof(discard)) > 0)
+			;
+
+		for (size_t i = 0; i < COUNT; i++)
+			ASSERT(g_rx[i] == g_tx[i]);
+		ASSERT(g_error_flags == 0);
+
+		// The driver keeps the line busy, so the throughput is the line rate no matter how fast the host is.
+		uint64_t bytes_per_second = COUNT * 1000000000ULL / elapsed_ns;
+		uint64_t line_rate = actual_baud / 10;
+		LOG_ALWAYS("UART2 %u baud: %u bytes/s of %u, host %u ns per byte", (int)baud_rate, (int)bytes_per_second, (int)line_rate, (int)(host_ns / COUNT));
+		ASSERT(bytes_per_second * 100 >= line_rate * 99);
+	}
+}
+
+TEST_CASE(Host_Random_Benchmark)
+{
+	static const size_t SIZE = 4096;
+	static uint8_t g_buffer[SIZE];
+
+	RLM3_Random_Init();
+	uint64_t start_ns = RLM3_Host_GetTimeNs();
+	uint64_t host_start_ns = GetHostNs();
+	RLM3_Random_Get(g_buffer, SIZE);
+	uint64_t host_ns = GetHostNs() - host_start_ns;
+	uint64_t elapsed_ns = RLM3_Host_GetTimeNs() - start_ns;
+	RLM3_Random_Deinit();
+
+	LOG_ALWAYS("RNG: %u bytes/s, host %u ns per word", (int)(SIZE * 1000000000ULL / elapsed_ns), (int)(host_ns / (SIZE / 4)));
+	ASSERT(elapsed_ns >= SIZE / 4 * 840);
+}
+
+TEST_CASE(Host_Random_Fault)
+{
+	uint8_t buffer[64];
+	uint32_t fault_count = RLM3_Random_GetFaultCount();
+
+	// The fault is counted and the request still completes.
+	RLM3_Random_Init();
+	RLM3_Host_RNG_Fault(RNG_SR_SEIS);
+	RLM3_Random_Get(buffer, sizeof(buffer));
+	RLM3_Random_Deinit();
+
+	ASSERT(RLM3_Random_GetFaultCount() == fault_count + 1);
+}
+
+TEST_CASE(Host_Timer2_Benchmark)
+{
+	static volatile size_t g_count = 0;
+	g_count = 0;
+	SetTimer2Callback([] { g_count++; });
+
+	uint64_t host_start_ns = GetHostNs();
+	RLM3_Timer2_Init(100000);
+	RLM3_Delay(100);
+	RLM3_Timer2_Deinit();
+	uint64_t host_ns = GetHostNs() - host_start_ns;
+	SetTimer2Callback(nullptr);
+
+	LOG_ALWAYS("TIM2: %u update events, host %u ns per event", (int)g_count, (int)(host_ns / g_count));
+	ASSERT(g_count >= 10000 && g_count <= 10101);
+}
+
+TEST_TEARDOWN(Host_Peripherals_Cleanup)
+{
+	g_task = nullptr;
+	g_tx_buffer = nullptr;
+	g_tx_size = 0;
+	g_rx_buffer = nullptr;
+	g_rx_size = 0;
+	g_error_flags = 0;
+}
+
+
+extern void RLM3_UART2_ReceiveCallback(uint8_t data)
+{
+	if (g_rx_buffer != nullptr && g_rx_size != 0)
+	{
+		*(g_rx_buffer++) = data;
+		if (--g_rx_size == 0)
+		{
+			g_rx_buffer = nullptr;
+			RLM3_GiveFromISR(g_task);
+		}
+	}
+}
+
+extern bool RLM3_UART2_TransmitCallback(uint8_t* data_to_send)
+{
+	if (g_tx_buffer == nullptr || g_tx_size == 0)
+		return false;
+	*data_to_send = *(g_tx_buffer++);
+	if (--g_tx_size == 0)
+	{
+		g_tx_buffer = nullptr;
+		RLM3_GiveFromISR(g_task);
+	}
+	return true;
+}
+
+extern void RLM3_UART2_ErrorCallback(uint32_t status_flags)
+{
+	g_error_flags |= status_flags;
+}
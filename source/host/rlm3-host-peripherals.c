@@ -0,0 +1,797 @@
+#include "rlm3-host-peripherals.h"
+#include "rlm3-host.h"
+#include "stm32f4xx_hal.h"
+#include "Assert.h"
+
+
+#define UART_QUEUE_SIZE 4096
+#define UART_DR_UNWRITTEN 0x80000000U
+#define UART_RX_ERROR_FLAGS (USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE)
+#define RNG_WORD_NS 840 // 40 cycles of the 48 MHz RNG clock.
+#define TIM_CHANNEL_COUNT 4
+
+
+typedef uint32_t (*BusClockFn)();
+
+typedef struct
+{
+	USART_TypeDef* uart;
+	IRQn_Type irq;
+	volatile uint32_t* clock_register;
+	uint32_t clock_bit;
+	BusClockFn get_bus_clock;
+	RLM3_Host_Handler irq_handler;
+	RLM3_Host_Handler interrupt;
+
+	bool is_enabled;
+	uint32_t sr;
+	uint16_t rdr;
+	bool is_tdr_full;
+	uint16_t tdr;
+	bool is_shifting;
+	uint16_t shift;
+	uint64_t shift_end_ns;
+	bool is_loopback;
+	bool is_cts_deasserted;
+	GPIO_TypeDef* rts_port;
+	uint16_t rts_pin;
+	uint8_t rx_queue[UART_QUEUE_SIZE];
+	size_t rx_head;
+	size_t rx_count;
+	uint64_t rx_next_ns;
+	bool is_rx_held;
+	uint8_t tx_log[UART_QUEUE_SIZE];
+	size_t tx_head;
+	size_t tx_count;
+	uint64_t scheduled_ns;
+} UartModel;
+
+typedef struct
+{
+	TIM_TypeDef* timer;
+	IRQn_Type irq;
+	volatile uint32_t* clock_register;
+	uint32_t clock_bit;
+	RLM3_Host_Handler irq_handler;
+	RLM3_Host_Handler interrupt;
+
+	bool is_running;
+	uint32_t sr;
+	uint32_t cnt;
+	uint32_t published_cnt;
+	uint32_t arr;
+	uint32_t psc;
+	uint32_t clock_hz;
+	uint64_t origin_ns;
+	uint64_t consumed_ticks;
+	uint64_t scheduled_ns;
+} TimModel;
+
+typedef struct
+{
+	bool is_enabled;
+	uint32_t sr;
+	uint64_t ready_ns;
+	uint64_t seed;
+	uint64_t scheduled_ns;
+} RngModel;
+
+
+static const uint64_t NEVER = UINT64_MAX;
+
+extern void TIM2_IRQHandler(void);
+extern void USART1_IRQHandler(void);
+extern void USART2_IRQHandler(void);
+extern void USART3_IRQHandler(void);
+extern void UART4_IRQHandler(void);
+extern void UART5_IRQHandler(void);
+extern void USART6_IRQHandler(void);
+extern void UART7_IRQHandler(void);
+extern void UART8_IRQHandler(void);
+extern void HASH_RNG_IRQHandler(void);
+
+static void Tim2Interrupt();
+static void Usart1Interrupt();
+static void Usart2Interrupt();
+static void Usart3Interrupt();
+static void Uart4Interrupt();
+static void Uart5Interrupt();
+static void Usart6Interrupt();
+static void Uart7Interrupt();
+static void Uart8Interrupt();
+static void RngInterrupt();
+
+
+#define UART_RESET_STATE { .SR = USART_SR_TXE | USART_SR_TC, .DR = UART_DR_UNWRITTEN }
+
+TIM_TypeDef RLM3_Host_TIM2;
+USART_TypeDef RLM3_Host_USART1 = UART_RESET_STATE;
+USART_TypeDef RLM3_Host_USART2 = UART_RESET_STATE;
+USART_TypeDef RLM3_Host_USART3 = UART_RESET_STATE;
+USART_TypeDef RLM3_Host_UART4 = UART_RESET_STATE;
+USART_TypeDef RLM3_Host_UART5 = UART_RESET_STATE;
+USART_TypeDef RLM3_Host_USART6 = UART_RESET_STATE;
+USART_TypeDef RLM3_Host_UART7 = UART_RESET_STATE;
+USART_TypeDef RLM3_Host_UART8 = UART_RESET_STATE;
+RNG_TypeDef RLM3_Host_RNG;
+
+static TimModel g_tim2 = { TIM2, TIM2_IRQn, &RLM3_Host_RCC.APB1ENR, RCC_APB1ENR_TIM2EN, TIM2_IRQHandler, Tim2Interrupt };
+static UartModel g_uarts[] =
+{
+	{ USART1, USART1_IRQn, &RLM3_Host_RCC.APB2ENR, RCC_APB2ENR_USART1EN, HAL_RCC_GetPCLK2Freq, USART1_IRQHandler, Usart1Interrupt },
+	{ USART2, USART2_IRQn, &RLM3_Host_RCC.APB1ENR, RCC_APB1ENR_USART2EN, HAL_RCC_GetPCLK1Freq, USART2_IRQHandler, Usart2Interrupt },
+	{ USART3, USART3_IRQn, &RLM3_Host_RCC.APB1ENR, RCC_APB1ENR_USART3EN, HAL_RCC_GetPCLK1Freq, USART3_IRQHandler, Usart3Interrupt },
+	{ UART4, UART4_IRQn, &RLM3_Host_RCC.APB1ENR, RCC_APB1ENR_UART4EN, HAL_RCC_GetPCLK1Freq, UART4_IRQHandler, Uart4Interrupt },
+	{ UART5, UART5_IRQn, &RLM3_Host_RCC.APB1ENR, RCC_APB1ENR_UART5EN, HAL_RCC_GetPCLK1Freq, UART5_IRQHandler, Uart5Interrupt },
+	{ USART6, USART6_IRQn, &RLM3_Host_RCC.APB2ENR, RCC_APB2ENR_USART6EN, HAL_RCC_GetPCLK2Freq, USART6_IRQHandler, Usart6Interrupt },
+	{ UART7, UART7_IRQn, &RLM3_Host_RCC.APB1ENR, RCC_APB1ENR_UART7EN, HAL_RCC_GetPCLK1Freq, UART7_IRQHandler, Uart7Interrupt },
+	{ UART8, UART8_IRQn, &RLM3_Host_RCC.APB1ENR, RCC_APB1ENR_UART8EN, HAL_RCC_GetPCLK1Freq, UART8_IRQHandler, Uart8Interrupt },
+};
+static RngModel g_rng = { .seed = 0x2545F4914F6CDD1DULL };
+
+
+static void ScheduleLine(IRQn_Type irq, RLM3_Host_Handler interrupt, uint64_t* scheduled_ns, uint64_t now, uint64_t deadline)
+{
+	if (deadline == *scheduled_ns)
+		return;
+	*scheduled_ns = deadline;
+	if (deadline == NEVER)
+		RLM3_Host_CancelInterrupt(irq);
+	else
+		RLM3_Host_ScheduleInterrupt(irq, interrupt, (deadline > now) ? deadline - now : 0, 0);
+}
+
+
+static uint64_t UartGetFrameNs(const UartModel* model)
+{
+	// Start bit, data bits and stop bits, counted in half bits so 0.5 and 1.5 stop bits come out exact.
+	static const uint32_t STOP_HALF_BITS[4] = { 2, 1, 4, 3 };
+	USART_TypeDef* uart = model->uart;
+	uint32_t half_bits = 2 * (1 + (((uart->CR1 & USART_CR1_M) != 0) ? 9 : 8)) + STOP_HALF_BITS[(uart->CR2 & USART_CR2_STOP) >> USART_CR2_STOP_Pos];
+
+	// Either way the bit time is the BRR divisor in bus clocks.  With OVER8 the fraction has only three bits.
+	uint32_t brr = uart->BRR & (USART_BRR_DIV_Mantissa | USART_BRR_DIV_Fraction);
+	uint32_t divisor = brr;
+	if ((uart->CR1 & USART_CR1_OVER8) != 0)
+		divisor = 8 * (brr >> USART_BRR_DIV_Mantissa_Pos) + (brr & 0x7);
+	ASSERT(divisor != 0);
+	return ((uint64_t)half_bits * divisor * 1000000000ULL) / (2ULL * model->get_bus_clock());
+}
+
+static void UartReset(UartModel* model)
+{
+	model->sr = USART_SR_TXE | USART_SR_TC;
+	model->is_tdr_full = false;
+	model->is_shifting = false;
+	model->rx_count = 0;
+	model->is_rx_held = false;
+}
+
+static bool UartIsRtsDeasserted(const UartModel* model)
+{
+	// The UART's own RTS goes high while its data register is full.  Otherwise a pin the driver controls stands in.
+	if ((model->uart->CR3 & USART_CR3_RTSE) != 0)
+		return (model->sr & USART_SR_RXNE) != 0;
+	return model->rts_port != NULL && (model->rts_port->ODR & model->rts_pin) != 0;
+}
+
+static bool UartIsCtsBlocked(const UartModel* model)
+{
+	return (model->uart->CR3 & USART_CR3_CTSE) != 0 && model->is_cts_deasserted;
+}
+
+static void UartDeliver(UartModel* model, uint8_t data)
+{
+	if ((model->uart->CR1 & USART_CR1_RE) == 0)
+		return;
+	if ((model->sr & USART_SR_RXNE) != 0)
+	{
+		model->sr |= USART_SR_ORE;
+		return;
+	}
+	model->rdr = data;
+	model->sr |= USART_SR_RXNE;
+}
+
+static void UartStartShift(UartModel* model, uint64_t time)
+{
+	model->is_tdr_full = false;
+	model->is_shifting = true;
+	model->shift = model->tdr;
+	model->shift_end_ns = time + UartGetFrameNs(model);
+	model->sr |= USART_SR_TXE;
+	model->sr &= ~USART_SR_TC;
+}
+
+static void UartFinishShift(UartModel* model)
+{
+	model->is_shifting = false;
+	if (model->tx_count < UART_QUEUE_SIZE)
+		model->tx_log[(model->tx_head + model->tx_count++) % UART_QUEUE_SIZE] = (uint8_t)model->shift;
+	if (model->is_loopback)
+		UartDeliver(model, (uint8_t)model->shift);
+	if (model->is_tdr_full && !UartIsCtsBlocked(model))
+		UartStartShift(model, model->shift_end_ns);
+	else if (!model->is_tdr_full)
+		model->sr |= USART_SR_TC;
+}
+
+static void UartSync(UartModel* model, uint64_t now)
+{
+	USART_TypeDef* uart = model->uart;
+	bool is_enabled = ((*model->clock_register & model->clock_bit) != 0 && (uart->CR1 & USART_CR1_UE) != 0);
+	if (is_enabled != model->is_enabled)
+	{
+		model->is_enabled = is_enabled;
+		UartReset(model);
+	}
+	if (!is_enabled)
+	{
+		uart->DR = UART_DR_UNWRITTEN;
+		return;
+	}
+
+	// Software clears RXNE and TC by writing zero to them.  The other status bits ignore writes.
+	model->sr &= (uart->SR | ~(USART_SR_RXNE | USART_SR_TC));
+
+	// The model leaves a marker in DR, so any value without it was written by the driver.
+	uint32_t dr = uart->DR;
+	if ((dr & UART_DR_UNWRITTEN) == 0 && (uart->CR1 & USART_CR1_TE) != 0)
+	{
+		model->tdr = (uint16_t)(dr & 0x1FF);
+		model->is_tdr_full = true;
+		model->sr &= ~(USART_SR_TXE | USART_SR_TC);
+	}
+	// The transmitter checks CTS before each frame it starts.
+	if (model->is_tdr_full && !model->is_shifting && !UartIsCtsBlocked(model))
+		UartStartShift(model, now);
+
+	// The remote sender checks RTS the same way.  A byte it has started arrives whatever RTS does.
+	if (model->is_rx_held && !UartIsRtsDeasserted(model))
+	{
+		model->is_rx_held = false;
+		model->rx_next_ns = now + UartGetFrameNs(model);
+	}
+
+	while (true)
+	{
+		uint64_t tx_ns = model->is_shifting ? model->shift_end_ns : NEVER;
+		uint64_t rx_ns = (model->rx_count > 0 && !model->is_rx_held) ? model->rx_next_ns : NEVER;
+		if (tx_ns <= rx_ns && tx_ns <= now)
+			UartFinishShift(model);
+		else if (rx_ns <= now)
+		{
+			UartDeliver(model, model->rx_queue[model->rx_head]);
+			model->rx_head = (model->rx_head + 1) % UART_QUEUE_SIZE;
+			if (--model->rx_count > 0)
+			{
+				if (UartIsRtsDeasserted(model))
+					model->is_rx_held = true;
+				else
+					model->rx_next_ns += UartGetFrameNs(model);
+			}
+		}
+		else
+			break;
+	}
+
+	uart->SR = model->sr;
+	uart->DR = UART_DR_UNWRITTEN | model->rdr;
+}
+
+static bool UartIsPending(const UartModel* model)
+{
+	if (!model->is_enabled || !RLM3_Host_IsIRQEnabled(model->irq))
+		return false;
+	uint32_t cr1 = model->uart->CR1;
+	uint32_t sr = model->sr;
+	return ((sr & USART_SR_TXE) != 0 && (cr1 & USART_CR1_TXEIE) != 0) ||
+			((sr & USART_SR_TC) != 0 && (cr1 & USART_CR1_TCIE) != 0) ||
+			((sr & (USART_SR_RXNE | USART_SR_ORE)) != 0 && (cr1 & USART_CR1_RXNEIE) != 0) ||
+			((sr & (USART_SR_ORE | USART_SR_NE | USART_SR_FE)) != 0 && (model->uart->CR3 & USART_CR3_EIE) != 0) ||
+			((sr & USART_SR_PE) != 0 && (cr1 & USART_CR1_PEIE) != 0);
+}
+
+static void UartSchedule(UartModel* model, uint64_t now)
+{
+	uint64_t deadline = NEVER;
+	if (UartIsPending(model))
+		deadline = now;
+	else if (model->is_enabled)
+	{
+		if (model->is_shifting)
+			deadline = model->shift_end_ns;
+		if (model->rx_count > 0 && !model->is_rx_held && model->rx_next_ns < deadline)
+			deadline = model->rx_next_ns;
+	}
+	ScheduleLine(model->irq, model->interrupt, &model->scheduled_ns, now, deadline);
+}
+
+static void UartInterrupt(UartModel* model)
+{
+	model->scheduled_ns = NEVER;
+	uint64_t now = RLM3_Host_GetTimeNs();
+	UartSync(model, now);
+	if (UartIsPending(model))
+	{
+		model->irq_handler();
+		// Reading SR and then DR clears RXNE along with the error flags.
+		if ((model->uart->CR1 & USART_CR1_RXNEIE) != 0)
+		{
+			model->sr &= ~(USART_SR_RXNE | UART_RX_ERROR_FLAGS);
+			model->uart->SR &= ~(USART_SR_RXNE | UART_RX_ERROR_FLAGS);
+		}
+		UartSync(model, now);
+	}
+	UartSchedule(model, now);
+}
+
+static void Usart1Interrupt()
+{
+	UartInterrupt(&g_uarts[0]);
+}
+
+static void Usart2Interrupt()
+{
+	UartInterrupt(&g_uarts[1]);
+}
+
+static void Usart3Interrupt()
+{
+	UartInterrupt(&g_uarts[2]);
+}
+
+static void Uart4Interrupt()
+{
+	UartInterrupt(&g_uarts[3]);
+}
+
+static void Uart5Interrupt()
+{
+	UartInterrupt(&g_uarts[4]);
+}
+
+static void Usart6Interrupt()
+{
+	UartInterrupt(&g_uarts[5]);
+}
+
+static void Uart7Interrupt()
+{
+	UartInterrupt(&g_uarts[6]);
+}
+
+static void Uart8Interrupt()
+{
+	UartInterrupt(&g_uarts[7]);
+}
+
+static UartModel* FindUart(USART_TypeDef* uart)
+{
+	for (size_t i = 0; i < sizeof(g_uarts) / sizeof(g_uarts[0]); i++)
+		if (g_uarts[i].uart == uart)
+			return &g_uarts[i];
+	ASSERT(false);
+	return NULL;
+}
+
+
+static uint32_t TimGetClock()
+{
+	// APB1 timers run at twice the bus clock whenever the bus is divided.
+	uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+	return (pclk == HAL_RCC_GetHCLKFreq()) ? pclk : 2 * pclk;
+}
+
+static void TimRebase(TimModel* model, uint64_t now)
+{
+	model->origin_ns = now;
+	model->consumed_ticks = 0;
+	model->clock_hz = TimGetClock();
+}
+
+static uint64_t TimGetTicks(const TimModel* model, uint64_t now)
+{
+	unsigned __int128 scaled = (unsigned __int128)(now - model->origin_ns) * model->clock_hz;
+	return (uint64_t)(scaled / ((unsigned __int128)(model->psc + 1ULL) * 1000000000ULL));
+}
+
+static uint64_t TimGetTickTime(const TimModel* model, uint64_t ticks)
+{
+	// The first time at which the given number of ticks have passed since the origin.
+	unsigned __int128 scaled = (unsigned __int128)ticks * (model->psc + 1ULL) * 1000000000ULL;
+	return model->origin_ns + (uint64_t)((scaled + model->clock_hz - 1) / model->clock_hz);
+}
+
+static bool TimIsInput(const TimModel* model, size_t index)
+{
+	uint32_t ccmr = (index < 2) ? model->timer->CCMR1 : model->timer->CCMR2;
+	return ((ccmr >> (8 * (index % 2))) & TIM_CCMR1_CC1S) != 0;
+}
+
+static volatile uint32_t* TimGetCcr(const TimModel* model, size_t index)
+{
+	volatile uint32_t* ccr[TIM_CHANNEL_COUNT] = { &model->timer->CCR1, &model->timer->CCR2, &model->timer->CCR3, &model->timer->CCR4 };
+	return ccr[index];
+}
+
+static void TimCompare(TimModel* model, uint32_t from, uint64_t step)
+{
+	// An output compare channel matches when the counter moves onto its compare value.
+	for (size_t i = 0; i < TIM_CHANNEL_COUNT; i++)
+	{
+		uint32_t ccr = *TimGetCcr(model, i);
+		if (!TimIsInput(model, i) && ccr > from && ccr <= model->arr && (uint64_t)ccr <= from + step)
+			model->sr |= (TIM_SR_CC1IF << i);
+	}
+}
+
+static void TimUpdate(TimModel* model)
+{
+	model->cnt = 0;
+	model->arr = model->timer->ARR;
+	model->psc = model->timer->PSC;
+	model->sr |= TIM_SR_UIF;
+	for (size_t i = 0; i < TIM_CHANNEL_COUNT; i++)
+		if (!TimIsInput(model, i) && *TimGetCcr(model, i) == 0)
+			model->sr |= (TIM_SR_CC1IF << i);
+}
+
+static void TimAdvance(TimModel* model, uint64_t now)
+{
+	uint64_t ticks = TimGetTicks(model, now);
+	uint64_t elapsed = ticks - model->consumed_ticks;
+	model->consumed_ticks = ticks;
+	while (elapsed > 0)
+	{
+		uint64_t to_overflow = (uint64_t)model->arr - model->cnt + 1;
+		uint64_t step = (elapsed < to_overflow) ? elapsed : to_overflow;
+		TimCompare(model, model->cnt, step);
+		elapsed -= step;
+		if (step < to_overflow)
+		{
+			model->cnt += step;
+			continue;
+		}
+		uint32_t psc = model->psc;
+		TimUpdate(model);
+		if (model->psc != psc)
+		{
+			// The tick rate changed at the overflow.  Close enough to restart the count from here.
+			TimRebase(model, now);
+			break;
+		}
+	}
+}
+
+static void TimCapture(TimModel* model, size_t index)
+{
+	if (TimIsInput(model, index))
+	{
+		*TimGetCcr(model, index) = model->cnt;
+		if ((model->sr & (TIM_SR_CC1IF << index)) != 0)
+			model->sr |= (TIM_SR_CC1OF << index);
+	}
+	model->sr |= (TIM_SR_CC1IF << index);
+}
+
+static void TimSync(TimModel* model, uint64_t now)
+{
+	TIM_TypeDef* timer = model->timer;
+	if ((*model->clock_register & model->clock_bit) == 0)
+	{
+		model->is_running = false;
+		return;
+	}
+
+	// Every status flag is cleared by writing zero to it.
+	model->sr &= timer->SR;
+	if (timer->CNT != model->published_cnt)
+	{
+		model->cnt = timer->CNT;
+		TimRebase(model, now);
+	}
+
+	bool is_running = ((timer->CR1 & TIM_CR1_CEN) != 0);
+	if (is_running && model->is_running)
+		TimAdvance(model, now);
+	else
+		TimRebase(model, now);
+	model->is_running = is_running;
+
+	if ((timer->CR1 & TIM_CR1_ARPE) == 0)
+		model->arr = timer->ARR;
+	uint32_t egr = timer->EGR;
+	timer->EGR = 0;
+	if ((egr & TIM_EGR_UG) != 0)
+	{
+		TimUpdate(model);
+		TimRebase(model, now);
+	}
+	for (size_t i = 0; i < TIM_CHANNEL_COUNT; i++)
+		if ((egr & (TIM_EGR_CC1G << i)) != 0)
+			TimCapture(model, i);
+
+	timer->SR = model->sr;
+	timer->CNT = model->cnt;
+	model->published_cnt = model->cnt;
+}
+
+static bool TimIsPending(const TimModel* model)
+{
+	if ((*model->clock_register & model->clock_bit) == 0 || !RLM3_Host_IsIRQEnabled(model->irq))
+		return false;
+	uint32_t sources = TIM_SR_UIF | TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF;
+	return (model->sr & model->timer->DIER & sources) != 0;
+}
+
+static void TimSchedule(TimModel* model, uint64_t now)
+{
+	uint64_t deadline = NEVER;
+	if (TimIsPending(model))
+		deadline = now;
+	else if (model->is_running)
+	{
+		// Ticks until the next event with its interrupt enabled.
+		uint32_t dier = model->timer->DIER;
+		uint64_t to_overflow = (uint64_t)model->arr - model->cnt + 1;
+		uint64_t ticks = NEVER;
+		if ((dier & TIM_DIER_UIE) != 0)
+			ticks = to_overflow;
+		for (size_t i = 0; i < TIM_CHANNEL_COUNT; i++)
+		{
+			uint32_t ccr = *TimGetCcr(model, i);
+			if ((dier & (TIM_DIER_CC1IE << i)) == 0 || TimIsInput(model, i) || ccr > model->arr)
+				continue;
+			uint64_t to_match = (ccr > model->cnt) ? ccr - model->cnt : to_overflow + ccr;
+			if (to_match < ticks)
+				ticks = to_match;
+		}
+		if (ticks != NEVER)
+			deadline = TimGetTickTime(model, model->consumed_ticks + ticks);
+	}
+	ScheduleLine(model->irq, model->interrupt, &model->scheduled_ns, now, deadline);
+}
+
+static void TimInterrupt(TimModel* model)
+{
+	model->scheduled_ns = NEVER;
+	uint64_t now = RLM3_Host_GetTimeNs();
+	TimSync(model, now);
+	if (TimIsPending(model))
+	{
+		model->irq_handler();
+		// The handler reads the capture register of every input channel it has enabled, which clears its flag.
+		for (size_t i = 0; i < TIM_CHANNEL_COUNT; i++)
+			if (TimIsInput(model, i) && (model->timer->DIER & (TIM_DIER_CC1IE << i)) != 0)
+				model->timer->SR &= ~(TIM_SR_CC1IF << i);
+		TimSync(model, now);
+	}
+	TimSchedule(model, now);
+}
+
+static void Tim2Interrupt()
+{
+	TimInterrupt(&g_tim2);
+}
+
+
+static uint32_t RngNext(RngModel* model)
+{
+	// xorshift64* is plenty for a model, and a fixed seed keeps runs repeatable.
+	model->seed ^= model->seed >> 12;
+	model->seed ^= model->seed << 25;
+	model->seed ^= model->seed >> 27;
+	return (uint32_t)((model->seed * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static void RngSync(RngModel* model, uint64_t now)
+{
+	bool is_enabled = (RCC->AHB2ENR & RCC_AHB2ENR_RNGEN) != 0 && (RNG->CR & RNG_CR_RNGEN) != 0;
+	if (is_enabled && !model->is_enabled)
+		model->ready_ns = now + RNG_WORD_NS;
+	model->is_enabled = is_enabled;
+
+	// Software clears the error flags by writing zero to them.
+	model->sr &= (RNG->SR | ~(RNG_SR_CEIS | RNG_SR_SEIS));
+	if (is_enabled && (model->sr & RNG_SR_DRDY) == 0 && model->ready_ns <= now)
+	{
+		RNG->DR = RngNext(model);
+		model->sr |= RNG_SR_DRDY;
+	}
+	RNG->SR = model->sr;
+}
+
+static bool RngIsPending(const RngModel* model)
+{
+	if ((RCC->AHB2ENR & RCC_AHB2ENR_RNGEN) == 0 || !RLM3_Host_IsIRQEnabled(HASH_RNG_IRQn) || (RNG->CR & RNG_CR_IE) == 0)
+		return false;
+	return (model->sr & (RNG_SR_DRDY | RNG_SR_CEIS | RNG_SR_SEIS)) != 0;
+}
+
+static void RngSchedule(RngModel* model, uint64_t now)
+{
+	uint64_t deadline = NEVER;
+	if (RngIsPending(model))
+		deadline = now;
+	else if (model->is_enabled && (model->sr & RNG_SR_DRDY) == 0)
+		deadline = model->ready_ns;
+	ScheduleLine(HASH_RNG_IRQn, RngInterrupt, &model->scheduled_ns, now, deadline);
+}
+
+static void RngInterrupt()
+{
+	RngModel* model = &g_rng;
+	model->scheduled_ns = NEVER;
+	uint64_t now = RLM3_Host_GetTimeNs();
+	RngSync(model, now);
+	if (RngIsPending(model))
+	{
+		HASH_RNG_IRQHandler();
+		// The handler always reads DR, which starts the next word.
+		if ((model->sr & RNG_SR_DRDY) != 0)
+		{
+			model->sr &= ~RNG_SR_DRDY;
+			RNG->SR &= ~RNG_SR_DRDY;
+			model->ready_ns = now + RNG_WORD_NS;
+		}
+		RngSync(model, now);
+	}
+	RngSchedule(model, now);
+}
+
+
+extern void RLM3_Host_PollPeripherals()
+{
+	uint64_t now = RLM3_Host_GetTimeNs();
+	TimSync(&g_tim2, now);
+	TimSchedule(&g_tim2, now);
+	for (size_t i = 0; i < sizeof(g_uarts) / sizeof(g_uarts[0]); i++)
+	{
+		UartSync(&g_uarts[i], now);
+		UartSchedule(&g_uarts[i], now);
+	}
+	RngSync(&g_rng, now);
+	RngSchedule(&g_rng, now);
+}
+
+extern void RLM3_Host_UART_Receive(USART_TypeDef* uart, const uint8_t* data, size_t size)
+{
+	UartModel* model = FindUart(uart);
+	uint64_t now = RLM3_Host_GetTimeNs();
+	UartSync(model, now);
+	if (!model->is_enabled)
+		return;
+	for (size_t i = 0; i < size && model->rx_count < UART_QUEUE_SIZE; i++)
+	{
+		if (model->rx_count == 0)
+		{
+			model->is_rx_held = UartIsRtsDeasserted(model);
+			model->rx_next_ns = now + UartGetFrameNs(model);
+		}
+		model->rx_queue[(model->rx_head + model->rx_count++) % UART_QUEUE_SIZE] = data[i];
+	}
+	UartSchedule(model, now);
+}
+
+extern size_t RLM3_Host_UART_TakeTransmitted(USART_TypeDef* uart, uint8_t* buffer, size_t size)
+{
+	UartModel* model = FindUart(uart);
+	size_t count = 0;
+	for (; count < size && model->tx_count > 0; count++, model->tx_count--)
+	{
+		buffer[count] = model->tx_log[model->tx_head];
+		model->tx_head = (model->tx_head + 1) % UART_QUEUE_SIZE;
+	}
+	return count;
+}
+
+extern void RLM3_Host_UART_SetLoopback(USART_TypeDef* uart, bool is_loopback)
+{
+	FindUart(uart)->is_loopback = is_loopback;
+}
+
+extern void RLM3_Host_UART_SetCts(USART_TypeDef* uart, bool is_asserted)
+{
+	UartModel* model = FindUart(uart);
+	uint64_t now = RLM3_Host_GetTimeNs();
+	UartSync(model, now);
+	model->is_cts_deasserted = !is_asserted;
+	UartSync(model, now);
+	UartSchedule(model, now);
+}
+
+extern void RLM3_Host_UART_SetRtsPin(USART_TypeDef* uart, GPIO_TypeDef* port, uint16_t pin)
+{
+	UartModel* model = FindUart(uart);
+	model->rts_port = port;
+	model->rts_pin = pin;
+}
+
+extern uint32_t RLM3_Host_UART_GetBaudRate(USART_TypeDef* uart)
+{
+	UartModel* model = FindUart(uart);
+	if ((*model->clock_register & model->clock_bit) == 0 || (uart->CR1 & USART_CR1_UE) == 0)
+		return 0;
+	uint32_t brr = uart->BRR & (USART_BRR_DIV_Mantissa | USART_BRR_DIV_Fraction);
+	uint32_t divisor = brr;
+	if ((uart->CR1 & USART_CR1_OVER8) != 0)
+		divisor = 8 * (brr >> USART_BRR_DIV_Mantissa_Pos) + (brr & 0x7);
+	return (divisor == 0) ? 0 : model->get_bus_clock() / divisor;
+}
+
+extern void RLM3_Host_TIM_Capture(TIM_TypeDef* timer, size_t channel)
+{
+	ASSERT(timer == TIM2);
+	ASSERT(channel >= 1 && channel <= TIM_CHANNEL_COUNT);
+	TimModel* model = &g_tim2;
+	uint64_t now = RLM3_Host_GetTimeNs();
+	TimSync(model, now);
+	if (model->is_running && (timer->CCER & (TIM_CCER_CC1E << (4 * (channel - 1)))) != 0)
+		TimCapture(model, channel - 1);
+	timer->SR = model->sr;
+	TimSchedule(model, now);
+}
+
+extern void RLM3_Host_RNG_Fault(uint32_t flags)
+{
+	ASSERT(flags != 0 && (flags & ~(RNG_SR_CEIS | RNG_SR_SEIS)) == 0);
+	RngModel* model = &g_rng;
+	uint64_t now = RLM3_Host_GetTimeNs();
+	RngSync(model, now);
+	model->sr |= flags;
+	RNG->SR = model->sr;
+	RngSchedule(model, now);
+}
+
+
+// Interrupts nothing has claimed trap here, like the default handlers in the startup code.
+extern __weak void TIM2_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void USART1_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void USART2_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void USART3_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void UART4_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void UART5_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void USART6_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void UART7_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void UART8_IRQHandler(void)
+{
+	ASSERT(false);
+}
+
+extern __weak void HASH_RNG_IRQHandler(void)
+{
+	ASSERT(false);
+}
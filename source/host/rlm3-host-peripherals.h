@@ -0,0 +1,86 @@
+#pragma once
+
+#include "stm32f4xx.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Peripheral models behind the register blocks in stm32f427xx.h.  The kernel polls them at every preemption point and
+ * before the idle clock skips ahead.  A poll brings the registers up to the current simulated time, acts on what the
+ * driver wrote since the last poll and schedules the peripheral's interrupt line for its next event.  When the line
+ * fires, the model calls the driver's real IRQ handler if the NVIC line and one of the peripheral's interrupt sources
+ * are both enabled.
+ *
+ * A model cannot see register reads, so a flag the hardware clears when the driver reads a data register (RXNE, DRDY,
+ * an input capture flag) is treated as read once the IRQ handler has run.
+ */
+
+
+extern void RLM3_Host_PollPeripherals();
+extern bool RLM3_Host_IsIRQEnabled(IRQn_Type irq);
+// Called by the host GPIO HAL after a pin changes mode or level, so bus models can follow pins a driver bit-bangs.
+extern void RLM3_Host_GPIO_Changed(GPIO_TypeDef* port);
+
+// Queues bytes to arrive back to back on the RX line at the UART's configured frame rate.
+extern void RLM3_Host_UART_Receive(USART_TypeDef* uart, const uint8_t* data, size_t size);
+// Copies out and forgets the bytes that have finished shifting out on the TX line.  Returns how many were copied.
+extern size_t RLM3_Host_UART_TakeTransmitted(USART_TypeDef* uart, uint8_t* buffer, size_t size);
+// Connects the TX line back to the RX line.
+extern void RLM3_Host_UART_SetLoopback(USART_TypeDef* uart, bool is_loopback);
+// CTS from the remote end.  While it is deasserted and CTSE is set, the UART does not start another frame.
+extern void RLM3_Host_UART_SetCts(USART_TypeDef* uart, bool is_asserted);
+// The remote sender holds off its next frame while this pin is high.  With RTSE set, the UART's own RTS is used instead.
+extern void RLM3_Host_UART_SetRtsPin(USART_TypeDef* uart, GPIO_TypeDef* port, uint16_t pin);
+// The baud rate BRR produces at the current bus clock, or 0 while the UART is disabled.
+extern uint32_t RLM3_Host_UART_GetBaudRate(USART_TypeDef* uart);
+
+// An edge on an input capture channel (1 to 4).  It is captured if the channel is enabled as an input.
+extern void RLM3_Host_TIM_Capture(TIM_TypeDef* timer, size_t channel);
+
+// Raises the RNG clock or seed error flags (RNG_SR_CEIS, RNG_SR_SEIS) until the driver clears them.
+extern void RLM3_Host_RNG_Fault(uint32_t flags);
+
+/*
+ * The I2C1 model sits behind the HAL I2C calls in rlm3-host-i2c.c instead of registers.  A transfer takes its time on
+ * the wire at the handle's clock speed, then talks to the attached device and calls the HAL completion or error
+ * callback from the I2C1 event interrupt.  The device callbacks run in that interrupt, so they must not block.
+ */
+typedef struct
+{
+	bool (*start)(void* context, bool is_read); // Returns false to NACK the address.
+	bool (*write)(void* context, uint8_t data); // Returns false to NACK the byte.
+	uint8_t (*read)(void* context);
+	void (*stop)(void* context);
+	void* context;
+} RLM3_Host_I2C_Device;
+
+extern void RLM3_Host_I2C_Attach(uint8_t address, const RLM3_Host_I2C_Device* device);
+extern void RLM3_Host_I2C_Detach(uint8_t address);
+// The next transfer stalls with SDA held low by a slave, which lets go after that many SCL clocks from a bit-banged
+// recovery.  SIZE_MAX holds the bus until RLM3_Host_I2C_ReleaseBus.
+extern void RLM3_Host_I2C_StickBus(size_t release_clocks);
+extern bool RLM3_Host_I2C_IsBusStuck();
+extern void RLM3_Host_I2C_ReleaseBus();
+// The SCL rate CCR produces at the current bus clock, or 0 while I2C1 is disabled.
+extern uint32_t RLM3_Host_I2C_GetClockHz();
+// Another master wins the address phase of the next count transfers.
+extern void RLM3_Host_I2C_LoseArbitration(size_t count);
+
+// A 24-series EEPROM on I2C1, erased to 0xFF.  Data bytes are latched into the addressed page, wrapping at its end,
+// and written at the STOP.  The device then NACKs its address until the write cycle is over.  Reads run on through
+// the whole array.
+extern void RLM3_Host_EEPROM_Attach(uint8_t address, size_t capacity, size_t page_size, size_t address_size, uint32_t write_cycle_us);
+extern void RLM3_Host_EEPROM_Detach();
+extern uint8_t* RLM3_Host_EEPROM_GetMemory();
+extern size_t RLM3_Host_EEPROM_GetWriteCycleCount();
+extern size_t RLM3_Host_EEPROM_GetBusyNackCount();
+
+
+#ifdef __cplusplus
+}
+#endif
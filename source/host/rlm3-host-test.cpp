@@ -0,0 +1,98 @@
+#include "Test.hpp"
+#include "logger.h"
+#include "cmsis_os2.h"
+#include "rlm3-host.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static TestCase* g_first_test = nullptr;
+static TestCase** g_last_test = &g_first_test;
+static const char* g_current_test = nullptr;
+static TestTeardown* g_first_teardown = nullptr;
+
+
+TestCase::TestCase(const char* name, TestFn fn)
+	: m_name(name)
+	, m_fn(fn)
+	, m_next(nullptr)
+{
+	*g_last_test = this;
+	g_last_test = &m_next;
+}
+
+bool TestCase::RunAll()
+{
+	size_t count = 0;
+	for (TestCase* test = g_first_test; test != nullptr; test = test->m_next)
+	{
+		g_current_test = test->m_name;
+		printf("RUN  %s\n", test->m_name);
+		// Starts every case three quarters of the way through a tick.  The bounds in the timing tests hold for a case that
+		// starts late in a tick, the way it does on the board after the runner logs the case name.
+		osDelay(1);
+		while (RLM3_Host_GetTimeNs() % 1000000 < 750000)
+			osThreadYield();
+		test->m_fn();
+		TestTeardown::RunAll();
+		printf("PASS %s\n", test->m_name);
+		count++;
+	}
+	printf("All %u tests passed\n", (unsigned)count);
+	return true;
+}
+
+TestTeardown::TestTeardown(const char* name, TeardownFn fn)
+	: m_name(name)
+	, m_fn(fn)
+	, m_next(g_first_teardown)
+{
+	g_first_teardown = this;
+}
+
+void TestTeardown::RunAll()
+{
+	for (TestTeardown* teardown = g_first_teardown; teardown != nullptr; teardown = teardown->m_next)
+		teardown->m_fn();
+}
+
+
+extern "C" void ASSERT_FAILED(const char* file, int line)
+{
+	printf("FAIL %s at %s:%d\n", (g_current_test != nullptr) ? g_current_test : "(none)", file, line);
+	fflush(stdout);
+	_Exit(1);
+}
+
+extern "C" void HostLog(const char* zone, const char* level, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	printf("%s %s ", level, zone);
+	vprintf(format, args);
+	printf("\n");
+	va_end(args);
+}
+
+
+static void RunTests(void* argument)
+{
+	bool is_success = TestCase::RunAll();
+	fflush(stdout);
+	exit(is_success ? 0 : 1);
+}
+
+int main()
+{
+	setvbuf(stdout, nullptr, _IOLBF, 0);
+
+	osKernelInitialize();
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "test";
+	task_attributes.stack_size = 1024 * 4;
+	task_attributes.priority = osPriorityNormal;
+	osThreadNew(RunTests, nullptr, &task_attributes);
+	osKernelStart();
+	return 1;
+}
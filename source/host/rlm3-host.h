@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Host kernel used by the host-test build.  Every task is a pthread, but only the task that owns the simulated CPU
+ * runs.  The others wait on their own condition variable, so the FreeRTOS scheduling rules the drivers rely on (single
+ * core, strict priorities, round robin on yield, critical sections that hold off interrupts) still hold.  Tasks give up
+ * the CPU and take pending interrupts only inside kernel calls, so a loop that never calls into the kernel starves
+ * everything else.
+ *
+ * Time is simulated.  Each kernel call made by a task costs RLM3_HOST_KERNEL_CALL_NS, and when every task is blocked the
+ * clock skips ahead to the next interrupt or timeout.  Timing tests therefore behave the same under a profiler or
+ * valgrind as they do on an idle machine.
+ */
+
+
+#define RLM3_HOST_INTERRUPT_COUNT 96
+#define RLM3_HOST_KERNEL_CALL_NS 1000
+
+typedef void (*RLM3_Host_Handler)(void);
+
+// Simulated time since the kernel started.
+extern uint64_t RLM3_Host_GetTimeNs();
+// RLM3_GetCycleCount counts host CPU cycles so benchmarks measure the host.  Tests that check cycle timestamps against
+// simulated events switch it to simulated time at HCLK.  Simulated cycles only advance inside kernel calls, so code that
+// busy waits on the cycle counter, such as the I2C bus recovery, must not run while they are switched on.
+extern void RLM3_Host_SetSimulatedCycleCount(bool is_simulated);
+extern bool RLM3_Host_IsISR();
+
+// Raises the interrupt line after delay_ns, then every period_ns if the period is not zero.  Lower lines run first.
+extern void RLM3_Host_ScheduleInterrupt(size_t line, RLM3_Host_Handler handler, uint64_t delay_ns, uint64_t period_ns);
+extern void RLM3_Host_CancelInterrupt(size_t line);
+extern bool RLM3_Host_IsInterruptScheduled(size_t line);
+
+// Yields requested from interrupts with a task woken, and switches of the CPU from one task (or idle) to another.
+extern uint32_t RLM3_Host_GetYieldRequestCount();
+extern uint32_t RLM3_Host_GetContextSwitchCount();
+
+
+#ifdef __cplusplus
+}
+#endif
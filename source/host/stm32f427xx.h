@@ -0,0 +1,475 @@
+#pragma once
+
+#include <stdint.h>
+
+
+/*
+ * Register layouts and bit definitions for the host-test build.  The register blocks the drivers use are backed by the
+ * peripheral models in rlm3-host-peripherals.c instead of memory mapped hardware.  Only the blocks and bits the drivers
+ * touch are defined.
+ */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define __IO volatile
+
+typedef enum
+{
+	EXTI0_IRQn = 6,
+	EXTI1_IRQn = 7,
+	EXTI2_IRQn = 8,
+	EXTI3_IRQn = 9,
+	EXTI4_IRQn = 10,
+	EXTI9_5_IRQn = 23,
+	TIM2_IRQn = 28,
+	I2C1_EV_IRQn = 31,
+	I2C1_ER_IRQn = 32,
+	USART1_IRQn = 37,
+	USART2_IRQn = 38,
+	USART3_IRQn = 39,
+	EXTI15_10_IRQn = 40,
+	UART4_IRQn = 52,
+	UART5_IRQn = 53,
+	USART6_IRQn = 71,
+	HASH_RNG_IRQn = 80,
+	UART7_IRQn = 82,
+	UART8_IRQn = 83,
+} IRQn_Type;
+
+
+typedef struct
+{
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t SMCR;
+	__IO uint32_t DIER;
+	__IO uint32_t SR;
+	__IO uint32_t EGR;
+	__IO uint32_t CCMR1;
+	__IO uint32_t CCMR2;
+	__IO uint32_t CCER;
+	__IO uint32_t CNT;
+	__IO uint32_t PSC;
+	__IO uint32_t ARR;
+	__IO uint32_t RCR;
+	__IO uint32_t CCR1;
+	__IO uint32_t CCR2;
+	__IO uint32_t CCR3;
+	__IO uint32_t CCR4;
+	__IO uint32_t BDTR;
+	__IO uint32_t DCR;
+	__IO uint32_t DMAR;
+	__IO uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t SR;
+	__IO uint32_t DR;
+	__IO uint32_t BRR;
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t CR3;
+	__IO uint32_t GTPR;
+} USART_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t CR;
+	__IO uint32_t SR;
+	__IO uint32_t DR;
+} RNG_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t CR1;
+	__IO uint32_t CR2;
+	__IO uint32_t OAR1;
+	__IO uint32_t OAR2;
+	__IO uint32_t DR;
+	__IO uint32_t SR1;
+	__IO uint32_t SR2;
+	__IO uint32_t CCR;
+	__IO uint32_t TRISE;
+	__IO uint32_t FLTR;
+} I2C_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t MODER;
+	__IO uint32_t OTYPER;
+	__IO uint32_t OSPEEDR;
+	__IO uint32_t PUPDR;
+	__IO uint32_t IDR;
+	__IO uint32_t ODR;
+	__IO uint32_t BSRR;
+	__IO uint32_t LCKR;
+	__IO uint32_t AFR[2];
+} GPIO_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t IMR;
+	__IO uint32_t EMR;
+	__IO uint32_t RTSR;
+	__IO uint32_t FTSR;
+	__IO uint32_t SWIER;
+	__IO uint32_t PR;
+} EXTI_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t MEMRMP;
+	__IO uint32_t PMC;
+	__IO uint32_t EXTICR[4];
+	uint32_t RESERVED[2];
+	__IO uint32_t CMPCR;
+} SYSCFG_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t CR;
+	__IO uint32_t PLLCFGR;
+	__IO uint32_t CFGR;
+	__IO uint32_t CIR;
+	__IO uint32_t AHB1RSTR;
+	__IO uint32_t AHB2RSTR;
+	__IO uint32_t AHB3RSTR;
+	uint32_t RESERVED0;
+	__IO uint32_t APB1RSTR;
+	__IO uint32_t APB2RSTR;
+	uint32_t RESERVED1[2];
+	__IO uint32_t AHB1ENR;
+	__IO uint32_t AHB2ENR;
+	__IO uint32_t AHB3ENR;
+	uint32_t RESERVED2;
+	__IO uint32_t APB1ENR;
+	__IO uint32_t APB2ENR;
+	uint32_t RESERVED3[2];
+	__IO uint32_t AHB1LPENR;
+	__IO uint32_t AHB2LPENR;
+	__IO uint32_t AHB3LPENR;
+	uint32_t RESERVED4;
+	__IO uint32_t APB1LPENR;
+	__IO uint32_t APB2LPENR;
+	uint32_t RESERVED5[2];
+	__IO uint32_t BDCR;
+	__IO uint32_t CSR;
+	uint32_t RESERVED6[2];
+	__IO uint32_t SSCGR;
+	__IO uint32_t PLLI2SCFGR;
+	__IO uint32_t PLLSAICFGR;
+	__IO uint32_t DCKCFGR;
+} RCC_TypeDef;
+
+
+extern TIM_TypeDef RLM3_Host_TIM2;
+extern USART_TypeDef RLM3_Host_USART1;
+extern USART_TypeDef RLM3_Host_USART2;
+extern USART_TypeDef RLM3_Host_USART3;
+extern USART_TypeDef RLM3_Host_UART4;
+extern USART_TypeDef RLM3_Host_UART5;
+extern USART_TypeDef RLM3_Host_USART6;
+extern USART_TypeDef RLM3_Host_UART7;
+extern USART_TypeDef RLM3_Host_UART8;
+extern RNG_TypeDef RLM3_Host_RNG;
+extern I2C_TypeDef RLM3_Host_I2C1;
+// The ports sit one after another, as they do in the memory map, so a port's index follows from its address.
+extern GPIO_TypeDef RLM3_Host_GPIO[9];
+// EXTI and SYSCFG are plain registers.  Pin edges are not modelled, so the EXTI interrupts never fire.
+extern EXTI_TypeDef RLM3_Host_EXTI;
+extern SYSCFG_TypeDef RLM3_Host_SYSCFG;
+extern RCC_TypeDef RLM3_Host_RCC;
+
+#define TIM2 (&RLM3_Host_TIM2)
+#define USART1 (&RLM3_Host_USART1)
+#define USART2 (&RLM3_Host_USART2)
+#define USART3 (&RLM3_Host_USART3)
+#define UART4 (&RLM3_Host_UART4)
+#define UART5 (&RLM3_Host_UART5)
+#define USART6 (&RLM3_Host_USART6)
+#define UART7 (&RLM3_Host_UART7)
+#define UART8 (&RLM3_Host_UART8)
+#define RNG (&RLM3_Host_RNG)
+#define I2C1 (&RLM3_Host_I2C1)
+#define GPIOA (&RLM3_Host_GPIO[0])
+#define GPIOB (&RLM3_Host_GPIO[1])
+#define GPIOC (&RLM3_Host_GPIO[2])
+#define GPIOD (&RLM3_Host_GPIO[3])
+#define GPIOE (&RLM3_Host_GPIO[4])
+#define GPIOF (&RLM3_Host_GPIO[5])
+#define GPIOG (&RLM3_Host_GPIO[6])
+#define GPIOH (&RLM3_Host_GPIO[7])
+#define GPIOI (&RLM3_Host_GPIO[8])
+#define EXTI (&RLM3_Host_EXTI)
+#define SYSCFG (&RLM3_Host_SYSCFG)
+#define RCC (&RLM3_Host_RCC)
+
+
+#define TIM_CR1_CEN_Pos 0
+#define TIM_CR1_CEN (0x1U << TIM_CR1_CEN_Pos)
+#define TIM_CR1_UDIS_Pos 1
+#define TIM_CR1_UDIS (0x1U << TIM_CR1_UDIS_Pos)
+#define TIM_CR1_URS_Pos 2
+#define TIM_CR1_URS (0x1U << TIM_CR1_URS_Pos)
+#define TIM_CR1_OPM_Pos 3
+#define TIM_CR1_OPM (0x1U << TIM_CR1_OPM_Pos)
+#define TIM_CR1_DIR_Pos 4
+#define TIM_CR1_DIR (0x1U << TIM_CR1_DIR_Pos)
+#define TIM_CR1_CMS_Pos 5
+#define TIM_CR1_CMS (0x3U << TIM_CR1_CMS_Pos)
+#define TIM_CR1_ARPE_Pos 7
+#define TIM_CR1_ARPE (0x1U << TIM_CR1_ARPE_Pos)
+#define TIM_CR1_CKD_Pos 8
+#define TIM_CR1_CKD (0x3U << TIM_CR1_CKD_Pos)
+
+#define TIM_CR2_MMS_Pos 4
+#define TIM_CR2_MMS (0x7U << TIM_CR2_MMS_Pos)
+
+#define TIM_SMCR_SMS_Pos 0
+#define TIM_SMCR_SMS (0x7U << TIM_SMCR_SMS_Pos)
+#define TIM_SMCR_TS_Pos 4
+#define TIM_SMCR_TS (0x7U << TIM_SMCR_TS_Pos)
+#define TIM_SMCR_MSM_Pos 7
+#define TIM_SMCR_MSM (0x1U << TIM_SMCR_MSM_Pos)
+#define TIM_SMCR_ETF_Pos 8
+#define TIM_SMCR_ETF (0xFU << TIM_SMCR_ETF_Pos)
+#define TIM_SMCR_ETPS_Pos 12
+#define TIM_SMCR_ETPS (0x3U << TIM_SMCR_ETPS_Pos)
+#define TIM_SMCR_ECE_Pos 14
+#define TIM_SMCR_ECE (0x1U << TIM_SMCR_ECE_Pos)
+#define TIM_SMCR_ETP_Pos 15
+#define TIM_SMCR_ETP (0x1U << TIM_SMCR_ETP_Pos)
+
+#define TIM_DIER_UIE_Pos 0
+#define TIM_DIER_UIE (0x1U << TIM_DIER_UIE_Pos)
+#define TIM_DIER_CC1IE_Pos 1
+#define TIM_DIER_CC1IE (0x1U << TIM_DIER_CC1IE_Pos)
+#define TIM_DIER_CC2IE_Pos 2
+#define TIM_DIER_CC2IE (0x1U << TIM_DIER_CC2IE_Pos)
+#define TIM_DIER_CC3IE_Pos 3
+#define TIM_DIER_CC3IE (0x1U << TIM_DIER_CC3IE_Pos)
+#define TIM_DIER_CC4IE_Pos 4
+#define TIM_DIER_CC4IE (0x1U << TIM_DIER_CC4IE_Pos)
+
+#define TIM_SR_UIF_Pos 0
+#define TIM_SR_UIF (0x1U << TIM_SR_UIF_Pos)
+#define TIM_SR_CC1IF_Pos 1
+#define TIM_SR_CC1IF (0x1U << TIM_SR_CC1IF_Pos)
+#define TIM_SR_CC2IF_Pos 2
+#define TIM_SR_CC2IF (0x1U << TIM_SR_CC2IF_Pos)
+#define TIM_SR_CC3IF_Pos 3
+#define TIM_SR_CC3IF (0x1U << TIM_SR_CC3IF_Pos)
+#define TIM_SR_CC4IF_Pos 4
+#define TIM_SR_CC4IF (0x1U << TIM_SR_CC4IF_Pos)
+#define TIM_SR_CC1OF_Pos 9
+#define TIM_SR_CC1OF (0x1U << TIM_SR_CC1OF_Pos)
+#define TIM_SR_CC2OF_Pos 10
+#define TIM_SR_CC2OF (0x1U << TIM_SR_CC2OF_Pos)
+#define TIM_SR_CC3OF_Pos 11
+#define TIM_SR_CC3OF (0x1U << TIM_SR_CC3OF_Pos)
+#define TIM_SR_CC4OF_Pos 12
+#define TIM_SR_CC4OF (0x1U << TIM_SR_CC4OF_Pos)
+
+#define TIM_EGR_UG_Pos 0
+#define TIM_EGR_UG (0x1U << TIM_EGR_UG_Pos)
+#define TIM_EGR_CC1G_Pos 1
+#define TIM_EGR_CC1G (0x1U << TIM_EGR_CC1G_Pos)
+#define TIM_EGR_CC2G_Pos 2
+#define TIM_EGR_CC2G (0x1U << TIM_EGR_CC2G_Pos)
+#define TIM_EGR_CC3G_Pos 3
+#define TIM_EGR_CC3G (0x1U << TIM_EGR_CC3G_Pos)
+#define TIM_EGR_CC4G_Pos 4
+#define TIM_EGR_CC4G (0x1U << TIM_EGR_CC4G_Pos)
+
+#define TIM_CCMR1_CC1S_Pos 0
+#define TIM_CCMR1_CC1S (0x3U << TIM_CCMR1_CC1S_Pos)
+#define TIM_CCMR1_CC1S_0 (0x1U << TIM_CCMR1_CC1S_Pos)
+#define TIM_CCMR1_IC1PSC_Pos 2
+#define TIM_CCMR1_IC1PSC (0x3U << TIM_CCMR1_IC1PSC_Pos)
+#define TIM_CCMR1_IC1F_Pos 4
+#define TIM_CCMR1_IC1F (0xFU << TIM_CCMR1_IC1F_Pos)
+#define TIM_CCMR1_CC2S_Pos 8
+#define TIM_CCMR1_CC2S (0x3U << TIM_CCMR1_CC2S_Pos)
+#define TIM_CCMR1_CC2S_0 (0x1U << TIM_CCMR1_CC2S_Pos)
+#define TIM_CCMR1_IC2PSC_Pos 10
+#define TIM_CCMR1_IC2PSC (0x3U << TIM_CCMR1_IC2PSC_Pos)
+#define TIM_CCMR1_IC2F_Pos 12
+#define TIM_CCMR1_IC2F (0xFU << TIM_CCMR1_IC2F_Pos)
+
+#define TIM_CCMR2_CC3S_Pos 0
+#define TIM_CCMR2_CC3S (0x3U << TIM_CCMR2_CC3S_Pos)
+#define TIM_CCMR2_CC3S_0 (0x1U << TIM_CCMR2_CC3S_Pos)
+#define TIM_CCMR2_IC3PSC_Pos 2
+#define TIM_CCMR2_IC3PSC (0x3U << TIM_CCMR2_IC3PSC_Pos)
+#define TIM_CCMR2_IC3F_Pos 4
+#define TIM_CCMR2_IC3F (0xFU << TIM_CCMR2_IC3F_Pos)
+#define TIM_CCMR2_CC4S_Pos 8
+#define TIM_CCMR2_CC4S (0x3U << TIM_CCMR2_CC4S_Pos)
+#define TIM_CCMR2_CC4S_0 (0x1U << TIM_CCMR2_CC4S_Pos)
+#define TIM_CCMR2_IC4PSC_Pos 10
+#define TIM_CCMR2_IC4PSC (0x3U << TIM_CCMR2_IC4PSC_Pos)
+#define TIM_CCMR2_IC4F_Pos 12
+#define TIM_CCMR2_IC4F (0xFU << TIM_CCMR2_IC4F_Pos)
+
+#define TIM_CCER_CC1E_Pos 0
+#define TIM_CCER_CC1E (0x1U << TIM_CCER_CC1E_Pos)
+#define TIM_CCER_CC1P_Pos 1
+#define TIM_CCER_CC1P (0x1U << TIM_CCER_CC1P_Pos)
+#define TIM_CCER_CC1NP_Pos 3
+#define TIM_CCER_CC1NP (0x1U << TIM_CCER_CC1NP_Pos)
+
+#define USART_SR_PE_Pos 0
+#define USART_SR_PE (0x1U << USART_SR_PE_Pos)
+#define USART_SR_FE_Pos 1
+#define USART_SR_FE (0x1U << USART_SR_FE_Pos)
+#define USART_SR_NE_Pos 2
+#define USART_SR_NE (0x1U << USART_SR_NE_Pos)
+#define USART_SR_ORE_Pos 3
+#define USART_SR_ORE (0x1U << USART_SR_ORE_Pos)
+#define USART_SR_IDLE_Pos 4
+#define USART_SR_IDLE (0x1U << USART_SR_IDLE_Pos)
+#define USART_SR_RXNE_Pos 5
+#define USART_SR_RXNE (0x1U << USART_SR_RXNE_Pos)
+#define USART_SR_TC_Pos 6
+#define USART_SR_TC (0x1U << USART_SR_TC_Pos)
+#define USART_SR_TXE_Pos 7
+#define USART_SR_TXE (0x1U << USART_SR_TXE_Pos)
+#define USART_SR_CTS_Pos 9
+#define USART_SR_CTS (0x1U << USART_SR_CTS_Pos)
+
+#define USART_BRR_DIV_Fraction_Pos 0
+#define USART_BRR_DIV_Fraction (0xFU << USART_BRR_DIV_Fraction_Pos)
+#define USART_BRR_DIV_Mantissa_Pos 4
+#define USART_BRR_DIV_Mantissa (0xFFFU << USART_BRR_DIV_Mantissa_Pos)
+
+#define USART_CR1_RE_Pos 2
+#define USART_CR1_RE (0x1U << USART_CR1_RE_Pos)
+#define USART_CR1_TE_Pos 3
+#define USART_CR1_TE (0x1U << USART_CR1_TE_Pos)
+#define USART_CR1_IDLEIE_Pos 4
+#define USART_CR1_IDLEIE (0x1U << USART_CR1_IDLEIE_Pos)
+#define USART_CR1_RXNEIE_Pos 5
+#define USART_CR1_RXNEIE (0x1U << USART_CR1_RXNEIE_Pos)
+#define USART_CR1_TCIE_Pos 6
+#define USART_CR1_TCIE (0x1U << USART_CR1_TCIE_Pos)
+#define USART_CR1_TXEIE_Pos 7
+#define USART_CR1_TXEIE (0x1U << USART_CR1_TXEIE_Pos)
+#define USART_CR1_PEIE_Pos 8
+#define USART_CR1_PEIE (0x1U << USART_CR1_PEIE_Pos)
+#define USART_CR1_PS_Pos 9
+#define USART_CR1_PS (0x1U << USART_CR1_PS_Pos)
+#define USART_CR1_PCE_Pos 10
+#define USART_CR1_PCE (0x1U << USART_CR1_PCE_Pos)
+#define USART_CR1_M_Pos 12
+#define USART_CR1_M (0x1U << USART_CR1_M_Pos)
+#define USART_CR1_UE_Pos 13
+#define USART_CR1_UE (0x1U << USART_CR1_UE_Pos)
+#define USART_CR1_OVER8_Pos 15
+#define USART_CR1_OVER8 (0x1U << USART_CR1_OVER8_Pos)
+
+#define USART_CR2_CLKEN_Pos 11
+#define USART_CR2_CLKEN (0x1U << USART_CR2_CLKEN_Pos)
+#define USART_CR2_STOP_Pos 12
+#define USART_CR2_STOP (0x3U << USART_CR2_STOP_Pos)
+#define USART_CR2_LINEN_Pos 14
+#define USART_CR2_LINEN (0x1U << USART_CR2_LINEN_Pos)
+
+#define USART_CR3_EIE_Pos 0
+#define USART_CR3_EIE (0x1U << USART_CR3_EIE_Pos)
+#define USART_CR3_IREN_Pos 1
+#define USART_CR3_IREN (0x1U << USART_CR3_IREN_Pos)
+#define USART_CR3_HDSEL_Pos 3
+#define USART_CR3_HDSEL (0x1U << USART_CR3_HDSEL_Pos)
+#define USART_CR3_SCEN_Pos 5
+#define USART_CR3_SCEN (0x1U << USART_CR3_SCEN_Pos)
+#define USART_CR3_RTSE_Pos 8
+#define USART_CR3_RTSE (0x1U << USART_CR3_RTSE_Pos)
+#define USART_CR3_CTSE_Pos 9
+#define USART_CR3_CTSE (0x1U << USART_CR3_CTSE_Pos)
+#define USART_CR3_CTSIE_Pos 10
+#define USART_CR3_CTSIE (0x1U << USART_CR3_CTSIE_Pos)
+
+#define RNG_CR_RNGEN_Pos 2
+#define RNG_CR_RNGEN (0x1U << RNG_CR_RNGEN_Pos)
+#define RNG_CR_IE_Pos 3
+#define RNG_CR_IE (0x1U << RNG_CR_IE_Pos)
+
+#define RNG_SR_DRDY_Pos 0
+#define RNG_SR_DRDY (0x1U << RNG_SR_DRDY_Pos)
+#define RNG_SR_CECS_Pos 1
+#define RNG_SR_CECS (0x1U << RNG_SR_CECS_Pos)
+#define RNG_SR_SECS_Pos 2
+#define RNG_SR_SECS (0x1U << RNG_SR_SECS_Pos)
+#define RNG_SR_CEIS_Pos 5
+#define RNG_SR_CEIS (0x1U << RNG_SR_CEIS_Pos)
+#define RNG_SR_SEIS_Pos 6
+#define RNG_SR_SEIS (0x1U << RNG_SR_SEIS_Pos)
+
+#define I2C_CR1_PE_Pos 0
+#define I2C_CR1_PE (0x1U << I2C_CR1_PE_Pos)
+#define I2C_CR1_SWRST_Pos 15
+#define I2C_CR1_SWRST (0x1U << I2C_CR1_SWRST_Pos)
+#define I2C_CR2_FREQ_Pos 0
+#define I2C_CR2_FREQ (0x3FU << I2C_CR2_FREQ_Pos)
+#define I2C_CCR_CCR_Pos 0
+#define I2C_CCR_CCR (0xFFFU << I2C_CCR_CCR_Pos)
+#define I2C_CCR_DUTY_Pos 14
+#define I2C_CCR_DUTY (0x1U << I2C_CCR_DUTY_Pos)
+#define I2C_CCR_FS_Pos 15
+#define I2C_CCR_FS (0x1U << I2C_CCR_FS_Pos)
+#define I2C_TRISE_TRISE_Pos 0
+#define I2C_TRISE_TRISE (0x3FU << I2C_TRISE_TRISE_Pos)
+
+#define EXTI_PR_PR0 (0x1U << 0)
+#define EXTI_PR_PR1 (0x1U << 1)
+#define EXTI_PR_PR2 (0x1U << 2)
+#define EXTI_PR_PR3 (0x1U << 3)
+#define EXTI_PR_PR4 (0x1U << 4)
+#define EXTI_PR_PR5 (0x1U << 5)
+#define EXTI_PR_PR6 (0x1U << 6)
+#define EXTI_PR_PR7 (0x1U << 7)
+#define EXTI_PR_PR8 (0x1U << 8)
+#define EXTI_PR_PR9 (0x1U << 9)
+#define EXTI_PR_PR10 (0x1U << 10)
+#define EXTI_PR_PR11 (0x1U << 11)
+#define EXTI_PR_PR12 (0x1U << 12)
+#define EXTI_PR_PR13 (0x1U << 13)
+#define EXTI_PR_PR14 (0x1U << 14)
+#define EXTI_PR_PR15 (0x1U << 15)
+
+#define RCC_CFGR_PPRE1_Pos 10
+#define RCC_CFGR_PPRE1 (0x7U << RCC_CFGR_PPRE1_Pos)
+#define RCC_CFGR_PPRE2_Pos 13
+#define RCC_CFGR_PPRE2 (0x7U << RCC_CFGR_PPRE2_Pos)
+#define RCC_DCKCFGR_TIMPRE_Pos 24
+#define RCC_DCKCFGR_TIMPRE (0x1U << RCC_DCKCFGR_TIMPRE_Pos)
+
+#define RCC_AHB1ENR_GPIOAEN (0x1U << 0)
+#define RCC_AHB1ENR_GPIOBEN (0x1U << 1)
+#define RCC_AHB1ENR_GPIOCEN (0x1U << 2)
+#define RCC_AHB1ENR_GPIODEN (0x1U << 3)
+#define RCC_AHB1ENR_GPIOEEN (0x1U << 4)
+#define RCC_AHB1ENR_GPIOFEN (0x1U << 5)
+#define RCC_AHB1ENR_GPIOGEN (0x1U << 6)
+#define RCC_AHB2ENR_RNGEN (0x1U << 6)
+#define RCC_APB1ENR_TIM2EN (0x1U << 0)
+#define RCC_APB1ENR_USART2EN (0x1U << 17)
+#define RCC_APB1ENR_USART3EN (0x1U << 18)
+#define RCC_APB1ENR_UART4EN (0x1U << 19)
+#define RCC_APB1ENR_UART5EN (0x1U << 20)
+#define RCC_APB1ENR_I2C1EN (0x1U << 21)
+#define RCC_APB1ENR_UART7EN (0x1U << 30)
+#define RCC_APB1ENR_UART8EN (0x1U << 31)
+#define RCC_APB2ENR_USART1EN (0x1U << 4)
+#define RCC_APB2ENR_USART6EN (0x1U << 5)
+#define RCC_APB2ENR_SYSCFGEN (0x1U << 14)
+
+
+#ifdef __cplusplus
+}
+#endif
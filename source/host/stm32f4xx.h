@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "rlm3-host.h"
+#include "stm32f427xx.h"
+
+
+/*
+ * Stands in for the CMSIS device header in the host-test build.
+ */
+
+
+#define __weak __attribute__((weak))
+
+#define SET_BIT(REG, BIT) ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT) ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT) ((REG) & (BIT))
+#define CLEAR_REG(REG) ((REG) = (0x0))
+#define WRITE_REG(REG, VAL) ((REG) = (VAL))
+#define READ_REG(REG) ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+static inline uint32_t __get_IPSR()
+{
+	return RLM3_Host_IsISR() ? 16 : 0;
+}
+
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "stm32f4xx.h"
+
+
+/*
+ * The part of the HAL the drivers call, for the host-test build.  The functions write the same registers the real HAL
+ * does, so the peripheral models see the same sequence of register writes they would on the board.  Pins are not
+ * modelled.
+ */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef enum
+{
+	HAL_OK = 0x00,
+	HAL_ERROR = 0x01,
+	HAL_BUSY = 0x02,
+	HAL_TIMEOUT = 0x03,
+} HAL_StatusTypeDef;
+
+
+// The board runs a 180 MHz core clock with APB1 divided by 4, so the APB1 timers run at 90 MHz.
+#define RLM3_HOST_HCLK_HZ 180000000
+
+extern const uint8_t APBPrescTable[8];
+extern uint32_t HAL_RCC_GetHCLKFreq();
+extern uint32_t HAL_RCC_GetPCLK1Freq();
+extern uint32_t HAL_RCC_GetPCLK2Freq();
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE() SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPIOAEN)
+#define __HAL_RCC_GPIOB_CLK_ENABLE() SET_BIT(RCC->AHB1ENR, RCC_AHB1ENR_GPIOBEN)
+#define __HAL_RCC_RNG_CLK_ENABLE() SET_BIT(RCC->AHB2ENR, RCC_AHB2ENR_RNGEN)
+#define __HAL_RCC_RNG_CLK_DISABLE() CLEAR_BIT(RCC->AHB2ENR, RCC_AHB2ENR_RNGEN)
+#define __HAL_RCC_RNG_IS_CLK_ENABLED() (READ_BIT(RCC->AHB2ENR, RCC_AHB2ENR_RNGEN) != 0)
+#define __HAL_RCC_TIM2_CLK_ENABLE() SET_BIT(RCC->APB1ENR, RCC_APB1ENR_TIM2EN)
+#define __HAL_RCC_TIM2_CLK_DISABLE() CLEAR_BIT(RCC->APB1ENR, RCC_APB1ENR_TIM2EN)
+#define __HAL_RCC_TIM2_IS_CLK_ENABLED() (READ_BIT(RCC->APB1ENR, RCC_APB1ENR_TIM2EN) != 0)
+#define __HAL_RCC_I2C1_CLK_ENABLE() SET_BIT(RCC->APB1ENR, RCC_APB1ENR_I2C1EN)
+#define __HAL_RCC_I2C1_CLK_DISABLE() CLEAR_BIT(RCC->APB1ENR, RCC_APB1ENR_I2C1EN)
+#define __HAL_RCC_USART2_CLK_ENABLE() SET_BIT(RCC->APB1ENR, RCC_APB1ENR_USART2EN)
+#define __HAL_RCC_USART2_CLK_DISABLE() CLEAR_BIT(RCC->APB1ENR, RCC_APB1ENR_USART2EN)
+#define __HAL_RCC_USART2_IS_CLK_ENABLED() (READ_BIT(RCC->APB1ENR, RCC_APB1ENR_USART2EN) != 0)
+#define __HAL_RCC_UART4_CLK_ENABLE() SET_BIT(RCC->APB1ENR, RCC_APB1ENR_UART4EN)
+#define __HAL_RCC_UART4_CLK_DISABLE() CLEAR_BIT(RCC->APB1ENR, RCC_APB1ENR_UART4EN)
+#define __HAL_RCC_UART4_IS_CLK_ENABLED() (READ_BIT(RCC->APB1ENR, RCC_APB1ENR_UART4EN) != 0)
+#define __HAL_RCC_SYSCFG_CLK_ENABLE() SET_BIT(RCC->APB2ENR, RCC_APB2ENR_SYSCFGEN)
+
+
+extern void HAL_NVIC_SetPriority(IRQn_Type irq, uint32_t preempt_priority, uint32_t sub_priority);
+extern void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+extern void HAL_NVIC_DisableIRQ(IRQn_Type irq);
+
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+#define GPIO_MODE_INPUT 0x00000000U
+#define GPIO_MODE_OUTPUT_PP 0x00000001U
+#define GPIO_MODE_OUTPUT_OD 0x00000011U
+#define GPIO_MODE_AF_PP 0x00000002U
+#define GPIO_MODE_AF_OD 0x00000012U
+#define GPIO_NOPULL 0x00000000U
+#define GPIO_PULLUP 0x00000001U
+#define GPIO_SPEED_FREQ_LOW 0x00000000U
+#define GPIO_SPEED_FREQ_VERY_HIGH 0x00000003U
+#define GPIO_AF4_I2C1 ((uint8_t)0x04)
+#define GPIO_AF7_USART1 ((uint8_t)0x07)
+#define GPIO_AF7_USART2 ((uint8_t)0x07)
+#define GPIO_AF7_USART3 ((uint8_t)0x07)
+#define GPIO_AF8_UART4 ((uint8_t)0x08)
+#define GPIO_AF8_UART5 ((uint8_t)0x08)
+#define GPIO_AF8_USART6 ((uint8_t)0x08)
+#define GPIO_AF8_UART7 ((uint8_t)0x08)
+#define GPIO_AF8_UART8 ((uint8_t)0x08)
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET,
+} GPIO_PinState;
+
+typedef struct
+{
+	uint32_t Pin;
+	uint32_t Mode;
+	uint32_t Pull;
+	uint32_t Speed;
+	uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+extern void HAL_GPIO_Init(GPIO_TypeDef* port, GPIO_InitTypeDef* init);
+extern void HAL_GPIO_DeInit(GPIO_TypeDef* port, uint32_t pins);
+extern void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+extern GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* port, uint16_t pin);
+
+
+#define TIM_COUNTERMODE_UP 0x00000000U
+#define TIM_CLOCKDIVISION_DIV1 0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_DISABLE 0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_ENABLE TIM_CR1_ARPE
+#define TIM_CLOCKSOURCE_INTERNAL (0x1U << TIM_SMCR_ETPS_Pos)
+#define TIM_TRGO_RESET 0x00000000U
+#define TIM_MASTERSLAVEMODE_DISABLE 0x00000000U
+#define TIM_IT_UPDATE TIM_DIER_UIE
+
+typedef enum
+{
+	HAL_TIM_STATE_RESET = 0x00,
+	HAL_TIM_STATE_READY = 0x01,
+	HAL_TIM_STATE_BUSY = 0x02,
+} HAL_TIM_StateTypeDef;
+
+typedef struct
+{
+	uint32_t Prescaler;
+	uint32_t CounterMode;
+	uint32_t Period;
+	uint32_t ClockDivision;
+	uint32_t RepetitionCounter;
+	uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+	TIM_TypeDef* Instance;
+	TIM_Base_InitTypeDef Init;
+	volatile HAL_TIM_StateTypeDef State;
+} TIM_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t ClockSource;
+	uint32_t ClockPolarity;
+	uint32_t ClockPrescaler;
+	uint32_t ClockFilter;
+} TIM_ClockConfigTypeDef;
+
+typedef struct
+{
+	uint32_t MasterOutputTrigger;
+	uint32_t MasterSlaveMode;
+} TIM_MasterConfigTypeDef;
+
+extern HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef* htim);
+extern HAL_StatusTypeDef HAL_TIM_Base_DeInit(TIM_HandleTypeDef* htim);
+extern HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim);
+extern HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim);
+extern HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef* htim, TIM_ClockConfigTypeDef* config);
+extern HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef* htim, TIM_MasterConfigTypeDef* config);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "stm32f4xx_hal.h"
+
+
+/*
+ * The interrupt driven master calls of the HAL I2C driver, for the host-test build.  They run against the bus model in
+ * rlm3-host-i2c.c rather than registers, because the HAL's own I2C interrupt handling is what the driver relies on.
+ */
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define I2C_DUTYCYCLE_2 0x00000000U
+#define I2C_DUTYCYCLE_16_9 0x00004000U
+#define I2C_ADDRESSINGMODE_7BIT 0x00004000U
+#define I2C_DUALADDRESS_DISABLE 0x00000000U
+#define I2C_GENERALCALL_DISABLE 0x00000000U
+#define I2C_NOSTRETCH_DISABLE 0x00000000U
+
+#define I2C_FIRST_FRAME 0x00000001U
+#define I2C_FIRST_AND_NEXT_FRAME 0x00000002U
+#define I2C_NEXT_FRAME 0x00000004U
+#define I2C_FIRST_AND_LAST_FRAME 0x00000008U
+#define I2C_LAST_FRAME_NO_STOP 0x00000010U
+#define I2C_LAST_FRAME 0x00000020U
+
+#define HAL_I2C_ERROR_NONE 0x00000000U
+#define HAL_I2C_ERROR_BERR 0x00000001U
+#define HAL_I2C_ERROR_ARLO 0x00000002U
+#define HAL_I2C_ERROR_AF 0x00000004U
+#define HAL_I2C_ERROR_OVR 0x00000008U
+#define HAL_I2C_ERROR_TIMEOUT 0x00000020U
+
+typedef enum
+{
+	HAL_I2C_STATE_RESET = 0x00,
+	HAL_I2C_STATE_READY = 0x20,
+	HAL_I2C_STATE_BUSY = 0x24,
+	HAL_I2C_STATE_BUSY_TX = 0x21,
+	HAL_I2C_STATE_BUSY_RX = 0x22,
+	HAL_I2C_STATE_ERROR = 0xE0,
+} HAL_I2C_StateTypeDef;
+
+typedef struct
+{
+	uint32_t ClockSpeed;
+	uint32_t DutyCycle;
+	uint32_t OwnAddress1;
+	uint32_t AddressingMode;
+	uint32_t DualAddressMode;
+	uint32_t OwnAddress2;
+	uint32_t GeneralCallMode;
+	uint32_t NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef struct
+{
+	I2C_TypeDef* Instance;
+	I2C_InitTypeDef Init;
+	uint8_t* pBuffPtr;
+	uint16_t XferSize;
+	uint32_t XferOptions;
+	uint16_t Devaddress;
+	volatile HAL_I2C_StateTypeDef State;
+	volatile uint32_t ErrorCode;
+} I2C_HandleTypeDef;
+
+extern HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef* hi2c);
+extern HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef* hi2c);
+extern HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size);
+extern HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size);
+extern HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size, uint32_t XferOptions);
+extern HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef* hi2c, uint16_t DevAddress, uint8_t* pData, uint16_t Size, uint32_t XferOptions);
+extern HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef* hi2c);
+extern uint32_t HAL_I2C_GetError(I2C_HandleTypeDef* hi2c);
+
+extern void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef* hi2c);
+extern void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef* hi2c);
+extern void HAL_I2C_ErrorCallback(I2C_HandleTypeDef* hi2c);
+
+
+#ifdef __cplusplus
+}
+#endif
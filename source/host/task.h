@@ -0,0 +1,67 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+typedef struct tskTaskControlBlock* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef enum
+{
+	eNoAction = 0,
+	eSetBits,
+	eIncrement,
+	eSetValueWithOverwrite,
+	eSetValueWithoutOverwrite,
+} eNotifyAction;
+
+#define taskSCHEDULER_SUSPENDED ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING ((BaseType_t)2)
+
+#define tskKERNEL_VERSION_MAJOR 10
+#define tskKERNEL_VERSION_MINOR 4
+#define tskKERNEL_VERSION_BUILD 3
+
+#define tskIDLE_PRIORITY ((UBaseType_t)0)
+
+extern BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth, void* parameters, UBaseType_t priority, TaskHandle_t* created_task);
+extern void vTaskDelete(TaskHandle_t task);
+extern void vTaskStartScheduler();
+extern BaseType_t xTaskGetSchedulerState();
+
+extern TickType_t xTaskGetTickCount();
+extern TickType_t xTaskGetTickCountFromISR();
+extern void vTaskDelay(TickType_t ticks);
+extern void vTaskDelayUntil(TickType_t* previous_wake_time, TickType_t increment);
+extern void vPortYield();
+
+extern TaskHandle_t xTaskGetCurrentTaskHandle();
+extern void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value);
+extern void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index);
+
+extern BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+extern BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* higher_priority_task_woken);
+extern BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value_out, TickType_t ticks_to_wait);
+extern BaseType_t xTaskNotifyStateClear(TaskHandle_t task);
+extern uint32_t ulTaskNotifyValueClear(TaskHandle_t task, uint32_t bits_to_clear);
+
+extern void vTaskEnterCritical();
+extern void vTaskExitCritical();
+extern UBaseType_t ulPortSetInterruptMaskFromISR();
+extern void vPortClearInterruptMaskFromISR(UBaseType_t saved_level);
+
+#define taskYIELD() vPortYield()
+#define taskENTER_CRITICAL() vTaskEnterCritical()
+#define taskEXIT_CRITICAL() vTaskExitCritical()
+#define taskENTER_CRITICAL_FROM_ISR() ulPortSetInterruptMaskFromISR()
+#define taskEXIT_CRITICAL_FROM_ISR(x) vPortClearInterruptMaskFromISR(x)
+
+
+#ifdef __cplusplus
+}
+#endif
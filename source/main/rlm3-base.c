@@ -4,6 +4,14 @@
 #include "task.h"
 
 
+static __attribute__((constructor)) void Init_CycleCount()
+{
+	// Started once before main and never reset, so every reader sees the same running count.
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+
 extern bool RLM3_IsIRQ()
 {
 	return (__get_IPSR() != 0U);
@@ -60,3 +68,7 @@ extern uint32_t RLM3_GetUniqueDeviceShortId()
 	return hash;
 }
 
+extern uint32_t RLM3_GetCycleCount()
+{
+	return DWT->CYCCNT;
+}
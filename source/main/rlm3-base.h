@@ -20,6 +20,9 @@ extern bool RLM3_DebugOutputFromISR(uint8_t c);
 extern void RLM3_GetUniqueDeviceId(uint8_t id_out[12]);
 extern uint32_t RLM3_GetUniqueDeviceShortId();
 
+// Core clock cycles from the DWT cycle counter, which runs from before main and wraps every 2^32 cycles.
+extern uint32_t RLM3_GetCycleCount();
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,87 @@
+#include "rlm3-capture.h"
+#include "Assert.h"
+
+
+extern void RLM3_Capture_Init(RLM3_Capture* capture)
+{
+	ASSERT(capture != NULL);
+
+	for (size_t i = 0; i < RLM3_CAPTURE_BATCH_COUNT; i++)
+		capture->batches[i].count = 0;
+	capture->head = 0;
+	capture->tail = 0;
+	capture->high = 0;
+	capture->dropped_count = 0;
+}
+
+extern uint64_t RLM3_Capture_ExtendTimestamp(uint32_t high, uint32_t captured, bool rollover_pending)
+{
+	// The captured value must be read before the rollover flag.  If a rollover is pending, a small captured value was
+	// latched after the counter wrapped and a large one was latched before it.
+	if (rollover_pending && captured < 0x80000000)
+		high++;
+	return ((uint64_t)high << 32) | captured;
+}
+
+extern bool RLM3_Capture_Record(RLM3_Capture* capture, uint32_t captured, bool rollover_pending)
+{
+	uint32_t head = capture->head;
+	if (head - capture->tail >= RLM3_CAPTURE_BATCH_COUNT)
+	{
+		// Every batch is waiting for the consumer.
+		capture->dropped_count++;
+		return false;
+	}
+
+	RLM3_CaptureBatch* batch = &capture->batches[head % RLM3_CAPTURE_BATCH_COUNT];
+	batch->timestamps[batch->count++] = RLM3_Capture_ExtendTimestamp(capture->high, captured, rollover_pending);
+	if (batch->count < RLM3_CAPTURE_BATCH_SIZE)
+		return false;
+
+	capture->head = head + 1;
+	return true;
+}
+
+extern void RLM3_Capture_Rollover(RLM3_Capture* capture)
+{
+	capture->high++;
+}
+
+extern void RLM3_Capture_Drop(RLM3_Capture* capture)
+{
+	capture->dropped_count++;
+}
+
+extern bool RLM3_Capture_Flush(RLM3_Capture* capture)
+{
+	uint32_t head = capture->head;
+	if (head - capture->tail >= RLM3_CAPTURE_BATCH_COUNT)
+		return false;
+	if (capture->batches[head % RLM3_CAPTURE_BATCH_COUNT].count == 0)
+		return false;
+
+	capture->head = head + 1;
+	return true;
+}
+
+extern const RLM3_CaptureBatch* RLM3_Capture_Acquire(RLM3_Capture* capture)
+{
+	uint32_t tail = capture->tail;
+	if (tail == capture->head)
+		return NULL;
+	return &capture->batches[tail % RLM3_CAPTURE_BATCH_COUNT];
+}
+
+extern void RLM3_Capture_Release(RLM3_Capture* capture)
+{
+	uint32_t tail = capture->tail;
+	ASSERT(tail != capture->head);
+
+	capture->batches[tail % RLM3_CAPTURE_BATCH_COUNT].count = 0;
+	capture->tail = tail + 1;
+}
+
+extern uint32_t RLM3_Capture_GetDroppedCount(const RLM3_Capture* capture)
+{
+	return capture->dropped_count;
+}
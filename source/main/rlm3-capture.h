@@ -0,0 +1,54 @@
+#pragma once
+
+#include "rlm3-base.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Collects hardware capture timestamps into fixed size batches.  A single interrupt records timestamps and a single
+ * task consumes complete batches, so no locking is needed between them.  The 32 bit hardware counter is extended to
+ * 64 bits by counting counter rollovers.
+ */
+
+
+#define RLM3_CAPTURE_BATCH_SIZE 16
+#define RLM3_CAPTURE_BATCH_COUNT 4
+
+
+typedef struct
+{
+	uint64_t timestamps[RLM3_CAPTURE_BATCH_SIZE];
+	size_t count;
+} RLM3_CaptureBatch;
+
+typedef struct
+{
+	RLM3_CaptureBatch batches[RLM3_CAPTURE_BATCH_COUNT];
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t high;
+	volatile uint32_t dropped_count;
+} RLM3_Capture;
+
+
+extern void RLM3_Capture_Init(RLM3_Capture* capture);
+
+// Producer side.  Record and Flush return true when a batch became ready for the consumer.
+extern uint64_t RLM3_Capture_ExtendTimestamp(uint32_t high, uint32_t captured, bool rollover_pending);
+extern bool RLM3_Capture_Record(RLM3_Capture* capture, uint32_t captured, bool rollover_pending);
+extern void RLM3_Capture_Rollover(RLM3_Capture* capture);
+extern void RLM3_Capture_Drop(RLM3_Capture* capture);
+extern bool RLM3_Capture_Flush(RLM3_Capture* capture);
+
+// Consumer side.
+extern const RLM3_CaptureBatch* RLM3_Capture_Acquire(RLM3_Capture* capture);
+extern void RLM3_Capture_Release(RLM3_Capture* capture);
+extern uint32_t RLM3_Capture_GetDroppedCount(const RLM3_Capture* capture);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,254 @@
+#include "rlm3-eeprom.h"
+#include "rlm3-i2c.h"
+#include "rlm3-log.h"
+#include "Assert.h"
+#include <string.h>
+
+
+#ifndef RLM3_EEPROM_LOG_LEVEL
+#define RLM3_EEPROM_LOG_LEVEL RLM3_LOG_LEVEL_DEFAULT
+#endif
+#define RLM3_LOG_LEVEL RLM3_EEPROM_LOG_LEVEL
+
+RLM3_LOG_ZONE(EEPROM);
+
+
+#define EEPROM_READ_CHUNK 0x8000
+
+
+static uint64_t RangeMask(size_t offset, size_t size)
+{
+	uint64_t mask = (size >= 64) ? ~0ULL : (1ULL << size) - 1;
+	return mask << offset;
+}
+
+static size_t EncodeAddress(const RLM3_EEPROM* eeprom, uint32_t address, uint8_t* out)
+{
+	if (eeprom->config.address_size == 2)
+		*out++ = (uint8_t)(address >> 8);
+	*out = (uint8_t)address;
+	return eeprom->config.address_size;
+}
+
+static bool ReadDevice(RLM3_EEPROM* eeprom, uint32_t address, uint8_t* data, size_t size)
+{
+	if (!RLM3_EEPROM_WaitReady(eeprom))
+		return false;
+	while (size > 0)
+	{
+		size_t chunk = (size < EEPROM_READ_CHUNK) ? size : EEPROM_READ_CHUNK;
+		uint8_t tx[2];
+		size_t tx_size = EncodeAddress(eeprom, address, tx);
+		if (!RLM3_I2C1_TransmitReceive(eeprom->config.addr, tx, tx_size, data, chunk))
+			return false;
+		address += chunk;
+		data += chunk;
+		size -= chunk;
+	}
+	return true;
+}
+
+static bool WriteDevice(RLM3_EEPROM* eeprom, uint32_t address, const uint8_t* data, size_t size)
+{
+	if (!RLM3_EEPROM_WaitReady(eeprom))
+		return false;
+	uint8_t tx[2 + RLM3_EEPROM_MAX_PAGE_SIZE];
+	size_t tx_size = EncodeAddress(eeprom, address, tx);
+	memcpy(tx + tx_size, data, size);
+	if (!RLM3_I2C1_Transmit(eeprom->config.addr, tx, tx_size + size))
+		return false;
+	eeprom->is_write_pending = true;
+	eeprom->write_start_time = RLM3_GetCurrentTime();
+	eeprom->stats.write_cycle_count++;
+	eeprom->stats.written_bytes += size;
+	return true;
+}
+
+static RLM3_EEPROM_CacheLine* FindLine(RLM3_EEPROM* eeprom, uint32_t page)
+{
+	for (size_t i = 0; i < RLM3_EEPROM_CACHE_LINES; i++)
+		if (eeprom->lines[i].is_used && eeprom->lines[i].page == page)
+			return &eeprom->lines[i];
+	return NULL;
+}
+
+static bool FlushLine(RLM3_EEPROM* eeprom, RLM3_EEPROM_CacheLine* line)
+{
+	size_t first = __builtin_ctzll(line->dirty);
+	size_t size = 64 - __builtin_clzll(line->dirty) - first;
+	uint32_t base = line->page * eeprom->config.page_size;
+
+	// Bytes between the changes are read back so the page still takes one write cycle.
+	uint64_t span = RangeMask(first, size);
+	if ((line->dirty & span) != span)
+	{
+		uint8_t current[RLM3_EEPROM_MAX_PAGE_SIZE];
+		if (!ReadDevice(eeprom, base + first, current, size))
+			return false;
+		for (size_t i = first; i < first + size; i++)
+			if ((line->dirty & (1ULL << i)) == 0)
+				line->data[i] = current[i - first];
+		eeprom->stats.gap_fill_count++;
+	}
+
+	if (!WriteDevice(eeprom, base + first, &line->data[first], size))
+		return false;
+	line->is_used = false;
+	return true;
+}
+
+static RLM3_EEPROM_CacheLine* AllocateLine(RLM3_EEPROM* eeprom, uint32_t page)
+{
+	// A free line, or else the one written longest ago.
+	RLM3_EEPROM_CacheLine* line = &eeprom->lines[0];
+	for (size_t i = 0; i < RLM3_EEPROM_CACHE_LINES; i++)
+	{
+		if (!eeprom->lines[i].is_used)
+		{
+			line = &eeprom->lines[i];
+			break;
+		}
+		if (eeprom->lines[i].age < line->age)
+			line = &eeprom->lines[i];
+	}
+	if (line->is_used)
+	{
+		eeprom->stats.eviction_count++;
+		if (!FlushLine(eeprom, line))
+			return NULL;
+	}
+	line->is_used = true;
+	line->page = page;
+	line->dirty = 0;
+	return line;
+}
+
+
+extern void RLM3_EEPROM_Init(RLM3_EEPROM* eeprom, const RLM3_EEPROM_Config* config)
+{
+	ASSERT(eeprom != NULL);
+	ASSERT(config != NULL);
+	ASSERT(config->addr <= 0x7F);
+	ASSERT(config->address_size == 1 || config->address_size == 2);
+	ASSERT(config->page_size > 0 && config->page_size <= RLM3_EEPROM_MAX_PAGE_SIZE);
+	ASSERT((config->page_size & (config->page_size - 1)) == 0);
+	ASSERT(config->capacity > 0 && config->capacity <= (1UL << (8 * config->address_size)));
+
+	eeprom->config = *config;
+	for (size_t i = 0; i < RLM3_EEPROM_CACHE_LINES; i++)
+		eeprom->lines[i].is_used = false;
+	eeprom->age = 0;
+	eeprom->is_write_pending = false;
+	eeprom->write_start_time = 0;
+	eeprom->stats = (RLM3_EEPROM_Stats){ 0 };
+	RLM3_I2C1_Init(RLM3_I2C1_DEVICE_FLASH);
+}
+
+extern bool RLM3_EEPROM_Deinit(RLM3_EEPROM* eeprom)
+{
+	ASSERT(eeprom != NULL);
+
+	bool result = RLM3_EEPROM_Flush(eeprom) && RLM3_EEPROM_WaitReady(eeprom);
+	RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE_FLASH);
+	return result;
+}
+
+extern bool RLM3_EEPROM_Read(RLM3_EEPROM* eeprom, uint32_t address, uint8_t* data, size_t size)
+{
+	ASSERT(eeprom != NULL);
+	ASSERT(data != NULL || size == 0);
+	ASSERT(address <= eeprom->config.capacity && size <= eeprom->config.capacity - address);
+
+	if (size > 0 && !ReadDevice(eeprom, address, data, size))
+		return false;
+
+	for (size_t i = 0; i < RLM3_EEPROM_CACHE_LINES; i++)
+	{
+		const RLM3_EEPROM_CacheLine* line = &eeprom->lines[i];
+		if (!line->is_used)
+			continue;
+		uint32_t base = line->page * eeprom->config.page_size;
+		for (size_t j = 0; j < eeprom->config.page_size; j++)
+			if ((line->dirty & (1ULL << j)) != 0 && base + j >= address && base + j - address < size)
+				data[base + j - address] = line->data[j];
+	}
+	return true;
+}
+
+extern bool RLM3_EEPROM_Write(RLM3_EEPROM* eeprom, uint32_t address, const uint8_t* data, size_t size)
+{
+	ASSERT(eeprom != NULL);
+	ASSERT(data != NULL || size == 0);
+	ASSERT(address <= eeprom->config.capacity && size <= eeprom->config.capacity - address);
+
+	size_t page_size = eeprom->config.page_size;
+	while (size > 0)
+	{
+		uint32_t page = address / page_size;
+		size_t offset = address % page_size;
+		size_t count = (size < page_size - offset) ? size : page_size - offset;
+
+		RLM3_EEPROM_CacheLine* line = FindLine(eeprom, page);
+		if (line != NULL)
+			eeprom->stats.coalesced_count++;
+		else if ((line = AllocateLine(eeprom, page)) == NULL)
+			return false;
+		memcpy(&line->data[offset], data, count);
+		line->dirty |= RangeMask(offset, count);
+		line->age = ++eeprom->age;
+
+		address += count;
+		data += count;
+		size -= count;
+	}
+	return eeprom->config.is_write_back || RLM3_EEPROM_Flush(eeprom);
+}
+
+extern bool RLM3_EEPROM_Flush(RLM3_EEPROM* eeprom)
+{
+	ASSERT(eeprom != NULL);
+
+	// Lowest page first, so a run of pages is written in order.
+	while (true)
+	{
+		RLM3_EEPROM_CacheLine* line = NULL;
+		for (size_t i = 0; i < RLM3_EEPROM_CACHE_LINES; i++)
+			if (eeprom->lines[i].is_used && (line == NULL || eeprom->lines[i].page < line->page))
+				line = &eeprom->lines[i];
+		if (line == NULL)
+			return true;
+		if (!FlushLine(eeprom, line))
+			return false;
+	}
+}
+
+extern bool RLM3_EEPROM_WaitReady(RLM3_EEPROM* eeprom)
+{
+	ASSERT(eeprom != NULL);
+
+	uint8_t tx[2] = { 0, 0 };
+	while (eeprom->is_write_pending)
+	{
+		// The device NACKs its address for as long as the write cycle runs.  Setting the address pointer starts no cycle.
+		RLM3_I2C1_Result result = RLM3_I2C1_TransmitWithTimeout(eeprom->config.addr, tx, eeprom->config.address_size, 0);
+		if (result == RLM3_I2C1_RESULT_OK)
+			eeprom->is_write_pending = false;
+		else if (result != RLM3_I2C1_RESULT_NACK || RLM3_GetCurrentTime() - eeprom->write_start_time > eeprom->config.write_cycle_ms)
+		{
+			RLM3_LOG_WARN("Not ready %d", (int)result);
+			eeprom->is_write_pending = false;
+			return false;
+		}
+		else
+			eeprom->stats.poll_count++;
+	}
+	return true;
+}
+
+extern void RLM3_EEPROM_GetStats(const RLM3_EEPROM* eeprom, RLM3_EEPROM_Stats* stats_out)
+{
+	ASSERT(eeprom != NULL);
+	ASSERT(stats_out != NULL);
+
+	*stats_out = eeprom->stats;
+}
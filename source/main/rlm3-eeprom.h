@@ -0,0 +1,86 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * A 24-series I2C EEPROM on the RLM3_I2C1_DEVICE_FLASH bus.  Writes are split at page boundaries, since the device
+ * wraps a write that runs past the end of a page back to its start.  After a write the device ignores its address
+ * until the write cycle is over, so the next access polls for an ACK instead of waiting out the longest cycle.  Reads
+ * are sequential and cross pages in one transaction.
+ *
+ * Writes go to a small write-back cache of whole pages.  Writes to a page that is already cached are merged, and a page
+ * with gaps between its changes is filled from the device so it still goes out in one write cycle.  Pages are written
+ * when the cache needs room, on RLM3_EEPROM_Flush, and on every write when the cache is turned off.
+ *
+ * An RLM3_EEPROM is used by one task at a time.
+ */
+
+
+#define RLM3_EEPROM_ADDRESS 0x50
+#define RLM3_EEPROM_MAX_PAGE_SIZE 64
+#define RLM3_EEPROM_CACHE_LINES 4
+
+
+typedef struct
+{
+	uint8_t addr;
+	uint8_t address_size; // Bytes of memory address sent before the data, 1 or 2.
+	uint16_t page_size; // A power of two, up to RLM3_EEPROM_MAX_PAGE_SIZE.
+	uint32_t capacity;
+	RLM3_Time write_cycle_ms; // The longest write cycle the datasheet allows.  ACK polling gives up after it.
+	bool is_write_back;
+} RLM3_EEPROM_Config;
+
+typedef struct
+{
+	uint32_t write_cycle_count;
+	uint32_t written_bytes;
+	uint32_t poll_count;
+	uint32_t coalesced_count; // Writes merged into a page that was already waiting in the cache.
+	uint32_t gap_fill_count;
+	uint32_t eviction_count;
+} RLM3_EEPROM_Stats;
+
+typedef struct
+{
+	bool is_used;
+	uint32_t page;
+	uint64_t dirty; // One bit per byte of the page.
+	uint32_t age;
+	uint8_t data[RLM3_EEPROM_MAX_PAGE_SIZE];
+} RLM3_EEPROM_CacheLine;
+
+typedef struct
+{
+	RLM3_EEPROM_Config config;
+	RLM3_EEPROM_CacheLine lines[RLM3_EEPROM_CACHE_LINES];
+	uint32_t age;
+	bool is_write_pending;
+	RLM3_Time write_start_time;
+	RLM3_EEPROM_Stats stats;
+} RLM3_EEPROM;
+
+
+extern void RLM3_EEPROM_Init(RLM3_EEPROM* eeprom, const RLM3_EEPROM_Config* config);
+// Writes out the cache first.  Returns false if that failed, and the changes it held are lost.
+extern bool RLM3_EEPROM_Deinit(RLM3_EEPROM* eeprom);
+
+// Reads see writes that are still in the cache.
+extern bool RLM3_EEPROM_Read(RLM3_EEPROM* eeprom, uint32_t address, uint8_t* data, size_t size);
+extern bool RLM3_EEPROM_Write(RLM3_EEPROM* eeprom, uint32_t address, const uint8_t* data, size_t size);
+// Writes out every cached page.  The last write cycle may still be running when it returns.
+extern bool RLM3_EEPROM_Flush(RLM3_EEPROM* eeprom);
+// Polls until the last write cycle is over.
+extern bool RLM3_EEPROM_WaitReady(RLM3_EEPROM* eeprom);
+extern void RLM3_EEPROM_GetStats(const RLM3_EEPROM* eeprom, RLM3_EEPROM_Stats* stats_out);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,369 @@
+#include "rlm3-frame.h"
+#include "Assert.h"
+
+
+#define SLIP_END 0xC0
+#define SLIP_ESC 0xDB
+#define SLIP_ESC_END 0xDC
+#define SLIP_ESC_ESC 0xDD
+
+#define COBS_MAX_CODE 0xFF
+
+
+typedef struct
+{
+	uint8_t* out;
+	size_t size;
+	size_t capacity;
+} Writer;
+
+
+extern uint16_t RLM3_Frame_CRC(const uint8_t* data, size_t size)
+{
+	// CRC-16/CCITT-FALSE a byte at a time without a table.
+	uint16_t crc = 0xFFFF;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = (uint16_t)((crc >> 8) | (crc << 8));
+		crc ^= data[i];
+		crc ^= (crc & 0xFF) >> 4;
+		crc ^= (uint16_t)(crc << 12);
+		crc ^= (uint16_t)((crc & 0xFF) << 5);
+	}
+	return crc;
+}
+
+extern void RLM3_FrameDecoder_Init(RLM3_FrameDecoder* decoder, RLM3_FrameEncoding encoding, bool has_crc, void* buffers, size_t buffer_size, size_t buffer_count, void* queue_storage, size_t queue_storage_size)
+{
+	ASSERT(decoder != NULL && buffers != NULL && queue_storage != NULL);
+	ASSERT(encoding == RLM3_FRAME_COBS || encoding == RLM3_FRAME_SLIP || encoding == RLM3_FRAME_LENGTH);
+	ASSERT(buffer_size > (has_crc ? RLM3_FRAME_CRC_SIZE : 0));
+	ASSERT(queue_storage_size >= RLM3_FRAME_DECODER_QUEUE_STORAGE_SIZE(buffer_count));
+
+	*decoder = (RLM3_FrameDecoder){ 0 };
+	decoder->encoding = encoding;
+	decoder->has_crc = has_crc;
+	decoder->buffers = (uint8_t*)buffers;
+	decoder->buffer_size = buffer_size;
+	decoder->buffer_count = buffer_count;
+
+	size_t half = (queue_storage_size / 2) & ~(size_t)3;
+	RLM3_MessageQueue_Init(&decoder->free_buffers, queue_storage, half, sizeof(RLM3_Frame), buffer_count);
+	RLM3_MessageQueue_Init(&decoder->frames, (uint8_t*)queue_storage + half, half, sizeof(RLM3_Frame), buffer_count);
+	for (size_t i = 0; i < buffer_count; i++)
+	{
+		RLM3_Frame frame = { decoder->buffers + i * buffer_size, 0 };
+		RLM3_MessageQueue_Push(&decoder->free_buffers, &frame);
+	}
+}
+
+static void ResetFrame(RLM3_FrameDecoder* decoder)
+{
+	// The buffer stays with the decoder for the next frame.
+	decoder->size = 0;
+	decoder->remaining = 0;
+	decoder->code = 0;
+	decoder->header_count = 0;
+	decoder->is_escaped = false;
+	decoder->is_in_frame = false;
+	decoder->is_discarding = false;
+}
+
+static void StartFrame(RLM3_FrameDecoder* decoder)
+{
+	if (!decoder->is_in_frame)
+		decoder->frame_cycles = decoder->cycles;
+	decoder->is_in_frame = true;
+}
+
+static void FailFrame(RLM3_FrameDecoder* decoder)
+{
+	if (!decoder->is_discarding)
+		decoder->counters.framing_error_count++;
+	decoder->is_discarding = true;
+}
+
+static void Append(RLM3_FrameDecoder* decoder, uint8_t data)
+{
+	if (decoder->is_discarding)
+		return;
+	if (decoder->buffer == NULL)
+	{
+		RLM3_Frame free_buffer;
+		if (!RLM3_MessageQueue_TryPop(&decoder->free_buffers, &free_buffer))
+		{
+			decoder->counters.no_buffer_count++;
+			decoder->is_discarding = true;
+			return;
+		}
+		decoder->buffer = free_buffer.data;
+	}
+	if (decoder->size == decoder->buffer_size)
+	{
+		decoder->counters.overflow_count++;
+		decoder->is_discarding = true;
+		return;
+	}
+	decoder->buffer[decoder->size++] = data;
+}
+
+static void EndFrame(RLM3_FrameDecoder* decoder)
+{
+	size_t size = decoder->size;
+	if (!decoder->is_discarding && size > 0)
+	{
+		// The CRC of a frame followed by its own CRC comes out zero.
+		if (decoder->has_crc && (size <= RLM3_FRAME_CRC_SIZE || RLM3_Frame_CRC(decoder->buffer, size) != 0))
+			decoder->counters.crc_error_count++;
+		else
+		{
+			RLM3_Frame frame = { decoder->buffer, decoder->has_crc ? size - RLM3_FRAME_CRC_SIZE : size, decoder->frame_cycles };
+			bool is_queued = RLM3_MessageQueue_Push(&decoder->frames, &frame);
+			ASSERT(is_queued); // There are as many cells as buffers.
+			decoder->buffer = NULL;
+			decoder->counters.frame_count++;
+		}
+	}
+	ResetFrame(decoder);
+}
+
+static inline void ReceiveCOBS(RLM3_FrameDecoder* decoder, uint8_t data)
+{
+	if (data == 0)
+	{
+		if (decoder->remaining != 0)
+			FailFrame(decoder);
+		EndFrame(decoder);
+		return;
+	}
+	StartFrame(decoder);
+	if (decoder->remaining == 0)
+	{
+		// Every block but the last ends in a zero the encoder left out, except a full block.
+		if (decoder->code != 0 && decoder->code != COBS_MAX_CODE)
+			Append(decoder, 0);
+		decoder->code = data;
+		decoder->remaining = data - 1;
+		return;
+	}
+	Append(decoder, data);
+	decoder->remaining--;
+}
+
+static inline void ReceiveSLIP(RLM3_FrameDecoder* decoder, uint8_t data)
+{
+	if (data == SLIP_END)
+	{
+		if (decoder->is_escaped)
+			FailFrame(decoder);
+		EndFrame(decoder);
+		return;
+	}
+	StartFrame(decoder);
+	if (decoder->is_escaped)
+	{
+		decoder->is_escaped = false;
+		if (data == SLIP_ESC_END)
+			Append(decoder, SLIP_END);
+		else if (data == SLIP_ESC_ESC)
+			Append(decoder, SLIP_ESC);
+		else
+			FailFrame(decoder);
+		return;
+	}
+	if (data == SLIP_ESC)
+		decoder->is_escaped = true;
+	else
+		Append(decoder, data);
+}
+
+static inline void ReceiveLength(RLM3_FrameDecoder* decoder, uint8_t data)
+{
+	StartFrame(decoder);
+	if (decoder->header_count < 2)
+	{
+		decoder->remaining = (decoder->remaining << 8) | data;
+		if (++decoder->header_count < 2)
+			return;
+		if (decoder->remaining == 0)
+		{
+			// No frame is empty, so this is noise.  Look for a header again at the next byte.
+			FailFrame(decoder);
+			ResetFrame(decoder);
+		}
+		else if (decoder->remaining > decoder->buffer_size)
+		{
+			// Skip the whole frame so the next header is found.
+			decoder->counters.overflow_count++;
+			decoder->is_discarding = true;
+		}
+		return;
+	}
+	Append(decoder, data);
+	if (--decoder->remaining == 0)
+		EndFrame(decoder);
+}
+
+static inline void CheckReset(RLM3_FrameDecoder* decoder)
+{
+	if (!decoder->is_reset_requested)
+		return;
+	decoder->is_reset_requested = false;
+	if (decoder->is_in_frame)
+		FailFrame(decoder);
+	ResetFrame(decoder);
+}
+
+static void ReceiveBlock(RLM3_FrameDecoder* decoder, const uint8_t* data, size_t size, uint32_t cycles)
+{
+	CheckReset(decoder);
+	decoder->cycles = cycles;
+	switch (decoder->encoding)
+	{
+	case RLM3_FRAME_COBS:
+		for (size_t i = 0; i < size; i++)
+			ReceiveCOBS(decoder, data[i]);
+		break;
+	case RLM3_FRAME_SLIP:
+		for (size_t i = 0; i < size; i++)
+			ReceiveSLIP(decoder, data[i]);
+		break;
+	case RLM3_FRAME_LENGTH:
+		for (size_t i = 0; i < size; i++)
+			ReceiveLength(decoder, data[i]);
+		break;
+	}
+}
+
+extern void RLM3_FrameDecoder_Receive(RLM3_FrameDecoder* decoder, uint8_t data)
+{
+	ReceiveBlock(decoder, &data, 1, RLM3_GetCycleCount());
+}
+
+extern void RLM3_FrameDecoder_ReceiveBlock(RLM3_FrameDecoder* decoder, const uint8_t* data, size_t size)
+{
+	ReceiveBlock(decoder, data, size, RLM3_GetCycleCount());
+}
+
+extern void RLM3_FrameDecoder_Reset(RLM3_FrameDecoder* decoder)
+{
+	decoder->is_reset_requested = true;
+}
+
+extern void RLM3_FrameDecoder_UARTReceive(RLM3_UART_ID id, uint8_t data, void* context)
+{
+	RLM3_UART_Timestamp timestamp;
+	RLM3_UART_GetReceiveTimestamp(id, &timestamp);
+	ReceiveBlock((RLM3_FrameDecoder*)context, &data, 1, timestamp.byte_cycles);
+}
+
+extern void RLM3_FrameDecoder_UARTError(RLM3_UART_ID id, uint32_t status_flags, void* context)
+{
+	// The byte the error came with is unreliable or lost.
+	RLM3_FrameDecoder* decoder = (RLM3_FrameDecoder*)context;
+	CheckReset(decoder);
+	if (decoder->is_in_frame)
+		FailFrame(decoder);
+}
+
+extern bool RLM3_FrameDecoder_Take(RLM3_FrameDecoder* decoder, RLM3_Frame* frame_out, RLM3_Time timeout_ms)
+{
+	return RLM3_MessageQueue_Pop(&decoder->frames, frame_out, timeout_ms);
+}
+
+extern void RLM3_FrameDecoder_Return(RLM3_FrameDecoder* decoder, const RLM3_Frame* frame)
+{
+	ASSERT(frame != NULL);
+	ASSERT(frame->data >= decoder->buffers && frame->data < decoder->buffers + decoder->buffer_count * decoder->buffer_size);
+	ASSERT((frame->data - decoder->buffers) % decoder->buffer_size == 0);
+	RLM3_Frame free_buffer = { frame->data, 0 };
+	RLM3_MessageQueue_Push(&decoder->free_buffers, &free_buffer);
+}
+
+extern void RLM3_FrameDecoder_GetCounters(const RLM3_FrameDecoder* decoder, RLM3_FrameDecoder_Counters* counters_out)
+{
+	ASSERT(counters_out != NULL);
+	RLM3_EnterCritical();
+	*counters_out = decoder->counters;
+	RLM3_ExitCritical();
+}
+
+static void Put(Writer* writer, uint8_t data)
+{
+	if (writer->size < writer->capacity)
+		writer->out[writer->size] = data;
+	writer->size++;
+}
+
+static void PutAt(Writer* writer, size_t position, uint8_t data)
+{
+	if (position < writer->capacity)
+		writer->out[position] = data;
+}
+
+extern size_t RLM3_Frame_Encode(RLM3_FrameEncoding encoding, bool has_crc, const uint8_t* payload, size_t size, uint8_t* out, size_t out_size)
+{
+	ASSERT(payload != NULL || size == 0);
+	ASSERT(out != NULL || out_size == 0);
+
+	uint16_t crc = has_crc ? RLM3_Frame_CRC(payload, size) : 0;
+	const uint8_t crc_bytes[RLM3_FRAME_CRC_SIZE] = { (uint8_t)(crc >> 8), (uint8_t)crc };
+	size_t total = size + (has_crc ? RLM3_FRAME_CRC_SIZE : 0);
+	Writer writer = { out, 0, out_size };
+
+	if (encoding == RLM3_FRAME_LENGTH)
+	{
+		ASSERT(total > 0 && total <= 0xFFFF);
+		Put(&writer, (uint8_t)(total >> 8));
+		Put(&writer, (uint8_t)total);
+	}
+	else if (encoding == RLM3_FRAME_SLIP)
+		Put(&writer, SLIP_END);
+
+	size_t code_position = writer.size;
+	uint8_t code = 1;
+	if (encoding == RLM3_FRAME_COBS)
+		Put(&writer, 0);
+
+	for (size_t i = 0; i < total; i++)
+	{
+		uint8_t data = (i < size) ? payload[i] : crc_bytes[i - size];
+		if (encoding == RLM3_FRAME_COBS)
+		{
+			if (data != 0)
+			{
+				Put(&writer, data);
+				code++;
+			}
+			if (data == 0 || code == COBS_MAX_CODE)
+			{
+				PutAt(&writer, code_position, code);
+				code_position = writer.size;
+				code = 1;
+				Put(&writer, 0);
+			}
+		}
+		else if (encoding == RLM3_FRAME_SLIP && data == SLIP_END)
+		{
+			Put(&writer, SLIP_ESC);
+			Put(&writer, SLIP_ESC_END);
+		}
+		else if (encoding == RLM3_FRAME_SLIP && data == SLIP_ESC)
+		{
+			Put(&writer, SLIP_ESC);
+			Put(&writer, SLIP_ESC_ESC);
+		}
+		else
+			Put(&writer, data);
+	}
+
+	if (encoding == RLM3_FRAME_COBS)
+	{
+		PutAt(&writer, code_position, code);
+		Put(&writer, 0);
+	}
+	else if (encoding == RLM3_FRAME_SLIP)
+		Put(&writer, SLIP_END);
+
+	return (writer.size <= out_size) ? writer.size : 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-message-queue.h"
+#include "rlm3-uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Decodes a framed byte stream from the receive interrupt, or from a DMA completion, straight into buffers from a pool
+ * the caller provides.  Complete frames go to a consumer task by pointer through a message queue, and the task hands
+ * each buffer back once it is done with it.  Nothing is copied after the decoder writes a byte.
+ *
+ *   COBS    Consistent overhead byte stuffing.  A zero ends each frame.
+ *   SLIP    RFC 1055.  END ends each frame, and the encoder also sends one in front of it to flush line noise.
+ *   LENGTH  A 16 bit big-endian count of the bytes that follow.  Nothing marks the end of a frame, so call
+ *           RLM3_FrameDecoder_Reset when the line goes idle to recover from one that was cut short.
+ *
+ * With the CRC on, the last two bytes of a frame are the CRC-16/CCITT-FALSE of the rest, big-endian.  Frames that fail
+ * the check are counted and dropped, and the size delivered leaves the CRC out.  The buffer size counts the CRC.
+ */
+
+
+#define RLM3_FRAME_CRC_SIZE 2
+// The buffer count must be a power of two.
+#define RLM3_FRAME_DECODER_QUEUE_STORAGE_SIZE(buffer_count) (2 * RLM3_MESSAGE_QUEUE_STORAGE_SIZE(sizeof(RLM3_Frame), (buffer_count)))
+
+
+typedef enum
+{
+	RLM3_FRAME_COBS,
+	RLM3_FRAME_SLIP,
+	RLM3_FRAME_LENGTH,
+} RLM3_FrameEncoding;
+
+typedef struct
+{
+	uint8_t* data;
+	size_t size;
+	uint32_t cycles; // When the frame's first byte arrived.  See RLM3_FrameDecoder_Receive.
+} RLM3_Frame;
+
+typedef struct
+{
+	uint32_t frame_count;
+	uint32_t crc_error_count;
+	uint32_t framing_error_count; // Bad escapes, COBS blocks cut short, zero lengths and line errors.
+	uint32_t overflow_count;      // Frames longer than a buffer.
+	uint32_t no_buffer_count;     // Frames dropped because the consumer held every buffer.
+} RLM3_FrameDecoder_Counters;
+
+typedef struct
+{
+	RLM3_FrameEncoding encoding;
+	bool has_crc;
+	uint8_t* buffers;
+	size_t buffer_size;
+	size_t buffer_count;
+	RLM3_MessageQueue free_buffers; // The interrupt is the only consumer.
+	RLM3_MessageQueue frames;
+
+	// Owned by the interrupt.
+	uint8_t* buffer;
+	size_t size;
+	size_t remaining;
+	uint32_t cycles;
+	uint32_t frame_cycles;
+	uint8_t code;
+	uint8_t header_count;
+	bool is_escaped;
+	bool is_in_frame;
+	bool is_discarding;
+	volatile bool is_reset_requested;
+	RLM3_FrameDecoder_Counters counters;
+} RLM3_FrameDecoder;
+
+
+extern void RLM3_FrameDecoder_Init(RLM3_FrameDecoder* decoder, RLM3_FrameEncoding encoding, bool has_crc, void* buffers, size_t buffer_size, size_t buffer_count, void* queue_storage, size_t queue_storage_size);
+
+// One receive context at a time.  Frames are stamped with the cycle counter when their first byte is passed in, or when
+// the block holding it is.  The UART callback below uses the time the byte arrived on the line instead.
+extern void RLM3_FrameDecoder_Receive(RLM3_FrameDecoder* decoder, uint8_t data);
+extern void RLM3_FrameDecoder_ReceiveBlock(RLM3_FrameDecoder* decoder, const uint8_t* data, size_t size);
+// Drops the partial frame when the next byte arrives.  Safe from any context.
+extern void RLM3_FrameDecoder_Reset(RLM3_FrameDecoder* decoder);
+
+// RLM3_UART_Config callbacks with the decoder as the context.  A line error drops the frame it lands in.
+extern void RLM3_FrameDecoder_UARTReceive(RLM3_UART_ID id, uint8_t data, void* context);
+extern void RLM3_FrameDecoder_UARTError(RLM3_UART_ID id, uint32_t status_flags, void* context);
+
+// A single consumer task takes the frames.  Any task may return them.
+extern bool RLM3_FrameDecoder_Take(RLM3_FrameDecoder* decoder, RLM3_Frame* frame_out, RLM3_Time timeout_ms);
+extern void RLM3_FrameDecoder_Return(RLM3_FrameDecoder* decoder, const RLM3_Frame* frame);
+
+extern void RLM3_FrameDecoder_GetCounters(const RLM3_FrameDecoder* decoder, RLM3_FrameDecoder_Counters* counters_out);
+
+// Writes the payload as one frame, with a CRC if has_crc is set.  Returns the encoded size, or 0 if it does not fit.
+extern size_t RLM3_Frame_Encode(RLM3_FrameEncoding encoding, bool has_crc, const uint8_t* payload, size_t size, uint8_t* out, size_t out_size);
+extern uint16_t RLM3_Frame_CRC(const uint8_t* data, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,173 @@
+#include "rlm3-gpio-event.h"
+#include "rlm3-timer.h"
+#include "rlm3-message-queue.h"
+#include "Assert.h"
+
+
+typedef struct
+{
+	GPIO_TypeDef* port;
+	RLM3_GPIO_Debounce debounce;
+	RLM3_TimerWheel_Entry holdoff_entry;
+	uint32_t holdoff_us;
+	volatile bool is_registered;
+} GpioEventLine;
+
+
+static uint32_t g_event_storage[RLM3_MESSAGE_QUEUE_STORAGE_SIZE(sizeof(RLM3_GPIO_Event), RLM3_GPIO_EVENT_QUEUE_SIZE) / sizeof(uint32_t)];
+static RLM3_MessageQueue g_event_queue;
+static GpioEventLine g_event_lines[RLM3_EXTI_LINE_COUNT];
+static volatile RLM3_Task g_event_task = NULL;
+
+
+static __attribute__((constructor)) void Init_GpioEvent()
+{
+	// Initialized once so events queued before a line is unregistered survive the next registration.
+	RLM3_MessageQueue_Init(&g_event_queue, g_event_storage, sizeof(g_event_storage), sizeof(RLM3_GPIO_Event), RLM3_GPIO_EVENT_QUEUE_SIZE);
+}
+
+
+static bool AcceptLevel(RLM3_GPIO_Debounce* debounce, uint8_t level)
+{
+	// With both edges enabled the level decides whether anything changed.  With a single edge every edge is reported.
+	if (debounce->edge == RLM3_EXTI_EDGE_BOTH && level == debounce->level)
+		return false;
+	debounce->level = level;
+	return true;
+}
+
+extern void RLM3_GPIO_Debounce_Init(RLM3_GPIO_Debounce* debounce, RLM3_EXTI_Edge edge, bool has_holdoff, uint8_t level)
+{
+	ASSERT(debounce != NULL);
+	ASSERT(edge == RLM3_EXTI_EDGE_RISING || edge == RLM3_EXTI_EDGE_FALLING || edge == RLM3_EXTI_EDGE_BOTH);
+
+	debounce->edge = edge;
+	debounce->level = (level != 0);
+	debounce->is_holdoff = false;
+	debounce->has_holdoff = has_holdoff;
+	debounce->suppressed_count = 0;
+}
+
+extern bool RLM3_GPIO_Debounce_Edge(RLM3_GPIO_Debounce* debounce, uint8_t level)
+{
+	if (debounce->is_holdoff)
+	{
+		debounce->suppressed_count++;
+		return false;
+	}
+	if (debounce->has_holdoff)
+		debounce->is_holdoff = true;
+	return AcceptLevel(debounce, (level != 0));
+}
+
+extern bool RLM3_GPIO_Debounce_EndHoldoff(RLM3_GPIO_Debounce* debounce, uint8_t level, bool missed)
+{
+	ASSERT(debounce->is_holdoff);
+
+	debounce->is_holdoff = false;
+	if (missed)
+		debounce->suppressed_count++;
+	if (debounce->edge != RLM3_EXTI_EDGE_BOTH)
+		return false;
+	return AcceptLevel(debounce, (level != 0));
+}
+
+static uint8_t ReadLevel(size_t line)
+{
+	return ((g_event_lines[line].port->IDR & (1UL << line)) != 0);
+}
+
+static void PushEvent(uint32_t timestamp, size_t line, uint8_t level)
+{
+	RLM3_GPIO_Event event = { timestamp, (uint8_t)line, level };
+	RLM3_Task task = g_event_task;
+	if (RLM3_MessageQueue_Push(&g_event_queue, &event) && task != NULL)
+		RLM3_GiveFromISR(task);
+}
+
+static void EdgeCallback(size_t line, void* context)
+{
+	GpioEventLine* state = &g_event_lines[line];
+	if (!state->is_registered)
+		return;
+	uint32_t timestamp = RLM3_GetCycleCount();
+	uint8_t level = ReadLevel(line);
+
+	bool is_reported = RLM3_GPIO_Debounce_Edge(&state->debounce, level);
+	if (state->debounce.is_holdoff)
+	{
+		// Mask the line until the contact settles.  The wheel callback unmasks it again.
+		CLEAR_BIT(EXTI->IMR, 1UL << line);
+		RLM3_Timer2_Wheel_Start(&state->holdoff_entry, state->holdoff_us, 0);
+	}
+	if (is_reported)
+		PushEvent(timestamp, line, level);
+}
+
+static void HoldoffCallback(RLM3_TimerWheel_Entry* entry, void* context)
+{
+	size_t line = (size_t)context;
+	GpioEventLine* state = &g_event_lines[line];
+	uint32_t mask = 1UL << line;
+
+	// Edges while masked still set the pending bit.  They are counted and discarded.
+	bool missed = ((EXTI->PR & mask) != 0);
+	EXTI->PR = mask;
+	if (RLM3_GPIO_Debounce_EndHoldoff(&state->debounce, ReadLevel(line), missed))
+		PushEvent(RLM3_GetCycleCount(), line, state->debounce.level);
+	if (state->is_registered)
+		SET_BIT(EXTI->IMR, mask);
+}
+
+extern void RLM3_GPIO_Event_SetTask(RLM3_Task task)
+{
+	g_event_task = task;
+}
+
+extern void RLM3_GPIO_Event_Register(size_t line, GPIO_TypeDef* port, RLM3_EXTI_Edge edge, uint32_t holdoff_us)
+{
+	ASSERT(line < RLM3_EXTI_LINE_COUNT);
+	ASSERT(!g_event_lines[line].is_registered);
+	ASSERT(holdoff_us == 0 || RLM3_Timer2_Wheel_IsInit());
+
+	GpioEventLine* state = &g_event_lines[line];
+	state->port = port;
+	state->holdoff_us = holdoff_us;
+	RLM3_TimerWheel_InitEntry(&state->holdoff_entry, HoldoffCallback, (void*)line, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+	RLM3_GPIO_Debounce_Init(&state->debounce, edge, (holdoff_us != 0), ReadLevel(line));
+	state->is_registered = true;
+
+	RLM3_EXTI_Register(line, port, edge, RLM3_EXTI_MIN_PRIORITY, EdgeCallback, NULL);
+}
+
+extern void RLM3_GPIO_Event_Unregister(size_t line)
+{
+	ASSERT(line < RLM3_EXTI_LINE_COUNT);
+	ASSERT(g_event_lines[line].is_registered);
+
+	// Mask the line before cancelling the holdoff.  Otherwise an edge in between could start the holdoff again, and a
+	// holdoff that is already running checks the flag before it unmasks the line.
+	GpioEventLine* state = &g_event_lines[line];
+	state->is_registered = false;
+	CLEAR_BIT(EXTI->IMR, 1UL << line);
+	if (state->holdoff_us != 0)
+		RLM3_Timer2_Wheel_Cancel(&state->holdoff_entry);
+	RLM3_EXTI_Unregister(line);
+}
+
+extern size_t RLM3_GPIO_Event_Drain(RLM3_GPIO_Event* events_out, size_t max_count)
+{
+	ASSERT(events_out != NULL);
+	return RLM3_MessageQueue_Drain(&g_event_queue, events_out, max_count);
+}
+
+extern uint32_t RLM3_GPIO_Event_GetSuppressedCount(size_t line)
+{
+	ASSERT(line < RLM3_EXTI_LINE_COUNT);
+	return g_event_lines[line].debounce.suppressed_count;
+}
+
+extern uint32_t RLM3_GPIO_Event_GetDroppedCount()
+{
+	return RLM3_MessageQueue_GetDroppedCount(&g_event_queue);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-gpio.h"
+#include "rlm3-task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Timestamped and debounced GPIO edge events.  Each edge is stamped with the cycle counter and the pin level when the
+ * EXTI interrupt runs.  After an accepted edge, the line is masked for a holdoff period so a bouncing contact cannot
+ * flood the interrupt.  Events go into a message queue that a single task drains in batches.
+ */
+
+
+#define RLM3_GPIO_EVENT_QUEUE_SIZE 64
+
+
+typedef struct
+{
+	uint32_t timestamp;
+	uint8_t line;
+	uint8_t level;
+} RLM3_GPIO_Event;
+
+// Debounce state for one line.  This does not know anything about the hardware and is driven by the service below.
+typedef struct
+{
+	uint8_t edge;
+	uint8_t level;
+	bool is_holdoff;
+	bool has_holdoff;
+	volatile uint32_t suppressed_count;
+} RLM3_GPIO_Debounce;
+
+
+// Edge returns true when an event should be reported for the edge and starts the holdoff.  EndHoldoff returns true when
+// the level settled somewhere other than the last reported level, which can only happen when both edges are reported.
+// Missed is set when the hardware saw edges while the line was masked.
+extern void RLM3_GPIO_Debounce_Init(RLM3_GPIO_Debounce* debounce, RLM3_EXTI_Edge edge, bool has_holdoff, uint8_t level);
+extern bool RLM3_GPIO_Debounce_Edge(RLM3_GPIO_Debounce* debounce, uint8_t level);
+extern bool RLM3_GPIO_Debounce_EndHoldoff(RLM3_GPIO_Debounce* debounce, uint8_t level, bool missed);
+
+// Holdoff requires the Timer2 wheel to be running.  The task is notified when events are queued.
+extern void RLM3_GPIO_Event_SetTask(RLM3_Task task);
+extern void RLM3_GPIO_Event_Register(size_t line, GPIO_TypeDef* port, RLM3_EXTI_Edge edge, uint32_t holdoff_us);
+extern void RLM3_GPIO_Event_Unregister(size_t line);
+extern size_t RLM3_GPIO_Event_Drain(RLM3_GPIO_Event* events_out, size_t max_count);
+extern uint32_t RLM3_GPIO_Event_GetSuppressedCount(size_t line);
+extern uint32_t RLM3_GPIO_Event_GetDroppedCount();
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,21 +1,172 @@
 #include "rlm3-gpio.h"
+#include "rlm3-task.h"
+#include "Assert.h"
 
 
+typedef struct
+{
+	RLM3_EXTI_Callback callback;
+	void* context;
+	uint32_t priority;
+} ExtiHandler;
+
+
+static ExtiHandler g_exti_handlers[RLM3_EXTI_LINE_COUNT] = { { NULL, NULL, 0 } };
+
+
+static IRQn_Type GetExtiIrq(size_t line)
+{
+	switch (line)
+	{
+	case 0: return EXTI0_IRQn;
+	case 1: return EXTI1_IRQn;
+	case 2: return EXTI2_IRQn;
+	case 3: return EXTI3_IRQn;
+	case 4: return EXTI4_IRQn;
+	}
+	return (line < 10) ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+static void UpdateExtiIrq(size_t line)
+{
+	// Lines sharing an interrupt run at the most urgent priority registered among them.
+	IRQn_Type irq = GetExtiIrq(line);
+	bool is_used = false;
+	uint32_t priority = 0;
+	for (size_t i = 0; i < RLM3_EXTI_LINE_COUNT; i++)
+	{
+		if (GetExtiIrq(i) != irq || g_exti_handlers[i].callback == NULL)
+			continue;
+		if (!is_used || g_exti_handlers[i].priority < priority)
+			priority = g_exti_handlers[i].priority;
+		is_used = true;
+	}
+
+	// The interrupt stays enabled once used.  Unregistered lines are masked in the EXTI instead.
+	if (!is_used)
+		return;
+	HAL_NVIC_SetPriority(irq, priority, 0);
+	HAL_NVIC_EnableIRQ(irq);
+}
+
+extern void RLM3_EXTI_Register(size_t line, GPIO_TypeDef* port, RLM3_EXTI_Edge edge, uint32_t priority, RLM3_EXTI_Callback callback, void* context)
+{
+	ASSERT(line < RLM3_EXTI_LINE_COUNT);
+	ASSERT(port != NULL);
+	ASSERT(edge == RLM3_EXTI_EDGE_RISING || edge == RLM3_EXTI_EDGE_FALLING || edge == RLM3_EXTI_EDGE_BOTH);
+	ASSERT(priority >= RLM3_EXTI_MIN_PRIORITY && priority < 16);
+	ASSERT(callback != NULL);
+	ASSERT(g_exti_handlers[line].callback == NULL);
+
+	uint32_t port_index = ((uintptr_t)port - (uintptr_t)GPIOA) / ((uintptr_t)GPIOB - (uintptr_t)GPIOA);
+	ASSERT(port_index < 11);
+	uint32_t mask = 1UL << line;
+
+	g_exti_handlers[line].callback = callback;
+	g_exti_handlers[line].context = context;
+	g_exti_handlers[line].priority = priority;
+
+	__HAL_RCC_SYSCFG_CLK_ENABLE();
+	uint32_t exticr_shift = 4 * (line % 4);
+	MODIFY_REG(SYSCFG->EXTICR[line / 4], 0xFUL << exticr_shift, port_index << exticr_shift);
+
+	if ((edge & RLM3_EXTI_EDGE_RISING) != 0)
+		SET_BIT(EXTI->RTSR, mask);
+	else
+		CLEAR_BIT(EXTI->RTSR, mask);
+	if ((edge & RLM3_EXTI_EDGE_FALLING) != 0)
+		SET_BIT(EXTI->FTSR, mask);
+	else
+		CLEAR_BIT(EXTI->FTSR, mask);
+
+	EXTI->PR = mask;
+	SET_BIT(EXTI->IMR, mask);
+	UpdateExtiIrq(line);
+}
+
+extern void RLM3_EXTI_Unregister(size_t line)
+{
+	ASSERT(RLM3_EXTI_IsRegistered(line));
+
+	uint32_t mask = 1UL << line;
+	CLEAR_BIT(EXTI->IMR, mask);
+	CLEAR_BIT(EXTI->RTSR, mask);
+	CLEAR_BIT(EXTI->FTSR, mask);
+	EXTI->PR = mask;
+
+	g_exti_handlers[line].callback = NULL;
+	g_exti_handlers[line].context = NULL;
+	g_exti_handlers[line].priority = 0;
+	UpdateExtiIrq(line);
+}
+
+extern bool RLM3_EXTI_IsRegistered(size_t line)
+{
+	return (line < RLM3_EXTI_LINE_COUNT && g_exti_handlers[line].callback != NULL);
+}
+
+extern void RLM3_EXTI_Dispatch(uint32_t pending)
+{
+	pending &= (1UL << RLM3_EXTI_LINE_COUNT) - 1;
+	while (pending != 0)
+	{
+		size_t line = 31 - __builtin_clz(pending);
+		pending &= ~(1UL << line);
+
+		RLM3_EXTI_Callback callback = g_exti_handlers[line].callback;
+		if (callback != NULL)
+			callback(line, g_exti_handlers[line].context);
+		else if (line == 12)
+			RLM3_EXTI12_Callback();
+	}
+}
+
 extern __attribute((weak)) void RLM3_EXTI12_Callback()
 {
+	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
 }
 
-extern void EXTI15_10_IRQHandler()
+static void ExtiInterrupt(uint32_t lines)
+{
+	// Clear only the lines handled by this interrupt before calling their handlers.
+	RLM3_ISR_Begin();
+	uint32_t pending = EXTI->PR & lines;
+	EXTI->PR = pending;
+	RLM3_EXTI_Dispatch(pending);
+	RLM3_ISR_End();
+}
+
+extern void EXTI0_IRQHandler()
+{
+	ExtiInterrupt(EXTI_PR_PR0);
+}
+
+extern void EXTI1_IRQHandler()
 {
-	const uint32_t supported_interrupts = EXTI_PR_PR12;
+	ExtiInterrupt(EXTI_PR_PR1);
+}
 
-	// Get all pending interrupts.
-	uint32_t pending_interrupts = EXTI->PR;
+extern void EXTI2_IRQHandler()
+{
+	ExtiInterrupt(EXTI_PR_PR2);
+}
 
-	// Clear any pending interrupts that will be handled in this function.
-	EXTI->PR = pending_interrupts & supported_interrupts;
+extern void EXTI3_IRQHandler()
+{
+	ExtiInterrupt(EXTI_PR_PR3);
+}
 
-	// Call the handlers for each handled interrupt.
-	if ((pending_interrupts & EXTI_PR_PR12) != 0)
-		RLM3_EXTI12_Callback();
+extern void EXTI4_IRQHandler()
+{
+	ExtiInterrupt(EXTI_PR_PR4);
+}
+
+extern void EXTI9_5_IRQHandler()
+{
+	ExtiInterrupt(EXTI_PR_PR5 | EXTI_PR_PR6 | EXTI_PR_PR7 | EXTI_PR_PR8 | EXTI_PR_PR9);
+}
+
+extern void EXTI15_10_IRQHandler()
+{
+	ExtiInterrupt(EXTI_PR_PR10 | EXTI_PR_PR11 | EXTI_PR_PR12 | EXTI_PR_PR13 | EXTI_PR_PR14 | EXTI_PR_PR15);
 }
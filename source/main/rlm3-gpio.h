@@ -8,8 +8,36 @@
 extern "C" {
 #endif
 
+
+#define RLM3_EXTI_LINE_COUNT 16
+// The most urgent priority that may call the FreeRTOS FromISR functions (configMAX_SYSCALL_INTERRUPT_PRIORITY).
+#define RLM3_EXTI_MIN_PRIORITY 5
+
+
+typedef enum
+{
+	RLM3_EXTI_EDGE_RISING = 1,
+	RLM3_EXTI_EDGE_FALLING = 2,
+	RLM3_EXTI_EDGE_BOTH = 3,
+} RLM3_EXTI_Edge;
+
+typedef void (*RLM3_EXTI_Callback)(size_t line, void* context);
+
+
+// Routes EXTI line n to pin n of the given port and calls the callback from the interrupt on the selected edges.  Lines
+// that share an interrupt (5-9 and 10-15) run at the most urgent priority registered among them.  The priority must be
+// from RLM3_EXTI_MIN_PRIORITY to 15 so callbacks can give to tasks.  The application configures the pin itself.
+extern void RLM3_EXTI_Register(size_t line, GPIO_TypeDef* port, RLM3_EXTI_Edge edge, uint32_t priority, RLM3_EXTI_Callback callback, void* context);
+extern void RLM3_EXTI_Unregister(size_t line);
+extern bool RLM3_EXTI_IsRegistered(size_t line);
+
+// Calls the registered callbacks for each line set in the pending mask, highest line first.
+extern void RLM3_EXTI_Dispatch(uint32_t pending);
+
+// Called for line 12 when no callback is registered for it.
 extern void RLM3_EXTI12_Callback();
 
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,341 @@
+#include "rlm3-i2c-poll.h"
+#include "rlm3-i2c.h"
+#include "rlm3-timer.h"
+#include "rlm3-timer-wheel.h"
+#include "stm32f4xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "rlm3-log.h"
+#include "Assert.h"
+
+
+#ifndef RLM3_I2C_POLL_LOG_LEVEL
+#define RLM3_I2C_POLL_LOG_LEVEL RLM3_LOG_LEVEL_DEFAULT
+#endif
+#define RLM3_LOG_LEVEL RLM3_I2C_POLL_LOG_LEVEL
+
+RLM3_LOG_ZONE(I2C_POLL);
+
+
+#define POLL_NO_JOB 0xFF
+
+
+typedef struct
+{
+	bool is_used;
+	RLM3_I2C1_PollJob job;
+	RLM3_I2C1_PollStats stats;
+	bool has_last;
+	uint32_t last_sequence;
+	uint32_t last_cycles;
+} Poll_Job;
+
+
+static Poll_Job g_poll_jobs[RLM3_I2C1_POLL_JOB_COUNT];
+static uint8_t g_poll_table[RLM3_I2C1_POLL_MAX_SLOTS];
+static uint32_t g_poll_hyperperiod = 1;
+static uint32_t g_poll_slot_us = 0;
+
+static RLM3_TimerWheel_Entry g_poll_entry;
+static volatile RLM3_Task g_poll_task = NULL;
+static RLM3_Task g_poll_stopper = NULL;
+static volatile bool g_poll_is_running = false;
+static volatile uint32_t g_poll_slot_count = 0;
+static volatile uint32_t g_poll_slot_time_us = 0;
+static volatile uint32_t g_poll_slot_cycles = 0;
+static uint32_t g_poll_next_slot = 0;
+
+
+static uint32_t Gcd(uint32_t a, uint32_t b)
+{
+	while (b != 0)
+	{
+		uint32_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+static bool IsPlaceable(uint32_t offset, uint32_t period, uint32_t hyperperiod)
+{
+	for (uint32_t slot = offset; slot < hyperperiod; slot += period)
+		if (g_poll_table[slot] != POLL_NO_JOB)
+			return false;
+	return true;
+}
+
+static bool BuildSchedule()
+{
+	uint64_t hyperperiod = 1;
+	for (size_t i = 0; i < RLM3_I2C1_POLL_JOB_COUNT; i++)
+	{
+		if (!g_poll_jobs[i].is_used)
+			continue;
+		uint32_t period = g_poll_jobs[i].stats.period_slots;
+		hyperperiod = hyperperiod / Gcd((uint32_t)hyperperiod, period) * period;
+		if (hyperperiod > RLM3_I2C1_POLL_MAX_SLOTS)
+			return false;
+	}
+
+	for (size_t i = 0; i < RLM3_I2C1_POLL_MAX_SLOTS; i++)
+		g_poll_table[i] = POLL_NO_JOB;
+
+	// Shortest period first, so the most frequent jobs get the evenly spaced slots.
+	bool is_placed[RLM3_I2C1_POLL_JOB_COUNT] = { false };
+	while (true)
+	{
+		size_t next = RLM3_I2C1_POLL_JOB_COUNT;
+		for (size_t i = 0; i < RLM3_I2C1_POLL_JOB_COUNT; i++)
+			if (g_poll_jobs[i].is_used && !is_placed[i] && (next == RLM3_I2C1_POLL_JOB_COUNT || g_poll_jobs[i].stats.period_slots < g_poll_jobs[next].stats.period_slots))
+				next = i;
+		if (next == RLM3_I2C1_POLL_JOB_COUNT)
+			break;
+
+		uint32_t period = g_poll_jobs[next].stats.period_slots;
+		uint32_t offset = 0;
+		while (offset < period && !IsPlaceable(offset, period, (uint32_t)hyperperiod))
+			offset++;
+		if (offset == period)
+			return false;
+		for (uint32_t slot = offset; slot < hyperperiod; slot += period)
+			g_poll_table[slot] = (uint8_t)next;
+		g_poll_jobs[next].stats.offset_slots = offset;
+		is_placed[next] = true;
+	}
+
+	g_poll_hyperperiod = (uint32_t)hyperperiod;
+	return true;
+}
+
+static void SlotCallback(RLM3_TimerWheel_Entry* entry, void* context)
+{
+	g_poll_slot_cycles = RLM3_GetCycleCount();
+	g_poll_slot_time_us = RLM3_Timer2_Wheel_GetTime();
+	g_poll_slot_count++;
+	RLM3_Task task = g_poll_task;
+	if (task != NULL)
+		RLM3_SignalFromISR(task, RLM3_SIGNAL_I2C_POLL);
+}
+
+static void CountOverrun(uint32_t slot)
+{
+	uint8_t index = g_poll_table[slot % g_poll_hyperperiod];
+	if (index == POLL_NO_JOB)
+		return;
+	RLM3_LOG_TRACE("Overrun %d", (int)index);
+	g_poll_jobs[index].stats.overrun_count++;
+	g_poll_jobs[index].has_last = false;
+}
+
+static void RunSlot(uint32_t slot, uint32_t time_us, uint32_t slot_cycles)
+{
+	uint8_t index = g_poll_table[slot % g_poll_hyperperiod];
+	if (index == POLL_NO_JOB)
+		return;
+	Poll_Job* entry = &g_poll_jobs[index];
+	RLM3_I2C1_PollBuffer* buffer = entry->job.buffer;
+	RLM3_I2C1_PollSample* sample = &buffer->samples[buffer->count % 2];
+
+	if (!RLM3_I2C1_TransmitReceive(entry->job.addr, &entry->job.reg, 1, sample->data, entry->job.size))
+	{
+		entry->stats.error_count++;
+		entry->has_last = false;
+		return;
+	}
+	uint32_t read_cycles = RLM3_GetCycleCount();
+	sample->sequence = slot;
+	sample->time_us = time_us;
+	sample->cycles = read_cycles;
+	sample->size = entry->job.size;
+	RLM3_EnterCritical();
+	buffer->count++;
+	RLM3_ExitCritical();
+
+	entry->stats.sample_count++;
+	uint32_t latency = read_cycles - slot_cycles;
+	if (latency > entry->stats.max_latency_cycles)
+		entry->stats.max_latency_cycles = latency;
+	if (entry->has_last && slot - entry->last_sequence == entry->stats.period_slots)
+	{
+		uint32_t expected = (uint32_t)((uint64_t)entry->stats.period_slots * g_poll_slot_us * (HAL_RCC_GetHCLKFreq() / 1000000));
+		uint32_t interval = read_cycles - entry->last_cycles;
+		uint32_t jitter = (interval > expected) ? interval - expected : expected - interval;
+		if (jitter > entry->stats.max_jitter_cycles)
+			entry->stats.max_jitter_cycles = jitter;
+	}
+	entry->has_last = true;
+	entry->last_sequence = slot;
+	entry->last_cycles = read_cycles;
+
+	if (entry->job.task != NULL)
+		RLM3_Give(entry->job.task);
+}
+
+static void PollTask(void* param)
+{
+	g_poll_task = RLM3_GetCurrentTask();
+	while (g_poll_is_running)
+	{
+		RLM3_EnterCritical();
+		uint32_t count = g_poll_slot_count;
+		uint32_t time_us = g_poll_slot_time_us;
+		uint32_t slot_cycles = g_poll_slot_cycles;
+		RLM3_ExitCritical();
+
+		// Only the latest slot runs.  The ones it passed while a read was late are not made up.
+		if (count != g_poll_next_slot)
+		{
+			uint32_t slot = count - 1;
+			for (uint32_t missed = g_poll_next_slot; missed != slot; missed++)
+				CountOverrun(missed);
+			g_poll_next_slot = count;
+			RunSlot(slot, time_us, slot_cycles);
+		}
+		// A bit of its own, so the reads' waits on Give cannot take a slot or the stop request.
+		RLM3_WaitAny(RLM3_SIGNAL_I2C_POLL, RLM3_WAIT_FOREVER);
+	}
+
+	RLM3_Task stopper = g_poll_stopper;
+	g_poll_task = NULL;
+	RLM3_Give(stopper);
+	vTaskDelete(NULL);
+}
+
+
+extern void RLM3_I2C1_Poll_Init(uint32_t slot_us)
+{
+	ASSERT(!RLM3_I2C1_Poll_IsRunning());
+	ASSERT(slot_us > 0);
+
+	for (size_t i = 0; i < RLM3_I2C1_POLL_JOB_COUNT; i++)
+		g_poll_jobs[i].is_used = false;
+	g_poll_slot_us = slot_us;
+	BuildSchedule();
+}
+
+extern bool RLM3_I2C1_Poll_Add(const RLM3_I2C1_PollJob* job, size_t* id_out)
+{
+	ASSERT(!RLM3_I2C1_Poll_IsRunning());
+	ASSERT(g_poll_slot_us > 0);
+	ASSERT(job != NULL);
+	ASSERT(job->addr <= 0x7F);
+	ASSERT(job->size > 0 && job->size <= RLM3_I2C1_POLL_MAX_SIZE);
+	ASSERT(job->rate_hz > 0);
+	ASSERT(job->buffer != NULL);
+	ASSERT(id_out != NULL);
+
+	uint64_t slot_rate = (uint64_t)job->rate_hz * g_poll_slot_us;
+	if (1000000 % slot_rate != 0)
+		return false;
+	if (RLM3_I2C1_GetTransferTimeUs(job->addr, 1, job->size) > g_poll_slot_us)
+		return false;
+	// Intervals are measured on the 32 bit cycle counter, so a period must be shorter than one wrap of it.
+	if (1000000 / job->rate_hz * (uint64_t)(HAL_RCC_GetHCLKFreq() / 1000000) > UINT32_MAX)
+		return false;
+
+	size_t id = 0;
+	while (id < RLM3_I2C1_POLL_JOB_COUNT && g_poll_jobs[id].is_used)
+		id++;
+	if (id == RLM3_I2C1_POLL_JOB_COUNT)
+		return false;
+
+	Poll_Job* entry = &g_poll_jobs[id];
+	entry->is_used = true;
+	entry->job = *job;
+	entry->stats = (RLM3_I2C1_PollStats){ 0 };
+	entry->stats.period_slots = (uint32_t)(1000000 / slot_rate);
+	entry->has_last = false;
+	if (!BuildSchedule())
+	{
+		entry->is_used = false;
+		bool is_rebuilt = BuildSchedule();
+		ASSERT(is_rebuilt);
+		return false;
+	}
+	*id_out = id;
+	return true;
+}
+
+extern void RLM3_I2C1_Poll_Remove(size_t id)
+{
+	ASSERT(!RLM3_I2C1_Poll_IsRunning());
+	ASSERT(id < RLM3_I2C1_POLL_JOB_COUNT && g_poll_jobs[id].is_used);
+
+	g_poll_jobs[id].is_used = false;
+	bool is_rebuilt = BuildSchedule();
+	ASSERT(is_rebuilt);
+}
+
+extern uint32_t RLM3_I2C1_Poll_GetHyperperiodSlots()
+{
+	return g_poll_hyperperiod;
+}
+
+extern void RLM3_I2C1_Poll_Start(uint32_t priority, size_t stack_size)
+{
+	ASSERT(!RLM3_I2C1_Poll_IsRunning());
+	ASSERT(g_poll_slot_us > 0);
+	ASSERT(priority < configMAX_PRIORITIES);
+	ASSERT(RLM3_Timer2_Wheel_IsInit());
+
+	for (size_t i = 0; i < RLM3_I2C1_POLL_JOB_COUNT; i++)
+		g_poll_jobs[i].has_last = false;
+	g_poll_slot_count = 0;
+	g_poll_next_slot = 0;
+	g_poll_is_running = true;
+	TaskHandle_t task = NULL;
+	BaseType_t status = xTaskCreate(PollTask, "I2C1 Poll", stack_size, NULL, priority, &task);
+	ASSERT(status == pdPASS);
+	g_poll_task = task;
+
+	RLM3_TimerWheel_InitEntry(&g_poll_entry, SlotCallback, NULL, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+	RLM3_Timer2_Wheel_Start(&g_poll_entry, g_poll_slot_us, g_poll_slot_us);
+}
+
+extern void RLM3_I2C1_Poll_Stop()
+{
+	ASSERT(RLM3_I2C1_Poll_IsRunning());
+
+	RLM3_Timer2_Wheel_Cancel(&g_poll_entry);
+	g_poll_stopper = RLM3_GetCurrentTask();
+	g_poll_is_running = false;
+	RLM3_Signal(g_poll_task, RLM3_SIGNAL_I2C_POLL);
+	while (g_poll_task != NULL)
+		RLM3_Take();
+	g_poll_stopper = NULL;
+}
+
+extern bool RLM3_I2C1_Poll_IsRunning()
+{
+	return (g_poll_task != NULL);
+}
+
+extern void RLM3_I2C1_Poll_GetStats(size_t id, RLM3_I2C1_PollStats* stats_out)
+{
+	ASSERT(id < RLM3_I2C1_POLL_JOB_COUNT && g_poll_jobs[id].is_used);
+	ASSERT(stats_out != NULL);
+
+	*stats_out = g_poll_jobs[id].stats;
+}
+
+extern void RLM3_I2C1_PollBuffer_Init(RLM3_I2C1_PollBuffer* buffer)
+{
+	ASSERT(buffer != NULL);
+
+	buffer->count = 0;
+}
+
+extern bool RLM3_I2C1_PollBuffer_Read(RLM3_I2C1_PollBuffer* buffer, RLM3_I2C1_PollSample* sample_out)
+{
+	ASSERT(buffer != NULL);
+	ASSERT(sample_out != NULL);
+
+	// The scheduler only writes the other sample, so the copy just has to finish before the next one is published.
+	RLM3_EnterCritical();
+	uint32_t count = buffer->count;
+	if (count > 0)
+		*sample_out = buffer->samples[(count - 1) % 2];
+	RLM3_ExitCritical();
+	return (count > 0);
+}
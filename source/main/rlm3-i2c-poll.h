@@ -0,0 +1,89 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Polls sensors on I2C1 at fixed rates from a precomputed schedule.  Time is cut into equal slots by a periodic TIM2
+ * wheel entry, and each slot belongs to at most one job, so a job's reads never wait behind another job's.  A job runs
+ * every period_slots slots starting at offset_slots.  The schedule repeats over the least common multiple of the
+ * periods and is built when jobs are added, shortest period first, each job in the first offset where all its slots
+ * are free.
+ *
+ * A slot that is still waiting when the next one starts is skipped and counted as an overrun rather than run late.
+ * Each read is published to the job's double buffer with the TIM2 time of its slot and the cycle count it finished at.
+ *
+ * Jobs are added and removed while the scheduler is stopped.  The application runs the TIM2 wheel and initializes the
+ * I2C1 devices that are polled.
+ */
+
+
+#define RLM3_I2C1_POLL_JOB_COUNT 8
+#define RLM3_I2C1_POLL_MAX_SIZE 16
+#define RLM3_I2C1_POLL_MAX_SLOTS 256
+
+
+typedef struct
+{
+	uint32_t sequence; // Slot number since the scheduler started.
+	uint32_t time_us; // TIM2 wheel time of the slot.
+	uint32_t cycles; // Cycle count when the read finished.
+	uint8_t size;
+	uint8_t data[RLM3_I2C1_POLL_MAX_SIZE];
+} RLM3_I2C1_PollSample;
+
+// The scheduler writes one sample while the other is read.  count is the number of samples published.
+typedef struct
+{
+	RLM3_I2C1_PollSample samples[2];
+	volatile uint32_t count;
+} RLM3_I2C1_PollBuffer;
+
+typedef struct
+{
+	uint8_t addr;
+	uint8_t reg;
+	uint8_t size;
+	uint32_t rate_hz;
+	RLM3_I2C1_PollBuffer* buffer;
+	RLM3_Task task; // Notified after each sample when not NULL.
+} RLM3_I2C1_PollJob;
+
+typedef struct
+{
+	uint32_t offset_slots;
+	uint32_t period_slots;
+	uint32_t sample_count;
+	uint32_t overrun_count;
+	uint32_t error_count;
+	uint32_t max_latency_cycles; // From the start of the slot to the end of the read.
+	uint32_t max_jitter_cycles; // Between consecutive reads, against the job's period.
+} RLM3_I2C1_PollStats;
+
+
+// Clears the jobs and sets the slot length.
+extern void RLM3_I2C1_Poll_Init(uint32_t slot_us);
+// Returns false if the job's period is not a whole number of slots, its read does not fit in a slot, or there is no
+// room for it in the schedule.
+extern bool RLM3_I2C1_Poll_Add(const RLM3_I2C1_PollJob* job, size_t* id_out);
+extern void RLM3_I2C1_Poll_Remove(size_t id);
+extern uint32_t RLM3_I2C1_Poll_GetHyperperiodSlots();
+
+extern void RLM3_I2C1_Poll_Start(uint32_t priority, size_t stack_size);
+extern void RLM3_I2C1_Poll_Stop();
+extern bool RLM3_I2C1_Poll_IsRunning();
+
+extern void RLM3_I2C1_Poll_GetStats(size_t id, RLM3_I2C1_PollStats* stats_out);
+extern void RLM3_I2C1_PollBuffer_Init(RLM3_I2C1_PollBuffer* buffer);
+// Copies the latest sample.  Returns false if nothing has been published yet.
+extern bool RLM3_I2C1_PollBuffer_Read(RLM3_I2C1_PollBuffer* buffer, RLM3_I2C1_PollSample* sample_out);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,15 +1,32 @@
 #include "rlm3-i2c.h"
-#include "rlm3-lock.h"
 #include "rlm3-task.h"
 #include "stm32f4xx_hal.h"
 #include "stm32f4xx_hal_i2c.h"
 #include "main.h"
-#include "logger.h"
+#include "rlm3-log.h"
 #include "i2c.h"
 #include "Assert.h"
 
 
-LOGGER_ZONE(I2C);
+#ifndef RLM3_I2C_LOG_LEVEL
+#define RLM3_I2C_LOG_LEVEL RLM3_LOG_LEVEL_DEFAULT
+#endif
+#define RLM3_LOG_LEVEL RLM3_I2C_LOG_LEVEL
+
+RLM3_LOG_ZONE(I2C);
+
+
+#ifndef RLM3_I2C1_SCL_PORT
+#define RLM3_I2C1_SCL_PORT GPIOB
+#define RLM3_I2C1_SCL_PIN GPIO_PIN_8
+#endif
+#ifndef RLM3_I2C1_SDA_PORT
+#define RLM3_I2C1_SDA_PORT GPIOB
+#define RLM3_I2C1_SDA_PIN GPIO_PIN_9
+#endif
+
+#define I2C_RECOVERY_CLOCKS 9
+#define I2C_RECOVERY_HALF_PERIOD_US 5
 
 
 enum
@@ -22,47 +39,371 @@ enum
 	I2C_STATE_RX_DONE,
 };
 
+typedef struct
+{
+	bool is_used;
+	uint8_t addr;
+	RLM3_I2C1_Policy policy;
+} I2C_PolicyEntry;
 
-static RLM3_SpinLock g_lock_i2c1;
+typedef struct
+{
+	bool is_set;
+	uint8_t addr;
+	RLM3_I2C1_Speed speed;
+} I2C_DeviceSpeed;
+
+// A task waiting for the bus.  It lives on the waiting task's stack until the task is woken.
+typedef struct I2C_BusWaiter
+{
+	struct I2C_BusWaiter* next;
+	RLM3_Task task;
+	RLM3_I2C1_Speed speed;
+	volatile bool is_granted;
+} I2C_BusWaiter;
+
+
+static volatile bool g_is_bus_owned_i2c1 = false;
+static I2C_BusWaiter* g_bus_waiters_i2c1 = NULL;
 
 static uint8_t g_active_devices_i2c1 = 0;
 
 static volatile uint8_t g_state_i2c1 = I2C_STATE_IDLE;
 static volatile RLM3_Task g_waiting_thread_i2c1 = NULL;
 
+static const RLM3_I2C1_Policy g_default_policy_i2c1 = { .timeout_ms = 0, .retry_count = 1, .retry_delay_ms = 0, .is_nack_retried = false };
+static I2C_PolicyEntry g_policies_i2c1[RLM3_I2C1_POLICY_COUNT];
+static RLM3_I2C1_Counters g_counters_i2c1;
+
+static I2C_DeviceSpeed g_device_speeds_i2c1[RLM3_I2C1_DEVICE_COUNT];
+static uint8_t g_batch_count_i2c1 = 0;
 
-static __attribute__((constructor)) void Init_I2C()
+
+static I2C_PolicyEntry* FindPolicyEntry(uint32_t addr)
+{
+	for (size_t i = 0; i < RLM3_I2C1_POLICY_COUNT; i++)
+		if (g_policies_i2c1[i].is_used && g_policies_i2c1[i].addr == addr)
+			return &g_policies_i2c1[i];
+	return NULL;
+}
+
+static RLM3_I2C1_Policy GetPolicy(uint32_t addr)
+{
+	I2C_PolicyEntry* entry = FindPolicyEntry(addr);
+	return (entry != NULL) ? entry->policy : g_default_policy_i2c1;
+}
+
+static RLM3_I2C1_Speed GetAddressSpeed(uint32_t addr)
 {
-	RLM3_SpinLock_Init(&g_lock_i2c1);
+	for (size_t i = 0; i < RLM3_I2C1_DEVICE_COUNT; i++)
+		if (g_device_speeds_i2c1[i].is_set && g_device_speeds_i2c1[i].addr == addr && READ_BIT(g_active_devices_i2c1, 1 << i) != 0)
+			return g_device_speeds_i2c1[i].speed;
+	return RLM3_I2C1_SPEED_STANDARD;
 }
 
+static bool IsAtBusRate(RLM3_I2C1_Speed speed)
+{
+	// Callers that do not transfer anything have no rate and fit in any batch.
+	return (speed == RLM3_I2C1_SPEED_COUNT || RLM3_I2C1_GetSpeedHz(speed) == hi2c1.Init.ClockSpeed);
+}
+
+static void EnterBus(RLM3_I2C1_Speed speed)
+{
+	I2C_BusWaiter waiter = { NULL, RLM3_GetCurrentTask(), speed, false };
+	bool is_retry = false;
+	while (true)
+	{
+		RLM3_EnterCritical();
+		if (!g_is_bus_owned_i2c1)
+		{
+			g_is_bus_owned_i2c1 = true;
+			RLM3_ExitCritical();
+			return;
+		}
+		// A waiter woken to try again keeps its place at the front.
+		I2C_BusWaiter** cursor = &g_bus_waiters_i2c1;
+		while (!is_retry && *cursor != NULL)
+			cursor = &(*cursor)->next;
+		waiter.next = *cursor;
+		*cursor = &waiter;
+		RLM3_ExitCritical();
+		is_retry = true;
+
+		// Leaving the bus takes this waiter off the list and signals it once.  A bit of its own keeps the wait from
+		// taking gives meant for the task's other work.
+		RLM3_WaitAny(RLM3_SIGNAL_I2C_BUS, RLM3_WAIT_FOREVER);
+		if (waiter.is_granted)
+			return;
+	}
+}
+
+static void LeaveBus()
+{
+	// While the batch lasts, a waiter at the bus's rate is handed the bus.  A waiter that would change the rate is
+	// only woken to try again, so a task at the current rate that comes straight back keeps the bus.  Once the batch
+	// is full, the first waiter at another rate is handed the bus instead.
+	RLM3_EnterCritical();
+	bool is_batch_full = (g_batch_count_i2c1 >= RLM3_I2C1_SPEED_BATCH_LIMIT);
+	I2C_BusWaiter** selected = NULL;
+	for (I2C_BusWaiter** cursor = &g_bus_waiters_i2c1; *cursor != NULL && selected == NULL; cursor = &(*cursor)->next)
+		if (IsAtBusRate((*cursor)->speed) != is_batch_full)
+			selected = cursor;
+	if (selected == NULL && g_bus_waiters_i2c1 != NULL)
+		selected = &g_bus_waiters_i2c1;
+
+	RLM3_Task task = NULL;
+	if (selected != NULL)
+	{
+		I2C_BusWaiter* waiter = *selected;
+		*selected = waiter->next;
+		task = waiter->task;
+		waiter->is_granted = (is_batch_full || IsAtBusRate(waiter->speed));
+		g_is_bus_owned_i2c1 = waiter->is_granted;
+	}
+	else
+		g_is_bus_owned_i2c1 = false;
+	RLM3_ExitCritical();
+
+	if (task != NULL)
+		RLM3_Signal(task, RLM3_SIGNAL_I2C_BUS);
+}
+
+static void SetBusSpeed(RLM3_I2C1_Speed speed)
+{
+	uint32_t clock_hz = RLM3_I2C1_GetSpeedHz(speed);
+	if (hi2c1.Init.ClockSpeed == clock_hz)
+	{
+		g_batch_count_i2c1++;
+		return;
+	}
+
+	RLM3_I2C1_Timing timing;
+	bool is_valid = RLM3_I2C1_ComputeTiming(HAL_RCC_GetPCLK1Freq(), clock_hz, &timing);
+	ASSERT(is_valid);
+	RLM3_LOG_TRACE("Speed %d", (int)clock_hz);
+	hi2c1.Init.ClockSpeed = clock_hz;
+	hi2c1.Init.DutyCycle = timing.is_duty_16_9 ? I2C_DUTYCYCLE_16_9 : I2C_DUTYCYCLE_2;
+	HAL_I2C_Init(&hi2c1);
+	g_counters_i2c1.speed_change_count++;
+	g_batch_count_i2c1 = 1;
+}
+
+static RLM3_Time GetDefaultTimeout(size_t tx_size, size_t rx_size)
+{
+	// Each frame is a START, the address and the data bytes with their acknowledge bits, then a STOP or repeated START.
+	uint64_t bits = 9 * ((uint64_t)tx_size + rx_size + 2) + 2;
+	uint64_t wire_ms = (bits * 1000 + hi2c1.Init.ClockSpeed - 1) / hi2c1.Init.ClockSpeed;
+	return (RLM3_Time)(2 * wire_ms) + RLM3_I2C1_TIMEOUT_MARGIN_MS;
+}
+
+static void RecoveryDelay()
+{
+	uint32_t cycles = HAL_RCC_GetHCLKFreq() / 1000000 * I2C_RECOVERY_HALF_PERIOD_US;
+	uint32_t start = RLM3_GetCycleCount();
+	while (RLM3_GetCycleCount() - start < cycles)
+		;
+}
+
+static bool RecoverBus()
+{
+	uint32_t start_cycles = RLM3_GetCycleCount();
+	RLM3_LOG_WARN("Recover");
+
+	HAL_I2C_DeInit(&hi2c1);
+
+	// Take both lines over as open drain outputs, released high.
+	HAL_GPIO_WritePin(RLM3_I2C1_SCL_PORT, RLM3_I2C1_SCL_PIN, GPIO_PIN_SET);
+	HAL_GPIO_WritePin(RLM3_I2C1_SDA_PORT, RLM3_I2C1_SDA_PIN, GPIO_PIN_SET);
+	GPIO_InitTypeDef init = { 0 };
+	init.Mode = GPIO_MODE_OUTPUT_OD;
+	init.Pull = GPIO_PULLUP;
+	init.Speed = GPIO_SPEED_FREQ_LOW;
+	init.Pin = RLM3_I2C1_SCL_PIN;
+	HAL_GPIO_Init(RLM3_I2C1_SCL_PORT, &init);
+	init.Pin = RLM3_I2C1_SDA_PIN;
+	HAL_GPIO_Init(RLM3_I2C1_SDA_PORT, &init);
+	RecoveryDelay();
+
+	// A slave cut off part way through a byte lets go of SDA within nine clocks.
+	for (size_t i = 0; i < I2C_RECOVERY_CLOCKS && HAL_GPIO_ReadPin(RLM3_I2C1_SDA_PORT, RLM3_I2C1_SDA_PIN) == GPIO_PIN_RESET; i++)
+	{
+		HAL_GPIO_WritePin(RLM3_I2C1_SCL_PORT, RLM3_I2C1_SCL_PIN, GPIO_PIN_RESET);
+		RecoveryDelay();
+		HAL_GPIO_WritePin(RLM3_I2C1_SCL_PORT, RLM3_I2C1_SCL_PIN, GPIO_PIN_SET);
+		RecoveryDelay();
+	}
+
+	// A STOP, with SDA rising while SCL is high, puts every slave back to waiting for a START.
+	HAL_GPIO_WritePin(RLM3_I2C1_SCL_PORT, RLM3_I2C1_SCL_PIN, GPIO_PIN_RESET);
+	HAL_GPIO_WritePin(RLM3_I2C1_SDA_PORT, RLM3_I2C1_SDA_PIN, GPIO_PIN_RESET);
+	RecoveryDelay();
+	HAL_GPIO_WritePin(RLM3_I2C1_SCL_PORT, RLM3_I2C1_SCL_PIN, GPIO_PIN_SET);
+	RecoveryDelay();
+	HAL_GPIO_WritePin(RLM3_I2C1_SDA_PORT, RLM3_I2C1_SDA_PIN, GPIO_PIN_SET);
+	RecoveryDelay();
+	bool is_released = (HAL_GPIO_ReadPin(RLM3_I2C1_SDA_PORT, RLM3_I2C1_SDA_PIN) == GPIO_PIN_SET &&
+			HAL_GPIO_ReadPin(RLM3_I2C1_SCL_PORT, RLM3_I2C1_SCL_PIN) == GPIO_PIN_SET);
+
+	// The peripheral can be left thinking the bus is busy, so reset it before handing the pins back.
+	__HAL_RCC_I2C1_CLK_ENABLE();
+	SET_BIT(hi2c1.Instance->CR1, I2C_CR1_SWRST);
+	CLEAR_BIT(hi2c1.Instance->CR1, I2C_CR1_SWRST);
+	MX_I2C1_Init();
+
+	uint32_t cycles = RLM3_GetCycleCount() - start_cycles;
+	g_counters_i2c1.recovery_count++;
+	if (!is_released)
+		g_counters_i2c1.recovery_failed_count++;
+	g_counters_i2c1.last_recovery_cycles = cycles;
+	if (cycles > g_counters_i2c1.max_recovery_cycles)
+		g_counters_i2c1.max_recovery_cycles = cycles;
+	if (!is_released)
+		RLM3_LOG_ERROR("Stuck");
+	return is_released;
+}
+
+static RLM3_I2C1_Result WaitForTransfer(HAL_StatusTypeDef status, uint8_t wait_state, uint8_t done_state, RLM3_Time start_time, RLM3_Time timeout_ms)
+{
+	if (status == HAL_BUSY)
+		return RLM3_I2C1_RESULT_BUSY;
+	if (status != HAL_OK)
+		return RLM3_I2C1_RESULT_BUS_ERROR;
+
+	bool is_timely = true;
+	while (is_timely && g_state_i2c1 == wait_state)
+		is_timely = RLM3_TakeUntil(start_time, timeout_ms);
+
+	uint8_t state = g_state_i2c1;
+	if (state == done_state)
+		return RLM3_I2C1_RESULT_OK;
+	if (state == wait_state)
+		return RLM3_I2C1_RESULT_TIMEOUT;
+	uint32_t error = HAL_I2C_GetError(&hi2c1);
+	if ((error & HAL_I2C_ERROR_AF) != 0)
+		return RLM3_I2C1_RESULT_NACK;
+	if ((error & HAL_I2C_ERROR_ARLO) != 0)
+		return RLM3_I2C1_RESULT_ARBITRATION_LOST;
+	return RLM3_I2C1_RESULT_BUS_ERROR;
+}
+
+static RLM3_I2C1_Result TransferOnce(uint32_t addr, const uint8_t* tx_data, size_t tx_size, uint8_t* rx_data, size_t rx_size, RLM3_Time timeout_ms)
+{
+	ASSERT(g_waiting_thread_i2c1 == NULL);
+	ASSERT(g_state_i2c1 == I2C_STATE_IDLE);
+	RLM3_Time start_time = RLM3_GetCurrentTime();
+	g_waiting_thread_i2c1 = RLM3_GetCurrentTask();
+
+	RLM3_I2C1_Result result = RLM3_I2C1_RESULT_OK;
+	if (tx_size > 0)
+	{
+		HAL_StatusTypeDef status;
+		g_state_i2c1 = I2C_STATE_TX_WAIT;
+		if (rx_size > 0)
+			status = HAL_I2C_Master_Seq_Transmit_IT(&hi2c1, (addr << 1) | 0x00, (uint8_t*)tx_data, tx_size, I2C_FIRST_FRAME);
+		else
+			status = HAL_I2C_Master_Transmit_IT(&hi2c1, (addr << 1) | 0x00, (uint8_t*)tx_data, tx_size);
+		result = WaitForTransfer(status, I2C_STATE_TX_WAIT, I2C_STATE_TX_DONE, start_time, timeout_ms);
+	}
+	if (result == RLM3_I2C1_RESULT_OK && rx_size > 0)
+	{
+		HAL_StatusTypeDef status;
+		g_state_i2c1 = I2C_STATE_RX_WAIT;
+		if (tx_size > 0)
+			status = HAL_I2C_Master_Seq_Receive_IT(&hi2c1, (addr << 1) | 0x01, rx_data, rx_size, I2C_LAST_FRAME);
+		else
+			status = HAL_I2C_Master_Receive_IT(&hi2c1, (addr << 1) | 0x01, rx_data, rx_size);
+		result = WaitForTransfer(status, I2C_STATE_RX_WAIT, I2C_STATE_RX_DONE, start_time, timeout_ms);
+	}
+
+	RLM3_EnterCritical();
+	g_waiting_thread_i2c1 = NULL;
+	g_state_i2c1 = I2C_STATE_IDLE;
+	RLM3_ExitCritical();
+
+	return result;
+}
+
+static void CountResult(RLM3_I2C1_Result result)
+{
+	switch (result)
+	{
+	case RLM3_I2C1_RESULT_OK: break;
+	case RLM3_I2C1_RESULT_NACK: g_counters_i2c1.nack_count++; break;
+	case RLM3_I2C1_RESULT_ARBITRATION_LOST: g_counters_i2c1.arbitration_lost_count++; break;
+	case RLM3_I2C1_RESULT_BUS_ERROR: g_counters_i2c1.bus_error_count++; break;
+	case RLM3_I2C1_RESULT_BUSY: g_counters_i2c1.busy_count++; break;
+	case RLM3_I2C1_RESULT_TIMEOUT: g_counters_i2c1.timeout_count++; break;
+	}
+}
+
+static RLM3_I2C1_Result Transact(uint32_t addr, const uint8_t* tx_data, size_t tx_size, uint8_t* rx_data, size_t rx_size, RLM3_Time timeout_ms)
+{
+	ASSERT(g_active_devices_i2c1 != 0);
+	ASSERT(addr <= 0x7F);
+
+	RLM3_I2C1_Speed speed = GetAddressSpeed(addr);
+	EnterBus(speed);
+	SetBusSpeed(speed);
+	RLM3_I2C1_Policy policy = GetPolicy(addr);
+	if (timeout_ms == 0)
+		timeout_ms = policy.timeout_ms;
+	if (timeout_ms == 0)
+		timeout_ms = GetDefaultTimeout(tx_size, rx_size);
+
+	g_counters_i2c1.transaction_count++;
+	RLM3_I2C1_Result result;
+	for (size_t attempt = 0; ; attempt++)
+	{
+		// A recovery puts the bus back to the rate MX_I2C1_Init configures.
+		if (attempt > 0)
+			SetBusSpeed(speed);
+		result = TransferOnce(addr, tx_data, tx_size, rx_data, rx_size, timeout_ms);
+		CountResult(result);
+		if (result == RLM3_I2C1_RESULT_TIMEOUT || result == RLM3_I2C1_RESULT_BUSY || result == RLM3_I2C1_RESULT_BUS_ERROR)
+			RecoverBus();
+		if (result == RLM3_I2C1_RESULT_OK || attempt >= policy.retry_count || (result == RLM3_I2C1_RESULT_NACK && !policy.is_nack_retried))
+			break;
+		g_counters_i2c1.retry_count++;
+		if (policy.retry_delay_ms > 0)
+			RLM3_Delay(policy.retry_delay_ms);
+	}
+	LeaveBus();
+
+#if RLM3_LOG_LEVEL >= RLM3_LOG_LEVEL_TRACE
+	// Print what the interrupt traced for this transaction.
+	RLM3_Log_FlushDeferred();
+#endif
+	if (result != RLM3_I2C1_RESULT_OK)
+		RLM3_LOG_DEBUG("Fail(%x) %d", (int)addr, result);
+	return result;
+}
 
 extern void RLM3_I2C1_Init(RLM3_I2C1_DEVICE device)
 {
-	LOG_TRACE("Init %d", device);
+	RLM3_LOG_TRACE("Init %d", device);
 
 	ASSERT(device < RLM3_I2C1_DEVICE_COUNT);
 	ASSERT(READ_BIT(g_active_devices_i2c1, 1 << device) == 0);
 
-	RLM3_SpinLock_Enter(&g_lock_i2c1);
+	EnterBus(RLM3_I2C1_SPEED_COUNT);
 	if (g_active_devices_i2c1 == 0)
 		MX_I2C1_Init();
 	SET_BIT(g_active_devices_i2c1, 1 << device);
-	RLM3_SpinLock_Leave(&g_lock_i2c1);
+	LeaveBus();
 }
 
 extern void RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE device)
 {
-	LOG_TRACE("Deinit %d", device);
+	RLM3_LOG_TRACE("Deinit %d", device);
 
 	ASSERT(device < RLM3_I2C1_DEVICE_COUNT);
 	ASSERT(READ_BIT(g_active_devices_i2c1, 1 << device) != 0);
 
-	RLM3_SpinLock_Enter(&g_lock_i2c1);
+	EnterBus(RLM3_I2C1_SPEED_COUNT);
 	CLEAR_BIT(g_active_devices_i2c1, 1 << device);
 	if (g_active_devices_i2c1 == 0)
 		HAL_I2C_DeInit(&hi2c1);
-	RLM3_SpinLock_Leave(&g_lock_i2c1);
+	LeaveBus();
 }
 
 extern bool RLM3_I2C1_IsInit(RLM3_I2C1_DEVICE device)
@@ -70,105 +411,184 @@ extern bool RLM3_I2C1_IsInit(RLM3_I2C1_DEVICE device)
 	return (READ_BIT(g_active_devices_i2c1, 1 << device) != 0);
 }
 
-extern bool RLM3_I2C1_Transmit(uint32_t addr, const uint8_t* data, size_t size)
+extern void RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE device, uint32_t addr, RLM3_I2C1_Speed speed)
 {
-	LOG_TRACE("TX(%x) %d", (int)addr, size);
-
-	ASSERT(g_active_devices_i2c1 != 0);
+	ASSERT(device < RLM3_I2C1_DEVICE_COUNT);
 	ASSERT(addr <= 0x7F);
-	ASSERT(data != NULL);
-	ASSERT(size > 0);
+	ASSERT(speed < RLM3_I2C1_SPEED_COUNT);
 
-	RLM3_SpinLock_Enter(&g_lock_i2c1);
-	ASSERT(g_waiting_thread_i2c1 == NULL);
-	ASSERT(g_state_i2c1 == I2C_STATE_IDLE);
-	g_waiting_thread_i2c1 = RLM3_GetCurrentTask();
-	g_state_i2c1 = I2C_STATE_TX_WAIT;
+	EnterBus(RLM3_I2C1_SPEED_COUNT);
+	g_device_speeds_i2c1[device].is_set = true;
+	g_device_speeds_i2c1[device].addr = addr;
+	g_device_speeds_i2c1[device].speed = speed;
+	LeaveBus();
+}
 
-	HAL_StatusTypeDef status = HAL_I2C_Master_Transmit_IT(&hi2c1, (addr << 1) | 0x00, (uint8_t*)data, size);
-	while (status == HAL_OK && g_state_i2c1 == I2C_STATE_TX_WAIT)
-		RLM3_Take();
-	bool result = (status == HAL_OK && g_state_i2c1 == I2C_STATE_TX_DONE);
+extern RLM3_I2C1_Speed RLM3_I2C1_GetDeviceSpeed(RLM3_I2C1_DEVICE device)
+{
+	ASSERT(device < RLM3_I2C1_DEVICE_COUNT);
+	return g_device_speeds_i2c1[device].is_set ? g_device_speeds_i2c1[device].speed : RLM3_I2C1_SPEED_STANDARD;
+}
 
-	g_waiting_thread_i2c1 = NULL;
-	g_state_i2c1 = I2C_STATE_IDLE;
-	RLM3_SpinLock_Leave(&g_lock_i2c1);
+extern uint32_t RLM3_I2C1_GetSpeedHz(RLM3_I2C1_Speed speed)
+{
+	static const uint32_t speed_hz[RLM3_I2C1_SPEED_COUNT] = { 100000, 400000, 1000000 };
+	ASSERT(speed < RLM3_I2C1_SPEED_COUNT);
+	return (speed_hz[speed] < RLM3_I2C1_MAX_CLOCK_HZ) ? speed_hz[speed] : RLM3_I2C1_MAX_CLOCK_HZ;
+}
 
-	return result;
+extern bool RLM3_I2C1_ComputeTiming(uint32_t pclk1_hz, uint32_t clock_hz, RLM3_I2C1_Timing* timing_out)
+{
+	ASSERT(clock_hz > 0);
+	ASSERT(timing_out != NULL);
+
+	// The peripheral times SCL in bus clocks: 2 per period in Standard mode, 3 or 25 in Fast mode depending on the duty
+	// cycle.  The HAL rounds the divisor up, so the rate comes out at or below the one asked for.
+	uint32_t freq_mhz = pclk1_hz / 1000000;
+	RLM3_I2C1_Timing timing = { 0 };
+	if (clock_hz <= 100000)
+	{
+		if (freq_mhz < 2)
+			return false;
+		timing.ccr = (pclk1_hz - 1) / (clock_hz * 2) + 1;
+		if (timing.ccr < 4)
+			timing.ccr = 4;
+		timing.trise = freq_mhz + 1;
+		timing.clock_hz = pclk1_hz / (timing.ccr * 2);
+	}
+	else
+	{
+		if (freq_mhz < 4 || clock_hz > 400000)
+			return false;
+		uint32_t ccr_2 = (pclk1_hz - 1) / (clock_hz * 3) + 1;
+		uint32_t ccr_16_9 = (pclk1_hz - 1) / (clock_hz * 25) + 1;
+		uint32_t clock_2 = pclk1_hz / (ccr_2 * 3);
+		uint32_t clock_16_9 = pclk1_hz / (ccr_16_9 * 25);
+		timing.is_fast = true;
+		timing.is_duty_16_9 = (clock_16_9 > clock_2);
+		timing.ccr = timing.is_duty_16_9 ? ccr_16_9 : ccr_2;
+		timing.clock_hz = timing.is_duty_16_9 ? clock_16_9 : clock_2;
+		timing.trise = freq_mhz * 300 / 1000 + 1;
+	}
+	*timing_out = timing;
+	return true;
+}
+
+extern uint32_t RLM3_I2C1_GetTransferTimeUs(uint32_t addr, size_t tx_size, size_t rx_size)
+{
+	ASSERT(addr <= 0x7F);
+
+	// A START or repeated START per frame, the address and data bytes with their acknowledge bits, and a STOP.
+	size_t frames = ((tx_size > 0) ? 1 : 0) + ((rx_size > 0) ? 1 : 0);
+	uint64_t bits = 9 * ((uint64_t)tx_size + rx_size + frames) + frames + 1;
+	uint32_t clock_hz = RLM3_I2C1_GetSpeedHz(GetAddressSpeed(addr));
+	return (uint32_t)((bits * 1000000 + clock_hz - 1) / clock_hz);
+}
+
+extern bool RLM3_I2C1_Transmit(uint32_t addr, const uint8_t* data, size_t size)
+{
+	return RLM3_I2C1_TransmitWithTimeout(addr, data, size, 0) == RLM3_I2C1_RESULT_OK;
 }
 
 extern bool RLM3_I2C1_Receive(uint32_t addr, uint8_t* data, size_t size)
 {
-	LOG_TRACE("RX(%x) %d", (int)addr, size);
+	return RLM3_I2C1_ReceiveWithTimeout(addr, data, size, 0) == RLM3_I2C1_RESULT_OK;
+}
+
+extern bool RLM3_I2C1_TransmitReceive(uint32_t addr, const uint8_t* tx_data, size_t tx_size, uint8_t* rx_data, size_t rx_size)
+{
+	return RLM3_I2C1_TransmitReceiveWithTimeout(addr, tx_data, tx_size, rx_data, rx_size, 0) == RLM3_I2C1_RESULT_OK;
+}
+
+extern RLM3_I2C1_Result RLM3_I2C1_TransmitWithTimeout(uint32_t addr, const uint8_t* data, size_t size, RLM3_Time timeout_ms)
+{
+	RLM3_LOG_TRACE("TX(%x) %d", (int)addr, size);
 
-	ASSERT(g_active_devices_i2c1 != 0);
-	ASSERT(addr <= 0x7F);
 	ASSERT(data != NULL);
 	ASSERT(size > 0);
 
-	RLM3_SpinLock_Enter(&g_lock_i2c1);
-	ASSERT(g_waiting_thread_i2c1 == NULL);
-	ASSERT(g_state_i2c1 == I2C_STATE_IDLE);
-	g_waiting_thread_i2c1 = RLM3_GetCurrentTask();
-	g_state_i2c1 = I2C_STATE_RX_WAIT;
+	return Transact(addr, data, size, NULL, 0, timeout_ms);
+}
 
-	HAL_StatusTypeDef status = HAL_I2C_Master_Receive_IT(&hi2c1, (addr << 1) | 0x01, data, size);
-	while (status == HAL_OK && hi2c1.State == HAL_I2C_STATE_BUSY_RX)
-		RLM3_Take();
-	bool result = (status == HAL_OK && g_state_i2c1 == I2C_STATE_RX_DONE);
+extern RLM3_I2C1_Result RLM3_I2C1_ReceiveWithTimeout(uint32_t addr, uint8_t* data, size_t size, RLM3_Time timeout_ms)
+{
+	RLM3_LOG_TRACE("RX(%x) %d", (int)addr, size);
 
-	g_waiting_thread_i2c1 = NULL;
-	g_state_i2c1 = I2C_STATE_IDLE;
-	RLM3_SpinLock_Leave(&g_lock_i2c1);
+	ASSERT(data != NULL);
+	ASSERT(size > 0);
 
-	return result;
+	return Transact(addr, NULL, 0, data, size, timeout_ms);
 }
 
-extern bool RLM3_I2C1_TransmitReceive(uint32_t addr, const uint8_t* tx_data, size_t tx_size, uint8_t* rx_data, size_t rx_size)
+extern RLM3_I2C1_Result RLM3_I2C1_TransmitReceiveWithTimeout(uint32_t addr, const uint8_t* tx_data, size_t tx_size, uint8_t* rx_data, size_t rx_size, RLM3_Time timeout_ms)
 {
-	LOG_TRACE("TR(%x) %d %d", (int)addr, tx_size, rx_size);
+	RLM3_LOG_TRACE("TR(%x) %d %d", (int)addr, tx_size, rx_size);
 
-	ASSERT(g_active_devices_i2c1 != 0);
-	ASSERT(addr <= 0x7F);
 	ASSERT(tx_data != NULL && rx_data != NULL);
 	ASSERT(tx_size > 0 && rx_size > 0);
 
-	RLM3_SpinLock_Enter(&g_lock_i2c1);
-	ASSERT(g_waiting_thread_i2c1 == NULL);
-	ASSERT(g_state_i2c1 == I2C_STATE_IDLE);
-	g_waiting_thread_i2c1 = RLM3_GetCurrentTask();
+	return Transact(addr, tx_data, tx_size, rx_data, rx_size, timeout_ms);
+}
 
-	HAL_StatusTypeDef status = HAL_OK;
+extern void RLM3_I2C1_SetPolicy(uint32_t addr, const RLM3_I2C1_Policy* policy)
+{
+	ASSERT(addr <= 0x7F);
 
-	if (status == HAL_OK)
+	EnterBus(RLM3_I2C1_SPEED_COUNT);
+	I2C_PolicyEntry* entry = FindPolicyEntry(addr);
+	if (policy == NULL)
 	{
-		g_state_i2c1 = I2C_STATE_TX_WAIT;
-		status = HAL_I2C_Master_Seq_Transmit_IT(&hi2c1, (addr << 1) | 0x00, (uint8_t*)tx_data, tx_size, I2C_FIRST_FRAME);
+		if (entry != NULL)
+			entry->is_used = false;
 	}
-	while (status == HAL_OK && g_state_i2c1 == I2C_STATE_TX_WAIT)
-		RLM3_Take();
-
-	if (status == HAL_OK && g_state_i2c1 == I2C_STATE_TX_DONE)
+	else
 	{
-		g_state_i2c1 = I2C_STATE_RX_WAIT;
-		status = HAL_I2C_Master_Seq_Receive_IT(&hi2c1, (addr << 1) | 0x01, rx_data, rx_size, I2C_LAST_FRAME);
+		for (size_t i = 0; entry == NULL && i < RLM3_I2C1_POLICY_COUNT; i++)
+			if (!g_policies_i2c1[i].is_used)
+				entry = &g_policies_i2c1[i];
+		ASSERT(entry != NULL);
+		entry->is_used = true;
+		entry->addr = addr;
+		entry->policy = *policy;
 	}
-	while (status == HAL_OK && g_state_i2c1 == I2C_STATE_RX_WAIT)
-		RLM3_Take();
+	LeaveBus();
+}
 
-	bool result = (status == HAL_OK && g_state_i2c1 == I2C_STATE_RX_DONE);
+extern void RLM3_I2C1_GetPolicy(uint32_t addr, RLM3_I2C1_Policy* policy_out)
+{
+	ASSERT(addr <= 0x7F);
+	ASSERT(policy_out != NULL);
 
-	g_waiting_thread_i2c1 = NULL;
-	g_state_i2c1 = I2C_STATE_IDLE;
-	RLM3_SpinLock_Leave(&g_lock_i2c1);
+	EnterBus(RLM3_I2C1_SPEED_COUNT);
+	*policy_out = GetPolicy(addr);
+	LeaveBus();
+}
+
+extern bool RLM3_I2C1_RecoverBus()
+{
+	ASSERT(g_active_devices_i2c1 != 0);
+
+	EnterBus(RLM3_I2C1_SPEED_COUNT);
+	bool result = RecoverBus();
+	LeaveBus();
 
 	return result;
 }
 
-static void WakeupWaitingThreadFromISR(I2C_HandleTypeDef *hi2c, uint8_t new_state, const char* type)
+extern void RLM3_I2C1_GetCounters(RLM3_I2C1_Counters* counters_out)
+{
+	ASSERT(counters_out != NULL);
+
+	RLM3_EnterCritical();
+	*counters_out = g_counters_i2c1;
+	RLM3_ExitCritical();
+}
+
+static void WakeupWaitingThreadFromISR(I2C_HandleTypeDef *hi2c, uint8_t new_state)
 {
-	LOG_TRACE("ISR %s", type);
-	if (hi2c == &hi2c1)
+	RLM3_LOG_DEFER_TRACE("ISR %u %x", new_state, hi2c->ErrorCode);
+	// A transfer that completes after its caller timed out has nobody waiting for it.
+	if (hi2c == &hi2c1 && g_waiting_thread_i2c1 != NULL)
 	{
 		g_state_i2c1 = new_state;
 		RLM3_GiveFromISR(g_waiting_thread_i2c1);
@@ -177,15 +597,15 @@ static void WakeupWaitingThreadFromISR(I2C_HandleTypeDef *hi2c, uint8_t new_stat
 
 extern void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
-	WakeupWaitingThreadFromISR(hi2c, I2C_STATE_TX_DONE, "TX");
+	WakeupWaitingThreadFromISR(hi2c, I2C_STATE_TX_DONE);
 }
 
 extern void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
 {
-	WakeupWaitingThreadFromISR(hi2c, I2C_STATE_RX_DONE, "RX");
+	WakeupWaitingThreadFromISR(hi2c, I2C_STATE_RX_DONE);
 }
 
 extern void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
 {
-	WakeupWaitingThreadFromISR(hi2c, I2C_STATE_ERROR, "ER");
+	WakeupWaitingThreadFromISR(hi2c, I2C_STATE_ERROR);
 }
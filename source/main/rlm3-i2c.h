@@ -1,12 +1,25 @@
 #pragma once
 
 #include "rlm3-base.h"
+#include "rlm3-task.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
+#define RLM3_I2C1_TIMEOUT_MARGIN_MS 10
+#define RLM3_I2C1_POLICY_COUNT 8
+#define RLM3_I2C1_SPEED_BATCH_LIMIT 8
+// The F4 I2C peripheral stops at Fast mode, so this can be lowered for a slow bus but not raised past 400 kHz.
+#ifndef RLM3_I2C1_MAX_CLOCK_HZ
+#define RLM3_I2C1_MAX_CLOCK_HZ 400000
+#endif
+#if RLM3_I2C1_MAX_CLOCK_HZ > 400000
+#error "The I2C1 peripheral cannot run faster than 400 kHz"
+#endif
+
+
 typedef enum
 {
 	RLM3_I2C1_DEVICE_TEST,
@@ -16,15 +29,93 @@ typedef enum
 	RLM3_I2C1_DEVICE_COUNT
 } RLM3_I2C1_DEVICE;
 
+typedef enum
+{
+	RLM3_I2C1_SPEED_STANDARD, // 100 kHz
+	RLM3_I2C1_SPEED_FAST, // 400 kHz
+	RLM3_I2C1_SPEED_FAST_PLUS, // 1 MHz, capped at RLM3_I2C1_MAX_CLOCK_HZ.
+	RLM3_I2C1_SPEED_COUNT
+} RLM3_I2C1_Speed;
+
+// The clock control register values the HAL programs for an SCL rate, and the rate they produce.
+typedef struct
+{
+	uint32_t ccr;
+	uint32_t trise;
+	bool is_fast;
+	bool is_duty_16_9;
+	uint32_t clock_hz;
+} RLM3_I2C1_Timing;
+
+typedef enum
+{
+	RLM3_I2C1_RESULT_OK,
+	RLM3_I2C1_RESULT_NACK,
+	RLM3_I2C1_RESULT_ARBITRATION_LOST,
+	RLM3_I2C1_RESULT_BUS_ERROR,
+	RLM3_I2C1_RESULT_BUSY,
+	RLM3_I2C1_RESULT_TIMEOUT,
+} RLM3_I2C1_Result;
+
+// How a transaction with one address is bounded and retried.  A timeout of 0 allows twice the time on the wire plus
+// RLM3_I2C1_TIMEOUT_MARGIN_MS.  After a timeout, a busy bus or a bus error the bus is recovered before the next attempt.
+// NACKs are only retried when asked for, since a device that is busy writing NACKs its address until it is done.
+typedef struct
+{
+	RLM3_Time timeout_ms;
+	uint8_t retry_count;
+	RLM3_Time retry_delay_ms;
+	bool is_nack_retried;
+} RLM3_I2C1_Policy;
+
+typedef struct
+{
+	uint32_t transaction_count;
+	uint32_t nack_count;
+	uint32_t arbitration_lost_count;
+	uint32_t bus_error_count;
+	uint32_t busy_count;
+	uint32_t timeout_count;
+	uint32_t retry_count;
+	uint32_t recovery_count;
+	uint32_t recovery_failed_count;
+	uint32_t speed_change_count;
+	uint32_t last_recovery_cycles;
+	uint32_t max_recovery_cycles;
+} RLM3_I2C1_Counters;
+
 
 extern void RLM3_I2C1_Init(RLM3_I2C1_DEVICE device);
 extern void RLM3_I2C1_Deinit(RLM3_I2C1_DEVICE device);
 extern bool RLM3_I2C1_IsInit(RLM3_I2C1_DEVICE device);
 
+// Runs transactions with addr at the device's speed.  Devices without a speed, and other addresses, run at Standard
+// mode.  The bus changes rate between transactions as needed, and transactions waiting at the bus's current rate go
+// before ones that would change it, up to RLM3_I2C1_SPEED_BATCH_LIMIT in a row.
+extern void RLM3_I2C1_SetDeviceSpeed(RLM3_I2C1_DEVICE device, uint32_t addr, RLM3_I2C1_Speed speed);
+extern RLM3_I2C1_Speed RLM3_I2C1_GetDeviceSpeed(RLM3_I2C1_DEVICE device);
+extern uint32_t RLM3_I2C1_GetSpeedHz(RLM3_I2C1_Speed speed);
+// Returns false if the bus clock is too slow for the rate.
+extern bool RLM3_I2C1_ComputeTiming(uint32_t pclk1_hz, uint32_t clock_hz, RLM3_I2C1_Timing* timing_out);
+// The time a transaction with addr spends on the wire at its speed, rounded up to a microsecond.
+extern uint32_t RLM3_I2C1_GetTransferTimeUs(uint32_t addr, size_t tx_size, size_t rx_size);
+
 extern bool RLM3_I2C1_Transmit(uint32_t addr, const uint8_t* data, size_t size);
 extern bool RLM3_I2C1_Receive(uint32_t addr, uint8_t* data, size_t size);
 extern bool RLM3_I2C1_TransmitReceive(uint32_t addr, const uint8_t* tx_data, size_t tx_size, uint8_t* rx_data, size_t rx_size);
 
+// As above, with a timeout in place of the policy's (0 keeps the policy's) and the reason for a failure.
+extern RLM3_I2C1_Result RLM3_I2C1_TransmitWithTimeout(uint32_t addr, const uint8_t* data, size_t size, RLM3_Time timeout_ms);
+extern RLM3_I2C1_Result RLM3_I2C1_ReceiveWithTimeout(uint32_t addr, uint8_t* data, size_t size, RLM3_Time timeout_ms);
+extern RLM3_I2C1_Result RLM3_I2C1_TransmitReceiveWithTimeout(uint32_t addr, const uint8_t* tx_data, size_t tx_size, uint8_t* rx_data, size_t rx_size, RLM3_Time timeout_ms);
+
+// Replaces the policy for one address, or restores the default when policy is NULL.
+extern void RLM3_I2C1_SetPolicy(uint32_t addr, const RLM3_I2C1_Policy* policy);
+extern void RLM3_I2C1_GetPolicy(uint32_t addr, RLM3_I2C1_Policy* policy_out);
+// Clocks a stuck slave off SDA, generates a STOP and resets the peripheral.  Returns false if SDA is still held low.
+extern bool RLM3_I2C1_RecoverBus();
+extern void RLM3_I2C1_GetCounters(RLM3_I2C1_Counters* counters_out);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,80 @@
+#include "rlm3-log.h"
+#include "rlm3-message-queue.h"
+#include "Assert.h"
+#include <stdio.h>
+
+
+LOGGER_ZONE(LOG);
+
+
+volatile uint8_t RLM3_Log_Level = RLM3_LOG_LEVEL_TRACE;
+
+static uint32_t g_log_storage[RLM3_MESSAGE_QUEUE_STORAGE_SIZE(sizeof(RLM3_LogRecord), RLM3_LOG_RING_CAPACITY) / sizeof(uint32_t)];
+static RLM3_MessageQueue g_log_queue;
+
+
+static __attribute__((constructor)) void Init_Log()
+{
+	RLM3_MessageQueue_Init(&g_log_queue, g_log_storage, sizeof(g_log_storage), sizeof(RLM3_LogRecord), RLM3_LOG_RING_CAPACITY);
+}
+
+static const char* GetLevelName(uint8_t level)
+{
+	static const char* const names[] = { "NONE", "FATAL", "ERROR", "WARN", "INFO", "DEBUG", "TRACE" };
+	return (level < sizeof(names) / sizeof(names[0])) ? names[level] : "?";
+}
+
+
+extern bool RLM3_Log_Defer(const char* zone, uint8_t level, const char* format, const uint32_t* args, size_t arg_count)
+{
+	ASSERT(format != NULL);
+	ASSERT(arg_count <= RLM3_LOG_MAX_ARGS);
+
+	RLM3_LogRecord record;
+	record.zone = zone;
+	record.format = format;
+	record.cycles = RLM3_GetCycleCount();
+	record.level = level;
+	record.arg_count = (uint8_t)arg_count;
+	for (size_t i = 0; i < RLM3_LOG_MAX_ARGS; i++)
+		record.args[i] = (i < arg_count) ? args[i] : 0;
+	return RLM3_MessageQueue_Push(&g_log_queue, &record);
+}
+
+extern bool RLM3_Log_PopDeferred(RLM3_LogRecord* record_out)
+{
+	ASSERT(record_out != NULL);
+
+	return RLM3_MessageQueue_TryPop(&g_log_queue, record_out);
+}
+
+extern size_t RLM3_Log_FormatDeferred(const RLM3_LogRecord* record, char* buffer, size_t size)
+{
+	ASSERT(record != NULL);
+	ASSERT(buffer != NULL && size > 0);
+
+	// Unused arguments are passed as zeros, which the format ignores.
+	int length = snprintf(buffer, size, record->format, record->args[0], record->args[1], record->args[2], record->args[3]);
+	if (length < 0)
+		length = 0;
+	return ((size_t)length < size) ? (size_t)length : size - 1;
+}
+
+extern size_t RLM3_Log_FlushDeferred()
+{
+	size_t count = 0;
+	RLM3_LogRecord record;
+	char text[128];
+	while (RLM3_Log_PopDeferred(&record))
+	{
+		RLM3_Log_FormatDeferred(&record, text, sizeof(text));
+		LOG_ALWAYS("%s %s @%u %s", GetLevelName(record.level), record.zone, (unsigned)record.cycles, text);
+		count++;
+	}
+	return count;
+}
+
+extern uint32_t RLM3_Log_GetDroppedCount()
+{
+	return RLM3_MessageQueue_GetDroppedCount(&g_log_queue);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "logger.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Log levels that are fixed when a driver is compiled, on top of the logger.  A driver picks its level from a
+ * per-zone macro before using the RLM3_LOG_ calls:
+ *
+ *   #ifndef RLM3_I2C_LOG_LEVEL
+ *   #define RLM3_I2C_LOG_LEVEL RLM3_LOG_LEVEL_DEFAULT
+ *   #endif
+ *   #define RLM3_LOG_LEVEL RLM3_I2C_LOG_LEVEL
+ *   RLM3_LOG_ZONE(I2C);
+ *
+ * Calls above that level compile to nothing, arguments included.  The rest are also checked against RLM3_Log_Level
+ * before their arguments are evaluated.
+ *
+ * The deferred calls are safe from interrupts.  They copy the format, which must be a string literal, and up to
+ * RLM3_LOG_MAX_ARGS 32 bit arguments into a ring, and a task formats them later with RLM3_Log_FlushDeferred.  Strings
+ * cannot be deferred, since they may be gone by then.
+ *
+ * Nothing drains the ring on its own.  The I2C driver flushes it after each transaction when its traces are compiled
+ * in.  An application that defers from its own handlers must call RLM3_Log_FlushDeferred from a task, for example the
+ * idle hook, or the records stay in the ring and later ones are dropped.  Faults are logged at once rather than
+ * deferred.
+ */
+
+
+#define RLM3_LOG_LEVEL_NONE 0
+#define RLM3_LOG_LEVEL_FATAL 1
+#define RLM3_LOG_LEVEL_ERROR 2
+#define RLM3_LOG_LEVEL_WARN 3
+#define RLM3_LOG_LEVEL_INFO 4
+#define RLM3_LOG_LEVEL_DEBUG 5
+#define RLM3_LOG_LEVEL_TRACE 6
+
+#ifndef RLM3_LOG_LEVEL_DEFAULT
+#define RLM3_LOG_LEVEL_DEFAULT RLM3_LOG_LEVEL_DEBUG
+#endif
+
+#define RLM3_LOG_MAX_ARGS 4
+#define RLM3_LOG_RING_CAPACITY 64
+
+
+typedef struct
+{
+	const char* zone;
+	const char* format;
+	uint32_t cycles;
+	uint8_t level;
+	uint8_t arg_count;
+	uint32_t args[RLM3_LOG_MAX_ARGS];
+} RLM3_LogRecord;
+
+
+#define RLM3_LOG_ZONE(zone) LOGGER_ZONE(zone); static const char g_rlm3_log_zone[] __attribute__((unused)) = #zone
+
+#define RLM3_LOG_IS_ENABLED(level) (RLM3_LOG_LEVEL >= (level) && RLM3_Log_Level >= (level))
+
+#define RLM3_LOG_ERROR(...) do { if (RLM3_LOG_IS_ENABLED(RLM3_LOG_LEVEL_ERROR)) LOG_ERROR(__VA_ARGS__); } while (0)
+#define RLM3_LOG_WARN(...) do { if (RLM3_LOG_IS_ENABLED(RLM3_LOG_LEVEL_WARN)) LOG_WARN(__VA_ARGS__); } while (0)
+#define RLM3_LOG_INFO(...) do { if (RLM3_LOG_IS_ENABLED(RLM3_LOG_LEVEL_INFO)) LOG_INFO(__VA_ARGS__); } while (0)
+#define RLM3_LOG_DEBUG(...) do { if (RLM3_LOG_IS_ENABLED(RLM3_LOG_LEVEL_DEBUG)) LOG_DEBUG(__VA_ARGS__); } while (0)
+#define RLM3_LOG_TRACE(...) do { if (RLM3_LOG_IS_ENABLED(RLM3_LOG_LEVEL_TRACE)) LOG_TRACE(__VA_ARGS__); } while (0)
+
+#define RLM3_LOG_DEFER(level, format, ...) do { \
+		if (RLM3_LOG_IS_ENABLED(level)) \
+		{ \
+			const uint32_t rlm3_log_args[] = { 0, ##__VA_ARGS__ }; \
+			RLM3_Log_Defer(g_rlm3_log_zone, (level), format, rlm3_log_args + 1, sizeof(rlm3_log_args) / sizeof(uint32_t) - 1); \
+		} \
+	} while (0)
+
+#define RLM3_LOG_DEFER_ERROR(format, ...) RLM3_LOG_DEFER(RLM3_LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#define RLM3_LOG_DEFER_WARN(format, ...) RLM3_LOG_DEFER(RLM3_LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#define RLM3_LOG_DEFER_TRACE(format, ...) RLM3_LOG_DEFER(RLM3_LOG_LEVEL_TRACE, format, ##__VA_ARGS__)
+
+
+// Calls above this level are dropped at run time.  Starts at RLM3_LOG_LEVEL_TRACE.
+extern volatile uint8_t RLM3_Log_Level;
+
+// Returns false and counts a drop when the ring is full.
+extern bool RLM3_Log_Defer(const char* zone, uint8_t level, const char* format, const uint32_t* args, size_t arg_count);
+extern bool RLM3_Log_PopDeferred(RLM3_LogRecord* record_out);
+extern size_t RLM3_Log_FormatDeferred(const RLM3_LogRecord* record, char* buffer, size_t size);
+// Formats the waiting records through the logger.  Returns how many there were.
+extern size_t RLM3_Log_FlushDeferred();
+extern uint32_t RLM3_Log_GetDroppedCount();
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,254 @@
+#include "rlm3-memory-scrub.h"
+#include "rlm3-lock.h"
+#include "rlm3-task.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Assert.h"
+
+
+typedef struct
+{
+	const uint32_t* address;
+	size_t size;
+	uint32_t sum_a;
+	uint32_t sum_b;
+} ScrubRegion;
+
+
+static volatile uint32_t g_error_count = 0;
+static volatile uint32_t g_pass_count = 0;
+static const void* volatile g_last_failure_address = NULL;
+static volatile size_t g_last_failure_size = 0;
+
+static RLM3_MutexLock g_scrub_lock;
+static ScrubRegion g_scrub_regions[RLM3_MEMORY_SCRUB_REGION_COUNT] = { 0 };
+static size_t g_scrub_cursor_region = 0;
+static size_t g_scrub_cursor_offset = 0;
+static uint32_t g_scrub_cursor_sum_a = 0;
+static uint32_t g_scrub_cursor_sum_b = 0;
+
+static volatile RLM3_Task g_scrub_task = NULL;
+static volatile RLM3_Task g_scrub_stopper = NULL;
+static volatile bool g_scrub_is_running = false;
+static volatile uint32_t g_scrub_bandwidth_percent = 0;
+
+
+static __attribute__((constructor)) void Init_MemoryScrub()
+{
+	RLM3_MutexLock_Init(&g_scrub_lock);
+}
+
+
+static void UpdateChecksum(const uint32_t* data, size_t words, uint32_t* sum_a, uint32_t* sum_b)
+{
+	// Fletcher style checksum over 32 bit words.  The second sum makes the result depend on the word order.
+	uint32_t a = *sum_a;
+	uint32_t b = *sum_b;
+	for (size_t i = 0; i < words; i++)
+	{
+		a += data[i];
+		b += a;
+	}
+	*sum_a = a;
+	*sum_b = b;
+}
+
+static void ResetCursor(size_t region)
+{
+	g_scrub_cursor_region = region;
+	g_scrub_cursor_offset = 0;
+	g_scrub_cursor_sum_a = 0;
+	g_scrub_cursor_sum_b = 0;
+}
+
+static bool FindNextRegion()
+{
+	// Moves the cursor forward to the next registered region, wrapping around at the end of the table.
+	for (size_t i = 0; i < RLM3_MEMORY_SCRUB_REGION_COUNT; i++)
+	{
+		size_t region = (g_scrub_cursor_region + i) % RLM3_MEMORY_SCRUB_REGION_COUNT;
+		if (g_scrub_regions[region].address != NULL)
+		{
+			if (region != g_scrub_cursor_region)
+				ResetCursor(region);
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool IsLastRegion(size_t region)
+{
+	for (size_t i = region + 1; i < RLM3_MEMORY_SCRUB_REGION_COUNT; i++)
+		if (g_scrub_regions[i].address != NULL)
+			return false;
+	return true;
+}
+
+extern bool RLM3_MEMORY_Scrub_AddRegion(const void* address, size_t size)
+{
+	ASSERT(address != NULL);
+	ASSERT(((uintptr_t)address & 3) == 0);
+	ASSERT(size > 0 && (size & 3) == 0);
+
+	uint32_t sum_a = 0;
+	uint32_t sum_b = 0;
+	UpdateChecksum((const uint32_t*)address, size / 4, &sum_a, &sum_b);
+
+	bool result = false;
+	RLM3_MutexLock_Enter(&g_scrub_lock);
+	for (size_t i = 0; i < RLM3_MEMORY_SCRUB_REGION_COUNT && !result; i++)
+	{
+		ScrubRegion* region = &g_scrub_regions[i];
+		if (region->address == NULL)
+		{
+			region->address = (const uint32_t*)address;
+			region->size = size;
+			region->sum_a = sum_a;
+			region->sum_b = sum_b;
+			result = true;
+		}
+	}
+	RLM3_MutexLock_Leave(&g_scrub_lock);
+
+	return result;
+}
+
+extern void RLM3_MEMORY_Scrub_RemoveRegion(const void* address)
+{
+	ASSERT(address != NULL);
+
+	RLM3_MutexLock_Enter(&g_scrub_lock);
+	for (size_t i = 0; i < RLM3_MEMORY_SCRUB_REGION_COUNT; i++)
+	{
+		if (g_scrub_regions[i].address == address)
+		{
+			g_scrub_regions[i].address = NULL;
+			g_scrub_regions[i].size = 0;
+			if (g_scrub_cursor_region == i)
+				ResetCursor(i);
+		}
+	}
+	RLM3_MutexLock_Leave(&g_scrub_lock);
+}
+
+extern size_t RLM3_MEMORY_Scrub_Step(size_t max_bytes)
+{
+	size_t result = 0;
+
+	RLM3_MutexLock_Enter(&g_scrub_lock);
+	if (FindNextRegion())
+	{
+		const ScrubRegion* region = &g_scrub_regions[g_scrub_cursor_region];
+		size_t words = (region->size - g_scrub_cursor_offset) / 4;
+		if (words > max_bytes / 4)
+			words = max_bytes / 4;
+
+		UpdateChecksum(region->address + g_scrub_cursor_offset / 4, words, &g_scrub_cursor_sum_a, &g_scrub_cursor_sum_b);
+		g_scrub_cursor_offset += 4 * words;
+		result = 4 * words;
+
+		if (g_scrub_cursor_offset == region->size)
+		{
+			if (g_scrub_cursor_sum_a != region->sum_a || g_scrub_cursor_sum_b != region->sum_b)
+			{
+				RLM3_EnterCritical();
+				g_error_count++;
+				g_last_failure_address = region->address;
+				g_last_failure_size = region->size;
+				RLM3_ExitCritical();
+			}
+			if (IsLastRegion(g_scrub_cursor_region))
+			{
+				g_pass_count++;
+				ResetCursor(0);
+			}
+			else
+				ResetCursor(g_scrub_cursor_region + 1);
+		}
+	}
+	RLM3_MutexLock_Leave(&g_scrub_lock);
+
+	return result;
+}
+
+extern void RLM3_MEMORY_Scrub_GetInfo(RLM3_MEMORY_ScrubInfo* info_out)
+{
+	ASSERT(info_out != NULL);
+
+	RLM3_EnterCritical();
+	info_out->error_count = g_error_count;
+	info_out->pass_count = g_pass_count;
+	info_out->last_failure_address = g_last_failure_address;
+	info_out->last_failure_size = g_last_failure_size;
+	RLM3_ExitCritical();
+}
+
+extern void RLM3_MEMORY_Scrub_ClearInfo()
+{
+	RLM3_EnterCritical();
+	g_error_count = 0;
+	g_pass_count = 0;
+	g_last_failure_address = NULL;
+	g_last_failure_size = 0;
+	RLM3_ExitCritical();
+}
+
+extern RLM3_Time RLM3_MEMORY_Scrub_GetBusyTime(RLM3_Time period_ms, uint32_t bandwidth_percent)
+{
+	ASSERT(bandwidth_percent > 0 && bandwidth_percent <= 100);
+
+	// Always allow at least one tick of work so low bandwidth settings still make progress.
+	RLM3_Time busy_time = period_ms * bandwidth_percent / 100;
+	if (busy_time == 0)
+		busy_time = 1;
+	return busy_time;
+}
+
+static void ScrubTask(void* param)
+{
+	while (g_scrub_is_running)
+	{
+		RLM3_Time period_start = RLM3_GetCurrentTime();
+		RLM3_Time busy_time = RLM3_MEMORY_Scrub_GetBusyTime(RLM3_MEMORY_SCRUB_PERIOD_MS, g_scrub_bandwidth_percent);
+		while (g_scrub_is_running && RLM3_GetCurrentTime() - period_start < busy_time)
+			if (RLM3_MEMORY_Scrub_Step(RLM3_MEMORY_SCRUB_CHUNK_SIZE) == 0)
+				break;
+		RLM3_DelayUntil(period_start, RLM3_MEMORY_SCRUB_PERIOD_MS);
+	}
+
+	RLM3_Task stopper = g_scrub_stopper;
+	g_scrub_task = NULL;
+	RLM3_Give(stopper);
+	vTaskDelete(NULL);
+}
+
+extern void RLM3_MEMORY_Scrub_Start(uint32_t bandwidth_percent)
+{
+	ASSERT(bandwidth_percent > 0 && bandwidth_percent <= 100);
+	ASSERT(g_scrub_task == NULL);
+
+	g_scrub_bandwidth_percent = bandwidth_percent;
+	g_scrub_is_running = true;
+
+	TaskHandle_t task = NULL;
+	BaseType_t status = xTaskCreate(ScrubTask, "scrub", 128 * 2, NULL, tskIDLE_PRIORITY + 1, &task);
+	ASSERT(status == pdPASS);
+	g_scrub_task = task;
+}
+
+extern void RLM3_MEMORY_Scrub_Stop()
+{
+	ASSERT(g_scrub_task != NULL);
+
+	g_scrub_stopper = RLM3_GetCurrentTask();
+	g_scrub_is_running = false;
+	while (g_scrub_task != NULL)
+		RLM3_Take();
+	g_scrub_stopper = NULL;
+}
+
+extern bool RLM3_MEMORY_Scrub_IsRunning()
+{
+	return (g_scrub_task != NULL);
+}
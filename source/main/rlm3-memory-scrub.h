@@ -0,0 +1,49 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Checks memory that should not change.  Each registered region keeps a Fletcher style checksum taken when it was
+ * added, and RLM3_MEMORY_Scrub_Step walks the regions in table order a chunk at a time, comparing each region's sum
+ * once its last chunk is read.  A pass is counted when the walk wraps around.  The scrub task steps for a share of
+ * each RLM3_MEMORY_SCRUB_PERIOD_MS period.
+ */
+
+
+#define RLM3_MEMORY_SCRUB_REGION_COUNT 8
+#define RLM3_MEMORY_SCRUB_CHUNK_SIZE 4096
+#define RLM3_MEMORY_SCRUB_PERIOD_MS 100
+
+
+typedef struct
+{
+	uint32_t error_count;
+	uint32_t pass_count;
+	const void* last_failure_address;
+	size_t last_failure_size;
+} RLM3_MEMORY_ScrubInfo;
+
+
+// Regions registered with the scrubber must not be modified until they are removed.
+extern bool RLM3_MEMORY_Scrub_AddRegion(const void* address, size_t size);
+extern void RLM3_MEMORY_Scrub_RemoveRegion(const void* address);
+extern size_t RLM3_MEMORY_Scrub_Step(size_t max_bytes);
+extern RLM3_Time RLM3_MEMORY_Scrub_GetBusyTime(RLM3_Time period_ms, uint32_t bandwidth_percent);
+
+extern void RLM3_MEMORY_Scrub_GetInfo(RLM3_MEMORY_ScrubInfo* info_out);
+extern void RLM3_MEMORY_Scrub_ClearInfo();
+
+extern void RLM3_MEMORY_Scrub_Start(uint32_t bandwidth_percent);
+extern void RLM3_MEMORY_Scrub_Stop();
+extern bool RLM3_MEMORY_Scrub_IsRunning();
+
+
+#ifdef __cplusplus
+}
+#endif
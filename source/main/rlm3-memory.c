@@ -2,14 +2,23 @@
 #include "fmc.h"
 #include "main.h"
 #include "rlm3-task.h"
+#include "Assert.h"
 
 
 static bool g_is_initialized = false;
 
+static volatile uint32_t g_refresh_error_count = 0;
+
 
 extern void RLM3_MEMORY_Init()
 {
 	MX_FMC_Init();
+
+	// Report refresh errors through HAL_SDRAM_RefreshErrorCallback.
+	__FMC_SDRAM_ENABLE_IT(hsdram2.Instance, FMC_IT_REFRESH_ERROR);
+	HAL_NVIC_SetPriority(FMC_IRQn, 5, 0);
+	HAL_NVIC_EnableIRQ(FMC_IRQn);
+
 	g_is_initialized = true;
 	RLM3_Delay(1000);
 }
@@ -17,6 +26,8 @@ extern void RLM3_MEMORY_Init()
 extern void RLM3_MEMORY_Deinit()
 {
 	g_is_initialized = false;
+	HAL_NVIC_DisableIRQ(FMC_IRQn);
+	__FMC_SDRAM_DISABLE_IT(hsdram2.Instance, FMC_IT_REFRESH_ERROR);
 	HAL_SDRAM_DeInit(&hsdram2);
 }
 
@@ -25,7 +36,41 @@ extern bool RLM3_MEMORY_IsInit()
 	return g_is_initialized;
 }
 
+extern uint32_t RLM3_MEMORY_GetRefreshErrorCount()
+{
+	return g_refresh_error_count;
+}
+
+extern void RLM3_MEMORY_GetErrorInfo(RLM3_MEMORY_ErrorInfo* info_out)
+{
+	ASSERT(info_out != NULL);
+
+	RLM3_MEMORY_ScrubInfo scrub_info;
+	RLM3_EnterCritical();
+	info_out->refresh_error_count = g_refresh_error_count;
+	RLM3_MEMORY_Scrub_GetInfo(&scrub_info);
+	RLM3_ExitCritical();
+	info_out->scrub_error_count = scrub_info.error_count;
+	info_out->scrub_pass_count = scrub_info.pass_count;
+	info_out->last_failure_address = scrub_info.last_failure_address;
+	info_out->last_failure_size = scrub_info.last_failure_size;
+}
+
+extern void RLM3_MEMORY_ClearErrorInfo()
+{
+	RLM3_EnterCritical();
+	g_refresh_error_count = 0;
+	RLM3_MEMORY_Scrub_ClearInfo();
+	RLM3_ExitCritical();
+}
+
 void HAL_SDRAM_RefreshErrorCallback(SDRAM_HandleTypeDef *hsdram)
 {
+	g_refresh_error_count++;
+}
 
+extern void FMC_IRQHandler(void)
+{
+	// The HAL clears the refresh error flag and calls back above.
+	HAL_SDRAM_IRQHandler(&hsdram2);
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "rlm3-base.h"
+#include "rlm3-task.h"
+#include "rlm3-memory-scrub.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -11,10 +13,24 @@ extern "C" {
 #define RLM3_EXTERNAL_MEMORY_SIZE (8 * 1024 * 1024)
 
 
+typedef struct
+{
+	uint32_t refresh_error_count;
+	uint32_t scrub_error_count;
+	uint32_t scrub_pass_count;
+	const void* last_failure_address;
+	size_t last_failure_size;
+} RLM3_MEMORY_ErrorInfo;
+
+
 extern void RLM3_MEMORY_Init();
 extern void RLM3_MEMORY_Deinit();
 extern bool RLM3_MEMORY_IsInit();
 
+extern uint32_t RLM3_MEMORY_GetRefreshErrorCount();
+extern void RLM3_MEMORY_GetErrorInfo(RLM3_MEMORY_ErrorInfo* info_out);
+extern void RLM3_MEMORY_ClearErrorInfo();
+
 
 #ifdef __cplusplus
 }
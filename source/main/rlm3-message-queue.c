@@ -0,0 +1,125 @@
+#include "rlm3-message-queue.h"
+#include "Assert.h"
+#include <string.h>
+
+
+static volatile uint32_t* GetSequence(RLM3_MessageQueue* queue, uint32_t position)
+{
+	return (volatile uint32_t*)(queue->storage + (position & (queue->capacity - 1)) * queue->cell_size);
+}
+
+static void* GetRecord(RLM3_MessageQueue* queue, uint32_t position)
+{
+	return queue->storage + (position & (queue->capacity - 1)) * queue->cell_size + sizeof(uint32_t);
+}
+
+extern void RLM3_MessageQueue_Init(RLM3_MessageQueue* queue, void* storage, size_t storage_size, size_t record_size, size_t capacity)
+{
+	ASSERT(queue != NULL && storage != NULL);
+	ASSERT(((uintptr_t)storage & 3) == 0);
+	ASSERT(record_size > 0);
+	ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+	ASSERT(storage_size >= RLM3_MESSAGE_QUEUE_STORAGE_SIZE(record_size, capacity));
+
+	queue->storage = (uint8_t*)storage;
+	queue->record_size = record_size;
+	queue->cell_size = RLM3_MESSAGE_QUEUE_CELL_SIZE(record_size);
+	queue->capacity = capacity;
+	queue->head = 0;
+	queue->tail = 0;
+	queue->dropped_count = 0;
+	queue->waiting_task = NULL;
+	for (uint32_t i = 0; i < capacity; i++)
+		*GetSequence(queue, i) = i;
+}
+
+extern bool RLM3_MessageQueue_Push(RLM3_MessageQueue* queue, const void* record)
+{
+	// Each cell's sequence number says whose turn it is.  A producer claims a cell by advancing the head and publishes
+	// it by advancing the sequence.
+	uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+	while (true)
+	{
+		volatile uint32_t* sequence = GetSequence(queue, head);
+		int32_t diff = (int32_t)(__atomic_load_n(sequence, __ATOMIC_ACQUIRE) - head);
+		if (diff < 0)
+		{
+			__atomic_fetch_add(&queue->dropped_count, 1, __ATOMIC_RELAXED);
+			return false;
+		}
+		if (diff == 0 && __atomic_compare_exchange_n(&queue->head, &head, head + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		{
+			memcpy(GetRecord(queue, head), record, queue->record_size);
+			__atomic_store_n(sequence, head + 1, __ATOMIC_RELEASE);
+			break;
+		}
+		if (diff > 0)
+			head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+	}
+
+	// Only a consumer that found the queue empty is woken.
+	RLM3_Task task = __atomic_exchange_n(&queue->waiting_task, NULL, __ATOMIC_SEQ_CST);
+	if (task != NULL)
+	{
+		if (RLM3_IsIRQ())
+			RLM3_GiveFromISR(task);
+		else
+			RLM3_Give(task);
+	}
+	return true;
+}
+
+extern bool RLM3_MessageQueue_TryPop(RLM3_MessageQueue* queue, void* record_out)
+{
+	return (RLM3_MessageQueue_Drain(queue, record_out, 1) != 0);
+}
+
+extern bool RLM3_MessageQueue_Pop(RLM3_MessageQueue* queue, void* record_out, RLM3_Time timeout_ms)
+{
+	ASSERT(!RLM3_IsIRQ());
+
+	RLM3_Time start_time = RLM3_GetCurrentTime();
+	while (true)
+	{
+		// Register before checking so a push between the check and the wait still wakes this task.
+		__atomic_store_n(&queue->waiting_task, RLM3_GetCurrentTask(), __ATOMIC_SEQ_CST);
+		if (RLM3_MessageQueue_TryPop(queue, record_out))
+		{
+			queue->waiting_task = NULL;
+			return true;
+		}
+		if (timeout_ms == RLM3_WAIT_FOREVER)
+			RLM3_Take();
+		else if (!RLM3_TakeUntil(start_time, timeout_ms + 1))
+		{
+			queue->waiting_task = NULL;
+			return RLM3_MessageQueue_TryPop(queue, record_out);
+		}
+	}
+}
+
+extern size_t RLM3_MessageQueue_Drain(RLM3_MessageQueue* queue, void* records_out, size_t max_count)
+{
+	ASSERT(queue != NULL && (records_out != NULL || max_count == 0));
+
+	uint8_t* out = (uint8_t*)records_out;
+	size_t count = 0;
+	uint32_t tail = queue->tail;
+	while (count < max_count)
+	{
+		volatile uint32_t* sequence = GetSequence(queue, tail);
+		if (__atomic_load_n(sequence, __ATOMIC_ACQUIRE) != tail + 1)
+			break;
+		memcpy(out + count * queue->record_size, GetRecord(queue, tail), queue->record_size);
+		__atomic_store_n(sequence, tail + queue->capacity, __ATOMIC_RELEASE);
+		tail++;
+		count++;
+	}
+	queue->tail = tail;
+	return count;
+}
+
+extern uint32_t RLM3_MessageQueue_GetDroppedCount(const RLM3_MessageQueue* queue)
+{
+	return queue->dropped_count;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * A bounded queue of fixed size records.  Any number of interrupts and tasks may push without critical sections.  A
+ * single task pops, either blocking with a timeout or draining a batch at a time.  The caller provides the storage,
+ * sized with RLM3_MESSAGE_QUEUE_STORAGE_SIZE, and the capacity must be a power of two.
+ */
+
+
+#define RLM3_MESSAGE_QUEUE_CELL_SIZE(record_size) (sizeof(uint32_t) + (((record_size) + 3) & ~(size_t)3))
+#define RLM3_MESSAGE_QUEUE_STORAGE_SIZE(record_size, capacity) ((capacity) * RLM3_MESSAGE_QUEUE_CELL_SIZE(record_size))
+
+
+typedef struct
+{
+	uint8_t* storage;
+	size_t record_size;
+	size_t cell_size;
+	uint32_t capacity;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t dropped_count;
+	volatile RLM3_Task waiting_task;
+} RLM3_MessageQueue;
+
+
+extern void RLM3_MessageQueue_Init(RLM3_MessageQueue* queue, void* storage, size_t storage_size, size_t record_size, size_t capacity);
+
+// Returns false and counts a drop when the queue is full.
+extern bool RLM3_MessageQueue_Push(RLM3_MessageQueue* queue, const void* record);
+
+extern bool RLM3_MessageQueue_TryPop(RLM3_MessageQueue* queue, void* record_out);
+extern bool RLM3_MessageQueue_Pop(RLM3_MessageQueue* queue, void* record_out, RLM3_Time timeout_ms);
+extern size_t RLM3_MessageQueue_Drain(RLM3_MessageQueue* queue, void* records_out, size_t max_count);
+extern uint32_t RLM3_MessageQueue_GetDroppedCount(const RLM3_MessageQueue* queue);
+
+
+#ifdef __cplusplus
+}
+#endif
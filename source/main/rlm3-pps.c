@@ -0,0 +1,90 @@
+#include "rlm3-pps.h"
+#include "rlm3-task.h"
+#include "main.h"
+#include "Assert.h"
+
+
+// The cycle counter wraps in under 24 seconds at 180 MHz.
+#define PPS_MAX_SECONDS 10
+#define PPS_TOLERANCE_DIVISOR 1000
+
+
+static uint32_t EnterPPS()
+{
+	if (RLM3_IsIRQ())
+		return RLM3_EnterCriticalFromISR();
+	RLM3_EnterCritical();
+	return 0;
+}
+
+static void LeavePPS(uint32_t saved_level)
+{
+	if (RLM3_IsIRQ())
+		RLM3_ExitCriticalFromISR(saved_level);
+	else
+		RLM3_ExitCritical();
+}
+
+extern void RLM3_PPS_Init(RLM3_PPS* pps)
+{
+	ASSERT(pps != NULL);
+	*pps = (RLM3_PPS){ 0 };
+}
+
+extern void RLM3_PPS_Edge(RLM3_PPS* pps, uint32_t cycles)
+{
+	uint32_t nominal = HAL_RCC_GetHCLKFreq();
+	uint32_t saved_level = EnterPPS();
+	pps->edge_count++;
+	if (pps->has_edge)
+	{
+		uint32_t interval = cycles - pps->edge_cycles;
+		uint32_t seconds = (uint32_t)(((uint64_t)interval + nominal / 2) / nominal);
+		int64_t error = (int64_t)interval - (int64_t)seconds * nominal;
+		if (seconds == 0 || seconds > PPS_MAX_SECONDS || error > seconds * (nominal / PPS_TOLERANCE_DIVISOR) || -error > seconds * (nominal / PPS_TOLERANCE_DIVISOR))
+		{
+			// Noise or a jump in the receiver's pulse.  Start counting again from this edge.
+			pps->rejected_count++;
+			pps->has_time = false;
+		}
+		else
+		{
+			if (seconds == 1)
+			{
+				pps->cycles_per_second = interval;
+				pps->has_rate = true;
+			}
+			pps->edge_seconds += seconds;
+		}
+	}
+	pps->edge_cycles = cycles;
+	pps->has_edge = true;
+	LeavePPS(saved_level);
+}
+
+extern void RLM3_PPS_SetTime(RLM3_PPS* pps, uint64_t gps_seconds)
+{
+	RLM3_EnterCritical();
+	pps->edge_seconds = gps_seconds;
+	pps->has_time = pps->has_edge;
+	RLM3_ExitCritical();
+}
+
+extern bool RLM3_PPS_IsLocked(const RLM3_PPS* pps)
+{
+	return pps->has_rate && pps->has_time;
+}
+
+extern bool RLM3_PPS_ToGpsTime(const RLM3_PPS* pps, uint32_t cycles, uint64_t* gps_ns_out)
+{
+	ASSERT(gps_ns_out != NULL);
+	RLM3_EnterCritical();
+	RLM3_PPS copy = *pps;
+	RLM3_ExitCritical();
+	if (!RLM3_PPS_IsLocked(&copy))
+		return false;
+
+	int64_t offset_ns = (int64_t)(int32_t)(cycles - copy.edge_cycles) * 1000000000 / copy.cycles_per_second;
+	*gps_ns_out = copy.edge_seconds * 1000000000ULL + offset_ns;
+	return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "rlm3-base.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Maps cycle counter timestamps to GPS time with a pulse per second input.  Each edge is reported with its cycle count,
+ * for example from a GPIO event or an input capture.  Two edges a second apart measure the core clock against GPS, and
+ * the time message that follows an edge says which second it was.  After that each edge labels itself by counting
+ * seconds, so the receiver's messages only have to arrive once.
+ *
+ * Edge is safe from an interrupt.  The rest are for tasks.
+ */
+
+
+typedef struct
+{
+	uint32_t edge_cycles;
+	uint32_t cycles_per_second;
+	uint64_t edge_seconds;
+	bool has_edge;
+	bool has_rate;
+	bool has_time;
+	uint32_t edge_count;
+	uint32_t rejected_count; // Edges that were not a whole number of seconds after the one before.
+} RLM3_PPS;
+
+
+extern void RLM3_PPS_Init(RLM3_PPS* pps);
+extern void RLM3_PPS_Edge(RLM3_PPS* pps, uint32_t cycles);
+// The GPS time of the latest edge, in whole seconds.
+extern void RLM3_PPS_SetTime(RLM3_PPS* pps, uint64_t gps_seconds);
+extern bool RLM3_PPS_IsLocked(const RLM3_PPS* pps);
+// Cycle counts within about ten seconds of the latest edge, before or after it.  False until locked.
+extern bool RLM3_PPS_ToGpsTime(const RLM3_PPS* pps, uint32_t cycles, uint64_t* gps_ns_out);
+
+
+#ifdef __cplusplus
+}
+#endif
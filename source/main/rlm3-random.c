@@ -1,16 +1,25 @@
 #include "rlm3-random.h"
 #include "rlm3-helper.h"
 #include "rlm3-task.h"
-#include "logger.h"
+#include "rlm3-log.h"
 #include "main.h"
 
 
-LOGGER_ZONE(RANDOM);
+#ifndef RLM3_RANDOM_LOG_LEVEL
+#define RLM3_RANDOM_LOG_LEVEL RLM3_LOG_LEVEL_DEFAULT
+#endif
+#define RLM3_LOG_LEVEL RLM3_RANDOM_LOG_LEVEL
+
+RLM3_LOG_ZONE(RANDOM);
 
 
 static volatile RLM3_Task g_client_task = NULL;
 static volatile uint8_t* g_buffer = NULL;
 static volatile size_t g_size = 0;
+static volatile uint32_t g_clock_error_count = 0;
+static volatile uint32_t g_seed_error_count = 0;
+static uint32_t g_reported_clock_error_count = 0;
+static uint32_t g_reported_seed_error_count = 0;
 
 
 extern void RLM3_Random_Init()
@@ -31,6 +40,18 @@ extern bool RLM3_Random_IsInit()
 	return __HAL_RCC_RNG_IS_CLK_ENABLED();
 }
 
+static void ReportFaults()
+{
+	uint32_t clock_errors = g_clock_error_count;
+	uint32_t seed_errors = g_seed_error_count;
+	if (clock_errors != g_reported_clock_error_count)
+		RLM3_LOG_WARN("CLOCK ERROR x%u", (unsigned)(clock_errors - g_reported_clock_error_count));
+	if (seed_errors != g_reported_seed_error_count)
+		RLM3_LOG_WARN("SEED ERROR x%u", (unsigned)(seed_errors - g_reported_seed_error_count));
+	g_reported_clock_error_count = clock_errors;
+	g_reported_seed_error_count = seed_errors;
+}
+
 extern void RLM3_Random_Get(uint8_t* data, size_t size)
 {
 	g_client_task = RLM3_GetCurrentTask();
@@ -41,7 +62,10 @@ extern void RLM3_Random_Get(uint8_t* data, size_t size)
 			FLAG(RNG_CR_IE,    1)); // Enable Random Number Interrupt
 
 	while (g_size > 0)
+	{
 		RLM3_Take();
+		ReportFaults();
+	}
 
 	SET_REGISTER_FLAGS(RNG->CR,
 		FLAG(RNG_CR_RNGEN, 0),  // Disable Random Number Generator
@@ -50,20 +74,29 @@ extern void RLM3_Random_Get(uint8_t* data, size_t size)
 	g_client_task = NULL;
 }
 
+extern uint32_t RLM3_Random_GetFaultCount()
+{
+	return g_clock_error_count + g_seed_error_count;
+}
+
 extern void HASH_RNG_IRQHandler(void)
 {
+	RLM3_ISR_Begin();
 	uint32_t status = RNG->SR;
 	uint32_t entropy = RNG->DR;
 
 	if ((status & (RNG_SR_CEIS | RNG_SR_SEIS)) != 0)
 	{
+		// Counted here and logged by the waiting task.
 		if ((status & RNG_SR_CEIS) != 0)
-			LOG_WARN("CLOCK ERROR");
+			g_clock_error_count++;
 		if ((status & RNG_SR_SEIS) != 0)
-			LOG_WARN("SEED ERROR");
+			g_seed_error_count++;
 		SET_REGISTER_FLAGS(RNG->SR,
 			FLAG(RNG_SR_CEIS, 0),  // Clear clock error
 			FLAG(RNG_SR_SEIS, 0)); // Clear seed error
+		if (g_client_task != NULL)
+			RLM3_GiveFromISR(g_client_task);
 	}
 	else if ((status & RNG_SR_DRDY) != 0 && g_size > 0)
 	{
@@ -72,4 +105,5 @@ extern void HASH_RNG_IRQHandler(void)
 		if (g_size == 0)
 			RLM3_GiveFromISR(g_client_task);
 	}
+	RLM3_ISR_End();
 }
@@ -13,6 +13,8 @@ extern void RLM3_Random_Deinit();
 extern bool RLM3_Random_IsInit();
 
 extern void RLM3_Random_Get(uint8_t* data, size_t size);
+// Clock and seed faults the generator has flagged.  The interrupt counts them and RLM3_Random_Get logs them.
+extern uint32_t RLM3_Random_GetFaultCount();
 
 
 #ifdef __cplusplus
@@ -0,0 +1,314 @@
+#include "rlm3-sync.h"
+#include "Assert.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+typedef struct Waiter
+{
+	struct Waiter* next;
+	RLM3_Task task;
+	uint32_t bits;
+	bool is_all;
+	volatile uint32_t result;
+	volatile bool is_ready;
+} Waiter;
+
+
+static void InitWaiter(Waiter* waiter, uint32_t bits, bool is_all)
+{
+	waiter->next = NULL;
+	waiter->task = RLM3_GetCurrentTask();
+	waiter->bits = bits;
+	waiter->is_all = is_all;
+	waiter->result = 0;
+	waiter->is_ready = false;
+}
+
+static void AddWaiter(volatile void** list, Waiter* waiter)
+{
+	// Waiters are released in arrival order, so new ones go on the end.
+	Waiter** cursor = (Waiter**)list;
+	while (*cursor != NULL)
+		cursor = &(*cursor)->next;
+	*cursor = waiter;
+}
+
+static void RemoveWaiter(volatile void** list, Waiter* waiter)
+{
+	Waiter** cursor = (Waiter**)list;
+	while (*cursor != NULL && *cursor != waiter)
+		cursor = &(*cursor)->next;
+	ASSERT(*cursor != NULL);
+	*cursor = waiter->next;
+	waiter->next = NULL;
+}
+
+static void WakeWaiter(Waiter* waiter, uint32_t result, bool is_isr)
+{
+	// Called inside a critical section, so the waiter cannot see is_ready and leave before it is notified.
+	RLM3_Task task = waiter->task;
+	waiter->next = NULL;
+	waiter->result = result;
+	waiter->is_ready = true;
+	if (is_isr)
+		RLM3_GiveFromISR(task);
+	else
+		RLM3_Give(task);
+}
+
+static Waiter* PopWaiter(volatile void** list)
+{
+	Waiter* waiter = (Waiter*)*list;
+	if (waiter != NULL)
+		*list = waiter->next;
+	return waiter;
+}
+
+static bool WaitForWake(volatile void** list, Waiter* waiter, RLM3_Time start_time, RLM3_Time timeout_ms)
+{
+	while (!waiter->is_ready)
+	{
+		if (timeout_ms == RLM3_WAIT_FOREVER)
+			RLM3_Take();
+		else if (!RLM3_TakeUntil(start_time, timeout_ms))
+		{
+			// A wake may race the timeout.  Whichever side gets the critical section first decides.
+			taskENTER_CRITICAL();
+			bool is_ready = waiter->is_ready;
+			if (!is_ready)
+				RemoveWaiter(list, waiter);
+			taskEXIT_CRITICAL();
+			return is_ready;
+		}
+	}
+	return true;
+}
+
+
+extern void RLM3_Semaphore_Init(RLM3_Semaphore* semaphore, uint32_t initial_count)
+{
+	semaphore->count = initial_count;
+	semaphore->waiters = NULL;
+}
+
+extern void RLM3_Semaphore_Deinit(RLM3_Semaphore* semaphore)
+{
+	ASSERT(semaphore->waiters == NULL);
+}
+
+extern void RLM3_Semaphore_Give(RLM3_Semaphore* semaphore)
+{
+	ASSERT(!RLM3_IsIRQ());
+
+	// A waiting task takes the count directly so a later Take cannot steal it.
+	taskENTER_CRITICAL();
+	Waiter* waiter = PopWaiter(&semaphore->waiters);
+	if (waiter != NULL)
+		WakeWaiter(waiter, 1, false);
+	else
+		semaphore->count++;
+	taskEXIT_CRITICAL();
+}
+
+extern void RLM3_Semaphore_GiveFromISR(RLM3_Semaphore* semaphore)
+{
+	ASSERT(RLM3_IsIRQ());
+
+	UBaseType_t saved_level = taskENTER_CRITICAL_FROM_ISR();
+	Waiter* waiter = PopWaiter(&semaphore->waiters);
+	if (waiter != NULL)
+		WakeWaiter(waiter, 1, true);
+	else
+		semaphore->count++;
+	taskEXIT_CRITICAL_FROM_ISR(saved_level);
+}
+
+extern void RLM3_Semaphore_Take(RLM3_Semaphore* semaphore)
+{
+	RLM3_Semaphore_Try(semaphore, RLM3_WAIT_FOREVER);
+}
+
+extern bool RLM3_Semaphore_Try(RLM3_Semaphore* semaphore, RLM3_Time timeout_ms)
+{
+	ASSERT(!RLM3_IsIRQ());
+	ASSERT(RLM3_IsSchedulerRunning());
+
+	RLM3_Time start_time = RLM3_GetCurrentTime();
+	Waiter waiter;
+	InitWaiter(&waiter, 0, false);
+
+	taskENTER_CRITICAL();
+	bool is_taken = (semaphore->count > 0);
+	if (is_taken)
+		semaphore->count--;
+	else if (timeout_ms != 0)
+		AddWaiter(&semaphore->waiters, &waiter);
+	taskEXIT_CRITICAL();
+
+	if (is_taken)
+		return true;
+	if (timeout_ms == 0)
+		return false;
+	return WaitForWake(&semaphore->waiters, &waiter, start_time, timeout_ms);
+}
+
+extern uint32_t RLM3_Semaphore_GetCount(const RLM3_Semaphore* semaphore)
+{
+	return semaphore->count;
+}
+
+
+static uint32_t MatchFlags(uint32_t flags, uint32_t bits, bool is_all)
+{
+	uint32_t matched = flags & bits;
+	if (matched == 0 || (is_all && matched != bits))
+		return 0;
+	return matched;
+}
+
+static void SetFlags(RLM3_EventFlags* event_flags, uint32_t bits, bool is_isr)
+{
+	uint32_t flags = (event_flags->flags |= bits);
+	Waiter** cursor = (Waiter**)&event_flags->waiters;
+	while (*cursor != NULL)
+	{
+		Waiter* waiter = *cursor;
+		uint32_t matched = MatchFlags(flags, waiter->bits, waiter->is_all);
+		if (matched != 0)
+		{
+			*cursor = waiter->next;
+			WakeWaiter(waiter, matched, is_isr);
+		}
+		else
+			cursor = &waiter->next;
+	}
+}
+
+static uint32_t WaitFlags(RLM3_EventFlags* event_flags, uint32_t bits, bool is_all, RLM3_Time timeout_ms)
+{
+	ASSERT(!RLM3_IsIRQ());
+	ASSERT(RLM3_IsSchedulerRunning());
+	ASSERT(bits != 0);
+
+	RLM3_Time start_time = RLM3_GetCurrentTime();
+	Waiter waiter;
+	InitWaiter(&waiter, bits, is_all);
+
+	taskENTER_CRITICAL();
+	uint32_t matched = MatchFlags(event_flags->flags, bits, is_all);
+	if (matched == 0 && timeout_ms != 0)
+		AddWaiter(&event_flags->waiters, &waiter);
+	taskEXIT_CRITICAL();
+
+	if (matched != 0 || timeout_ms == 0)
+		return matched;
+	if (!WaitForWake(&event_flags->waiters, &waiter, start_time, timeout_ms))
+		return 0;
+	return waiter.result;
+}
+
+extern void RLM3_EventFlags_Init(RLM3_EventFlags* event_flags)
+{
+	event_flags->flags = 0;
+	event_flags->waiters = NULL;
+}
+
+extern void RLM3_EventFlags_Deinit(RLM3_EventFlags* event_flags)
+{
+	ASSERT(event_flags->waiters == NULL);
+}
+
+extern void RLM3_EventFlags_Set(RLM3_EventFlags* event_flags, uint32_t bits)
+{
+	ASSERT(!RLM3_IsIRQ());
+	taskENTER_CRITICAL();
+	SetFlags(event_flags, bits, false);
+	taskEXIT_CRITICAL();
+}
+
+extern void RLM3_EventFlags_SetFromISR(RLM3_EventFlags* event_flags, uint32_t bits)
+{
+	ASSERT(RLM3_IsIRQ());
+	UBaseType_t saved_level = taskENTER_CRITICAL_FROM_ISR();
+	SetFlags(event_flags, bits, true);
+	taskEXIT_CRITICAL_FROM_ISR(saved_level);
+}
+
+extern void RLM3_EventFlags_Clear(RLM3_EventFlags* event_flags, uint32_t bits)
+{
+	taskENTER_CRITICAL();
+	event_flags->flags &= ~bits;
+	taskEXIT_CRITICAL();
+}
+
+extern uint32_t RLM3_EventFlags_Get(const RLM3_EventFlags* event_flags)
+{
+	return event_flags->flags;
+}
+
+extern uint32_t RLM3_EventFlags_WaitAny(RLM3_EventFlags* event_flags, uint32_t bits, RLM3_Time timeout_ms)
+{
+	return WaitFlags(event_flags, bits, false, timeout_ms);
+}
+
+extern uint32_t RLM3_EventFlags_WaitAll(RLM3_EventFlags* event_flags, uint32_t bits, RLM3_Time timeout_ms)
+{
+	return WaitFlags(event_flags, bits, true, timeout_ms);
+}
+
+
+extern void RLM3_CondVar_Init(RLM3_CondVar* cond_var)
+{
+	cond_var->waiters = NULL;
+}
+
+extern void RLM3_CondVar_Deinit(RLM3_CondVar* cond_var)
+{
+	ASSERT(cond_var->waiters == NULL);
+}
+
+extern void RLM3_CondVar_Wait(RLM3_CondVar* cond_var, RLM3_MutexLock* lock)
+{
+	RLM3_CondVar_Try(cond_var, lock, RLM3_WAIT_FOREVER);
+}
+
+extern bool RLM3_CondVar_Try(RLM3_CondVar* cond_var, RLM3_MutexLock* lock, RLM3_Time timeout_ms)
+{
+	ASSERT(!RLM3_IsIRQ());
+	ASSERT(RLM3_IsSchedulerRunning());
+
+	RLM3_Time start_time = RLM3_GetCurrentTime();
+	Waiter waiter;
+	InitWaiter(&waiter, 0, false);
+
+	// Joining the list before releasing the lock means a signal sent after the release cannot be missed.
+	taskENTER_CRITICAL();
+	AddWaiter(&cond_var->waiters, &waiter);
+	taskEXIT_CRITICAL();
+
+	RLM3_MutexLock_Leave(lock);
+	bool is_signaled = WaitForWake(&cond_var->waiters, &waiter, start_time, timeout_ms);
+	RLM3_MutexLock_Enter(lock);
+	return is_signaled;
+}
+
+extern void RLM3_CondVar_Signal(RLM3_CondVar* cond_var)
+{
+	ASSERT(!RLM3_IsIRQ());
+	taskENTER_CRITICAL();
+	Waiter* waiter = PopWaiter(&cond_var->waiters);
+	if (waiter != NULL)
+		WakeWaiter(waiter, 1, false);
+	taskEXIT_CRITICAL();
+}
+
+extern void RLM3_CondVar_Broadcast(RLM3_CondVar* cond_var)
+{
+	ASSERT(!RLM3_IsIRQ());
+	taskENTER_CRITICAL();
+	Waiter* waiter;
+	while ((waiter = PopWaiter(&cond_var->waiters)) != NULL)
+		WakeWaiter(waiter, 1, false);
+	taskEXIT_CRITICAL();
+}
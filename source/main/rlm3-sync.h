@@ -0,0 +1,69 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-task.h"
+#include "rlm3-lock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Blocking primitives built on task notifications.  Each object is a small struct in caller-provided storage.  Waiting
+ * tasks link a record on their own stack into the object's wait list, so nothing is ever allocated.  Wait lists are
+ * walked inside critical sections, which assumes only a handful of tasks wait on any one object.
+ */
+
+
+typedef struct
+{
+	volatile uint32_t count;
+	volatile void* waiters;
+} RLM3_Semaphore;
+
+extern void RLM3_Semaphore_Init(RLM3_Semaphore* semaphore, uint32_t initial_count);
+extern void RLM3_Semaphore_Deinit(RLM3_Semaphore* semaphore);
+extern void RLM3_Semaphore_Give(RLM3_Semaphore* semaphore);
+extern void RLM3_Semaphore_GiveFromISR(RLM3_Semaphore* semaphore);
+extern void RLM3_Semaphore_Take(RLM3_Semaphore* semaphore);
+extern bool RLM3_Semaphore_Try(RLM3_Semaphore* semaphore, RLM3_Time timeout_ms);
+extern uint32_t RLM3_Semaphore_GetCount(const RLM3_Semaphore* semaphore);
+
+
+// Flags stay set until cleared, so every task waiting on a bit is released when it is set.
+typedef struct
+{
+	volatile uint32_t flags;
+	volatile void* waiters;
+} RLM3_EventFlags;
+
+extern void RLM3_EventFlags_Init(RLM3_EventFlags* event_flags);
+extern void RLM3_EventFlags_Deinit(RLM3_EventFlags* event_flags);
+extern void RLM3_EventFlags_Set(RLM3_EventFlags* event_flags, uint32_t bits);
+extern void RLM3_EventFlags_SetFromISR(RLM3_EventFlags* event_flags, uint32_t bits);
+extern void RLM3_EventFlags_Clear(RLM3_EventFlags* event_flags, uint32_t bits);
+extern uint32_t RLM3_EventFlags_Get(const RLM3_EventFlags* event_flags);
+
+// Returns the matching bits, or 0 on timeout.
+extern uint32_t RLM3_EventFlags_WaitAny(RLM3_EventFlags* event_flags, uint32_t bits, RLM3_Time timeout_ms);
+extern uint32_t RLM3_EventFlags_WaitAll(RLM3_EventFlags* event_flags, uint32_t bits, RLM3_Time timeout_ms);
+
+
+// The lock must be held on Wait and is held again on return, whether or not the task was signaled.
+typedef struct
+{
+	volatile void* waiters;
+} RLM3_CondVar;
+
+extern void RLM3_CondVar_Init(RLM3_CondVar* cond_var);
+extern void RLM3_CondVar_Deinit(RLM3_CondVar* cond_var);
+extern void RLM3_CondVar_Wait(RLM3_CondVar* cond_var, RLM3_MutexLock* lock);
+extern bool RLM3_CondVar_Try(RLM3_CondVar* cond_var, RLM3_MutexLock* lock, RLM3_Time timeout_ms);
+extern void RLM3_CondVar_Signal(RLM3_CondVar* cond_var);
+extern void RLM3_CondVar_Broadcast(RLM3_CondVar* cond_var);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,6 +5,10 @@
 #include "Assert.h"
 
 
+static volatile uint32_t g_isr_depth = 0;
+static volatile uint32_t g_isr_yield = 0;
+
+
 static bool IsISR()
 {
 	return (__get_IPSR() != 0U);
@@ -46,47 +50,154 @@ extern RLM3_Task RLM3_GetCurrentTask()
 	return xTaskGetCurrentTaskHandle();
 }
 
+static void YieldFromISR(BaseType_t higher_priority_task_woken)
+{
+	if (g_isr_depth == 0)
+		portYIELD_FROM_ISR(higher_priority_task_woken);
+	else if (higher_priority_task_woken != pdFALSE)
+		g_isr_yield = 1;
+}
+
+#if tskKERNEL_VERSION_MAJOR > 10 || (tskKERNEL_VERSION_MAJOR == 10 && tskKERNEL_VERSION_MINOR >= 4)
+
+static uint32_t ClearSignals(uint32_t bits)
+{
+	return ulTaskNotifyValueClear(NULL, bits);
+}
+
+#else
+
+static uint32_t ClearSignals(uint32_t bits)
+{
+	// Before FreeRTOS 10.4 the value can only be cleared by overwriting it, which also marks a notification pending.
+	// The pending state is put back so a consumed signal does not wake the next wait.
+	taskENTER_CRITICAL();
+	BaseType_t was_pending = xTaskNotifyStateClear(NULL);
+	uint32_t value = 0;
+	xTaskNotifyWait(0, 0, &value, 0);
+	if ((value & bits) != 0 || was_pending != pdFALSE)
+		xTaskNotify(xTaskGetCurrentTaskHandle(), value & ~bits, eSetValueWithOverwrite);
+	if (was_pending == pdFALSE)
+		xTaskNotifyStateClear(NULL);
+	taskEXIT_CRITICAL();
+	return value;
+}
+
+#endif
+
+static uint32_t ConsumeSignals(uint32_t bits, bool is_all)
+{
+	// Only this task clears its bits, so bits seen set stay set until they are cleared here.
+	if (!is_all)
+		return ClearSignals(bits) & bits;
+	if ((ClearSignals(0) & bits) != bits)
+		return 0;
+	ClearSignals(bits);
+	return bits;
+}
+
+static uint32_t WaitSignals(uint32_t bits, bool is_all, TickType_t start_time, TickType_t delay)
+{
+	// Any notification wakes the task, so it checks the bits again until they match or the time runs out.  Clearing
+	// the pending state first keeps a signal that was already consumed from waking the task again.
+	while (true)
+	{
+		xTaskNotifyStateClear(NULL);
+		uint32_t fired = ConsumeSignals(bits, is_all);
+		if (fired != 0)
+			return fired;
+
+		TickType_t remaining = portMAX_DELAY;
+		if (delay != portMAX_DELAY)
+		{
+			TickType_t elapsed = xTaskGetTickCount() - start_time;
+			if (elapsed >= delay)
+				return 0;
+			remaining = delay - elapsed;
+		}
+		xTaskNotifyWait(0, 0, NULL, remaining);
+	}
+}
+
+static TickType_t GetTimeoutTicks(RLM3_Time timeout_ms)
+{
+	return (timeout_ms == RLM3_WAIT_FOREVER) ? portMAX_DELAY : timeout_ms + 1;
+}
+
 extern void RLM3_Give(RLM3_Task task)
+{
+	RLM3_Signal(task, RLM3_SIGNAL_GIVE);
+}
+
+extern void RLM3_GiveFromISR(RLM3_Task task)
+{
+	RLM3_SignalFromISR(task, RLM3_SIGNAL_GIVE);
+}
+
+extern void RLM3_Take()
+{
+	ASSERT(!IsISR());
+	WaitSignals(RLM3_SIGNAL_GIVE, false, xTaskGetTickCount(), portMAX_DELAY);
+}
+
+extern bool RLM3_TakeWithTimeout(RLM3_Time timeout_ms)
+{
+	ASSERT(!IsISR());
+	return (WaitSignals(RLM3_SIGNAL_GIVE, false, xTaskGetTickCount(), timeout_ms + 1) != 0);
+}
+
+extern bool RLM3_TakeUntil(RLM3_Time start_time, RLM3_Time delay_ms)
+{
+	ASSERT(!IsISR());
+	return (WaitSignals(RLM3_SIGNAL_GIVE, false, start_time, delay_ms) != 0);
+}
+
+extern void RLM3_Signal(RLM3_Task task, uint32_t bits)
 {
 	ASSERT(!IsISR());
 	if (task != NULL)
 	{
-		xTaskNotifyGive(task);
+		xTaskNotify(task, bits, eSetBits);
 	}
 }
 
-extern void RLM3_GiveFromISR(RLM3_Task task)
+extern void RLM3_SignalFromISR(RLM3_Task task, uint32_t bits)
 {
 	ASSERT(IsISR());
 	if (task != NULL)
 	{
 		BaseType_t higher_priority_task_woken = pdFALSE;
-		vTaskNotifyGiveFromISR(task, &higher_priority_task_woken);
-		portYIELD_FROM_ISR(higher_priority_task_woken);
+		xTaskNotifyFromISR(task, bits, eSetBits, &higher_priority_task_woken);
+		YieldFromISR(higher_priority_task_woken);
 	}
 }
 
-extern void RLM3_Take()
+extern uint32_t RLM3_WaitAny(uint32_t bits, RLM3_Time timeout_ms)
 {
 	ASSERT(!IsISR());
-	ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	ASSERT(bits != 0);
+	return WaitSignals(bits, false, xTaskGetTickCount(), GetTimeoutTicks(timeout_ms));
 }
 
-extern bool RLM3_TakeWithTimeout(RLM3_Time timeout_ms)
+extern uint32_t RLM3_WaitAll(uint32_t bits, RLM3_Time timeout_ms)
 {
 	ASSERT(!IsISR());
-	uint32_t value = ulTaskNotifyTake(pdTRUE, timeout_ms + 1);
-	return (value > 0);
+	ASSERT(bits != 0);
+	return WaitSignals(bits, true, xTaskGetTickCount(), GetTimeoutTicks(timeout_ms));
 }
 
-extern bool RLM3_TakeUntil(RLM3_Time start_time, RLM3_Time delay_ms)
+extern void RLM3_ISR_Begin()
 {
-	ASSERT(!IsISR());
-	RLM3_Time current_time = xTaskGetTickCount();
-	if (current_time - start_time >= delay_ms)
-		return false;
-	uint32_t value = ulTaskNotifyTake(pdTRUE, delay_ms + start_time - current_time);
-	return (value > 0);
+	// A nested interrupt always restores the depth before returning, so the increment does not need to be atomic.
+	ASSERT(IsISR());
+	g_isr_depth++;
+}
+
+extern void RLM3_ISR_End()
+{
+	ASSERT(IsISR() && g_isr_depth > 0);
+	if (--g_isr_depth == 0 && __atomic_exchange_n(&g_isr_yield, 0, __ATOMIC_RELAXED) != 0)
+		portYIELD_FROM_ISR(pdTRUE);
 }
 
 extern void RLM3_EnterCritical()
@@ -10,6 +10,13 @@ extern "C" {
 typedef void* RLM3_Task;
 typedef uint32_t RLM3_Time;
 
+// Give and Take use this notification bit, the I2C driver hands over the bus with the next and the I2C1 poll task
+// wakes on the third.  The other bits are free for RLM3_Signal.
+#define RLM3_SIGNAL_GIVE 0x80000000UL
+#define RLM3_SIGNAL_I2C_BUS 0x40000000UL
+#define RLM3_SIGNAL_I2C_POLL 0x20000000UL
+#define RLM3_WAIT_FOREVER 0xFFFFFFFFUL
+
 extern RLM3_Time RLM3_GetCurrentTime();
 extern RLM3_Time RLM3_GetCurrentTimeFromISR();
 extern void RLM3_Yield();
@@ -23,6 +30,17 @@ extern void RLM3_Take();
 extern bool RLM3_TakeWithTimeout(RLM3_Time timeout_ms);
 extern bool RLM3_TakeUntil(RLM3_Time start_time, RLM3_Time delay_ms);
 
+// Sets notification bits on a task.  The waits clear and return the bits that satisfied them, or zero on timeout.
+extern void RLM3_Signal(RLM3_Task task, uint32_t bits);
+extern void RLM3_SignalFromISR(RLM3_Task task, uint32_t bits);
+extern uint32_t RLM3_WaitAny(uint32_t bits, RLM3_Time timeout_ms);
+extern uint32_t RLM3_WaitAll(uint32_t bits, RLM3_Time timeout_ms);
+
+// Interrupt handlers wrap their body in these so every RLM3_GiveFromISR in between requests at most one context switch,
+// made when the outermost handler ends.  Gives outside a scope still switch immediately.
+extern void RLM3_ISR_Begin();
+extern void RLM3_ISR_End();
+
 extern void RLM3_EnterCritical();
 extern uint32_t RLM3_EnterCriticalFromISR();
 extern void RLM3_ExitCritical();
@@ -0,0 +1,262 @@
+#include "rlm3-timer-wheel.h"
+#include "Assert.h"
+
+
+enum
+{
+	ENTRY_FLAG_SCHEDULED = 0x01,
+	ENTRY_FLAG_QUEUED = 0x02,
+	ENTRY_FLAG_PENDING = 0x04,
+};
+
+
+static uint32_t GetSlotIndex(uint32_t time, uint32_t level)
+{
+	return (time >> (RLM3_TIMER_WHEEL_SLOT_BITS * level)) & (RLM3_TIMER_WHEEL_SLOTS - 1);
+}
+
+static void Link(RLM3_TimerWheel* wheel, RLM3_TimerWheel_Entry* entry)
+{
+	// The level is picked by the highest bit that differs between the expiry and the current time.  Every level above
+	// that one already matches the current time, so the entry only needs to move once the lower levels roll over.
+	uint32_t diff = entry->expiry ^ wheel->now;
+	uint32_t level = (diff == 0) ? 0 : (31 - __builtin_clz(diff)) / RLM3_TIMER_WHEEL_SLOT_BITS;
+	uint32_t slot = GetSlotIndex(entry->expiry, level);
+
+	RLM3_TimerWheel_Entry* head = wheel->slots[level][slot];
+	entry->level = level;
+	entry->slot = slot;
+	entry->prev = NULL;
+	entry->next = head;
+	if (head != NULL)
+		head->prev = entry;
+	wheel->slots[level][slot] = entry;
+	wheel->occupied[level] |= (1ULL << slot);
+	entry->flags |= ENTRY_FLAG_SCHEDULED;
+}
+
+static void Unlink(RLM3_TimerWheel* wheel, RLM3_TimerWheel_Entry* entry)
+{
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		wheel->slots[entry->level][entry->slot] = entry->next;
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	if (wheel->slots[entry->level][entry->slot] == NULL)
+		wheel->occupied[entry->level] &= ~(1ULL << entry->slot);
+	entry->next = NULL;
+	entry->prev = NULL;
+	entry->flags &= ~ENTRY_FLAG_SCHEDULED;
+}
+
+static bool FindNextEvent(const RLM3_TimerWheel* wheel, uint32_t* level_out, uint32_t* slot_out, uint32_t* delta_out)
+{
+	bool result = false;
+	uint32_t now = wheel->now;
+	for (uint32_t level = 0; level < RLM3_TIMER_WHEEL_LEVELS; level++)
+	{
+		uint64_t occupied = wheel->occupied[level];
+		if (occupied == 0)
+			continue;
+
+		// Slots before the current one can only be used when the top level wraps around.
+		uint32_t current = GetSlotIndex(now, level);
+		uint64_t upcoming = occupied & (~0ULL << current);
+		uint32_t slot = __builtin_ctzll((upcoming != 0) ? upcoming : occupied);
+
+		uint32_t shift = RLM3_TIMER_WHEEL_SLOT_BITS * level;
+		uint32_t span_shift = shift + RLM3_TIMER_WHEEL_SLOT_BITS;
+		uint32_t base = (span_shift >= 32) ? 0 : (now & ~((1UL << span_shift) - 1));
+		uint32_t event_time = base | (slot << shift);
+		uint32_t delta = (slot == current) ? 0 : event_time - now;
+
+		if (!result || delta < *delta_out)
+		{
+			*level_out = level;
+			*slot_out = slot;
+			*delta_out = delta;
+			result = true;
+		}
+	}
+	return result;
+}
+
+static void Enqueue(RLM3_TimerWheel_Entry** head, RLM3_TimerWheel_Entry** tail, RLM3_TimerWheel_Entry* entry)
+{
+	// Entries that are still waiting from an earlier expiration are only queued once.
+	entry->flags |= ENTRY_FLAG_PENDING;
+	if ((entry->flags & ENTRY_FLAG_QUEUED) == 0)
+	{
+		entry->flags |= ENTRY_FLAG_QUEUED;
+		entry->queue_next = NULL;
+		if (*tail != NULL)
+			(*tail)->queue_next = entry;
+		else
+			*head = entry;
+		*tail = entry;
+	}
+}
+
+static RLM3_TimerWheel_Entry* Dequeue(RLM3_TimerWheel_Entry** head, RLM3_TimerWheel_Entry** tail)
+{
+	// A cancelled entry stays in the queue and is skipped here rather than searched for when it is cancelled.
+	RLM3_TimerWheel_Entry* entry;
+	while ((entry = *head) != NULL)
+	{
+		*head = entry->queue_next;
+		if (*head == NULL)
+			*tail = NULL;
+		entry->queue_next = NULL;
+		entry->flags &= ~ENTRY_FLAG_QUEUED;
+
+		if ((entry->flags & ENTRY_FLAG_PENDING) != 0)
+		{
+			entry->flags &= ~ENTRY_FLAG_PENDING;
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void Expire(RLM3_TimerWheel* wheel, RLM3_TimerWheel_Entry* entry)
+{
+	if (entry->period != 0)
+	{
+		entry->expiry += entry->period;
+		Link(wheel, entry);
+	}
+
+	if (entry->dispatch == RLM3_TIMER_WHEEL_DISPATCH_ISR)
+		Enqueue(&wheel->expired_head, &wheel->expired_tail, entry);
+	else
+		Enqueue(&wheel->deferred_head, &wheel->deferred_tail, entry);
+}
+
+extern void RLM3_TimerWheel_Init(RLM3_TimerWheel* wheel, uint32_t now)
+{
+	ASSERT(wheel != NULL);
+
+	wheel->now = now;
+	for (size_t level = 0; level < RLM3_TIMER_WHEEL_LEVELS; level++)
+	{
+		wheel->occupied[level] = 0;
+		for (size_t slot = 0; slot < RLM3_TIMER_WHEEL_SLOTS; slot++)
+			wheel->slots[level][slot] = NULL;
+	}
+	wheel->expired_head = NULL;
+	wheel->expired_tail = NULL;
+	wheel->deferred_head = NULL;
+	wheel->deferred_tail = NULL;
+}
+
+extern void RLM3_TimerWheel_InitEntry(RLM3_TimerWheel_Entry* entry, RLM3_TimerWheel_Callback callback, void* context, RLM3_TimerWheel_Dispatch dispatch)
+{
+	ASSERT(entry != NULL);
+	ASSERT(callback != NULL);
+	ASSERT(dispatch == RLM3_TIMER_WHEEL_DISPATCH_ISR || dispatch == RLM3_TIMER_WHEEL_DISPATCH_TASK);
+
+	entry->next = NULL;
+	entry->prev = NULL;
+	entry->queue_next = NULL;
+	entry->callback = callback;
+	entry->context = context;
+	entry->expiry = 0;
+	entry->period = 0;
+	entry->dispatch = dispatch;
+	entry->level = 0;
+	entry->slot = 0;
+	entry->flags = 0;
+}
+
+extern void RLM3_TimerWheel_Schedule(RLM3_TimerWheel* wheel, RLM3_TimerWheel_Entry* entry, uint32_t expiry, uint32_t period)
+{
+	ASSERT(wheel != NULL && entry != NULL);
+	ASSERT(expiry - wheel->now <= RLM3_TIMER_WHEEL_MAX_DELAY);
+	ASSERT(period <= RLM3_TIMER_WHEEL_MAX_DELAY);
+
+	if ((entry->flags & ENTRY_FLAG_SCHEDULED) != 0)
+		Unlink(wheel, entry);
+	entry->expiry = expiry;
+	entry->period = period;
+	Link(wheel, entry);
+}
+
+extern void RLM3_TimerWheel_Cancel(RLM3_TimerWheel* wheel, RLM3_TimerWheel_Entry* entry)
+{
+	ASSERT(wheel != NULL && entry != NULL);
+
+	if ((entry->flags & ENTRY_FLAG_SCHEDULED) != 0)
+		Unlink(wheel, entry);
+	entry->period = 0;
+	entry->flags &= ~ENTRY_FLAG_PENDING;
+}
+
+extern bool RLM3_TimerWheel_IsScheduled(const RLM3_TimerWheel_Entry* entry)
+{
+	return ((entry->flags & (ENTRY_FLAG_SCHEDULED | ENTRY_FLAG_PENDING)) != 0);
+}
+
+extern bool RLM3_TimerWheel_Advance(RLM3_TimerWheel* wheel, uint32_t now)
+{
+	bool has_deferred = RLM3_TimerWheel_Collect(wheel, now);
+	RLM3_TimerWheel_Entry* entry;
+	while ((entry = RLM3_TimerWheel_PopExpired(wheel)) != NULL)
+		entry->callback(entry, entry->context);
+	return has_deferred;
+}
+
+extern bool RLM3_TimerWheel_Collect(RLM3_TimerWheel* wheel, uint32_t now)
+{
+	ASSERT(wheel != NULL);
+
+	uint32_t remaining = now - wheel->now;
+	uint32_t level = 0;
+	uint32_t slot = 0;
+	uint32_t delta = 0;
+	while (FindNextEvent(wheel, &level, &slot, &delta) && delta <= remaining)
+	{
+		wheel->now += delta;
+		remaining -= delta;
+
+		// Entries at level 0 are due now.  Entries at higher levels are moved down closer to their expiry.
+		RLM3_TimerWheel_Entry* entry;
+		while ((entry = wheel->slots[level][slot]) != NULL)
+		{
+			Unlink(wheel, entry);
+			if (level == 0)
+				Expire(wheel, entry);
+			else
+				Link(wheel, entry);
+		}
+	}
+	wheel->now = now;
+
+	return (wheel->deferred_head != NULL);
+}
+
+extern bool RLM3_TimerWheel_GetNextExpiry(const RLM3_TimerWheel* wheel, uint32_t* expiry_out)
+{
+	ASSERT(wheel != NULL && expiry_out != NULL);
+
+	// This may be a time where entries only move to a lower level, but the wheel must be advanced then either way.
+	uint32_t level = 0;
+	uint32_t slot = 0;
+	uint32_t delta = 0;
+	if (!FindNextEvent(wheel, &level, &slot, &delta))
+		return false;
+	*expiry_out = wheel->now + delta;
+	return true;
+}
+
+extern RLM3_TimerWheel_Entry* RLM3_TimerWheel_PopExpired(RLM3_TimerWheel* wheel)
+{
+	ASSERT(wheel != NULL);
+	return Dequeue(&wheel->expired_head, &wheel->expired_tail);
+}
+
+extern RLM3_TimerWheel_Entry* RLM3_TimerWheel_PopDeferred(RLM3_TimerWheel* wheel)
+{
+	ASSERT(wheel != NULL);
+	return Dequeue(&wheel->deferred_head, &wheel->deferred_tail);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "rlm3-base.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * A hierarchical timer wheel.  The wheel does not know anything about the hardware.  Time is an unsigned 32 bit
+ * value that is allowed to wrap, and the owner of the wheel moves time forward by calling RLM3_TimerWheel_Advance.
+ * Scheduling and cancelling an entry are constant time operations.  Entries are owned by the caller.
+ */
+
+
+#define RLM3_TIMER_WHEEL_LEVELS 6
+#define RLM3_TIMER_WHEEL_SLOT_BITS 6
+#define RLM3_TIMER_WHEEL_SLOTS (1 << RLM3_TIMER_WHEEL_SLOT_BITS)
+#define RLM3_TIMER_WHEEL_MAX_DELAY 0x7FFFFFFF
+
+
+typedef enum
+{
+	RLM3_TIMER_WHEEL_DISPATCH_ISR,  // Callback runs from RLM3_TimerWheel_Advance, or is queued for RLM3_TimerWheel_PopExpired by RLM3_TimerWheel_Collect.
+	RLM3_TIMER_WHEEL_DISPATCH_TASK, // Callback is queued until RLM3_TimerWheel_PopDeferred returns it.
+} RLM3_TimerWheel_Dispatch;
+
+typedef struct RLM3_TimerWheel_Entry RLM3_TimerWheel_Entry;
+typedef void (*RLM3_TimerWheel_Callback)(RLM3_TimerWheel_Entry* entry, void* context);
+
+struct RLM3_TimerWheel_Entry
+{
+	RLM3_TimerWheel_Entry* next;
+	RLM3_TimerWheel_Entry* prev;
+	RLM3_TimerWheel_Entry* queue_next;
+	RLM3_TimerWheel_Callback callback;
+	void* context;
+	uint32_t expiry;
+	uint32_t period;
+	uint8_t dispatch;
+	uint8_t level;
+	uint8_t slot;
+	uint8_t flags;
+};
+
+typedef struct
+{
+	uint32_t now;
+	uint64_t occupied[RLM3_TIMER_WHEEL_LEVELS];
+	RLM3_TimerWheel_Entry* slots[RLM3_TIMER_WHEEL_LEVELS][RLM3_TIMER_WHEEL_SLOTS];
+	RLM3_TimerWheel_Entry* expired_head;
+	RLM3_TimerWheel_Entry* expired_tail;
+	RLM3_TimerWheel_Entry* deferred_head;
+	RLM3_TimerWheel_Entry* deferred_tail;
+} RLM3_TimerWheel;
+
+
+extern void RLM3_TimerWheel_Init(RLM3_TimerWheel* wheel, uint32_t now);
+extern void RLM3_TimerWheel_InitEntry(RLM3_TimerWheel_Entry* entry, RLM3_TimerWheel_Callback callback, void* context, RLM3_TimerWheel_Dispatch dispatch);
+
+// Schedules the entry to expire at an absolute time no more than RLM3_TIMER_WHEEL_MAX_DELAY after the current time.  A non-zero period makes the entry repeat.
+extern void RLM3_TimerWheel_Schedule(RLM3_TimerWheel* wheel, RLM3_TimerWheel_Entry* entry, uint32_t expiry, uint32_t period);
+extern void RLM3_TimerWheel_Cancel(RLM3_TimerWheel* wheel, RLM3_TimerWheel_Entry* entry);
+extern bool RLM3_TimerWheel_IsScheduled(const RLM3_TimerWheel_Entry* entry);
+
+// Moves time forward and expires every entry due at or before the new time.  Returns true if deferred entries are waiting.
+extern bool RLM3_TimerWheel_Advance(RLM3_TimerWheel* wheel, uint32_t now);
+// The same as Advance, except the ISR callbacks are queued instead of called.  This lets the owner move time inside a
+// critical section and call them after it leaves.  PopExpired returns them in the order they expired.
+extern bool RLM3_TimerWheel_Collect(RLM3_TimerWheel* wheel, uint32_t now);
+extern RLM3_TimerWheel_Entry* RLM3_TimerWheel_PopExpired(RLM3_TimerWheel* wheel);
+extern bool RLM3_TimerWheel_GetNextExpiry(const RLM3_TimerWheel* wheel, uint32_t* expiry_out);
+extern RLM3_TimerWheel_Entry* RLM3_TimerWheel_PopDeferred(RLM3_TimerWheel* wheel);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,20 +1,95 @@
 #include "rlm3-timer.h"
+#include "rlm3-task.h"
 #include "main.h"
+#include "Assert.h"
+
+
+#define TIMER2_WHEEL_FREQUENCY_HZ 1000000
+#define TIMER2_CAPTURE_FIRST_CHANNEL 2
+#define TIMER2_CAPTURE_CHANNEL_COUNT 3
+
+#if RLM3_TIMER_WHEEL_MAX_DELAY > RLM3_TIMER_COMPARE_MAX_AHEAD
+#error "Wheel entries must expire within the compare horizon"
+#endif
+
+
+typedef enum
+{
+	TIMER2_MODE_PERIODIC,
+	TIMER2_MODE_ONE_SHOT,
+	TIMER2_MODE_WHEEL,
+} Timer2Mode;
 
 
 static TIM_HandleTypeDef g_htim2 = { 0 };
 
+static volatile Timer2Mode g_timer2_mode = TIMER2_MODE_PERIODIC;
+static RLM3_TimerWheel g_wheel;
+static volatile RLM3_Task g_wheel_deferred_task = NULL;
+static volatile uint32_t g_timer2_high = 0;
+static RLM3_Capture g_captures[TIMER2_CAPTURE_CHANNEL_COUNT];
+static volatile RLM3_Task g_capture_tasks[TIMER2_CAPTURE_CHANNEL_COUNT] = { NULL };
+static volatile bool g_capture_active[TIMER2_CAPTURE_CHANNEL_COUNT] = { false };
 
-extern void RLM3_Timer2_Init(size_t frequency_hz)
+
+extern uint32_t RLM3_Timer_ComputeClock(uint32_t pclk_hz, uint32_t apb_divider, bool timer_prescaler)
+{
+	ASSERT(apb_divider == 1 || apb_divider == 2 || apb_divider == 4 || apb_divider == 8 || apb_divider == 16);
+
+	// Timers on a divided APB bus run faster than the bus.  See the clock tree in the reference manual (RM0090 6.2).
+	if (!timer_prescaler)
+		return (apb_divider == 1) ? pclk_hz : 2 * pclk_hz;
+	return (apb_divider <= 4) ? pclk_hz * apb_divider : 4 * pclk_hz;
+}
+
+extern uint32_t RLM3_Timer_ComputeReload(uint32_t clock_hz, uint32_t frequency_hz)
+{
+	ASSERT(frequency_hz > 0 && frequency_hz <= clock_hz);
+
+	// The counter runs from 0 through the reload value, so the period is one count longer than the reload value.
+	return (clock_hz + frequency_hz / 2) / frequency_hz - 1;
+}
+
+extern void RLM3_Timer_UpdateReload(TIM_TypeDef* timer, uint32_t reload)
+{
+	// With preload enabled the new value only takes effect on the next update event, so the current period is not cut short.
+	SET_BIT(timer->CR1, TIM_CR1_ARPE);
+	timer->ARR = reload;
+}
+
+extern bool RLM3_Timer_ScheduleCompare(TIM_TypeDef* timer, uint32_t time)
 {
+	timer->CCR1 = time;
+	SET_BIT(timer->DIER, TIM_DIER_CC1IE);
+
+	// If the counter already passed the compare value, the hardware will not match it until it wraps.
+	if ((int32_t)(timer->CNT - time) >= 0)
+	{
+		timer->EGR = TIM_EGR_CC1G;
+		return false;
+	}
+	return true;
+}
+
+extern uint32_t RLM3_Timer2_GetClockFrequency()
+{
+	uint32_t apb_divider = 1UL << APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> RCC_CFGR_PPRE1_Pos];
+	bool timer_prescaler = ((RCC->DCKCFGR & RCC_DCKCFGR_TIMPRE) != 0);
+	return RLM3_Timer_ComputeClock(HAL_RCC_GetPCLK1Freq(), apb_divider, timer_prescaler);
+}
+
+static void Timer2_Init(Timer2Mode mode, uint32_t prescaler, uint32_t period)
+{
+	g_timer2_mode = mode;
+
 	__HAL_RCC_TIM2_CLK_ENABLE();
 
 	g_htim2.Instance = TIM2;
-	g_htim2.Init.Prescaler = 0;
+	g_htim2.Init.Prescaler = prescaler;
 	g_htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
-	g_htim2.Init.Period = 180000000 / frequency_hz / 2;
+	g_htim2.Init.Period = period;
 	g_htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-	g_htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	g_htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
 	HAL_TIM_Base_Init(&g_htim2);
 
 	TIM_ClockConfigTypeDef sClockSourceConfig = { 0 };
@@ -28,14 +103,37 @@ extern void RLM3_Timer2_Init(size_t frequency_hz)
 
 	HAL_NVIC_SetPriority(TIM2_IRQn, 5, 0);
 	HAL_NVIC_EnableIRQ(TIM2_IRQn);
+}
+
+static void Timer2_StartFreeRunning()
+{
+	// The update interrupt counts counter rollovers for the capture channels.
+	g_timer2_high = 0;
+	TIM2->SR = ~(TIM_SR_CC1IF | TIM_SR_UIF);
 	HAL_TIM_Base_Start_IT(&g_htim2);
 }
 
-extern void RLM3_Timer2_Deinit()
+static void Timer2_Deinit()
 {
+	for (size_t i = 0; i < TIMER2_CAPTURE_CHANNEL_COUNT; i++)
+		if (g_capture_active[i])
+			RLM3_Timer2_Capture_Stop(TIMER2_CAPTURE_FIRST_CHANNEL + i);
+	CLEAR_BIT(TIM2->DIER, TIM_DIER_CC1IE);
 	HAL_TIM_Base_Stop_IT(&g_htim2);
 	HAL_TIM_Base_DeInit(&g_htim2);
 	__HAL_RCC_TIM2_CLK_DISABLE();
+	g_timer2_mode = TIMER2_MODE_PERIODIC;
+}
+
+extern void RLM3_Timer2_Init(size_t frequency_hz)
+{
+	Timer2_Init(TIMER2_MODE_PERIODIC, 0, RLM3_Timer_ComputeReload(RLM3_Timer2_GetClockFrequency(), frequency_hz));
+	HAL_TIM_Base_Start_IT(&g_htim2);
+}
+
+extern void RLM3_Timer2_Deinit()
+{
+	Timer2_Deinit();
 }
 
 extern bool RLM3_Timer2_IsInit()
@@ -43,13 +141,338 @@ extern bool RLM3_Timer2_IsInit()
 	return __HAL_RCC_TIM2_IS_CLK_ENABLED();
 }
 
+extern void RLM3_Timer2_SetFrequency(size_t frequency_hz)
+{
+	ASSERT(RLM3_Timer2_IsInit() && g_timer2_mode == TIMER2_MODE_PERIODIC);
+	RLM3_Timer_UpdateReload(TIM2, RLM3_Timer_ComputeReload(RLM3_Timer2_GetClockFrequency(), frequency_hz));
+}
+
+extern void RLM3_Timer2_InitOneShot()
+{
+	ASSERT(!RLM3_Timer2_IsInit());
+
+	Timer2_Init(TIMER2_MODE_ONE_SHOT, 0, 0xFFFFFFFF);
+	Timer2_StartFreeRunning();
+}
+
+extern uint32_t RLM3_Timer2_GetCycles()
+{
+	return TIM2->CNT;
+}
+
+extern void RLM3_Timer2_ScheduleAt(uint32_t cycles)
+{
+	ASSERT(RLM3_Timer2_IsInit() && g_timer2_mode == TIMER2_MODE_ONE_SHOT);
+	RLM3_Timer_ScheduleCompare(TIM2, cycles);
+}
+
+extern void RLM3_Timer2_ScheduleAfter(uint32_t delay_cycles)
+{
+	ASSERT(RLM3_Timer2_IsInit() && g_timer2_mode == TIMER2_MODE_ONE_SHOT);
+	ASSERT(delay_cycles <= RLM3_TIMER_COMPARE_MAX_AHEAD);
+	RLM3_Timer_ScheduleCompare(TIM2, TIM2->CNT + delay_cycles);
+}
+
+extern void RLM3_Timer2_CancelScheduled()
+{
+	ASSERT(RLM3_Timer2_IsInit() && g_timer2_mode == TIMER2_MODE_ONE_SHOT);
+	CLEAR_BIT(TIM2->DIER, TIM_DIER_CC1IE);
+	TIM2->SR = ~TIM_SR_CC1IF;
+}
+
 extern __attribute__((weak)) void RLM3_Timer2_Event_Callback()
 {
 	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
 }
 
-extern void TIM2_IRQHandler(void)
+static uint32_t EnterWheel()
+{
+	// The wheel is shared between tasks, the TIM2 interrupt and callbacks running inside that interrupt.
+	if (RLM3_IsIRQ())
+		return RLM3_EnterCriticalFromISR();
+	RLM3_EnterCritical();
+	return 0;
+}
+
+static void LeaveWheel(uint32_t saved_level)
+{
+	if (RLM3_IsIRQ())
+		RLM3_ExitCriticalFromISR(saved_level);
+	else
+		RLM3_ExitCritical();
+}
+
+static void UpdateWheelCompare()
+{
+	uint32_t expiry = 0;
+	if (RLM3_TimerWheel_GetNextExpiry(&g_wheel, &expiry))
+		RLM3_Timer_ScheduleCompare(TIM2, expiry);
+	else
+		CLEAR_BIT(TIM2->DIER, TIM_DIER_CC1IE);
+}
+
+extern void RLM3_Timer2_Wheel_Init()
+{
+	ASSERT(!RLM3_Timer2_IsInit());
+
+	RLM3_TimerWheel_Init(&g_wheel, 0);
+
+	uint32_t prescaler = RLM3_Timer2_GetClockFrequency() / TIMER2_WHEEL_FREQUENCY_HZ - 1;
+	Timer2_Init(TIMER2_MODE_WHEEL, prescaler, 0xFFFFFFFF);
+	Timer2_StartFreeRunning();
+}
+
+extern void RLM3_Timer2_Wheel_Deinit()
 {
-	TIM2->SR = ~TIM_IT_UPDATE;
+	ASSERT(g_timer2_mode == TIMER2_MODE_WHEEL);
+
+	HAL_NVIC_DisableIRQ(TIM2_IRQn);
+	Timer2_Deinit();
+	g_wheel_deferred_task = NULL;
+}
+
+extern bool RLM3_Timer2_Wheel_IsInit()
+{
+	return (g_timer2_mode == TIMER2_MODE_WHEEL) && RLM3_Timer2_IsInit();
+}
+
+extern uint32_t RLM3_Timer2_Wheel_GetTime()
+{
+	ASSERT(g_timer2_mode == TIMER2_MODE_WHEEL);
+	return TIM2->CNT;
+}
+
+extern void RLM3_Timer2_Wheel_Start(RLM3_TimerWheel_Entry* entry, uint32_t delay_us, uint32_t period_us)
+{
+	ASSERT(g_timer2_mode == TIMER2_MODE_WHEEL);
+	ASSERT(entry != NULL);
+	ASSERT(delay_us <= RLM3_TIMER_WHEEL_MAX_DELAY);
+	ASSERT(period_us <= RLM3_TIMER_WHEEL_MAX_DELAY);
+
+	uint32_t saved_level = EnterWheel();
+
+	// Bring the wheel up to the counter when nothing is due yet so the delay is measured from the current time.  With
+	// nothing due, no callback is collected.
+	uint32_t now = TIM2->CNT;
+	uint32_t next_expiry = 0;
+	if (!RLM3_TimerWheel_GetNextExpiry(&g_wheel, &next_expiry) || (int32_t)(next_expiry - now) > 0)
+		RLM3_TimerWheel_Collect(&g_wheel, now);
+
+	RLM3_TimerWheel_Schedule(&g_wheel, entry, now + delay_us, period_us);
+	UpdateWheelCompare();
+	LeaveWheel(saved_level);
+}
+
+extern void RLM3_Timer2_Wheel_Cancel(RLM3_TimerWheel_Entry* entry)
+{
+	ASSERT(g_timer2_mode == TIMER2_MODE_WHEEL);
+	ASSERT(entry != NULL);
+
+	uint32_t saved_level = EnterWheel();
+	RLM3_TimerWheel_Cancel(&g_wheel, entry);
+	UpdateWheelCompare();
+	LeaveWheel(saved_level);
+}
+
+extern void RLM3_Timer2_Wheel_SetDeferredTask(RLM3_Task task)
+{
+	g_wheel_deferred_task = task;
+}
+
+extern size_t RLM3_Timer2_Wheel_RunDeferred()
+{
+	ASSERT(!RLM3_IsIRQ());
+
+	size_t count = 0;
+	while (true)
+	{
+		RLM3_EnterCritical();
+		RLM3_TimerWheel_Entry* entry = RLM3_TimerWheel_PopDeferred(&g_wheel);
+		RLM3_ExitCritical();
+		if (entry == NULL)
+			break;
+		entry->callback(entry, entry->context);
+		count++;
+	}
+	return count;
+}
+
+static volatile uint32_t* GetCaptureRegister(size_t channel)
+{
+	switch (channel)
+	{
+	case 2: return &TIM2->CCR2;
+	case 3: return &TIM2->CCR3;
+	default: return &TIM2->CCR4;
+	}
+}
+
+extern void RLM3_Timer2_Capture_Start(size_t channel, RLM3_Timer2_CaptureEdge edge, RLM3_Task task)
+{
+	ASSERT(RLM3_Timer2_IsInit());
+	ASSERT(g_timer2_mode == TIMER2_MODE_ONE_SHOT || g_timer2_mode == TIMER2_MODE_WHEEL);
+	ASSERT(channel >= TIMER2_CAPTURE_FIRST_CHANNEL && channel < TIMER2_CAPTURE_FIRST_CHANNEL + TIMER2_CAPTURE_CHANNEL_COUNT);
+	ASSERT(edge == RLM3_TIMER2_CAPTURE_RISING || edge == RLM3_TIMER2_CAPTURE_FALLING || edge == RLM3_TIMER2_CAPTURE_BOTH);
+
+	size_t index = channel - TIMER2_CAPTURE_FIRST_CHANNEL;
+	ASSERT(!g_capture_active[index]);
+
+	RLM3_Capture_Init(&g_captures[index]);
+	g_captures[index].high = g_timer2_high;
+	g_capture_tasks[index] = task;
+	g_capture_active[index] = true;
+
+	// Map the channel directly to its own input with no filter and no prescaler.
+	uint32_t ccer_shift = 4 * (channel - 1);
+	CLEAR_BIT(TIM2->CCER, TIM_CCER_CC1E << ccer_shift);
+	if (channel == 2)
+		MODIFY_REG(TIM2->CCMR1, TIM_CCMR1_CC2S | TIM_CCMR1_IC2F | TIM_CCMR1_IC2PSC, TIM_CCMR1_CC2S_0);
+	else if (channel == 3)
+		MODIFY_REG(TIM2->CCMR2, TIM_CCMR2_CC3S | TIM_CCMR2_IC3F | TIM_CCMR2_IC3PSC, TIM_CCMR2_CC3S_0);
+	else
+		MODIFY_REG(TIM2->CCMR2, TIM_CCMR2_CC4S | TIM_CCMR2_IC4F | TIM_CCMR2_IC4PSC, TIM_CCMR2_CC4S_0);
+
+	uint32_t polarity = 0;
+	if (edge == RLM3_TIMER2_CAPTURE_FALLING)
+		polarity = TIM_CCER_CC1P;
+	else if (edge == RLM3_TIMER2_CAPTURE_BOTH)
+		polarity = TIM_CCER_CC1P | TIM_CCER_CC1NP;
+	MODIFY_REG(TIM2->CCER, (TIM_CCER_CC1P | TIM_CCER_CC1NP) << ccer_shift, polarity << ccer_shift);
+
+	TIM2->SR = ~((TIM_SR_CC1IF | TIM_SR_CC1OF) << (channel - 1));
+	SET_BIT(TIM2->DIER, TIM_DIER_CC1IE << (channel - 1));
+	SET_BIT(TIM2->CCER, TIM_CCER_CC1E << ccer_shift);
+}
+
+extern void RLM3_Timer2_Capture_Stop(size_t channel)
+{
+	ASSERT(RLM3_Timer2_Capture_IsActive(channel));
+
+	size_t index = channel - TIMER2_CAPTURE_FIRST_CHANNEL;
+	CLEAR_BIT(TIM2->CCER, TIM_CCER_CC1E << (4 * (channel - 1)));
+	CLEAR_BIT(TIM2->DIER, TIM_DIER_CC1IE << (channel - 1));
+	g_capture_active[index] = false;
+	g_capture_tasks[index] = NULL;
+}
+
+extern bool RLM3_Timer2_Capture_IsActive(size_t channel)
+{
+	if (channel < TIMER2_CAPTURE_FIRST_CHANNEL || channel >= TIMER2_CAPTURE_FIRST_CHANNEL + TIMER2_CAPTURE_CHANNEL_COUNT)
+		return false;
+	return g_capture_active[channel - TIMER2_CAPTURE_FIRST_CHANNEL];
+}
+
+extern void RLM3_Timer2_Capture_Flush(size_t channel)
+{
+	ASSERT(RLM3_Timer2_Capture_IsActive(channel));
+
+	RLM3_EnterCritical();
+	RLM3_Capture_Flush(&g_captures[channel - TIMER2_CAPTURE_FIRST_CHANNEL]);
+	RLM3_ExitCritical();
+}
+
+extern const RLM3_CaptureBatch* RLM3_Timer2_Capture_Acquire(size_t channel)
+{
+	ASSERT(RLM3_Timer2_Capture_IsActive(channel));
+	return RLM3_Capture_Acquire(&g_captures[channel - TIMER2_CAPTURE_FIRST_CHANNEL]);
+}
+
+extern void RLM3_Timer2_Capture_Release(size_t channel)
+{
+	ASSERT(RLM3_Timer2_Capture_IsActive(channel));
+	RLM3_Capture_Release(&g_captures[channel - TIMER2_CAPTURE_FIRST_CHANNEL]);
+}
+
+extern uint32_t RLM3_Timer2_Capture_GetDroppedCount(size_t channel)
+{
+	ASSERT(channel >= TIMER2_CAPTURE_FIRST_CHANNEL && channel < TIMER2_CAPTURE_FIRST_CHANNEL + TIMER2_CAPTURE_CHANNEL_COUNT);
+	return RLM3_Capture_GetDroppedCount(&g_captures[channel - TIMER2_CAPTURE_FIRST_CHANNEL]);
+}
+
+static void Timer2_CaptureInterrupt(uint32_t status)
+{
+	for (size_t index = 0; index < TIMER2_CAPTURE_CHANNEL_COUNT; index++)
+	{
+		size_t channel = TIMER2_CAPTURE_FIRST_CHANNEL + index;
+		uint32_t capture_flag = TIM_SR_CC1IF << (channel - 1);
+		uint32_t overcapture_flag = TIM_SR_CC1OF << (channel - 1);
+		if ((status & capture_flag) == 0 || !g_capture_active[index])
+			continue;
+
+		// Reading the capture register clears the capture flag.  The rollover flag must be read after it.
+		uint32_t captured = *GetCaptureRegister(channel);
+		bool rollover_pending = ((TIM2->SR & TIM_SR_UIF) != 0);
+		if ((status & overcapture_flag) != 0)
+		{
+			TIM2->SR = ~overcapture_flag;
+			RLM3_Capture_Drop(&g_captures[index]);
+		}
+		if (RLM3_Capture_Record(&g_captures[index], captured, rollover_pending))
+			RLM3_GiveFromISR(g_capture_tasks[index]);
+	}
+}
+
+static void Timer2_RolloverInterrupt()
+{
+	TIM2->SR = ~TIM_SR_UIF;
+	g_timer2_high++;
+	for (size_t index = 0; index < TIMER2_CAPTURE_CHANNEL_COUNT; index++)
+		if (g_capture_active[index])
+			RLM3_Capture_Rollover(&g_captures[index]);
+}
+
+static void Timer2_WheelInterrupt()
+{
+	TIM2->SR = ~TIM_SR_CC1IF;
+
+	// The callbacks run outside the critical section.  They may start or cancel entries, which enters it again.
+	uint32_t saved_level = RLM3_EnterCriticalFromISR();
+	bool has_deferred = RLM3_TimerWheel_Collect(&g_wheel, TIM2->CNT);
+	UpdateWheelCompare();
+	RLM3_ExitCriticalFromISR(saved_level);
+	while (true)
+	{
+		saved_level = RLM3_EnterCriticalFromISR();
+		RLM3_TimerWheel_Entry* entry = RLM3_TimerWheel_PopExpired(&g_wheel);
+		RLM3_ExitCriticalFromISR(saved_level);
+		if (entry == NULL)
+			break;
+		entry->callback(entry, entry->context);
+	}
+
+	if (has_deferred)
+		RLM3_GiveFromISR(g_wheel_deferred_task);
+}
+
+static void Timer2_OneShotInterrupt()
+{
+	TIM2->SR = ~TIM_SR_CC1IF;
+	CLEAR_BIT(TIM2->DIER, TIM_DIER_CC1IE);
 	RLM3_Timer2_Event_Callback();
 }
+
+extern void TIM2_IRQHandler(void)
+{
+	RLM3_ISR_Begin();
+	if (g_timer2_mode == TIMER2_MODE_PERIODIC)
+	{
+		TIM2->SR = ~TIM_IT_UPDATE;
+		RLM3_Timer2_Event_Callback();
+	}
+	else
+	{
+		uint32_t status = TIM2->SR;
+		uint32_t enabled = TIM2->DIER;
+		if ((status & TIM_SR_CC1IF) != 0 && (enabled & TIM_DIER_CC1IE) != 0)
+		{
+			if (g_timer2_mode == TIMER2_MODE_WHEEL)
+				Timer2_WheelInterrupt();
+			else
+				Timer2_OneShotInterrupt();
+		}
+		Timer2_CaptureInterrupt(status);
+		if ((status & TIM_SR_UIF) != 0)
+			Timer2_RolloverInterrupt();
+	}
+	RLM3_ISR_End();
+}
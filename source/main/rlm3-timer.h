@@ -1,17 +1,74 @@
 #pragma once
 
 #include "rlm3-base.h"
+#include "rlm3-task.h"
+#include "rlm3-timer-wheel.h"
+#include "rlm3-capture.h"
+#include "main.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
+// Compare times are told apart from passed ones by the signed difference from the counter, so a time can be at most
+// this many ticks ahead.  A time further ahead is taken as already passed and fires at once.
+#define RLM3_TIMER_COMPARE_MAX_AHEAD 0x80000000UL
+
+
+typedef enum
+{
+	RLM3_TIMER2_CAPTURE_RISING,
+	RLM3_TIMER2_CAPTURE_FALLING,
+	RLM3_TIMER2_CAPTURE_BOTH,
+} RLM3_Timer2_CaptureEdge;
+
+
 extern void RLM3_Timer2_Init(size_t frequency_hz);
 extern void RLM3_Timer2_Deinit();
 extern bool RLM3_Timer2_IsInit();
 extern void RLM3_Timer2_Event_Callback();
 
+// Changes the rate of a running periodic timer.  The new period starts at the next update event.
+extern void RLM3_Timer2_SetFrequency(size_t frequency_hz);
+extern uint32_t RLM3_Timer2_GetClockFrequency();
+
+// Runs TIM2 as a free running counter at the timer clock.  Each scheduled event calls the event callback once.  An
+// absolute time must be within RLM3_TIMER_COMPARE_MAX_AHEAD of the counter.  ScheduleAfter checks the delay.
+extern void RLM3_Timer2_InitOneShot();
+extern uint32_t RLM3_Timer2_GetCycles();
+extern void RLM3_Timer2_ScheduleAt(uint32_t cycles);
+extern void RLM3_Timer2_ScheduleAfter(uint32_t delay_cycles);
+extern void RLM3_Timer2_CancelScheduled();
+
+// Runs TIM2 as a free running 1 MHz counter that services a timer wheel instead of the periodic event callback.  The
+// delay and period are each limited to RLM3_TIMER_WHEEL_MAX_DELAY microseconds, which is inside the compare horizon.
+extern void RLM3_Timer2_Wheel_Init();
+extern void RLM3_Timer2_Wheel_Deinit();
+extern bool RLM3_Timer2_Wheel_IsInit();
+extern uint32_t RLM3_Timer2_Wheel_GetTime();
+extern void RLM3_Timer2_Wheel_Start(RLM3_TimerWheel_Entry* entry, uint32_t delay_us, uint32_t period_us);
+extern void RLM3_Timer2_Wheel_Cancel(RLM3_TimerWheel_Entry* entry);
+extern void RLM3_Timer2_Wheel_SetDeferredTask(RLM3_Task task);
+extern size_t RLM3_Timer2_Wheel_RunDeferred();
+
+// Input capture on channels 2 to 4 while TIM2 runs in one-shot or wheel mode.  Timestamps are in counter ticks
+// extended to 64 bits.  The application configures the input pins for GPIO_AF1_TIM2.  The task is notified each time
+// a batch is ready.
+extern void RLM3_Timer2_Capture_Start(size_t channel, RLM3_Timer2_CaptureEdge edge, RLM3_Task task);
+extern void RLM3_Timer2_Capture_Stop(size_t channel);
+extern bool RLM3_Timer2_Capture_IsActive(size_t channel);
+extern void RLM3_Timer2_Capture_Flush(size_t channel);
+extern const RLM3_CaptureBatch* RLM3_Timer2_Capture_Acquire(size_t channel);
+extern void RLM3_Timer2_Capture_Release(size_t channel);
+extern uint32_t RLM3_Timer2_Capture_GetDroppedCount(size_t channel);
+
+// Register level helpers shared by the timer drivers.
+extern uint32_t RLM3_Timer_ComputeClock(uint32_t pclk_hz, uint32_t apb_divider, bool timer_prescaler);
+extern uint32_t RLM3_Timer_ComputeReload(uint32_t clock_hz, uint32_t frequency_hz);
+extern void RLM3_Timer_UpdateReload(TIM_TypeDef* timer, uint32_t reload);
+extern bool RLM3_Timer_ScheduleCompare(TIM_TypeDef* timer, uint32_t time); // Returns false if the time already passed and the event was forced.
+
 
 #ifdef __cplusplus
 }
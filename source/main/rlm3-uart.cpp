@@ -0,0 +1,624 @@
+#include "rlm3-uart.hpp"
+#include "Assert.h"
+
+
+/*
+ * This UART interface was written to provide a simple interface to the UARTs used on the RLM3 PCB.  This interface
+ * makes no assumptions about how the data is used.  When it needs data, it asks the application for it.  When it
+ * receives data, it sends it to the application.  The driver itself is the template in rlm3-uart.hpp.  Each port is
+ * a row in the descriptor table below.
+ */
+
+
+typedef struct
+{
+	IRQn_Type irq;
+	bool is_apb2;
+	uint32_t clock_bit;
+	GPIO_TypeDef* tx_port;
+	uint16_t tx_pin;
+	GPIO_TypeDef* rx_port;
+	uint16_t rx_pin;
+	uint8_t alternate;
+	// NULL on the UARTs, which have no modem lines.
+	GPIO_TypeDef* cts_port;
+	uint16_t cts_pin;
+	GPIO_TypeDef* rts_port;
+	uint16_t rts_pin;
+} UartDescriptor;
+
+typedef struct
+{
+	uint32_t baud_rate;
+	RLM3_UART_FlowControl flow_control;
+	bool has_cts;
+	GPIO_TypeDef* rts_port;
+	uint16_t rts_pin;
+	size_t high_water;
+	size_t low_water;
+	bool is_paused;
+	uint32_t burst_gap_bits;
+} UartState;
+
+
+static const UartDescriptor g_uart_descriptors[RLM3_UART_COUNT] =
+{
+	{ USART1_IRQn, true,  RCC_APB2ENR_USART1EN, GPIOA, GPIO_PIN_9, GPIOA, GPIO_PIN_10, GPIO_AF7_USART1, GPIOA, GPIO_PIN_11, GPIOA, GPIO_PIN_12 },
+	{ USART2_IRQn, false, RCC_APB1ENR_USART2EN, GPS_TX_GPIO_Port, GPS_TX_Pin, GPS_RX_GPIO_Port, GPS_RX_Pin, GPIO_AF7_USART2, GPIOD, GPIO_PIN_3, GPIOD, GPIO_PIN_4 },
+	{ USART3_IRQn, false, RCC_APB1ENR_USART3EN, GPIOB, GPIO_PIN_10, GPIOB, GPIO_PIN_11, GPIO_AF7_USART3, GPIOB, GPIO_PIN_13, GPIOB, GPIO_PIN_14 },
+	{ UART4_IRQn,  false, RCC_APB1ENR_UART4EN, WIFI_TX_GPIO_Port, WIFI_TX_Pin, WIFI_RX_GPIO_Port, WIFI_RX_Pin, GPIO_AF8_UART4, NULL, 0, NULL, 0 },
+	{ UART5_IRQn,  false, RCC_APB1ENR_UART5EN, GPIOC, GPIO_PIN_12, GPIOD, GPIO_PIN_2, GPIO_AF8_UART5, NULL, 0, NULL, 0 },
+	{ USART6_IRQn, true,  RCC_APB2ENR_USART6EN, GPIOC, GPIO_PIN_6, GPIOC, GPIO_PIN_7, GPIO_AF8_USART6, GPIOG, GPIO_PIN_13, GPIOG, GPIO_PIN_8 },
+	{ UART7_IRQn,  false, RCC_APB1ENR_UART7EN, GPIOF, GPIO_PIN_7, GPIOF, GPIO_PIN_6, GPIO_AF8_UART7, NULL, 0, NULL, 0 },
+	{ UART8_IRQn,  false, RCC_APB1ENR_UART8EN, GPIOE, GPIO_PIN_1, GPIOE, GPIO_PIN_0, GPIO_AF8_UART8, NULL, 0, NULL, 0 },
+};
+
+static RLM3_UART_Config g_uart_configs[RLM3_UART_COUNT];
+static UartState g_uart_states[RLM3_UART_COUNT];
+
+RLM3_UART_Counters g_rlm3_uart_counters[RLM3_UART_COUNT];
+RLM3_UART_ReceiveTiming g_rlm3_uart_timing[RLM3_UART_COUNT];
+
+
+template <RLM3_UART_ID ID>
+struct ConfigHandler
+{
+	static void Receive(uint8_t data)
+	{
+		const RLM3_UART_Config& config = g_uart_configs[ID];
+		if (config.receive != NULL)
+			config.receive(ID, data, config.context);
+	}
+
+	static bool Transmit(uint8_t* data_to_send)
+	{
+		const RLM3_UART_Config& config = g_uart_configs[ID];
+		return config.transmit != NULL && config.transmit(ID, data_to_send, config.context);
+	}
+
+	static void Error(uint32_t status_flags)
+	{
+		const RLM3_UART_Config& config = g_uart_configs[ID];
+		if (config.error != NULL)
+			config.error(ID, status_flags, config.context);
+	}
+};
+
+
+static volatile uint32_t* GetClockRegister(const UartDescriptor* descriptor)
+{
+	return descriptor->is_apb2 ? &RCC->APB2ENR : &RCC->APB1ENR;
+}
+
+static uint32_t GetGpioClockBit(GPIO_TypeDef* port)
+{
+	if (port == GPIOA)
+		return RCC_AHB1ENR_GPIOAEN;
+	if (port == GPIOB)
+		return RCC_AHB1ENR_GPIOBEN;
+	if (port == GPIOC)
+		return RCC_AHB1ENR_GPIOCEN;
+	if (port == GPIOD)
+		return RCC_AHB1ENR_GPIODEN;
+	if (port == GPIOE)
+		return RCC_AHB1ENR_GPIOEEN;
+	if (port == GPIOF)
+		return RCC_AHB1ENR_GPIOFEN;
+	ASSERT(port == GPIOG);
+	return RCC_AHB1ENR_GPIOGEN;
+}
+
+static void EnableClock(volatile uint32_t* clock_register, uint32_t clock_bit)
+{
+	SET_BIT(*clock_register, clock_bit);
+	// Delay after an RCC peripheral clock enabling, as the HAL macros do.
+	volatile uint32_t tmpreg = READ_BIT(*clock_register, clock_bit);
+	(void)tmpreg;
+}
+
+static void InitPin(GPIO_TypeDef* port, uint16_t pin, uint8_t alternate)
+{
+	EnableClock(&RCC->AHB1ENR, GetGpioClockBit(port));
+
+	GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+	GPIO_InitStruct.Pin = pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+	GPIO_InitStruct.Alternate = alternate;
+	HAL_GPIO_Init(port, &GPIO_InitStruct);
+}
+
+static void InitOutputPin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state)
+{
+	EnableClock(&RCC->AHB1ENR, GetGpioClockBit(port));
+	HAL_GPIO_WritePin(port, pin, state);
+
+	GPIO_InitTypeDef GPIO_InitStruct = { 0 };
+	GPIO_InitStruct.Pin = pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+	HAL_GPIO_Init(port, &GPIO_InitStruct);
+}
+
+static uint32_t EnterState()
+{
+	// Flow control state is shared between the port's interrupt and the application's tasks.
+	if (RLM3_IsIRQ())
+		return RLM3_EnterCriticalFromISR();
+	RLM3_EnterCritical();
+	return 0;
+}
+
+static void LeaveState(uint32_t saved_level)
+{
+	if (RLM3_IsIRQ())
+		RLM3_ExitCriticalFromISR(saved_level);
+	else
+		RLM3_ExitCritical();
+}
+
+static uint32_t GetBusFrequency(const UartDescriptor* descriptor)
+{
+	return descriptor->is_apb2 ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+}
+
+static uint32_t GetDivisor(USART_TypeDef* uart)
+{
+	uint32_t brr = uart->BRR & (USART_BRR_DIV_Mantissa | USART_BRR_DIV_Fraction);
+	if ((uart->CR1 & USART_CR1_OVER8) == 0)
+		return brr;
+	return 8 * (brr >> USART_BRR_DIV_Mantissa_Pos) + (brr & 0x7);
+}
+
+static uint32_t UART_SelectDivisor(uint32_t pclk_frequency, uint32_t baud_rate)
+{
+	// The bit time is divisor / pclk in both oversampling modes.  BRR holds the divisor in sixteenths of a bit with
+	// OVER16 and in eighths with OVER8, so neither mode can get closer to the requested rate than the other.
+	ASSERT(baud_rate != 0);
+	uint32_t lower = pclk_frequency / baud_rate;
+	uint32_t upper = lower + 1;
+	uint64_t lower_error = (uint64_t)(pclk_frequency - lower * baud_rate) * upper;
+	uint64_t upper_error = (uint64_t)(upper * baud_rate - pclk_frequency) * lower;
+	uint32_t divisor = (lower == 0 || upper_error < lower_error) ? upper : lower;
+
+	ASSERT(divisor >= 8); // OVER8 with a mantissa of 1 is as fast as the UART goes.
+	ASSERT(divisor <= (USART_BRR_DIV_Mantissa | USART_BRR_DIV_Fraction));
+	return divisor;
+}
+
+static void UART_SetDivisor(USART_TypeDef* uart, uint32_t divisor)
+{
+	// OVER16 tolerates more clock error and noise, so OVER8 is only for rates it cannot reach.
+	bool is_oversample_8 = (divisor < 16);
+	uint32_t brr = divisor;
+	if (is_oversample_8)
+		brr = ((divisor / 8) << USART_BRR_DIV_Mantissa_Pos) | (divisor % 8);
+
+	SET_REGISTER_FLAGS(uart->CR1,
+			FLAG(USART_CR1_OVER8, is_oversample_8)); // Oversample 8 or 16
+	uint32_t reg = uart->BRR;
+	MODIFY_REG(reg, USART_BRR_DIV_Mantissa | USART_BRR_DIV_Fraction, brr); // Set baud rate
+	uart->BRR = reg;
+}
+
+static void UART_SetTiming(RLM3_UART_ID id, uint32_t divisor)
+{
+	// A bit lasts divisor cycles of the bus clock.  The timestamps count the core clock.
+	RLM3_UART_ReceiveTiming* timing = &g_rlm3_uart_timing[id];
+	uint64_t bit_scaled = (uint64_t)divisor * HAL_RCC_GetHCLKFreq();
+	uint32_t pclk_frequency = GetBusFrequency(&g_uart_descriptors[id]);
+	uint32_t gap_bits = g_uart_states[id].burst_gap_bits;
+	timing->frame_cycles = (uint32_t)(bit_scaled * 10 / pclk_frequency);
+	timing->gap_cycles = (uint32_t)(bit_scaled * ((gap_bits != 0) ? gap_bits : 20) / pclk_frequency);
+}
+
+static void UART_Configure(USART_TypeDef* uart, uint32_t divisor, bool is_rts_enabled, bool is_cts_enabled)
+{
+	SET_REGISTER_FLAGS(uart->CR1,
+			FLAG(USART_CR1_UE, 0)); // Disable UART
+	SET_REGISTER_FLAGS(uart->CR2,
+			FLAG(USART_CR2_STOP,  0), // 1 Stop Bit
+			FLAG(USART_CR2_LINEN, 0),  // Disable LIN mode
+			FLAG(USART_CR2_CLKEN, 0)); // Disable flow control clock
+	SET_REGISTER_FLAGS(uart->CR1,
+			FLAG(USART_CR1_M,     0),  // 8 Data Bits
+			FLAG(USART_CR1_PCE,   0),  // Parity control disabled
+			FLAG(USART_CR1_TE,    0),  // Disable Transmit
+			FLAG(USART_CR1_RE,    0)); // Disable Receive
+	SET_REGISTER_FLAGS(uart->CR3,
+			FLAG(USART_CR3_RTSE,  is_rts_enabled), // RTS Flow Control
+			FLAG(USART_CR3_CTSE,  is_cts_enabled), // CTS Flow Control
+			FLAG(USART_CR3_SCEN,  0),  // Disable smartcard mode
+			FLAG(USART_CR3_HDSEL, 0),  // Disable half duplex mode
+			FLAG(USART_CR3_IREN,  0)); // Disable IrDA mode
+
+	UART_SetDivisor(uart, divisor);
+
+	SET_REGISTER_FLAGS(uart->CR1,
+			FLAG(USART_CR1_UE,     1),  // Enable UART
+			FLAG(USART_CR1_TE,     1),  // Enable Transmit
+			FLAG(USART_CR1_RE,     1),  // Enable Receive
+			FLAG(USART_CR1_TXEIE,  1),  // Enable TXE (Transmit data register empty) interrupt
+			FLAG(USART_CR1_RXNEIE, 1)); // Enable RXNE (Read register not empty) interrupt
+	SET_REGISTER_FLAGS(uart->CR3,
+			FLAG(USART_CR3_EIE, 1)); // Enable ERR (Error) interrupt
+}
+
+extern void RLM3_UART_Start(RLM3_UART_ID id, const RLM3_UART_Config* config)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	ASSERT(config != NULL);
+	const UartDescriptor* descriptor = &g_uart_descriptors[id];
+	uint32_t divisor = UART_SelectDivisor(GetBusFrequency(descriptor), config->baud_rate);
+
+	UartState* state = &g_uart_states[id];
+	*state = UartState();
+	g_rlm3_uart_counters[id] = RLM3_UART_Counters();
+	g_rlm3_uart_timing[id] = RLM3_UART_ReceiveTiming();
+	state->baud_rate = config->baud_rate;
+	state->burst_gap_bits = config->burst_gap_bits;
+	UART_SetTiming(id, divisor);
+	state->flow_control = config->flow_control;
+	state->has_cts = (config->flow_control != RLM3_UART_FLOW_NONE && descriptor->cts_port != NULL);
+	if (config->flow_control == RLM3_UART_FLOW_HARDWARE)
+	{
+		ASSERT(descriptor->rts_port != NULL);
+		state->rts_port = descriptor->rts_port;
+		state->rts_pin = descriptor->rts_pin;
+	}
+	else if (config->flow_control == RLM3_UART_FLOW_SOFTWARE)
+	{
+		ASSERT(config->high_water > config->low_water);
+		state->rts_port = (config->rts_port != NULL) ? config->rts_port : descriptor->rts_port;
+		state->rts_pin = (config->rts_port != NULL) ? config->rts_pin : descriptor->rts_pin;
+		ASSERT(state->rts_port != NULL);
+		state->high_water = config->high_water;
+		state->low_water = config->low_water;
+	}
+
+	EnableClock(GetClockRegister(descriptor), descriptor->clock_bit);
+	InitPin(descriptor->tx_port, descriptor->tx_pin, descriptor->alternate);
+	InitPin(descriptor->rx_port, descriptor->rx_pin, descriptor->alternate);
+	if (state->has_cts)
+		InitPin(descriptor->cts_port, descriptor->cts_pin, descriptor->alternate);
+	if (state->flow_control == RLM3_UART_FLOW_HARDWARE)
+		InitPin(state->rts_port, state->rts_pin, descriptor->alternate);
+	if (state->flow_control == RLM3_UART_FLOW_SOFTWARE)
+		InitOutputPin(state->rts_port, state->rts_pin, GPIO_PIN_RESET); // RTS is active low.
+
+	HAL_NVIC_SetPriority(descriptor->irq, 5, 0);
+	HAL_NVIC_EnableIRQ(descriptor->irq);
+
+	UART_Configure(RLM3_UART_GetRegisters(id), divisor, state->flow_control == RLM3_UART_FLOW_HARDWARE, state->has_cts);
+}
+
+extern void RLM3_UART_Stop(RLM3_UART_ID id)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	const UartDescriptor* descriptor = &g_uart_descriptors[id];
+	UartState* state = &g_uart_states[id];
+
+	SET_REGISTER_FLAGS(RLM3_UART_GetRegisters(id)->CR1,
+			FLAG(USART_CR1_UE, 0)); // Disable UART
+
+	CLEAR_BIT(*GetClockRegister(descriptor), descriptor->clock_bit);
+
+	HAL_GPIO_DeInit(descriptor->tx_port, descriptor->tx_pin);
+	HAL_GPIO_DeInit(descriptor->rx_port, descriptor->rx_pin);
+	if (state->has_cts)
+		HAL_GPIO_DeInit(descriptor->cts_port, descriptor->cts_pin);
+	if (state->rts_port != NULL)
+		HAL_GPIO_DeInit(state->rts_port, state->rts_pin);
+	state->flow_control = RLM3_UART_FLOW_NONE;
+	state->has_cts = false;
+	state->rts_port = NULL;
+
+	HAL_NVIC_DisableIRQ(descriptor->irq);
+}
+
+extern void RLM3_UART_Init(RLM3_UART_ID id, const RLM3_UART_Config* config)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	ASSERT(config != NULL);
+	ASSERT(!RLM3_UART_IsInit(id));
+
+	g_uart_configs[id] = *config;
+	RLM3_UART_Start(id, config);
+}
+
+extern void RLM3_UART_Deinit(RLM3_UART_ID id)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+
+	RLM3_UART_Stop(id);
+	g_uart_configs[id] = RLM3_UART_Config();
+}
+
+extern bool RLM3_UART_IsInit(RLM3_UART_ID id)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	const UartDescriptor* descriptor = &g_uart_descriptors[id];
+	return (*GetClockRegister(descriptor) & descriptor->clock_bit) != 0;
+}
+
+extern void RLM3_UART_EnsureTransmit(RLM3_UART_ID id)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	SET_REGISTER_FLAGS(RLM3_UART_GetRegisters(id)->CR1,
+			FLAG(USART_CR1_TXEIE,  1)); // Enable TXE (Transmit data register empty) interrupt
+}
+
+extern void RLM3_UART_SetBaudRate(RLM3_UART_ID id, uint32_t baud_rate)
+{
+	ASSERT(RLM3_UART_IsInit(id));
+	ASSERT(!RLM3_IsIRQ());
+	USART_TypeDef* uart = RLM3_UART_GetRegisters(id);
+	uint32_t divisor = UART_SelectDivisor(GetBusFrequency(&g_uart_descriptors[id]), baud_rate);
+
+	// The baud counters reload as soon as BRR is written, so wait until the application has nothing more to send and the
+	// last byte has shifted out.  The critical section keeps the interrupt from starting another byte meanwhile.
+	RLM3_EnterCritical();
+	while ((uart->CR1 & USART_CR1_TXEIE) != 0 || (uart->SR & USART_SR_TC) == 0)
+	{
+		RLM3_ExitCritical();
+		RLM3_Yield();
+		RLM3_EnterCritical();
+	}
+	SET_REGISTER_FLAGS(uart->CR1,
+			FLAG(USART_CR1_UE, 0)); // Disable UART
+	UART_SetDivisor(uart, divisor);
+	SET_REGISTER_FLAGS(uart->CR1,
+			FLAG(USART_CR1_UE, 1)); // Enable UART
+	g_uart_states[id].baud_rate = baud_rate;
+	UART_SetTiming(id, divisor);
+	RLM3_ExitCritical();
+}
+
+extern void RLM3_UART_GetBaudInfo(RLM3_UART_ID id, RLM3_UART_BaudInfo* info)
+{
+	ASSERT(RLM3_UART_IsInit(id));
+	ASSERT(info != NULL);
+	USART_TypeDef* uart = RLM3_UART_GetRegisters(id);
+	uint32_t pclk_frequency = GetBusFrequency(&g_uart_descriptors[id]);
+	uint32_t divisor = GetDivisor(uart);
+	uint32_t requested = g_uart_states[id].baud_rate;
+
+	info->requested_baud_rate = requested;
+	info->actual_baud_rate = (pclk_frequency + divisor / 2) / divisor;
+	int64_t ideal_clocks = (int64_t)requested * divisor;
+	info->error_ppm = (int32_t)(((int64_t)pclk_frequency - ideal_clocks) * 1000000 / ideal_clocks);
+	info->is_oversample_8 = (uart->CR1 & USART_CR1_OVER8) != 0;
+}
+
+extern void RLM3_UART_SetReceiveLevel(RLM3_UART_ID id, size_t level)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	UartState* state = &g_uart_states[id];
+	RLM3_UART_Counters* counters = &g_rlm3_uart_counters[id];
+
+	uint32_t saved_level = EnterState();
+	counters->receive_level = level;
+	if (level > counters->peak_receive_level)
+		counters->peak_receive_level = level;
+	bool is_software = (state->flow_control == RLM3_UART_FLOW_SOFTWARE);
+	if (is_software && !state->is_paused && level >= state->high_water)
+	{
+		HAL_GPIO_WritePin(state->rts_port, state->rts_pin, GPIO_PIN_SET); // Deassert RTS
+		state->is_paused = true;
+		counters->pause_count++;
+	}
+	else if (is_software && state->is_paused && level <= state->low_water)
+	{
+		HAL_GPIO_WritePin(state->rts_port, state->rts_pin, GPIO_PIN_RESET); // Assert RTS
+		state->is_paused = false;
+	}
+	LeaveState(saved_level);
+}
+
+extern bool RLM3_UART_IsReceivePaused(RLM3_UART_ID id)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	return g_uart_states[id].is_paused;
+}
+
+extern void RLM3_UART_CountErrors(RLM3_UART_ID id, uint32_t status_flags)
+{
+	RLM3_UART_Counters* counters = &g_rlm3_uart_counters[id];
+	if ((status_flags & USART_SR_ORE) != 0)
+		counters->overrun_count++;
+	if ((status_flags & USART_SR_NE) != 0)
+		counters->noise_count++;
+	if ((status_flags & USART_SR_FE) != 0)
+		counters->framing_count++;
+	if ((status_flags & USART_SR_PE) != 0)
+		counters->parity_count++;
+}
+
+extern void RLM3_UART_GetReceiveTimestamp(RLM3_UART_ID id, RLM3_UART_Timestamp* timestamp)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	ASSERT(timestamp != NULL);
+	uint32_t saved_level = EnterState();
+	*timestamp = g_rlm3_uart_timing[id].timestamp;
+	LeaveState(saved_level);
+}
+
+extern void RLM3_UART_GetCounters(RLM3_UART_ID id, RLM3_UART_Counters* counters)
+{
+	ASSERT(id < RLM3_UART_COUNT);
+	ASSERT(counters != NULL);
+	uint32_t saved_level = EnterState();
+	*counters = g_rlm3_uart_counters[id];
+	counters->baud_rate = g_uart_states[id].baud_rate;
+	LeaveState(saved_level);
+	counters->time_ms = RLM3_IsIRQ() ? RLM3_GetCurrentTimeFromISR() : RLM3_GetCurrentTime();
+}
+
+static uint32_t PerSecond(uint32_t count, uint32_t elapsed_ms)
+{
+	return (uint32_t)((uint64_t)count * 1000 / elapsed_ms);
+}
+
+static uint32_t Utilization(uint32_t bytes_per_second, uint32_t baud_rate)
+{
+	if (baud_rate == 0)
+		return 0;
+	return (uint32_t)((uint64_t)bytes_per_second * 10 * 1000 / baud_rate);
+}
+
+extern void RLM3_UART_GetRates(const RLM3_UART_Counters* before, const RLM3_UART_Counters* after, RLM3_UART_Rates* rates)
+{
+	ASSERT(before != NULL && after != NULL && rates != NULL);
+	*rates = RLM3_UART_Rates();
+	// Unsigned differences stay right across a wrap of the counters or the tick.
+	rates->error_count = (after->overrun_count - before->overrun_count) + (after->noise_count - before->noise_count) +
+			(after->framing_count - before->framing_count) + (after->parity_count - before->parity_count);
+	uint32_t elapsed_ms = after->time_ms - before->time_ms;
+	if (elapsed_ms == 0)
+		return;
+	rates->rx_bytes_per_second = PerSecond(after->rx_byte_count - before->rx_byte_count, elapsed_ms);
+	rates->tx_bytes_per_second = PerSecond(after->tx_byte_count - before->tx_byte_count, elapsed_ms);
+	rates->isr_per_second = PerSecond(after->isr_count - before->isr_count, elapsed_ms);
+	rates->rx_utilization_permille = Utilization(rates->rx_bytes_per_second, after->baud_rate);
+	rates->tx_utilization_permille = Utilization(rates->tx_bytes_per_second, after->baud_rate);
+}
+
+static void UART2_Receive(RLM3_UART_ID id, uint8_t data, void* context)
+{
+	RLM3_UART2_ReceiveCallback(data);
+}
+
+static bool UART2_Transmit(RLM3_UART_ID id, uint8_t* data_to_send, void* context)
+{
+	return RLM3_UART2_TransmitCallback(data_to_send);
+}
+
+static void UART2_Error(RLM3_UART_ID id, uint32_t status_flags, void* context)
+{
+	RLM3_UART2_ErrorCallback(status_flags);
+}
+
+extern void RLM3_UART2_Init(uint32_t baud_rate)
+{
+	RLM3_UART_Config config = { baud_rate, UART2_Receive, UART2_Transmit, UART2_Error, NULL };
+	RLM3_UART_Init(RLM3_UART_2, &config);
+}
+
+extern void RLM3_UART2_Deinit()
+{
+	RLM3_UART_Deinit(RLM3_UART_2);
+}
+
+extern bool RLM3_UART2_IsInit()
+{
+	return RLM3_UART_IsInit(RLM3_UART_2);
+}
+
+extern void RLM3_UART2_EnsureTransmit()
+{
+	RLM3_UART_EnsureTransmit(RLM3_UART_2);
+}
+
+
+static void UART4_Receive(RLM3_UART_ID id, uint8_t data, void* context)
+{
+	RLM3_UART4_ReceiveCallback(data);
+}
+
+static bool UART4_Transmit(RLM3_UART_ID id, uint8_t* data_to_send, void* context)
+{
+	return RLM3_UART4_TransmitCallback(data_to_send);
+}
+
+static void UART4_Error(RLM3_UART_ID id, uint32_t status_flags, void* context)
+{
+	RLM3_UART4_ErrorCallback(status_flags);
+}
+
+extern void RLM3_UART4_Init(uint32_t baud_rate)
+{
+	RLM3_UART_Config config = { baud_rate, UART4_Receive, UART4_Transmit, UART4_Error, NULL };
+	RLM3_UART_Init(RLM3_UART_4, &config);
+}
+
+extern void RLM3_UART4_Deinit()
+{
+	RLM3_UART_Deinit(RLM3_UART_4);
+}
+
+extern bool RLM3_UART4_IsInit()
+{
+	return RLM3_UART_IsInit(RLM3_UART_4);
+}
+
+extern void RLM3_UART4_EnsureTransmit()
+{
+	RLM3_UART_EnsureTransmit(RLM3_UART_4);
+}
+
+#ifndef RLM3_UART1_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(USART1_IRQHandler, RLM3_UART_1, ConfigHandler<RLM3_UART_1>)
+#endif
+
+#ifndef RLM3_UART2_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(USART2_IRQHandler, RLM3_UART_2, ConfigHandler<RLM3_UART_2>)
+#endif
+
+#ifndef RLM3_UART3_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(USART3_IRQHandler, RLM3_UART_3, ConfigHandler<RLM3_UART_3>)
+#endif
+
+#ifndef RLM3_UART4_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(UART4_IRQHandler, RLM3_UART_4, ConfigHandler<RLM3_UART_4>)
+#endif
+
+#ifndef RLM3_UART5_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(UART5_IRQHandler, RLM3_UART_5, ConfigHandler<RLM3_UART_5>)
+#endif
+
+#ifndef RLM3_UART6_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(USART6_IRQHandler, RLM3_UART_6, ConfigHandler<RLM3_UART_6>)
+#endif
+
+#ifndef RLM3_UART7_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(UART7_IRQHandler, RLM3_UART_7, ConfigHandler<RLM3_UART_7>)
+#endif
+
+#ifndef RLM3_UART8_CUSTOM_IRQ_HANDLER
+RLM3_UART_IRQ_HANDLER(UART8_IRQHandler, RLM3_UART_8, ConfigHandler<RLM3_UART_8>)
+#endif
+
+
+extern __weak void RLM3_UART2_ReceiveCallback(uint8_t data)
+{
+	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
+}
+
+extern __weak bool RLM3_UART2_TransmitCallback(uint8_t* data_to_send)
+{
+	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
+	return false;
+}
+
+extern __weak void RLM3_UART2_ErrorCallback(uint32_t status_flags)
+{
+	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
+}
+
+extern __weak void RLM3_UART4_ReceiveCallback(uint8_t data)
+{
+	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
+}
+
+extern __weak bool RLM3_UART4_TransmitCallback(uint8_t* data_to_send)
+{
+	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
+	return false;
+}
+
+extern __weak void RLM3_UART4_ErrorCallback(uint32_t status_flags)
+{
+	// DO NOT MODIFIY THIS FUNCTION.  Override it by declaring a non-weak version in your project files.
+}
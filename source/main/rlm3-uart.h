@@ -1,12 +1,135 @@
 #pragma once
 
 #include "rlm3-base.h"
+#include "main.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
+typedef enum
+{
+	RLM3_UART_1,
+	RLM3_UART_2,
+	RLM3_UART_3,
+	RLM3_UART_4,
+	RLM3_UART_5,
+	RLM3_UART_6,
+	RLM3_UART_7,
+	RLM3_UART_8,
+	RLM3_UART_COUNT
+} RLM3_UART_ID;
+
+typedef void (*RLM3_UART_ReceiveFn)(RLM3_UART_ID id, uint8_t data, void* context);
+typedef bool (*RLM3_UART_TransmitFn)(RLM3_UART_ID id, uint8_t* data_to_send, void* context);
+typedef void (*RLM3_UART_ErrorFn)(RLM3_UART_ID id, uint32_t status_flags, void* context);
+
+typedef enum
+{
+	RLM3_UART_FLOW_NONE,
+	RLM3_UART_FLOW_HARDWARE, // The UART holds RTS while its data register is full and waits for CTS.  USART1, 2, 3 and 6.
+	RLM3_UART_FLOW_SOFTWARE, // RTS follows the receive level the application reports.  CTS as above where the port has it.
+} RLM3_UART_FlowControl;
+
+// The callbacks run from the port's interrupt.  Any of them may be NULL.
+typedef struct
+{
+	uint32_t baud_rate;
+	RLM3_UART_ReceiveFn receive;
+	RLM3_UART_TransmitFn transmit;
+	RLM3_UART_ErrorFn error;
+	void* context;
+
+	RLM3_UART_FlowControl flow_control;
+	// SOFTWARE flow control deasserts RTS when the reported level reaches the high water mark and asserts it again once
+	// the level is back down to the low water mark.  Leave room above the high water mark for the byte the sender
+	// already has in flight.  RTS can be any free pin, or NULL for the port's own RTS pin.
+	size_t high_water;
+	size_t low_water;
+	GPIO_TypeDef* rts_port;
+	uint16_t rts_pin;
+
+	// Idle bit times between bytes that start a new receive burst.  0 for two characters.
+	uint32_t burst_gap_bits;
+} RLM3_UART_Config;
+
+typedef struct
+{
+	uint32_t requested_baud_rate;
+	uint32_t actual_baud_rate;
+	int32_t error_ppm; // Actual rate against the requested rate, in parts per million.
+	bool is_oversample_8;
+} RLM3_UART_BaudInfo;
+
+// Receive times from the cycle counter.  A byte's time is the start of its start bit, worked back from the receive
+// interrupt by one character time, so interrupt latency is all that adds to it.  A burst starts with the first byte after
+// the line was idle for the burst gap.
+typedef struct
+{
+	uint32_t burst_cycles;
+	uint32_t byte_cycles;
+	uint32_t burst_count; // Since the port was started.
+	uint32_t byte_index;  // Of the latest byte within its burst.
+} RLM3_UART_Timestamp;
+
+// Counted since the port was last started.  The interrupt keeps them with single increments, so they are always on.
+typedef struct
+{
+	uint32_t time_ms; // RLM3_GetCurrentTime when the snapshot was taken.
+	uint32_t baud_rate;
+	uint32_t rx_byte_count;
+	uint32_t tx_byte_count;
+	uint32_t isr_count;
+	uint32_t max_isr_cycles;
+	uint32_t overrun_count;
+	uint32_t noise_count;
+	uint32_t framing_count;
+	uint32_t parity_count;
+	uint32_t pause_count; // Times SOFTWARE flow control deasserted RTS.
+	size_t receive_level; // The last level reported to RLM3_UART_SetReceiveLevel.
+	size_t peak_receive_level;
+} RLM3_UART_Counters;
+
+// Between two snapshots of the same port.  Utilization is against the line's capacity at the later baud rate, with
+// ten bits a byte.
+typedef struct
+{
+	uint32_t rx_bytes_per_second;
+	uint32_t tx_bytes_per_second;
+	uint32_t isr_per_second;
+	uint32_t error_count;
+	uint32_t rx_utilization_permille;
+	uint32_t tx_utilization_permille;
+} RLM3_UART_Rates;
+
+
+// Any of the STM32F427's eight U(S)ARTs on the pins listed in rlm3-uart.cpp.  UART2 (GPS) and UART4 (WiFi) use the
+// board's pins.  The others use the part's default pins, so check the board before starting one.
+extern void RLM3_UART_Init(RLM3_UART_ID id, const RLM3_UART_Config* config);
+extern void RLM3_UART_Deinit(RLM3_UART_ID id);
+extern bool RLM3_UART_IsInit(RLM3_UART_ID id);
+
+extern void RLM3_UART_EnsureTransmit(RLM3_UART_ID id);
+
+// The divisor closest to the rate at the port's bus clock.  Rates above PCLK / 16 switch the port to 8x oversampling,
+// up to PCLK / 8.  Changing the rate waits for transmission to finish.  A byte arriving during the change is lost.
+extern void RLM3_UART_SetBaudRate(RLM3_UART_ID id, uint32_t baud_rate);
+extern void RLM3_UART_GetBaudInfo(RLM3_UART_ID id, RLM3_UART_BaudInfo* info);
+
+// The application reports how many received bytes it is holding, from the receive callback as it stores them and from
+// its own task as it consumes them.  SOFTWARE flow control drives RTS from it.  Other ports only record it.
+extern void RLM3_UART_SetReceiveLevel(RLM3_UART_ID id, size_t level);
+extern bool RLM3_UART_IsReceivePaused(RLM3_UART_ID id);
+
+// For the latest received byte.  From the receive callback that is the byte it was given.
+extern void RLM3_UART_GetReceiveTimestamp(RLM3_UART_ID id, RLM3_UART_Timestamp* timestamp);
+
+// A consistent snapshot.  Safe from any context.
+extern void RLM3_UART_GetCounters(RLM3_UART_ID id, RLM3_UART_Counters* counters);
+extern void RLM3_UART_GetRates(const RLM3_UART_Counters* before, const RLM3_UART_Counters* after, RLM3_UART_Rates* rates);
+
+
 extern void RLM3_UART2_Init(uint32_t baud_rate);
 extern void RLM3_UART2_Deinit();
 extern bool RLM3_UART2_IsInit();
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "rlm3-uart.h"
+#include "stm32f427xx.h"
+#include "main.h"
+#include "rlm3-helper.h"
+#include "rlm3-task.h"
+
+
+/*
+ * Compile-time UART driver.  The port ID and a handler policy type are template parameters.  The policy takes the
+ * received bytes and supplies the bytes to send.  Both are known at compile time, so the interrupt handler generated
+ * for a port calls the policy directly and the compiler can inline the application's code into the interrupt.  The
+ * library's own handlers are this template with a policy that calls the callbacks in the port's RLM3_UART_Config.
+ *
+ * A handler policy provides:
+ *   static void Receive(uint8_t data);
+ *   static bool Transmit(uint8_t* data_to_send);  // Returns false when there is nothing more to send.
+ *   static void Error(uint32_t status_flags);
+ *
+ * To give a port its own handler, build with RLM3_UARTn_CUSTOM_IRQ_HANDLER defined for that port and add the handler
+ * to one C++ file in the project:
+ *   RLM3_UART_IRQ_HANDLER(USART2_IRQHandler, RLM3_UART_2, MyHandler)
+ */
+
+
+// Clocks, pins, interrupt and registers of a port from the descriptor table.  Start takes the line settings from the
+// config and ignores its callbacks.
+extern void RLM3_UART_Start(RLM3_UART_ID id, const RLM3_UART_Config* config);
+extern void RLM3_UART_Stop(RLM3_UART_ID id);
+// Adds the receive errors in the status flags to the port's counters.
+extern void RLM3_UART_CountErrors(RLM3_UART_ID id, uint32_t status_flags);
+// Written only by the port's interrupt, apart from the flow control fields.  Read them with RLM3_UART_GetCounters.
+extern RLM3_UART_Counters g_rlm3_uart_counters[RLM3_UART_COUNT];
+
+// Written only by the port's interrupt, apart from the character and gap times the port sets when its rate changes.
+typedef struct
+{
+	uint32_t frame_cycles;
+	uint32_t gap_cycles;
+	uint32_t last_cycles;
+	RLM3_UART_Timestamp timestamp;
+} RLM3_UART_ReceiveTiming;
+
+extern RLM3_UART_ReceiveTiming g_rlm3_uart_timing[RLM3_UART_COUNT];
+
+
+static inline USART_TypeDef* RLM3_UART_GetRegisters(RLM3_UART_ID id)
+{
+	switch (id)
+	{
+	case RLM3_UART_1: return USART1;
+	case RLM3_UART_2: return USART2;
+	case RLM3_UART_3: return USART3;
+	case RLM3_UART_4: return UART4;
+	case RLM3_UART_5: return UART5;
+	case RLM3_UART_6: return USART6;
+	case RLM3_UART_7: return UART7;
+	case RLM3_UART_8: return UART8;
+	case RLM3_UART_COUNT: break;
+	}
+	return NULL;
+}
+
+
+template <RLM3_UART_ID ID, typename Handler>
+class RLM3_UART
+{
+public:
+	static void Init(uint32_t baud_rate)
+	{
+		RLM3_UART_Config config = { baud_rate };
+		RLM3_UART_Start(ID, &config);
+	}
+
+	static void Init(const RLM3_UART_Config* config)
+	{
+		RLM3_UART_Start(ID, config);
+	}
+
+	static void Deinit()
+	{
+		RLM3_UART_Stop(ID);
+	}
+
+	static bool IsInit()
+	{
+		return RLM3_UART_IsInit(ID);
+	}
+
+	static void SetBaudRate(uint32_t baud_rate)
+	{
+		RLM3_UART_SetBaudRate(ID, baud_rate);
+	}
+
+	static void GetBaudInfo(RLM3_UART_BaudInfo* info)
+	{
+		RLM3_UART_GetBaudInfo(ID, info);
+	}
+
+	static void EnsureTransmit()
+	{
+		SET_REGISTER_FLAGS(RLM3_UART_GetRegisters(ID)->CR1,
+				FLAG(USART_CR1_TXEIE,  1)); // Enable TXE (Transmit data register empty) interrupt
+	}
+
+	static inline __attribute__((always_inline)) void StampReceive(uint32_t cycles)
+	{
+		// RXNE rises at the stop bit, one character after the start bit.  Signed, so latency on the previous byte
+		// cannot make a gap look huge.
+		RLM3_UART_ReceiveTiming& timing = g_rlm3_uart_timing[ID];
+		uint32_t start = cycles - timing.frame_cycles;
+		if (timing.timestamp.burst_count == 0 || (int32_t)(start - timing.last_cycles) > (int32_t)timing.gap_cycles)
+		{
+			timing.timestamp.burst_cycles = start;
+			timing.timestamp.burst_count++;
+			timing.timestamp.byte_index = 0;
+		}
+		else
+			timing.timestamp.byte_index++;
+		timing.timestamp.byte_cycles = start;
+		timing.last_cycles = cycles;
+	}
+
+	static void HandleInterrupt()
+	{
+		RLM3_ISR_Begin();
+		uint32_t start = RLM3_GetCycleCount();
+		Dispatch(RLM3_UART_GetRegisters(ID), start);
+		uint32_t cycles = RLM3_GetCycleCount() - start;
+		RLM3_UART_Counters& counters = g_rlm3_uart_counters[ID];
+		counters.isr_count++;
+		if (cycles > counters.max_isr_cycles)
+			counters.max_isr_cycles = cycles;
+		RLM3_ISR_End();
+	}
+
+	// The body of the interrupt handler.  It takes the registers as an argument so it can be benchmarked against a copy
+	// of them in memory.  The cycle count is from the start of the interrupt.
+	static inline __attribute__((always_inline)) void Dispatch(USART_TypeDef* uart, uint32_t cycles)
+	{
+		uint32_t CR1 = uart->CR1;
+		uint32_t SR = uart->SR;
+
+		if ((SR & USART_SR_RXNE) != 0 && (CR1 & USART_CR1_RXNEIE) != 0)
+		{
+			StampReceive(cycles);
+			Handler::Receive(uart->DR & 0xFF);
+			g_rlm3_uart_counters[ID].rx_byte_count++;
+		}
+		if ((SR & USART_SR_TXE) != 0 && (CR1 & USART_CR1_TXEIE) != 0)
+		{
+			uint8_t data = 0;
+			if (Handler::Transmit(&data))
+			{
+				uart->DR = data;
+				g_rlm3_uart_counters[ID].tx_byte_count++;
+			}
+			else
+			{
+				SET_REGISTER_FLAGS(uart->CR1,
+						FLAG(USART_CR1_TXEIE,  0)); // Disable TXE (Transmit data register empty) interrupt
+			}
+		}
+		if ((SR & (USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE)) != 0)
+		{
+			RLM3_UART_CountErrors(ID, SR);
+			Handler::Error(SR);
+		}
+	}
+};
+
+#define RLM3_UART_IRQ_HANDLER(irq_handler, id, handler) \
+	extern "C" void irq_handler() { RLM3_UART<id, handler>::HandleInterrupt(); }
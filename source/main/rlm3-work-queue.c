@@ -0,0 +1,138 @@
+#include "rlm3-work-queue.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "Assert.h"
+
+
+extern void RLM3_WorkQueue_Init(RLM3_WorkQueue* queue)
+{
+	ASSERT(queue != NULL);
+
+	queue->head = NULL;
+	queue->task = NULL;
+	queue->stopper = NULL;
+	queue->is_running = false;
+	queue->posted_count = 0;
+	queue->coalesced_count = 0;
+}
+
+extern void RLM3_WorkItem_Init(RLM3_WorkItem* item, RLM3_WorkItem_Callback callback, void* context)
+{
+	ASSERT(item != NULL);
+	ASSERT(callback != NULL);
+
+	item->next = NULL;
+	item->callback = callback;
+	item->context = context;
+	item->is_pending = 0;
+}
+
+extern bool RLM3_WorkItem_IsPending(const RLM3_WorkItem* item)
+{
+	return (__atomic_load_n(&item->is_pending, __ATOMIC_ACQUIRE) != 0);
+}
+
+extern bool RLM3_WorkQueue_Post(RLM3_WorkQueue* queue, RLM3_WorkItem* item)
+{
+	// Only the caller that marks the item pending may link it.
+	uint32_t expected = 0;
+	if (!__atomic_compare_exchange_n(&item->is_pending, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+	{
+		__atomic_fetch_add(&queue->coalesced_count, 1, __ATOMIC_RELAXED);
+		return false;
+	}
+
+	// Items are pushed onto a stack.  The worker takes the whole stack at once and reverses it.
+	RLM3_WorkItem* head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+	do
+	{
+		item->next = head;
+	} while (!__atomic_compare_exchange_n(&queue->head, &head, item, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+	__atomic_fetch_add(&queue->posted_count, 1, __ATOMIC_RELAXED);
+
+	// Before Start there is no worker to wake.  It runs the items when it starts.
+	RLM3_Task task = queue->task;
+	if (head == NULL && task != NULL)
+	{
+		if (RLM3_IsIRQ())
+			RLM3_GiveFromISR(task);
+		else
+			RLM3_Give(task);
+	}
+	return true;
+}
+
+extern size_t RLM3_WorkQueue_RunPending(RLM3_WorkQueue* queue)
+{
+	ASSERT(queue != NULL);
+
+	RLM3_WorkItem* stack = __atomic_exchange_n(&queue->head, NULL, __ATOMIC_ACQUIRE);
+	RLM3_WorkItem* list = NULL;
+	while (stack != NULL)
+	{
+		RLM3_WorkItem* next = stack->next;
+		stack->next = list;
+		list = stack;
+		stack = next;
+	}
+
+	size_t count = 0;
+	while (list != NULL)
+	{
+		// The item may be posted again as soon as it is no longer pending, so the link is read first.
+		RLM3_WorkItem* item = list;
+		list = item->next;
+		__atomic_store_n(&item->is_pending, 0, __ATOMIC_RELEASE);
+		item->callback(item, item->context);
+		count++;
+	}
+	return count;
+}
+
+static void WorkerTask(void* param)
+{
+	// The handle is set here as well as in Start so posts made before xTaskCreate returns are not missed.
+	RLM3_WorkQueue* queue = (RLM3_WorkQueue*)param;
+	queue->task = RLM3_GetCurrentTask();
+	while (queue->is_running)
+	{
+		RLM3_WorkQueue_RunPending(queue);
+		RLM3_Take();
+	}
+
+	RLM3_Task stopper = queue->stopper;
+	queue->task = NULL;
+	RLM3_Give(stopper);
+	vTaskDelete(NULL);
+}
+
+extern void RLM3_WorkQueue_Start(RLM3_WorkQueue* queue, const char* name, uint32_t priority, size_t stack_size)
+{
+	ASSERT(queue != NULL);
+	ASSERT(queue->task == NULL);
+	ASSERT(priority < configMAX_PRIORITIES);
+
+	// Items posted before the worker existed are picked up when it first runs.
+	queue->is_running = true;
+	TaskHandle_t task = NULL;
+	BaseType_t status = xTaskCreate(WorkerTask, name, stack_size, queue, priority, &task);
+	ASSERT(status == pdPASS);
+	queue->task = task;
+}
+
+extern void RLM3_WorkQueue_Stop(RLM3_WorkQueue* queue)
+{
+	ASSERT(RLM3_WorkQueue_IsRunning(queue));
+
+	queue->stopper = RLM3_GetCurrentTask();
+	queue->is_running = false;
+	RLM3_Give(queue->task);
+	while (queue->task != NULL)
+		RLM3_Take();
+	queue->stopper = NULL;
+}
+
+extern bool RLM3_WorkQueue_IsRunning(const RLM3_WorkQueue* queue)
+{
+	return (queue->task != NULL);
+}
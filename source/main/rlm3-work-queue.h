@@ -0,0 +1,58 @@
+#pragma once
+
+#include "rlm3-base.h"
+#include "rlm3-task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Defers work out of interrupt context.  Work items are owned by the caller and linked into the queue, so posting
+ * never allocates.  Posting is lock-free and safe from any interrupt or task.  Posting an item that is already
+ * pending does nothing, so an interrupt that fires repeatedly before the worker runs costs a single execution.  Each
+ * queue has one worker task.  Use several queues for work at different priorities.
+ */
+
+
+typedef struct RLM3_WorkItem RLM3_WorkItem;
+typedef void (*RLM3_WorkItem_Callback)(RLM3_WorkItem* item, void* context);
+
+struct RLM3_WorkItem
+{
+	RLM3_WorkItem* next;
+	RLM3_WorkItem_Callback callback;
+	void* context;
+	volatile uint32_t is_pending;
+};
+
+typedef struct
+{
+	RLM3_WorkItem* volatile head;
+	volatile RLM3_Task task;
+	volatile RLM3_Task stopper;
+	volatile bool is_running;
+	volatile uint32_t posted_count;
+	volatile uint32_t coalesced_count;
+} RLM3_WorkQueue;
+
+
+extern void RLM3_WorkQueue_Init(RLM3_WorkQueue* queue);
+extern void RLM3_WorkItem_Init(RLM3_WorkItem* item, RLM3_WorkItem_Callback callback, void* context);
+extern bool RLM3_WorkItem_IsPending(const RLM3_WorkItem* item);
+
+// Returns false if the item was already pending.  The worker is only notified when the queue was empty.
+extern bool RLM3_WorkQueue_Post(RLM3_WorkQueue* queue, RLM3_WorkItem* item);
+
+// Runs every item posted so far in the order they were posted.  The worker task calls this.
+extern size_t RLM3_WorkQueue_RunPending(RLM3_WorkQueue* queue);
+
+extern void RLM3_WorkQueue_Start(RLM3_WorkQueue* queue, const char* name, uint32_t priority, size_t stack_size);
+extern void RLM3_WorkQueue_Stop(RLM3_WorkQueue* queue);
+extern bool RLM3_WorkQueue_IsRunning(const RLM3_WorkQueue* queue);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -54,7 +54,7 @@ TEST_CASE(SpinLock_MultipleThreads_StressTest)
 	task_attributes.name = "thread";
 	task_attributes.stack_size = 128 * 4;
 	task_attributes.priority = osPriorityNormal;
-	size_t counts[8] = {};
+	static size_t counts[8] = {};
 	for (size_t i = 0; i < 4; i++)
 		ASSERT(::osThreadNew(enter_thread_fn, counts + i, &task_attributes) != nullptr);
 	for (size_t i = 4; i < 8; i++)
@@ -67,6 +67,10 @@ TEST_CASE(SpinLock_MultipleThreads_StressTest)
 		LOG_ALWAYS("%d Total %d Miss %d Enter %d %d %d %d Try %d %d %d %d", i, g_total_count, g_miss_count, counts[0], counts[1], counts[2], counts[3], counts[4], counts[5], counts[6], counts[7]);
 	}
 	g_is_done = true;
+
+	// Every thread got the lock, so none of them was starved.
+	for (size_t i = 0; i < 8; i++)
+		ASSERT(counts[i] > 0);
 }
 
 TEST_CASE(MutexLock_MultipleThreads_StressTest)
@@ -116,7 +120,7 @@ TEST_CASE(MutexLock_MultipleThreads_StressTest)
 	task_attributes.name = "thread";
 	task_attributes.stack_size = 128 * 4;
 	task_attributes.priority = osPriorityNormal;
-	size_t counts[8] = {};
+	static size_t counts[8] = {};
 	for (size_t i = 0; i < 4; i++)
 		ASSERT(::osThreadNew(enter_thread_fn, counts + i, &task_attributes) != nullptr);
 	for (size_t i = 4; i < 8; i++)
@@ -129,5 +133,9 @@ TEST_CASE(MutexLock_MultipleThreads_StressTest)
 		LOG_ALWAYS("%d Total %d Miss %d Enter %d %d %d %d Try %d %d %d %d", i, g_total_count, g_miss_count, counts[0], counts[1], counts[2], counts[3], counts[4], counts[5], counts[6], counts[7]);
 	}
 	g_is_done = true;
+
+	// Every thread got the lock, so none of them was starved.
+	for (size_t i = 0; i < 8; i++)
+		ASSERT(counts[i] > 0);
 }
 
@@ -0,0 +1,216 @@
+#include "Test.hpp"
+#include "rlm3-sync.h"
+#include "cmsis_os2.h"
+#include "logger.h"
+
+
+LOGGER_ZONE(STRESS);
+
+
+TEST_CASE(Semaphore_MultipleThreads_StressTest)
+{
+	static RLM3_Semaphore g_semaphore;
+	static volatile bool g_is_done = false;
+	static volatile size_t g_given_count = 0;
+	static volatile size_t g_taken_count = 0;
+	static volatile size_t g_miss_count = 0;
+
+	auto give_thread_fn = [](void* param)
+	{
+		volatile size_t* self_count = (size_t*)param;
+		while (!g_is_done)
+		{
+			RLM3_Semaphore_Give(&g_semaphore);
+			(*self_count)++;
+			g_given_count++;
+			::osThreadYield();
+		}
+		::osThreadExit();
+	};
+
+	auto take_thread_fn = [](void* param)
+	{
+		volatile size_t* self_count = (size_t*)param;
+		while (!g_is_done)
+		{
+			if (RLM3_Semaphore_Try(&g_semaphore, 1))
+			{
+				(*self_count)++;
+				g_taken_count++;
+			}
+			else
+				g_miss_count++;
+		}
+		::osThreadExit();
+	};
+
+	RLM3_Semaphore_Init(&g_semaphore, 0);
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "thread";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityNormal;
+	static size_t counts[8] = {};
+	for (size_t i = 0; i < 4; i++)
+		ASSERT(::osThreadNew(give_thread_fn, counts + i, &task_attributes) != nullptr);
+	for (size_t i = 4; i < 8; i++)
+		ASSERT(::osThreadNew(take_thread_fn, counts + i, &task_attributes) != nullptr);
+
+	uint32_t start_time = osKernelGetTickCount();
+	for (size_t i = 1; i <= 30; i++)
+	{
+		::osDelayUntil(start_time + 1000 * i);
+		LOG_ALWAYS("%d Given %d Taken %d Count %d Miss %d Give %d %d %d %d Take %d %d %d %d", i, g_given_count, g_taken_count, RLM3_Semaphore_GetCount(&g_semaphore), g_miss_count, counts[0], counts[1], counts[2], counts[3], counts[4], counts[5], counts[6], counts[7]);
+	}
+	g_is_done = true;
+}
+
+TEST_CASE(EventFlags_MultipleThreads_StressTest)
+{
+	static RLM3_EventFlags g_event_flags;
+	static volatile bool g_is_done = false;
+	static volatile size_t g_set_count = 0;
+	static volatile size_t g_miss_count = 0;
+
+	auto set_thread_fn = [](void* param)
+	{
+		// One bit at a time, except that 0x3 is held together once a cycle for the WaitAll threads.
+		static const uint32_t PATTERNS[] = { 0x1, 0x2, 0x3, 0x4, 0x8 };
+		size_t index = 0;
+		while (!g_is_done)
+		{
+			uint32_t bits = PATTERNS[index];
+			RLM3_EventFlags_Set(&g_event_flags, bits);
+			g_set_count++;
+			::osThreadYield();
+			RLM3_EventFlags_Clear(&g_event_flags, bits);
+			index = (index + 1) % (sizeof(PATTERNS) / sizeof(PATTERNS[0]));
+		}
+		RLM3_EventFlags_Set(&g_event_flags, 0xF);
+		::osThreadExit();
+	};
+
+	auto any_thread_fn = [](void* param)
+	{
+		volatile size_t* self_count = (size_t*)param;
+		while (!g_is_done)
+		{
+			if (RLM3_EventFlags_WaitAny(&g_event_flags, 0x5, 1) != 0)
+				(*self_count)++;
+			else
+				g_miss_count++;
+			::osThreadYield();
+		}
+		::osThreadExit();
+	};
+
+	auto all_thread_fn = [](void* param)
+	{
+		volatile size_t* self_count = (size_t*)param;
+		while (!g_is_done)
+		{
+			if (RLM3_EventFlags_WaitAll(&g_event_flags, 0x3, 1) != 0)
+				(*self_count)++;
+		}
+		::osThreadExit();
+	};
+
+	RLM3_EventFlags_Init(&g_event_flags);
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "thread";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityNormal;
+	static size_t counts[6] = {};
+	ASSERT(::osThreadNew(set_thread_fn, nullptr, &task_attributes) != nullptr);
+	for (size_t i = 0; i < 4; i++)
+		ASSERT(::osThreadNew(any_thread_fn, counts + i, &task_attributes) != nullptr);
+	for (size_t i = 4; i < 6; i++)
+		ASSERT(::osThreadNew(all_thread_fn, counts + i, &task_attributes) != nullptr);
+
+	uint32_t start_time = osKernelGetTickCount();
+	for (size_t i = 1; i <= 30; i++)
+	{
+		::osDelayUntil(start_time + 1000 * i);
+		LOG_ALWAYS("%d Set %d Miss %d Any %d %d %d %d All %d %d", i, g_set_count, g_miss_count, counts[0], counts[1], counts[2], counts[3], counts[4], counts[5]);
+	}
+	g_is_done = true;
+
+	ASSERT(counts[4] > 0 && counts[5] > 0);
+}
+
+TEST_CASE(CondVar_MultipleThreads_StressTest)
+{
+	static const size_t CAPACITY = 4;
+	static RLM3_MutexLock g_lock;
+	static RLM3_CondVar g_not_empty;
+	static RLM3_CondVar g_not_full;
+	static volatile bool g_is_done = false;
+	static volatile size_t g_level = 0;
+	static volatile size_t g_total_count = 0;
+	static volatile size_t g_timeout_count = 0;
+
+	auto produce_thread_fn = [](void* param)
+	{
+		volatile size_t* self_count = (size_t*)param;
+		while (!g_is_done)
+		{
+			RLM3_MutexLock_Enter(&g_lock);
+			while (g_level == CAPACITY && !g_is_done)
+				RLM3_CondVar_Wait(&g_not_full, &g_lock);
+			ASSERT(g_level <= CAPACITY);
+			if (g_level < CAPACITY)
+			{
+				g_level++;
+				(*self_count)++;
+				RLM3_CondVar_Signal(&g_not_empty);
+			}
+			RLM3_MutexLock_Leave(&g_lock);
+		}
+		::osThreadExit();
+	};
+
+	auto consume_thread_fn = [](void* param)
+	{
+		volatile size_t* self_count = (size_t*)param;
+		while (!g_is_done)
+		{
+			RLM3_MutexLock_Enter(&g_lock);
+			if (g_level == 0 && !RLM3_CondVar_Try(&g_not_empty, &g_lock, 1))
+				g_timeout_count++;
+			if (g_level > 0)
+			{
+				g_level--;
+				(*self_count)++;
+				g_total_count++;
+				RLM3_CondVar_Signal(&g_not_full);
+			}
+			RLM3_MutexLock_Leave(&g_lock);
+			::osThreadYield();
+		}
+		::osThreadExit();
+	};
+
+	RLM3_MutexLock_Init(&g_lock);
+	RLM3_CondVar_Init(&g_not_empty);
+	RLM3_CondVar_Init(&g_not_full);
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "thread";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityNormal;
+	static size_t counts[8] = {};
+	for (size_t i = 0; i < 4; i++)
+		ASSERT(::osThreadNew(produce_thread_fn, counts + i, &task_attributes) != nullptr);
+	for (size_t i = 4; i < 8; i++)
+		ASSERT(::osThreadNew(consume_thread_fn, counts + i, &task_attributes) != nullptr);
+
+	uint32_t start_time = osKernelGetTickCount();
+	for (size_t i = 1; i <= 30; i++)
+	{
+		::osDelayUntil(start_time + 1000 * i);
+		LOG_ALWAYS("%d Total %d Level %d Timeout %d Produce %d %d %d %d Consume %d %d %d %d", i, g_total_count, g_level, g_timeout_count, counts[0], counts[1], counts[2], counts[3], counts[4], counts[5], counts[6], counts[7]);
+	}
+
+	RLM3_MutexLock_Enter(&g_lock);
+	g_is_done = true;
+	RLM3_CondVar_Broadcast(&g_not_full);
+	RLM3_MutexLock_Leave(&g_lock);
+}
@@ -25,3 +25,11 @@ TEST_CASE(IsDebugOutput_HappyCase)
 {
 	ASSERT(RLM3_IsDebugOutput());
 }
+
+TEST_CASE(GetCycleCount_HappyCase)
+{
+	uint32_t start = RLM3_GetCycleCount();
+	uint32_t finish = RLM3_GetCycleCount();
+
+	ASSERT(finish - start > 0 && finish - start < 1000);
+}
@@ -0,0 +1,107 @@
+#include "Test.hpp"
+#include "rlm3-capture.h"
+
+
+static RLM3_Capture g_capture;
+
+
+TEST_CASE(RLM3_Capture_ExtendTimestamp_HappyCase)
+{
+	ASSERT(RLM3_Capture_ExtendTimestamp(0, 1234, false) == 1234);
+	ASSERT(RLM3_Capture_ExtendTimestamp(7, 0xFFFFFFFF, false) == 0x7FFFFFFFFULL);
+	ASSERT(RLM3_Capture_ExtendTimestamp(7, 0xFFFFFFF0, true) == 0x7FFFFFFF0ULL);
+	ASSERT(RLM3_Capture_ExtendTimestamp(7, 0x00000010, true) == 0x800000010ULL);
+}
+
+TEST_CASE(RLM3_Capture_Record_Batching)
+{
+	RLM3_Capture_Init(&g_capture);
+
+	for (size_t i = 0; i < RLM3_CAPTURE_BATCH_SIZE - 1; i++)
+		ASSERT(!RLM3_Capture_Record(&g_capture, 100 + i, false));
+	ASSERT(RLM3_Capture_Acquire(&g_capture) == nullptr);
+	ASSERT(RLM3_Capture_Record(&g_capture, 100 + RLM3_CAPTURE_BATCH_SIZE - 1, false));
+
+	const RLM3_CaptureBatch* batch = RLM3_Capture_Acquire(&g_capture);
+	ASSERT(batch != nullptr);
+	ASSERT(batch->count == RLM3_CAPTURE_BATCH_SIZE);
+	for (size_t i = 0; i < RLM3_CAPTURE_BATCH_SIZE; i++)
+		ASSERT(batch->timestamps[i] == 100 + i);
+	RLM3_Capture_Release(&g_capture);
+	ASSERT(RLM3_Capture_Acquire(&g_capture) == nullptr);
+	ASSERT(RLM3_Capture_GetDroppedCount(&g_capture) == 0);
+}
+
+TEST_CASE(RLM3_Capture_Flush_HappyCase)
+{
+	RLM3_Capture_Init(&g_capture);
+
+	ASSERT(!RLM3_Capture_Flush(&g_capture));
+	RLM3_Capture_Record(&g_capture, 5, false);
+	RLM3_Capture_Record(&g_capture, 6, false);
+	ASSERT(RLM3_Capture_Flush(&g_capture));
+	ASSERT(!RLM3_Capture_Flush(&g_capture));
+
+	const RLM3_CaptureBatch* batch = RLM3_Capture_Acquire(&g_capture);
+	ASSERT(batch != nullptr && batch->count == 2);
+	ASSERT(batch->timestamps[0] == 5 && batch->timestamps[1] == 6);
+	RLM3_Capture_Release(&g_capture);
+}
+
+TEST_CASE(RLM3_Capture_Overflow)
+{
+	RLM3_Capture_Init(&g_capture);
+
+	// Fill every batch without consuming any of them.
+	size_t ready = 0;
+	for (size_t i = 0; i < RLM3_CAPTURE_BATCH_SIZE * RLM3_CAPTURE_BATCH_COUNT; i++)
+		if (RLM3_Capture_Record(&g_capture, i, false))
+			ready++;
+	ASSERT(ready == RLM3_CAPTURE_BATCH_COUNT);
+
+	ASSERT(!RLM3_Capture_Record(&g_capture, 9999, false));
+	ASSERT(!RLM3_Capture_Flush(&g_capture));
+	RLM3_Capture_Drop(&g_capture);
+	ASSERT(RLM3_Capture_GetDroppedCount(&g_capture) == 2);
+
+	// Releasing a batch makes room for new edges again.
+	const RLM3_CaptureBatch* batch = RLM3_Capture_Acquire(&g_capture);
+	ASSERT(batch->timestamps[0] == 0);
+	RLM3_Capture_Release(&g_capture);
+	ASSERT(!RLM3_Capture_Record(&g_capture, 10000, false));
+	ASSERT(RLM3_Capture_GetDroppedCount(&g_capture) == 2);
+	for (size_t i = 0; i < RLM3_CAPTURE_BATCH_COUNT - 1; i++)
+	{
+		batch = RLM3_Capture_Acquire(&g_capture);
+		ASSERT(batch->timestamps[0] == RLM3_CAPTURE_BATCH_SIZE * (i + 1));
+		RLM3_Capture_Release(&g_capture);
+	}
+	ASSERT(RLM3_Capture_Flush(&g_capture));
+	batch = RLM3_Capture_Acquire(&g_capture);
+	ASSERT(batch->count == 1 && batch->timestamps[0] == 10000);
+	RLM3_Capture_Release(&g_capture);
+}
+
+TEST_CASE(RLM3_Capture_Rollover)
+{
+	// Simulate edges around a counter wrap where the interrupt sees the edges before the rollover is serviced.
+	RLM3_Capture_Init(&g_capture);
+	g_capture.high = 3;
+
+	RLM3_Capture_Record(&g_capture, 0xFFFFFF00, false);
+	RLM3_Capture_Record(&g_capture, 0xFFFFFFF0, true);
+	RLM3_Capture_Record(&g_capture, 0x00000008, true);
+	RLM3_Capture_Rollover(&g_capture);
+	RLM3_Capture_Record(&g_capture, 0x00000100, false);
+	RLM3_Capture_Flush(&g_capture);
+
+	const RLM3_CaptureBatch* batch = RLM3_Capture_Acquire(&g_capture);
+	ASSERT(batch->count == 4);
+	ASSERT(batch->timestamps[0] == 0x3FFFFFF00ULL);
+	ASSERT(batch->timestamps[1] == 0x3FFFFFFF0ULL);
+	ASSERT(batch->timestamps[2] == 0x400000008ULL);
+	ASSERT(batch->timestamps[3] == 0x400000100ULL);
+	for (size_t i = 1; i < batch->count; i++)
+		ASSERT(batch->timestamps[i - 1] < batch->timestamps[i]);
+	RLM3_Capture_Release(&g_capture);
+}
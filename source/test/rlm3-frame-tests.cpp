@@ -0,0 +1,304 @@
+#include "Test.hpp"
+#include "rlm3-frame.h"
+#include "logger.h"
+#include "main.h"
+
+
+LOGGER_ZONE(TEST_FRAME);
+
+
+static const size_t BUFFER_SIZE = 64;
+static const size_t BUFFER_COUNT = 4;
+static const RLM3_FrameEncoding ENCODINGS[] = { RLM3_FRAME_COBS, RLM3_FRAME_SLIP, RLM3_FRAME_LENGTH };
+
+static RLM3_FrameDecoder g_decoder;
+static uint8_t g_buffers[BUFFER_COUNT][BUFFER_SIZE];
+static uint32_t g_queue_storage[RLM3_FRAME_DECODER_QUEUE_STORAGE_SIZE(BUFFER_COUNT) / sizeof(uint32_t)];
+
+
+static void InitDecoder(RLM3_FrameEncoding encoding, bool has_crc)
+{
+	RLM3_FrameDecoder_Init(&g_decoder, encoding, has_crc, g_buffers, BUFFER_SIZE, BUFFER_COUNT, g_queue_storage, sizeof(g_queue_storage));
+}
+
+static size_t Encode(RLM3_FrameEncoding encoding, const uint8_t* payload, size_t size, uint8_t* out, size_t out_size)
+{
+	size_t encoded = RLM3_Frame_Encode(encoding, true, payload, size, out, out_size);
+	ASSERT(encoded != 0);
+	return encoded;
+}
+
+static void ExpectFrame(const uint8_t* payload, size_t size)
+{
+	RLM3_Frame frame;
+	ASSERT(RLM3_FrameDecoder_Take(&g_decoder, &frame, 0));
+	ASSERT(frame.size == size);
+	for (size_t i = 0; i < size; i++)
+		ASSERT(frame.data[i] == payload[i]);
+	RLM3_FrameDecoder_Return(&g_decoder, &frame);
+}
+
+static void ExpectNoFrame()
+{
+	RLM3_Frame frame;
+	ASSERT(!RLM3_FrameDecoder_Take(&g_decoder, &frame, 0));
+}
+
+static RLM3_FrameDecoder_Counters GetCounters()
+{
+	RLM3_FrameDecoder_Counters counters;
+	RLM3_FrameDecoder_GetCounters(&g_decoder, &counters);
+	return counters;
+}
+
+
+TEST_CASE(RLM3_Frame_CRC_KnownValue)
+{
+	const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	ASSERT(RLM3_Frame_CRC(check, sizeof(check)) == 0x29B1);
+}
+
+TEST_CASE(RLM3_Frame_Encode_KnownValues)
+{
+	const uint8_t payload[] = { 0x11, 0x00, 0xC0, 0xDB };
+	uint8_t out[16];
+
+	const uint8_t cobs[] = { 0x02, 0x11, 0x03, 0xC0, 0xDB, 0x00 };
+	ASSERT(RLM3_Frame_Encode(RLM3_FRAME_COBS, false, payload, sizeof(payload), out, sizeof(out)) == sizeof(cobs));
+	for (size_t i = 0; i < sizeof(cobs); i++)
+		ASSERT(out[i] == cobs[i]);
+
+	const uint8_t slip[] = { 0xC0, 0x11, 0x00, 0xDB, 0xDC, 0xDB, 0xDD, 0xC0 };
+	ASSERT(RLM3_Frame_Encode(RLM3_FRAME_SLIP, false, payload, sizeof(payload), out, sizeof(out)) == sizeof(slip));
+	for (size_t i = 0; i < sizeof(slip); i++)
+		ASSERT(out[i] == slip[i]);
+
+	const uint8_t length[] = { 0x00, 0x04, 0x11, 0x00, 0xC0, 0xDB };
+	ASSERT(RLM3_Frame_Encode(RLM3_FRAME_LENGTH, false, payload, sizeof(payload), out, sizeof(out)) == sizeof(length));
+	for (size_t i = 0; i < sizeof(length); i++)
+		ASSERT(out[i] == length[i]);
+
+	ASSERT(RLM3_Frame_Encode(RLM3_FRAME_SLIP, false, payload, sizeof(payload), out, sizeof(slip) - 1) == 0);
+}
+
+TEST_CASE(RLM3_FrameDecoder_RoundTrip_HappyCase)
+{
+	// Sizes around the 254 byte COBS block need a bigger buffer than the other cases.
+	static uint8_t large_buffers[BUFFER_COUNT][600];
+	static uint8_t payload[520];
+	static uint8_t stream[1200];
+	const size_t sizes[] = { 1, 2, 5, 253, 254, 255, 256, 508, 509, 520 };
+	for (size_t i = 0; i < sizeof(payload); i++)
+		payload[i] = (i % 5 == 0) ? 0x00 : (i % 7 == 0) ? 0xC0 : (i % 11 == 0) ? 0xDB : (uint8_t)(i * 13);
+
+	for (RLM3_FrameEncoding encoding : ENCODINGS)
+	{
+		for (int pass = 0; pass < 2; pass++)
+		{
+			bool has_crc = (pass == 1);
+			RLM3_FrameDecoder_Init(&g_decoder, encoding, has_crc, large_buffers, sizeof(large_buffers[0]), BUFFER_COUNT, g_queue_storage, sizeof(g_queue_storage));
+			for (size_t size : sizes)
+			{
+				size_t encoded = RLM3_Frame_Encode(encoding, has_crc, payload, size, stream, sizeof(stream));
+				ASSERT(encoded != 0);
+				RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, encoded);
+				ExpectFrame(payload, size);
+			}
+			ExpectNoFrame();
+			RLM3_FrameDecoder_Counters counters = GetCounters();
+			ASSERT(counters.frame_count == sizeof(sizes) / sizeof(sizes[0]));
+			ASSERT(counters.crc_error_count == 0 && counters.framing_error_count == 0);
+			ASSERT(counters.overflow_count == 0 && counters.no_buffer_count == 0);
+		}
+	}
+}
+
+TEST_CASE(RLM3_FrameDecoder_ByteAtATime_HappyCase)
+{
+	const uint8_t first[] = { 1, 2, 3 };
+	const uint8_t second[] = { 0, 0xC0, 0xDB, 0xDC };
+	uint8_t stream[32];
+	for (RLM3_FrameEncoding encoding : ENCODINGS)
+	{
+		InitDecoder(encoding, true);
+		size_t size = Encode(encoding, first, sizeof(first), stream, sizeof(stream));
+		size += Encode(encoding, second, sizeof(second), stream + size, sizeof(stream) - size);
+		for (size_t i = 0; i < size; i++)
+			RLM3_FrameDecoder_Receive(&g_decoder, stream[i]);
+		ExpectFrame(first, sizeof(first));
+		ExpectFrame(second, sizeof(second));
+		ExpectNoFrame();
+	}
+}
+
+TEST_CASE(RLM3_FrameDecoder_Corrupted_Dropped)
+{
+	const uint8_t payload[] = { 'H', 'e', 'l', 'l', 'o', 0, 'W', 'o', 'r', 'l', 'd' };
+	uint8_t stream[32];
+	uint8_t next[32];
+	for (RLM3_FrameEncoding encoding : ENCODINGS)
+	{
+		InitDecoder(encoding, true);
+		size_t size = Encode(encoding, payload, sizeof(payload), stream, sizeof(stream));
+		size_t next_size = Encode(encoding, payload, sizeof(payload), next, sizeof(next));
+
+		// A flipped bit in the last payload byte leaves the framing intact, so only the CRC catches it.
+		stream[size - 4] ^= 0x10;
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size);
+		ExpectNoFrame();
+		ASSERT(GetCounters().crc_error_count == 1);
+
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, next, next_size);
+		ExpectFrame(payload, sizeof(payload));
+		ASSERT(GetCounters().frame_count == 1);
+	}
+}
+
+TEST_CASE(RLM3_FrameDecoder_BadFraming_Dropped)
+{
+	const uint8_t payload[] = { 10, 20, 30 };
+	uint8_t next[16];
+
+	// A COBS block that claims more bytes than come before the zero.
+	InitDecoder(RLM3_FRAME_COBS, true);
+	const uint8_t short_block[] = { 0x09, 1, 2, 0x00 };
+	RLM3_FrameDecoder_ReceiveBlock(&g_decoder, short_block, sizeof(short_block));
+	RLM3_FrameDecoder_ReceiveBlock(&g_decoder, next, Encode(RLM3_FRAME_COBS, payload, sizeof(payload), next, sizeof(next)));
+	ExpectFrame(payload, sizeof(payload));
+	ASSERT(GetCounters().framing_error_count == 1);
+
+	// A SLIP escape followed by a byte that is not an escape code.
+	InitDecoder(RLM3_FRAME_SLIP, true);
+	const uint8_t bad_escape[] = { 0xC0, 1, 0xDB, 0x42, 2, 0xC0 };
+	RLM3_FrameDecoder_ReceiveBlock(&g_decoder, bad_escape, sizeof(bad_escape));
+	RLM3_FrameDecoder_ReceiveBlock(&g_decoder, next, Encode(RLM3_FRAME_SLIP, payload, sizeof(payload), next, sizeof(next)));
+	ExpectFrame(payload, sizeof(payload));
+	ASSERT(GetCounters().framing_error_count == 1);
+
+	// A zero length.
+	InitDecoder(RLM3_FRAME_LENGTH, true);
+	const uint8_t zero_length[] = { 0x00, 0x00 };
+	RLM3_FrameDecoder_ReceiveBlock(&g_decoder, zero_length, sizeof(zero_length));
+	RLM3_FrameDecoder_ReceiveBlock(&g_decoder, next, Encode(RLM3_FRAME_LENGTH, payload, sizeof(payload), next, sizeof(next)));
+	ExpectFrame(payload, sizeof(payload));
+	ASSERT(GetCounters().framing_error_count == 1);
+}
+
+TEST_CASE(RLM3_FrameDecoder_Truncated_Recovers)
+{
+	const uint8_t payload[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	uint8_t stream[32];
+	for (RLM3_FrameEncoding encoding : ENCODINGS)
+	{
+		InitDecoder(encoding, true);
+		size_t size = Encode(encoding, payload, sizeof(payload), stream, sizeof(stream));
+
+		// Cut short, then the line goes idle.  The next frame starts clean.
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size / 2);
+		RLM3_FrameDecoder_Reset(&g_decoder);
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size);
+		ExpectFrame(payload, sizeof(payload));
+		ExpectNoFrame();
+		ASSERT(GetCounters().framing_error_count == 1);
+		ASSERT(GetCounters().frame_count == 1);
+	}
+
+	// Without the reset a delimited encoding loses the cut frame and the one it runs into, then picks up again.
+	const RLM3_FrameEncoding delimited[] = { RLM3_FRAME_COBS, RLM3_FRAME_SLIP };
+	for (RLM3_FrameEncoding encoding : delimited)
+	{
+		InitDecoder(encoding, true);
+		size_t size = Encode(encoding, payload, sizeof(payload), stream, sizeof(stream));
+		size_t skip = (encoding == RLM3_FRAME_SLIP) ? 1 : 0;
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size / 2);
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream + skip, size - skip);
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size);
+		ExpectFrame(payload, sizeof(payload));
+		ExpectNoFrame();
+		ASSERT(GetCounters().crc_error_count + GetCounters().framing_error_count == 1);
+	}
+}
+
+TEST_CASE(RLM3_FrameDecoder_Overflow_Dropped)
+{
+	uint8_t payload[BUFFER_SIZE];
+	for (size_t i = 0; i < sizeof(payload); i++)
+		payload[i] = (uint8_t)(i + 1);
+	uint8_t stream[2 * BUFFER_SIZE];
+	uint8_t next[2 * BUFFER_SIZE];
+	for (RLM3_FrameEncoding encoding : ENCODINGS)
+	{
+		InitDecoder(encoding, true);
+		// The CRC pushes a full buffer of payload one frame over.
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, Encode(encoding, payload, sizeof(payload), stream, sizeof(stream)));
+		size_t next_size = Encode(encoding, payload, BUFFER_SIZE - RLM3_FRAME_CRC_SIZE, next, sizeof(next));
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, next, next_size);
+		ExpectFrame(payload, BUFFER_SIZE - RLM3_FRAME_CRC_SIZE);
+		ExpectNoFrame();
+		ASSERT(GetCounters().overflow_count == 1);
+	}
+}
+
+TEST_CASE(RLM3_FrameDecoder_NoBuffer_Dropped)
+{
+	const uint8_t payload[] = { 0xA5, 0x5A };
+	uint8_t stream[16];
+	for (RLM3_FrameEncoding encoding : ENCODINGS)
+	{
+		InitDecoder(encoding, true);
+		size_t size = Encode(encoding, payload, sizeof(payload), stream, sizeof(stream));
+
+		// The consumer holds on to every buffer.
+		RLM3_Frame held[BUFFER_COUNT];
+		for (size_t i = 0; i < BUFFER_COUNT; i++)
+		{
+			RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size);
+			ASSERT(RLM3_FrameDecoder_Take(&g_decoder, &held[i], 0));
+		}
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size);
+		ExpectNoFrame();
+		ASSERT(GetCounters().no_buffer_count == 1);
+
+		// Frames are delivered in place, so each one is in a different buffer.
+		for (size_t i = 0; i < BUFFER_COUNT; i++)
+			for (size_t j = 0; j < i; j++)
+				ASSERT(held[i].data != held[j].data);
+		for (size_t i = 0; i < BUFFER_COUNT; i++)
+			RLM3_FrameDecoder_Return(&g_decoder, &held[i]);
+		RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size);
+		ExpectFrame(payload, sizeof(payload));
+	}
+}
+
+TEST_CASE(RLM3_FrameDecoder_Benchmark)
+{
+	static const size_t PAYLOAD_SIZE = 48;
+	static const size_t ROUNDS = 64;
+	static uint8_t stream[BUFFER_COUNT * 2 * BUFFER_SIZE];
+	uint8_t payload[PAYLOAD_SIZE];
+	for (size_t i = 0; i < sizeof(payload); i++)
+		payload[i] = (uint8_t)(i * 37);
+
+	for (RLM3_FrameEncoding encoding : ENCODINGS)
+	{
+		InitDecoder(encoding, true);
+		size_t size = 0;
+		for (size_t i = 0; i < BUFFER_COUNT; i++)
+			size += Encode(encoding, payload, sizeof(payload), stream + size, sizeof(stream) - size);
+
+		// A batch of frames as one DMA block, then the consumer hands every buffer back.
+		uint32_t cycles = 0;
+		for (size_t round = 0; round < ROUNDS; round++)
+		{
+			uint32_t start = RLM3_GetCycleCount();
+			RLM3_FrameDecoder_ReceiveBlock(&g_decoder, stream, size);
+			cycles += RLM3_GetCycleCount() - start;
+			for (size_t i = 0; i < BUFFER_COUNT; i++)
+				ExpectFrame(payload, sizeof(payload));
+		}
+
+		uint64_t bytes = (uint64_t)size * ROUNDS;
+		ASSERT(GetCounters().frame_count == BUFFER_COUNT * ROUNDS);
+		LOG_ALWAYS("Frame decode %d: %u cycles per 100 bytes, %u bytes/s at HCLK", (int)encoding, (int)(100 * (uint64_t)cycles / bytes), (int)(bytes * HAL_RCC_GetHCLKFreq() / cycles));
+	}
+}
@@ -0,0 +1,156 @@
+#include "Test.hpp"
+#include "rlm3-gpio-event.h"
+#include <vector>
+
+
+struct SimEdge
+{
+	uint32_t time;
+	uint8_t level;
+};
+
+
+static std::vector<RLM3_GPIO_Event> g_events;
+
+
+static void Simulate(RLM3_GPIO_Debounce* debounce, uint32_t holdoff, const std::vector<SimEdge>& edges, uint32_t end_time)
+{
+	// Edges that arrive while the line is masked only set the pending bit.  The holdoff timer unmasks the line.
+	g_events.clear();
+	bool is_masked = false;
+	bool is_pending = false;
+	uint32_t unmask_time = 0;
+	uint8_t level = debounce->level;
+	for (size_t i = 0; i <= edges.size(); i++)
+	{
+		uint32_t time = (i < edges.size()) ? edges[i].time : end_time;
+		if (is_masked && time >= unmask_time)
+		{
+			is_masked = false;
+			if (RLM3_GPIO_Debounce_EndHoldoff(debounce, level, is_pending))
+				g_events.push_back({ unmask_time, 0, debounce->level });
+			is_pending = false;
+		}
+		if (i == edges.size())
+			break;
+
+		level = edges[i].level;
+		if (is_masked)
+		{
+			is_pending = true;
+			continue;
+		}
+		if (RLM3_GPIO_Debounce_Edge(debounce, level))
+			g_events.push_back({ time, 0, level });
+		if (debounce->is_holdoff)
+		{
+			is_masked = true;
+			unmask_time = time + holdoff;
+		}
+	}
+}
+
+static std::vector<SimEdge> MakeBouncyPress(uint32_t start, uint8_t final_level, size_t bounces)
+{
+	std::vector<SimEdge> edges;
+	for (size_t i = 0; i < bounces; i++)
+		edges.push_back({ start + 3 * (uint32_t)i, (uint8_t)((i % 2 == 0) ? final_level : !final_level) });
+	edges.push_back({ start + 3 * (uint32_t)bounces, final_level });
+	return edges;
+}
+
+
+TEST_CASE(RLM3_GPIO_Debounce_NoHoldoff)
+{
+	RLM3_GPIO_Debounce debounce;
+	RLM3_GPIO_Debounce_Init(&debounce, RLM3_EXTI_EDGE_BOTH, false, 0);
+
+	Simulate(&debounce, 0, { { 10, 1 }, { 11, 0 }, { 12, 1 }, { 12, 1 } }, 100);
+
+	// Without a holdoff every change is reported, but repeated levels are not.
+	ASSERT(g_events.size() == 3);
+	ASSERT(g_events[0].level == 1 && g_events[1].level == 0 && g_events[2].level == 1);
+	ASSERT(debounce.suppressed_count == 0);
+}
+
+TEST_CASE(RLM3_GPIO_Debounce_BouncyPress)
+{
+	RLM3_GPIO_Debounce debounce;
+	RLM3_GPIO_Debounce_Init(&debounce, RLM3_EXTI_EDGE_BOTH, true, 0);
+
+	std::vector<SimEdge> edges = MakeBouncyPress(1000, 1, 6);
+	std::vector<SimEdge> release = MakeBouncyPress(5000, 0, 8);
+	edges.insert(edges.end(), release.begin(), release.end());
+	Simulate(&debounce, 100, edges, 10000);
+
+	ASSERT(g_events.size() == 2);
+	ASSERT(g_events[0].timestamp == 1000 && g_events[0].level == 1);
+	ASSERT(g_events[1].timestamp == 5000 && g_events[1].level == 0);
+	ASSERT(debounce.suppressed_count == 2);
+}
+
+TEST_CASE(RLM3_GPIO_Debounce_TrailingEdge)
+{
+	RLM3_GPIO_Debounce debounce;
+	RLM3_GPIO_Debounce_Init(&debounce, RLM3_EXTI_EDGE_BOTH, true, 0);
+
+	// A short pulse that ends inside the holdoff is reported when the line is unmasked.
+	Simulate(&debounce, 100, { { 1000, 1 }, { 1020, 0 } }, 2000);
+
+	ASSERT(g_events.size() == 2);
+	ASSERT(g_events[0].timestamp == 1000 && g_events[0].level == 1);
+	ASSERT(g_events[1].timestamp == 1100 && g_events[1].level == 0);
+	ASSERT(debounce.suppressed_count == 1);
+}
+
+TEST_CASE(RLM3_GPIO_Debounce_SingleEdge)
+{
+	RLM3_GPIO_Debounce debounce;
+	RLM3_GPIO_Debounce_Init(&debounce, RLM3_EXTI_EDGE_RISING, true, 0);
+
+	// Only the rising edges reach the debouncer.  Each press is reported once however much it bounces.
+	std::vector<SimEdge> edges;
+	for (uint32_t press = 0; press < 5; press++)
+		for (uint32_t bounce = 0; bounce < 4; bounce++)
+			edges.push_back({ 1000 * press + 5 * bounce, 1 });
+	Simulate(&debounce, 50, edges, 10000);
+
+	ASSERT(g_events.size() == 5);
+	for (size_t i = 0; i < g_events.size(); i++)
+		ASSERT(g_events[i].timestamp == 1000 * i && g_events[i].level == 1);
+	ASSERT(debounce.suppressed_count == 5);
+}
+
+TEST_CASE(RLM3_GPIO_Debounce_EdgeDuringHoldoff)
+{
+	// An edge that was already pending when the line was masked is counted and ignored.
+	RLM3_GPIO_Debounce debounce;
+	RLM3_GPIO_Debounce_Init(&debounce, RLM3_EXTI_EDGE_BOTH, true, 0);
+
+	ASSERT(RLM3_GPIO_Debounce_Edge(&debounce, 1));
+	ASSERT(!RLM3_GPIO_Debounce_Edge(&debounce, 0));
+	ASSERT(!RLM3_GPIO_Debounce_Edge(&debounce, 1));
+	ASSERT(debounce.suppressed_count == 2);
+	ASSERT(!RLM3_GPIO_Debounce_EndHoldoff(&debounce, 1, false));
+	ASSERT(debounce.suppressed_count == 2);
+	ASSERT(!debounce.is_holdoff);
+}
+
+TEST_CASE(RLM3_GPIO_Event_Reregister_KeepsEvents)
+{
+	RLM3_GPIO_Event events[RLM3_GPIO_EVENT_QUEUE_SIZE];
+	RLM3_GPIO_Event_Drain(events, RLM3_GPIO_EVENT_QUEUE_SIZE);
+
+	// An event queued before the only line is dropped is still there after the line comes back.
+	SET_BIT(GPIOB->IDR, 1UL << 6);
+	RLM3_GPIO_Event_Register(6, GPIOB, RLM3_EXTI_EDGE_BOTH, 0);
+	CLEAR_BIT(GPIOB->IDR, 1UL << 6);
+	RLM3_EXTI_Dispatch(1UL << 6);
+	RLM3_GPIO_Event_Unregister(6);
+	ASSERT((EXTI->IMR & (1UL << 6)) == 0);
+	RLM3_GPIO_Event_Register(6, GPIOB, RLM3_EXTI_EDGE_BOTH, 0);
+	RLM3_GPIO_Event_Unregister(6);
+
+	ASSERT(RLM3_GPIO_Event_Drain(events, RLM3_GPIO_EVENT_QUEUE_SIZE) == 1);
+	ASSERT(events[0].line == 6 && events[0].level == 0);
+}
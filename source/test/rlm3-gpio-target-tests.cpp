@@ -0,0 +1,40 @@
+#include "Test.hpp"
+#include "rlm3-gpio.h"
+#include "rlm3-base.h"
+#include "logger.h"
+
+
+LOGGER_ZONE(TEST_GPIO_TARGET);
+
+
+TEST_CASE(RLM3_EXTI_Latency)
+{
+	static volatile uint32_t g_entry_cycles = 0;
+	static volatile bool g_fired = false;
+	RLM3_EXTI_Register(1, GPIOI, RLM3_EXTI_EDGE_RISING, 5, [](size_t line, void* context) {
+		g_entry_cycles = RLM3_GetCycleCount();
+		g_fired = true;
+	}, nullptr);
+
+	// A software trigger sets the pending bit the same way an edge on the pin would.
+	uint32_t min_cycles = UINT32_MAX;
+	uint32_t max_cycles = 0;
+	uint32_t total_cycles = 0;
+	static const size_t COUNT = 100;
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		g_fired = false;
+		uint32_t start = RLM3_GetCycleCount();
+		EXTI->SWIER = EXTI_SWIER_SWIER1;
+		while (!g_fired)
+			;
+		uint32_t cycles = g_entry_cycles - start;
+		min_cycles = (cycles < min_cycles) ? cycles : min_cycles;
+		max_cycles = (cycles > max_cycles) ? cycles : max_cycles;
+		total_cycles += cycles;
+	}
+	RLM3_EXTI_Unregister(1);
+
+	LOG_ALWAYS("EXTI latency cycles min: %u avg: %u max: %u", (int)min_cycles, (int)(total_cycles / COUNT), (int)max_cycles);
+	ASSERT(max_cycles < 1000);
+}
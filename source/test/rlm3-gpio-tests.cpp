@@ -0,0 +1,67 @@
+#include "Test.hpp"
+#include "rlm3-gpio.h"
+#include "rlm3-base.h"
+#include "logger.h"
+
+
+LOGGER_ZONE(TEST_GPIO);
+
+
+static size_t g_calls[8];
+static size_t g_call_count = 0;
+
+
+static void RecordCallback(size_t line, void* context)
+{
+	ASSERT((size_t)(intptr_t)context == line * 10);
+	if (g_call_count < 8)
+		g_calls[g_call_count] = line;
+	g_call_count++;
+}
+
+
+TEST_CASE(RLM3_EXTI_Register_HappyCase)
+{
+	ASSERT(!RLM3_EXTI_IsRegistered(6));
+	RLM3_EXTI_Register(6, GPIOB, RLM3_EXTI_EDGE_RISING, 10, RecordCallback, (void*)60);
+	ASSERT(RLM3_EXTI_IsRegistered(6));
+	ASSERT(!RLM3_EXTI_IsRegistered(7));
+	// Line 6 is routed to port B and unmasked on the rising edge only.
+	ASSERT(((SYSCFG->EXTICR[1] >> 8) & 0xF) == 1);
+	ASSERT((EXTI->IMR & (1UL << 6)) != 0);
+	ASSERT((EXTI->RTSR & (1UL << 6)) != 0 && (EXTI->FTSR & (1UL << 6)) == 0);
+	RLM3_EXTI_Unregister(6);
+	ASSERT(!RLM3_EXTI_IsRegistered(6));
+	ASSERT((EXTI->IMR & (1UL << 6)) == 0);
+	ASSERT(!RLM3_EXTI_IsRegistered(RLM3_EXTI_LINE_COUNT));
+}
+
+TEST_CASE(RLM3_EXTI_Dispatch_Table)
+{
+	static const size_t LINES[] = { 0, 3, 9, 10, 15 };
+	for (size_t line : LINES)
+	{
+		RLM3_EXTI_Register(line, GPIOI, RLM3_EXTI_EDGE_BOTH, 10, RecordCallback, (void*)(line * 10));
+		ASSERT(((SYSCFG->EXTICR[line / 4] >> (4 * (line % 4))) & 0xF) == 8);
+	}
+
+	// Only registered lines are called, highest line first.  Bits past the last line are ignored.
+	g_call_count = 0;
+	RLM3_EXTI_Dispatch((1UL << 0) | (1UL << 2) | (1UL << 9) | (1UL << 15) | (1UL << 20));
+	ASSERT(g_call_count == 3);
+	ASSERT(g_calls[0] == 15 && g_calls[1] == 9 && g_calls[2] == 0);
+
+	g_call_count = 0;
+	RLM3_EXTI_Dispatch(0);
+	ASSERT(g_call_count == 0);
+
+	RLM3_EXTI_Unregister(9);
+	g_call_count = 0;
+	RLM3_EXTI_Dispatch(0xFFFF);
+	ASSERT(g_call_count == 4);
+	ASSERT(g_calls[0] == 15 && g_calls[1] == 10 && g_calls[2] == 3 && g_calls[3] == 0);
+
+	for (size_t line : LINES)
+		if (RLM3_EXTI_IsRegistered(line))
+			RLM3_EXTI_Unregister(line);
+}
@@ -0,0 +1,121 @@
+#include "Test.hpp"
+#include "rlm3-log.h"
+#include "rlm3-timer.h"
+#include "rlm3-task.h"
+#include <string.h>
+
+
+#define RLM3_LOG_LEVEL RLM3_LOG_LEVEL_TRACE
+
+RLM3_LOG_ZONE(TEST_LOG);
+
+
+typedef void (*TimerFn)();
+extern void SetTimer2Callback(TimerFn timer_fn);
+
+
+static size_t g_evaluation_count = 0;
+static volatile size_t g_isr_count = 0;
+
+
+static uint32_t CountEvaluation()
+{
+	return (uint32_t)++g_evaluation_count;
+}
+
+static void DrainDeferred()
+{
+	RLM3_LogRecord record;
+	while (RLM3_Log_PopDeferred(&record))
+		;
+}
+
+// Compiled with traces left out, as a driver built at the default level would be.
+#undef RLM3_LOG_LEVEL
+#define RLM3_LOG_LEVEL RLM3_LOG_LEVEL_DEBUG
+
+static void TraceCompiledOut()
+{
+	RLM3_LOG_TRACE("Out %u", (unsigned)CountEvaluation());
+	RLM3_LOG_DEFER_TRACE("Out %u", CountEvaluation());
+}
+
+#undef RLM3_LOG_LEVEL
+#define RLM3_LOG_LEVEL RLM3_LOG_LEVEL_TRACE
+
+
+TEST_CASE(RLM3_Log_CompiledOut_SkipsArguments)
+{
+	DrainDeferred();
+	g_evaluation_count = 0;
+
+	TraceCompiledOut();
+	ASSERT(g_evaluation_count == 0);
+
+	// Filtered at run time, the arguments are still not evaluated.
+	RLM3_Log_Level = RLM3_LOG_LEVEL_DEBUG;
+	RLM3_LOG_TRACE("Filtered %u", (unsigned)CountEvaluation());
+	RLM3_LOG_DEFER_TRACE("Filtered %u", CountEvaluation());
+	RLM3_Log_Level = RLM3_LOG_LEVEL_TRACE;
+	ASSERT(g_evaluation_count == 0);
+
+	RLM3_LOG_DEFER_TRACE("Enabled %u", CountEvaluation());
+	ASSERT(g_evaluation_count == 1);
+	ASSERT(RLM3_Log_FlushDeferred() == 1);
+}
+
+TEST_CASE(RLM3_Log_Deferred_FormatsLater)
+{
+	DrainDeferred();
+
+	uint32_t before = RLM3_GetCycleCount();
+	RLM3_LOG_DEFER_WARN("No arguments");
+	RLM3_LOG_DEFER_TRACE("Value %u hex %x and %u %u", 12u, 0xBEEFu, 3u, 4u);
+
+	RLM3_LogRecord record;
+	char text[64];
+	ASSERT(RLM3_Log_PopDeferred(&record));
+	ASSERT(record.level == RLM3_LOG_LEVEL_WARN && record.arg_count == 0);
+	ASSERT(strcmp(record.zone, "TEST_LOG") == 0);
+	ASSERT(record.cycles - before < 1000000);
+	ASSERT(RLM3_Log_FormatDeferred(&record, text, sizeof(text)) == strlen("No arguments"));
+	ASSERT(strcmp(text, "No arguments") == 0);
+
+	ASSERT(RLM3_Log_PopDeferred(&record));
+	ASSERT(record.level == RLM3_LOG_LEVEL_TRACE && record.arg_count == 4);
+	RLM3_Log_FormatDeferred(&record, text, sizeof(text));
+	ASSERT(strcmp(text, "Value 12 hex beef and 3 4") == 0);
+	// Long messages are cut to the buffer.
+	ASSERT(RLM3_Log_FormatDeferred(&record, text, 6) == 5);
+	ASSERT(strcmp(text, "Value") == 0);
+	ASSERT(!RLM3_Log_PopDeferred(&record));
+}
+
+TEST_CASE(RLM3_Log_Deferred_FromISR)
+{
+	DrainDeferred();
+	uint32_t dropped = RLM3_Log_GetDroppedCount();
+	g_isr_count = 0;
+
+	SetTimer2Callback([] {
+		if (g_isr_count < RLM3_LOG_RING_CAPACITY + 8)
+		{
+			RLM3_LOG_DEFER_TRACE("ISR %u", (uint32_t)g_isr_count);
+			g_isr_count++;
+		}
+	});
+	RLM3_Timer2_Init(10000);
+	while (g_isr_count < RLM3_LOG_RING_CAPACITY + 8)
+		RLM3_Delay(1);
+	RLM3_Timer2_Deinit();
+
+	// The ring holds what it can and counts the rest.
+	RLM3_LogRecord record;
+	for (uint32_t i = 0; i < RLM3_LOG_RING_CAPACITY; i++)
+	{
+		ASSERT(RLM3_Log_PopDeferred(&record));
+		ASSERT(record.args[0] == i);
+	}
+	ASSERT(!RLM3_Log_PopDeferred(&record));
+	ASSERT(RLM3_Log_GetDroppedCount() - dropped == 8);
+}
@@ -0,0 +1,158 @@
+#include "Test.hpp"
+#include "rlm3-memory-scrub.h"
+#include "logger.h"
+
+
+LOGGER_ZONE(TEST_MEM_SCRUB);
+
+
+TEST_CASE(MEMORY_Scrub_HappyCase)
+{
+	static uint32_t buffer[256];
+	for (size_t i = 0; i < 256; i++)
+		buffer[i] = i * 2654435761u;
+	RLM3_MEMORY_Scrub_ClearInfo();
+
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer, sizeof(buffer)));
+	size_t total = 0;
+	for (size_t i = 0; i < 4; i++)
+		total += RLM3_MEMORY_Scrub_Step(256);
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer);
+
+	RLM3_MEMORY_ScrubInfo info;
+	RLM3_MEMORY_Scrub_GetInfo(&info);
+	ASSERT(total == sizeof(buffer));
+	ASSERT(info.pass_count == 1);
+	ASSERT(info.error_count == 0);
+	ASSERT(info.last_failure_address == nullptr);
+}
+
+TEST_CASE(MEMORY_Scrub_DetectsCorruption)
+{
+	static uint32_t buffer_a[64];
+	static uint32_t buffer_b[64];
+	for (size_t i = 0; i < 64; i++)
+		buffer_a[i] = buffer_b[i] = i;
+	RLM3_MEMORY_Scrub_ClearInfo();
+
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer_a, sizeof(buffer_a)));
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer_b, sizeof(buffer_b)));
+	buffer_b[17] ^= 0x00010000;
+	RLM3_MEMORY_ScrubInfo info;
+	do
+	{
+		RLM3_MEMORY_Scrub_Step(RLM3_MEMORY_SCRUB_CHUNK_SIZE);
+		RLM3_MEMORY_Scrub_GetInfo(&info);
+	} while (info.pass_count == 0);
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer_a);
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer_b);
+
+	ASSERT(info.error_count == 1);
+	ASSERT(info.last_failure_address == buffer_b);
+	ASSERT(info.last_failure_size == sizeof(buffer_b));
+}
+
+TEST_CASE(MEMORY_Scrub_DetectsSwappedWords)
+{
+	static uint32_t buffer[16];
+	for (size_t i = 0; i < 16; i++)
+		buffer[i] = i;
+	RLM3_MEMORY_Scrub_ClearInfo();
+
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer, sizeof(buffer)));
+	buffer[3] = 4;
+	buffer[4] = 3;
+	RLM3_MEMORY_Scrub_Step(sizeof(buffer));
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer);
+
+	RLM3_MEMORY_ScrubInfo info;
+	RLM3_MEMORY_Scrub_GetInfo(&info);
+	ASSERT(info.error_count == 1);
+}
+
+TEST_CASE(MEMORY_Scrub_PartialSteps)
+{
+	static uint32_t buffer[250];
+
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer, sizeof(buffer)));
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == 256);
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == 256);
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == 256);
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == 232);
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == 256);
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer);
+
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == 0);
+}
+
+TEST_CASE(MEMORY_Scrub_RegionTableFull)
+{
+	static uint32_t buffer[RLM3_MEMORY_SCRUB_REGION_COUNT + 1][4];
+
+	for (size_t i = 0; i < RLM3_MEMORY_SCRUB_REGION_COUNT; i++)
+		ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer[i], sizeof(buffer[i])));
+	ASSERT(!RLM3_MEMORY_Scrub_AddRegion(buffer[RLM3_MEMORY_SCRUB_REGION_COUNT], sizeof(buffer[RLM3_MEMORY_SCRUB_REGION_COUNT])));
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer[2]);
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer[RLM3_MEMORY_SCRUB_REGION_COUNT], sizeof(buffer[RLM3_MEMORY_SCRUB_REGION_COUNT])));
+
+	for (size_t i = 0; i <= RLM3_MEMORY_SCRUB_REGION_COUNT; i++)
+		RLM3_MEMORY_Scrub_RemoveRegion(buffer[i]);
+}
+
+TEST_CASE(MEMORY_Scrub_PassVisitsRegionsInOrder)
+{
+	static uint32_t buffer_a[100];
+	static uint32_t buffer_b[30];
+	static uint32_t buffer_c[64];
+	RLM3_MEMORY_Scrub_ClearInfo();
+
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer_a, sizeof(buffer_a)));
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer_b, sizeof(buffer_b)));
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer_c, sizeof(buffer_c)));
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer_b);
+
+	// A step never crosses into the next region, and the removed one is skipped.
+	for (size_t pass = 1; pass <= 2; pass++)
+	{
+		ASSERT(RLM3_MEMORY_Scrub_Step(256) == 256);
+		ASSERT(RLM3_MEMORY_Scrub_Step(256) == 144);
+		ASSERT(RLM3_MEMORY_Scrub_Step(256) == 256);
+		RLM3_MEMORY_ScrubInfo info;
+		RLM3_MEMORY_Scrub_GetInfo(&info);
+		ASSERT(info.pass_count == pass);
+		ASSERT(info.error_count == 0);
+	}
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer_a);
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer_c);
+}
+
+TEST_CASE(MEMORY_Scrub_RemoveRegionInProgress)
+{
+	static uint32_t buffer_a[128];
+	static uint32_t buffer_b[16];
+	for (size_t i = 0; i < 16; i++)
+		buffer_b[i] = i;
+	RLM3_MEMORY_Scrub_ClearInfo();
+
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer_a, sizeof(buffer_a)));
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(buffer_b, sizeof(buffer_b)));
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == 256);
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer_a);
+
+	// The walk starts the next region from its beginning with fresh sums.
+	ASSERT(RLM3_MEMORY_Scrub_Step(256) == sizeof(buffer_b));
+	RLM3_MEMORY_Scrub_RemoveRegion(buffer_b);
+
+	RLM3_MEMORY_ScrubInfo info;
+	RLM3_MEMORY_Scrub_GetInfo(&info);
+	ASSERT(info.pass_count == 1);
+	ASSERT(info.error_count == 0);
+}
+
+TEST_CASE(MEMORY_Scrub_GetBusyTime)
+{
+	ASSERT(RLM3_MEMORY_Scrub_GetBusyTime(100, 100) == 100);
+	ASSERT(RLM3_MEMORY_Scrub_GetBusyTime(100, 25) == 25);
+	ASSERT(RLM3_MEMORY_Scrub_GetBusyTime(100, 1) == 1);
+	ASSERT(RLM3_MEMORY_Scrub_GetBusyTime(10, 5) == 1);
+}
@@ -93,3 +93,53 @@ TEST_CASE(MEMORY_WriteRandomBytes)
 	LOG_ALWAYS("Read Time: %u ms", (int)(read_finish_time - read_start_time));
 }
 
+TEST_CASE(MEMORY_RefreshErrors_HappyCase)
+{
+	RLM3_MEMORY_ClearErrorInfo();
+	RLM3_MEMORY_Init();
+
+	for (size_t i = 0; i < RLM3_EXTERNAL_MEMORY_SIZE; i += 4)
+		*(volatile uint32_t*)(RLM3_EXTERNAL_MEMORY_ADDRESS + i) = i;
+	for (size_t i = 0; i < RLM3_EXTERNAL_MEMORY_SIZE; i += 4)
+		ASSERT(*(volatile uint32_t*)(RLM3_EXTERNAL_MEMORY_ADDRESS + i) == i);
+
+	RLM3_MEMORY_Deinit();
+
+	ASSERT(RLM3_MEMORY_GetRefreshErrorCount() == 0);
+}
+
+static uint32_t MeasureScrubPasses(uint32_t bandwidth_percent, RLM3_Time duration_ms)
+{
+	RLM3_MEMORY_ClearErrorInfo();
+	RLM3_MEMORY_Scrub_Start(bandwidth_percent);
+	ASSERT(RLM3_MEMORY_Scrub_IsRunning());
+	RLM3_Delay(duration_ms);
+	RLM3_MEMORY_Scrub_Stop();
+	ASSERT(!RLM3_MEMORY_Scrub_IsRunning());
+
+	RLM3_MEMORY_ErrorInfo info;
+	RLM3_MEMORY_GetErrorInfo(&info);
+	ASSERT(info.scrub_error_count == 0);
+	return info.scrub_pass_count;
+}
+
+TEST_CASE(MEMORY_Scrub_Task)
+{
+	static const size_t REGION_SIZE = 1024 * 1024;
+
+	RLM3_MEMORY_Init();
+	for (size_t i = 0; i < REGION_SIZE; i += 4)
+		*(uint32_t*)(RLM3_EXTERNAL_MEMORY_ADDRESS + i) = i;
+	ASSERT(RLM3_MEMORY_Scrub_AddRegion(RLM3_EXTERNAL_MEMORY_ADDRESS, REGION_SIZE));
+
+	uint32_t full_passes = MeasureScrubPasses(100, 1000);
+	uint32_t limited_passes = MeasureScrubPasses(20, 1000);
+
+	RLM3_MEMORY_Scrub_RemoveRegion(RLM3_EXTERNAL_MEMORY_ADDRESS);
+	RLM3_MEMORY_Deinit();
+
+	LOG_ALWAYS("Passes: 100%% %u 20%% %u", (int)full_passes, (int)limited_passes);
+	ASSERT(limited_passes >= 1);
+	ASSERT(3 * limited_passes < full_passes);
+	ASSERT(RLM3_MEMORY_GetRefreshErrorCount() == 0);
+}
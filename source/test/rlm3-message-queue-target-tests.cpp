@@ -0,0 +1,65 @@
+#include "Test.hpp"
+#include "rlm3-message-queue.h"
+#include "logger.h"
+#include "FreeRTOS.h"
+#include "queue.h"
+
+
+LOGGER_ZONE(TEST_QUEUE_TARGET);
+
+
+struct TestRecord
+{
+	uint32_t producer;
+	uint32_t sequence;
+	uint8_t extra[6];
+};
+
+static const size_t CAPACITY = 16;
+static RLM3_MessageQueue g_queue;
+static uint32_t g_storage[RLM3_MESSAGE_QUEUE_STORAGE_SIZE(sizeof(TestRecord), CAPACITY) / sizeof(uint32_t)];
+
+
+TEST_CASE(RLM3_MessageQueue_Benchmark)
+{
+	static const size_t COUNT = 1000;
+	static const size_t BATCH = 8;
+	RLM3_MessageQueue_Init(&g_queue, g_storage, sizeof(g_storage), sizeof(TestRecord), CAPACITY);
+	QueueHandle_t baseline = xQueueCreate(CAPACITY, sizeof(TestRecord));
+	ASSERT(baseline != NULL);
+	TestRecord record = {};
+	TestRecord records[BATCH];
+
+	uint32_t start = RLM3_GetCycleCount();
+	for (size_t i = 0; i < COUNT / BATCH; i++)
+	{
+		for (size_t j = 0; j < BATCH; j++)
+			RLM3_MessageQueue_Push(&g_queue, &record);
+		for (size_t j = 0; j < BATCH; j++)
+			RLM3_MessageQueue_TryPop(&g_queue, &record);
+	}
+	uint32_t queue_cycles = RLM3_GetCycleCount() - start;
+
+	start = RLM3_GetCycleCount();
+	for (size_t i = 0; i < COUNT / BATCH; i++)
+	{
+		for (size_t j = 0; j < BATCH; j++)
+			RLM3_MessageQueue_Push(&g_queue, &record);
+		RLM3_MessageQueue_Drain(&g_queue, records, BATCH);
+	}
+	uint32_t drain_cycles = RLM3_GetCycleCount() - start;
+
+	start = RLM3_GetCycleCount();
+	for (size_t i = 0; i < COUNT / BATCH; i++)
+	{
+		for (size_t j = 0; j < BATCH; j++)
+			xQueueSend(baseline, &record, 0);
+		for (size_t j = 0; j < BATCH; j++)
+			xQueueReceive(baseline, &record, 0);
+	}
+	uint32_t baseline_cycles = RLM3_GetCycleCount() - start;
+	vQueueDelete(baseline);
+
+	LOG_ALWAYS("Cycles per record queue: %u drain: %u xQueue: %u", (int)(queue_cycles / COUNT), (int)(drain_cycles / COUNT), (int)(baseline_cycles / COUNT));
+	ASSERT(queue_cycles < baseline_cycles);
+}
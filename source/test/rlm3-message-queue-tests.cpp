@@ -0,0 +1,157 @@
+#include "Test.hpp"
+#include "rlm3-message-queue.h"
+#include "rlm3-timer.h"
+#include "logger.h"
+#include "cmsis_os2.h"
+
+
+LOGGER_ZONE(TEST_QUEUE);
+
+
+typedef void (*TimerFn)();
+extern void SetTimer2Callback(TimerFn timer_fn);
+
+
+struct TestRecord
+{
+	uint32_t producer;
+	uint32_t sequence;
+	uint8_t extra[6];
+};
+
+static const size_t CAPACITY = 16;
+static RLM3_MessageQueue g_queue;
+static uint32_t g_storage[RLM3_MESSAGE_QUEUE_STORAGE_SIZE(sizeof(TestRecord), CAPACITY) / sizeof(uint32_t)];
+
+
+static void InitQueue()
+{
+	RLM3_MessageQueue_Init(&g_queue, g_storage, sizeof(g_storage), sizeof(TestRecord), CAPACITY);
+}
+
+
+TEST_CASE(RLM3_MessageQueue_PushPop_HappyCase)
+{
+	InitQueue();
+
+	TestRecord record = {};
+	ASSERT(!RLM3_MessageQueue_TryPop(&g_queue, &record));
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		TestRecord in = { 7, i, { (uint8_t)i, 1, 2, 3, 4, 5 } };
+		ASSERT(RLM3_MessageQueue_Push(&g_queue, &in));
+	}
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		ASSERT(RLM3_MessageQueue_TryPop(&g_queue, &record));
+		ASSERT(record.producer == 7 && record.sequence == i);
+		ASSERT(record.extra[0] == i && record.extra[5] == 5);
+	}
+	ASSERT(!RLM3_MessageQueue_TryPop(&g_queue, &record));
+}
+
+TEST_CASE(RLM3_MessageQueue_Drain_Batch)
+{
+	InitQueue();
+
+	// Cycle through the storage several times so the sequence numbers wrap around the cells.
+	uint32_t next_push = 0;
+	uint32_t next_pop = 0;
+	TestRecord records[CAPACITY];
+	for (size_t round = 0; round < 10; round++)
+	{
+		for (size_t i = 0; i < 11; i++, next_push++)
+		{
+			TestRecord in = { 0, next_push, {} };
+			ASSERT(RLM3_MessageQueue_Push(&g_queue, &in));
+		}
+		size_t count = RLM3_MessageQueue_Drain(&g_queue, records, 4);
+		ASSERT(count == 4);
+		count += RLM3_MessageQueue_Drain(&g_queue, records + 4, CAPACITY);
+		ASSERT(count == 11);
+		for (size_t i = 0; i < count; i++, next_pop++)
+			ASSERT(records[i].sequence == next_pop);
+	}
+}
+
+TEST_CASE(RLM3_MessageQueue_Push_Full)
+{
+	InitQueue();
+
+	TestRecord record = {};
+	for (size_t i = 0; i < CAPACITY; i++)
+		ASSERT(RLM3_MessageQueue_Push(&g_queue, &record));
+	ASSERT(!RLM3_MessageQueue_Push(&g_queue, &record));
+	ASSERT(RLM3_MessageQueue_GetDroppedCount(&g_queue) == 1);
+
+	ASSERT(RLM3_MessageQueue_TryPop(&g_queue, &record));
+	ASSERT(RLM3_MessageQueue_Push(&g_queue, &record));
+	ASSERT(RLM3_MessageQueue_GetDroppedCount(&g_queue) == 1);
+}
+
+TEST_CASE(RLM3_MessageQueue_Pop_Timeout)
+{
+	InitQueue();
+
+	TestRecord record = {};
+	RLM3_Time start_time = RLM3_GetCurrentTime();
+	ASSERT(!RLM3_MessageQueue_Pop(&g_queue, &record, 10));
+	RLM3_Time elapsed = RLM3_GetCurrentTime() - start_time;
+	ASSERT(10 <= elapsed && elapsed <= 11);
+}
+
+TEST_CASE(RLM3_MessageQueue_MultipleProducers)
+{
+	// Four tasks and an interrupt push numbered records.  Each producer's records must arrive complete and in order.
+	static const size_t TASK_PRODUCERS = 4;
+	static const uint32_t RECORDS_PER_PRODUCER = 2000;
+	static const uint32_t ISR_PRODUCER = TASK_PRODUCERS;
+	static volatile uint32_t g_isr_sequence = 0;
+	InitQueue();
+
+	auto producer_fn = [](void* param)
+	{
+		uint32_t producer = (uint32_t)(uintptr_t)param;
+		for (uint32_t i = 0; i < RECORDS_PER_PRODUCER; )
+		{
+			TestRecord record = { producer, i, {} };
+			if (RLM3_MessageQueue_Push(&g_queue, &record))
+				i++;
+			else
+				::osThreadYield();
+		}
+		::osThreadExit();
+	};
+	SetTimer2Callback([] {
+		TestRecord record = { ISR_PRODUCER, g_isr_sequence, {} };
+		if (g_isr_sequence < RECORDS_PER_PRODUCER && RLM3_MessageQueue_Push(&g_queue, &record))
+			g_isr_sequence++;
+	});
+
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "producer";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityNormal;
+	for (size_t i = 0; i < TASK_PRODUCERS; i++)
+		ASSERT(::osThreadNew(producer_fn, (void*)i, &task_attributes) != nullptr);
+	RLM3_Timer2_Init(20000);
+
+	uint32_t next[TASK_PRODUCERS + 1] = {};
+	size_t remaining = (TASK_PRODUCERS + 1) * RECORDS_PER_PRODUCER;
+	while (remaining > 0)
+	{
+		TestRecord records[8];
+		ASSERT(RLM3_MessageQueue_Pop(&g_queue, &records[0], 100));
+		size_t count = 1 + RLM3_MessageQueue_Drain(&g_queue, &records[1], 7);
+		for (size_t i = 0; i < count; i++)
+		{
+			ASSERT(records[i].producer <= TASK_PRODUCERS);
+			ASSERT(records[i].sequence == next[records[i].producer]);
+			next[records[i].producer]++;
+		}
+		remaining -= count;
+	}
+	RLM3_Timer2_Deinit();
+
+	LOG_ALWAYS("Dropped while full: %u", (int)RLM3_MessageQueue_GetDroppedCount(&g_queue));
+}
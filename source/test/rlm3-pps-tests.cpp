@@ -0,0 +1,78 @@
+#include "Test.hpp"
+#include "rlm3-pps.h"
+#include "main.h"
+
+
+static RLM3_PPS g_pps;
+
+
+TEST_CASE(RLM3_PPS_Unlocked_NoTime)
+{
+	uint64_t gps_ns = 0;
+	RLM3_PPS_Init(&g_pps);
+	ASSERT(!RLM3_PPS_ToGpsTime(&g_pps, 1000, &gps_ns));
+
+	// A label without a rate is not enough.
+	RLM3_PPS_Edge(&g_pps, 1000);
+	RLM3_PPS_SetTime(&g_pps, 50);
+	ASSERT(!RLM3_PPS_IsLocked(&g_pps));
+	ASSERT(!RLM3_PPS_ToGpsTime(&g_pps, 2000, &gps_ns));
+}
+
+TEST_CASE(RLM3_PPS_DriftingClock_Interpolates)
+{
+	// The core clock runs 20 ppm fast, and the counter wraps between the edges.
+	uint32_t cycles_per_second = HAL_RCC_GetHCLKFreq() + HAL_RCC_GetHCLKFreq() / 50000;
+	uint32_t first = 0xFFFF0000;
+	uint32_t second = first + cycles_per_second;
+	RLM3_PPS_Init(&g_pps);
+	RLM3_PPS_Edge(&g_pps, first);
+	RLM3_PPS_Edge(&g_pps, second);
+	RLM3_PPS_SetTime(&g_pps, 1000);
+	ASSERT(RLM3_PPS_IsLocked(&g_pps));
+	ASSERT(g_pps.cycles_per_second == cycles_per_second);
+
+	uint64_t gps_ns = 0;
+	ASSERT(RLM3_PPS_ToGpsTime(&g_pps, second, &gps_ns));
+	ASSERT(gps_ns == 1000000000000ULL);
+	ASSERT(RLM3_PPS_ToGpsTime(&g_pps, second + cycles_per_second / 2, &gps_ns));
+	ASSERT(gps_ns == 1000500000000ULL);
+	ASSERT(RLM3_PPS_ToGpsTime(&g_pps, second - cycles_per_second / 4, &gps_ns));
+	ASSERT(gps_ns == 999750000000ULL);
+
+	// The next edge labels itself.
+	RLM3_PPS_Edge(&g_pps, second + cycles_per_second);
+	ASSERT(RLM3_PPS_ToGpsTime(&g_pps, second + cycles_per_second, &gps_ns));
+	ASSERT(gps_ns == 1001000000000ULL);
+}
+
+TEST_CASE(RLM3_PPS_MissedPulse_CountsSeconds)
+{
+	uint32_t nominal = HAL_RCC_GetHCLKFreq();
+	RLM3_PPS_Init(&g_pps);
+	RLM3_PPS_Edge(&g_pps, 0);
+	RLM3_PPS_Edge(&g_pps, nominal);
+	RLM3_PPS_SetTime(&g_pps, 7);
+	RLM3_PPS_Edge(&g_pps, 4 * nominal);
+
+	uint64_t gps_ns = 0;
+	ASSERT(RLM3_PPS_ToGpsTime(&g_pps, 4 * nominal, &gps_ns));
+	ASSERT(gps_ns == 10000000000ULL);
+	ASSERT(g_pps.rejected_count == 0);
+}
+
+TEST_CASE(RLM3_PPS_Glitch_DropsTime)
+{
+	uint32_t nominal = HAL_RCC_GetHCLKFreq();
+	RLM3_PPS_Init(&g_pps);
+	RLM3_PPS_Edge(&g_pps, 0);
+	RLM3_PPS_Edge(&g_pps, nominal);
+	RLM3_PPS_SetTime(&g_pps, 7);
+
+	// Half a second is no whole number of seconds, so the count of seconds cannot be trusted until the next label.
+	RLM3_PPS_Edge(&g_pps, nominal + nominal / 2);
+	ASSERT(g_pps.rejected_count == 1);
+	ASSERT(!RLM3_PPS_IsLocked(&g_pps));
+	RLM3_PPS_SetTime(&g_pps, 8);
+	ASSERT(RLM3_PPS_IsLocked(&g_pps));
+}
@@ -0,0 +1,198 @@
+#include "Test.hpp"
+#include "rlm3-sync.h"
+#include "rlm3-timer.h"
+#include "cmsis_os2.h"
+
+
+typedef void (*TimerFn)();
+extern void SetTimer2Callback(TimerFn timer_fn);
+
+
+static void StartThreads(osThreadFunc_t thread_fn, void* param, size_t count)
+{
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "secondary_thread";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityNormal;
+	for (size_t i = 0; i < count; i++)
+		ASSERT(::osThreadNew(thread_fn, param, &task_attributes) != nullptr);
+}
+
+
+TEST_CASE(Semaphore_Count_HappyCase)
+{
+	RLM3_Semaphore test;
+	RLM3_Semaphore_Init(&test, 2);
+
+	ASSERT(RLM3_Semaphore_Try(&test, 0));
+	ASSERT(RLM3_Semaphore_Try(&test, 0));
+	ASSERT(!RLM3_Semaphore_Try(&test, 0));
+	ASSERT(!RLM3_Semaphore_Try(&test, 3));
+	RLM3_Semaphore_Give(&test);
+	RLM3_Semaphore_Give(&test);
+	ASSERT(RLM3_Semaphore_GetCount(&test) == 2);
+	RLM3_Semaphore_Take(&test);
+	ASSERT(RLM3_Semaphore_GetCount(&test) == 1);
+
+	RLM3_Semaphore_Deinit(&test);
+}
+
+TEST_CASE(Semaphore_MultipleThreads_Wake)
+{
+	static RLM3_Semaphore test;
+	static volatile size_t g_count = 0;
+	auto secondary_thread_fn = [](void* param)
+	{
+		RLM3_Semaphore_Take(&test);
+		g_count++;
+		::osThreadExit();
+	};
+
+	RLM3_Semaphore_Init(&test, 0);
+	g_count = 0;
+	StartThreads(secondary_thread_fn, nullptr, 4);
+	::osDelay(2);
+	ASSERT(g_count == 0);
+
+	RLM3_Semaphore_Give(&test);
+	::osDelay(2);
+	ASSERT(g_count == 1);
+	for (size_t i = 0; i < 3; i++)
+		RLM3_Semaphore_Give(&test);
+	::osDelay(2);
+	ASSERT(g_count == 4);
+	ASSERT(RLM3_Semaphore_GetCount(&test) == 0);
+
+	RLM3_Semaphore_Deinit(&test);
+}
+
+TEST_CASE(Semaphore_GiveFromISR_HappyCase)
+{
+	static RLM3_Semaphore test;
+	RLM3_Semaphore_Init(&test, 0);
+	SetTimer2Callback([] { RLM3_Semaphore_GiveFromISR(&test); });
+
+	RLM3_Timer2_Init(1000);
+	for (size_t i = 0; i < 20; i++)
+		ASSERT(RLM3_Semaphore_Try(&test, 5));
+	RLM3_Timer2_Deinit();
+
+	RLM3_Semaphore_Deinit(&test);
+}
+
+TEST_CASE(EventFlags_WaitAnyAll_HappyCase)
+{
+	RLM3_EventFlags test;
+	RLM3_EventFlags_Init(&test);
+
+	ASSERT(RLM3_EventFlags_WaitAny(&test, 0x3, 0) == 0);
+	RLM3_EventFlags_Set(&test, 0x2);
+	ASSERT(RLM3_EventFlags_WaitAny(&test, 0x3, 0) == 0x2);
+	ASSERT(RLM3_EventFlags_WaitAll(&test, 0x3, 3) == 0);
+	RLM3_EventFlags_Set(&test, 0x1);
+	ASSERT(RLM3_EventFlags_WaitAll(&test, 0x3, 0) == 0x3);
+	RLM3_EventFlags_Clear(&test, 0x2);
+	ASSERT(RLM3_EventFlags_Get(&test) == 0x1);
+
+	RLM3_EventFlags_Deinit(&test);
+}
+
+TEST_CASE(EventFlags_MultipleThreads_Broadcast)
+{
+	static RLM3_EventFlags test;
+	static volatile size_t g_count = 0;
+	auto secondary_thread_fn = [](void* param)
+	{
+		if (RLM3_EventFlags_WaitAll(&test, 0x11, RLM3_WAIT_FOREVER) == 0x11)
+			g_count++;
+		::osThreadExit();
+	};
+
+	RLM3_EventFlags_Init(&test);
+	g_count = 0;
+	StartThreads(secondary_thread_fn, nullptr, 4);
+	::osDelay(2);
+	RLM3_EventFlags_Set(&test, 0x10);
+	::osDelay(2);
+	ASSERT(g_count == 0);
+
+	RLM3_EventFlags_Set(&test, 0x01);
+	::osDelay(2);
+	ASSERT(g_count == 4);
+
+	RLM3_EventFlags_Deinit(&test);
+}
+
+TEST_CASE(EventFlags_SetFromISR_HappyCase)
+{
+	static RLM3_EventFlags test;
+	RLM3_EventFlags_Init(&test);
+	SetTimer2Callback([] { RLM3_EventFlags_SetFromISR(&test, 0x4); });
+
+	RLM3_Timer2_Init(1000);
+	for (size_t i = 0; i < 20; i++)
+	{
+		ASSERT(RLM3_EventFlags_WaitAny(&test, 0x4, 5) == 0x4);
+		RLM3_EventFlags_Clear(&test, 0x4);
+	}
+	RLM3_Timer2_Deinit();
+
+	RLM3_EventFlags_Deinit(&test);
+}
+
+TEST_CASE(CondVar_Signal_HappyCase)
+{
+	static RLM3_MutexLock g_lock;
+	static RLM3_CondVar test;
+	static volatile size_t g_ready = 0;
+	static volatile size_t g_count = 0;
+	auto secondary_thread_fn = [](void* param)
+	{
+		RLM3_MutexLock_Enter(&g_lock);
+		while (g_ready == 0)
+			RLM3_CondVar_Wait(&test, &g_lock);
+		g_ready--;
+		g_count++;
+		RLM3_MutexLock_Leave(&g_lock);
+		::osThreadExit();
+	};
+
+	RLM3_MutexLock_Init(&g_lock);
+	RLM3_CondVar_Init(&test);
+	g_ready = 0;
+	g_count = 0;
+	StartThreads(secondary_thread_fn, nullptr, 4);
+	::osDelay(2);
+
+	RLM3_MutexLock_Enter(&g_lock);
+	g_ready = 1;
+	RLM3_CondVar_Signal(&test);
+	RLM3_MutexLock_Leave(&g_lock);
+	::osDelay(2);
+	ASSERT(g_count == 1);
+
+	RLM3_MutexLock_Enter(&g_lock);
+	g_ready = 3;
+	RLM3_CondVar_Broadcast(&test);
+	RLM3_MutexLock_Leave(&g_lock);
+	::osDelay(2);
+	ASSERT(g_count == 4);
+
+	RLM3_CondVar_Deinit(&test);
+	RLM3_MutexLock_Deinit(&g_lock);
+}
+
+TEST_CASE(CondVar_Try_Timeout)
+{
+	RLM3_MutexLock lock;
+	RLM3_CondVar test;
+	RLM3_MutexLock_Init(&lock);
+	RLM3_CondVar_Init(&test);
+
+	RLM3_MutexLock_Enter(&lock);
+	ASSERT(!RLM3_CondVar_Try(&test, &lock, 3));
+	RLM3_MutexLock_Leave(&lock);
+
+	RLM3_CondVar_Deinit(&test);
+	RLM3_MutexLock_Deinit(&lock);
+}
@@ -4,6 +4,8 @@
 #include <algorithm>
 #include "logger.h"
 #include "cmsis_os2.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include "rlm3-timer.h"
 
 
@@ -305,6 +307,157 @@ TEST_CASE(Task_TakeUntil_Timeout)
 	ASSERT(end_time == target_time);
 }
 
+TEST_CASE(Task_Signal_WaitAny)
+{
+	RLM3_Task self = RLM3_GetCurrentTask();
+	RLM3_Signal(self, 0x01 | 0x04);
+
+	ASSERT(RLM3_WaitAny(0x04 | 0x08, 0) == 0x04);
+	ASSERT(RLM3_WaitAny(0x01 | 0x02, 0) == 0x01);
+
+	RLM3_Time start_time = RLM3_GetCurrentTime();
+	ASSERT(RLM3_WaitAny(0x01 | 0x04, 10) == 0);
+	RLM3_Time elapsed = RLM3_GetCurrentTime() - start_time;
+	ASSERT(10 <= elapsed && elapsed <= 11);
+}
+
+TEST_CASE(Task_Signal_WaitAll)
+{
+	RLM3_Task self = RLM3_GetCurrentTask();
+	RLM3_Signal(self, 0x01);
+
+	ASSERT(RLM3_WaitAll(0x03, 2) == 0);
+	RLM3_Signal(self, 0x02 | 0x10);
+	ASSERT(RLM3_WaitAll(0x03, 0) == 0x03);
+	ASSERT(RLM3_WaitAll(0x03, 0) == 0);
+	ASSERT(RLM3_WaitAny(0x10, 0) == 0x10);
+}
+
+TEST_CASE(Task_Signal_WithGive)
+{
+	// Signals and gives do not consume each other.
+	RLM3_Task self = RLM3_GetCurrentTask();
+	RLM3_Signal(self, 0x01);
+	ASSERT(!RLM3_TakeWithTimeout(0));
+	RLM3_Give(self);
+	ASSERT(RLM3_WaitAny(0x01, 0) == 0x01);
+	ASSERT(RLM3_TakeWithTimeout(0));
+	ASSERT(RLM3_WaitAny(RLM3_SIGNAL_GIVE - 1, 0) == 0);
+}
+
+TEST_CASE(Task_Signal_FromISR)
+{
+	static RLM3_Task g_target_task = NULL;
+	static volatile uint32_t g_count = 0;
+	g_target_task = RLM3_GetCurrentTask();
+	g_count = 0;
+	SetTimer2Callback([] { RLM3_SignalFromISR(g_target_task, 1UL << (g_count++ % 3)); });
+	RLM3_Timer2_Init(1000);
+
+	uint32_t seen = 0;
+	while (seen != 0x07)
+	{
+		uint32_t fired = RLM3_WaitAny(0x07, 10);
+		ASSERT(fired != 0);
+		seen |= fired;
+	}
+	ASSERT(RLM3_WaitAll(0x07, 10) == 0x07);
+
+	RLM3_Timer2_Deinit();
+}
+
+static const size_t BENCHMARK_EVENT_COUNT = 3;
+static RLM3_Task g_benchmark_tasks[BENCHMARK_EVENT_COUNT] = {};
+static volatile uint32_t g_benchmark_event_cycles[BENCHMARK_EVENT_COUNT] = {};
+static volatile uint32_t g_benchmark_latency_total = 0;
+static volatile uint32_t g_benchmark_handled = 0;
+static volatile bool g_benchmark_is_single = false;
+static volatile bool g_benchmark_stop = false;
+static volatile uint32_t g_benchmark_exited = 0;
+
+static void BenchmarkHandleEvent(size_t event)
+{
+	g_benchmark_latency_total += RLM3_GetCycleCount() - g_benchmark_event_cycles[event];
+	g_benchmark_handled++;
+}
+
+static void BenchmarkExitTask()
+{
+	RLM3_EnterCritical();
+	g_benchmark_exited++;
+	RLM3_ExitCritical();
+	::osThreadExit();
+}
+
+static void BenchmarkSingleTask(void* param)
+{
+	while (!g_benchmark_stop)
+	{
+		uint32_t fired = RLM3_WaitAny((1UL << BENCHMARK_EVENT_COUNT) - 1, 10);
+		for (size_t i = 0; i < BENCHMARK_EVENT_COUNT; i++)
+			if ((fired & (1UL << i)) != 0)
+				BenchmarkHandleEvent(i);
+	}
+	BenchmarkExitTask();
+}
+
+static void BenchmarkBlockingTask(void* param)
+{
+	while (!g_benchmark_stop)
+		if (RLM3_TakeWithTimeout(10))
+			BenchmarkHandleEvent((size_t)param);
+	BenchmarkExitTask();
+}
+
+TEST_CASE(Task_Signal_Benchmark)
+{
+	// One task waiting on three event bits against three tasks each blocking on their own event.
+	static const size_t ROUNDS = 200;
+	SetTimer2Callback([] {
+		for (size_t i = 0; i < BENCHMARK_EVENT_COUNT; i++)
+		{
+			g_benchmark_event_cycles[i] = RLM3_GetCycleCount();
+			if (g_benchmark_is_single)
+				RLM3_SignalFromISR(g_benchmark_tasks[0], 1UL << i);
+			else
+				RLM3_GiveFromISR(g_benchmark_tasks[i]);
+		}
+	});
+
+	osThreadAttr_t task_attributes = {};
+	task_attributes.name = "event";
+	task_attributes.stack_size = 128 * 4;
+	task_attributes.priority = osPriorityAboveNormal;
+
+	uint32_t average[2] = {};
+	for (size_t mode = 0; mode < 2; mode++)
+	{
+		g_benchmark_is_single = (mode == 0);
+		g_benchmark_stop = false;
+		g_benchmark_exited = 0;
+		g_benchmark_latency_total = 0;
+		g_benchmark_handled = 0;
+		size_t task_count = g_benchmark_is_single ? 1 : BENCHMARK_EVENT_COUNT;
+		for (size_t i = 0; i < task_count; i++)
+		{
+			g_benchmark_tasks[i] = ::osThreadNew(g_benchmark_is_single ? BenchmarkSingleTask : BenchmarkBlockingTask, (void*)i, &task_attributes);
+			ASSERT(g_benchmark_tasks[i] != nullptr);
+		}
+
+		RLM3_Timer2_Init(1000);
+		while (g_benchmark_handled < ROUNDS * BENCHMARK_EVENT_COUNT)
+			RLM3_Delay(1);
+		RLM3_Timer2_Deinit();
+		average[mode] = g_benchmark_latency_total / g_benchmark_handled;
+
+		g_benchmark_stop = true;
+		while (g_benchmark_exited < task_count)
+			RLM3_Delay(1);
+	}
+
+	LOG_ALWAYS("Event latency cycles one task: %u three tasks: %u", (int)average[0], (int)average[1]);
+}
+
 TEST_CASE(Task_EnterCritical)
 {
 	static volatile uint32_t g_count = 0;
@@ -332,3 +485,25 @@ TEST_CASE(Task_EnterCriticalFromISR)
 	RLM3_Delay(10);
 	RLM3_Timer2_Deinit();
 }
+
+TEST_CASE(Task_ISR_Scope_HappyCase)
+{
+	// Gives inside a scope still wake the task.  The switch happens once the outermost scope ends.
+	static RLM3_Task g_task = NULL;
+	static volatile size_t g_count = 0;
+	g_task = RLM3_GetCurrentTask();
+	g_count = 0;
+	SetTimer2Callback([] {
+		if (g_count++ != 0)
+			return;
+		RLM3_ISR_Begin();
+		RLM3_GiveFromISR(g_task);
+		RLM3_GiveFromISR(g_task);
+		RLM3_ISR_End();
+	});
+
+	RLM3_Timer2_Init(1000);
+	ASSERT(RLM3_TakeWithTimeout(10));
+	RLM3_Timer2_Deinit();
+	ASSERT(!RLM3_TakeWithTimeout(0));
+}
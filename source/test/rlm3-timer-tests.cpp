@@ -42,9 +42,262 @@ TEST_CASE(RLM3_Timer2_HappyCase)
 	ASSERT(g_count >= 498 && g_count <= 502);
 }
 
+TEST_CASE(RLM3_Timer_ComputeClock_HappyCase)
+{
+	ASSERT(RLM3_Timer_ComputeClock(45000000, 1, false) == 45000000);
+	ASSERT(RLM3_Timer_ComputeClock(45000000, 4, false) == 90000000);
+	ASSERT(RLM3_Timer_ComputeClock(22500000, 8, false) == 45000000);
+	ASSERT(RLM3_Timer_ComputeClock(45000000, 4, true) == 180000000);
+	ASSERT(RLM3_Timer_ComputeClock(22500000, 8, true) == 90000000);
+}
+
+TEST_CASE(RLM3_Timer_ComputeReload_HappyCase)
+{
+	ASSERT(RLM3_Timer_ComputeReload(90000000, 5000) == 17999);
+	ASSERT(RLM3_Timer_ComputeReload(90000000, 1000) == 89999);
+	ASSERT(RLM3_Timer_ComputeReload(90000000, 7) == 12857142);
+	ASSERT(RLM3_Timer_ComputeReload(90000000, 90000000) == 0);
+	ASSERT(RLM3_Timer_ComputeReload(90000000, 45000001) == 1);
+}
+
+TEST_CASE(RLM3_Timer_UpdateReload_Simulated)
+{
+	TIM_TypeDef timer = {};
+	timer.CR1 = TIM_CR1_CEN;
+	timer.ARR = 1000;
+	timer.CNT = 900;
+
+	RLM3_Timer_UpdateReload(&timer, 500);
+
+	ASSERT(timer.CR1 == (TIM_CR1_CEN | TIM_CR1_ARPE));
+	ASSERT(timer.ARR == 500);
+	ASSERT(timer.CNT == 900);
+}
+
+TEST_CASE(RLM3_Timer_ScheduleCompare_Simulated)
+{
+	TIM_TypeDef timer = {};
+	timer.CNT = 1000;
+
+	ASSERT(RLM3_Timer_ScheduleCompare(&timer, 1500));
+	ASSERT(timer.CCR1 == 1500);
+	ASSERT(timer.DIER == TIM_DIER_CC1IE);
+	ASSERT(timer.EGR == 0);
+
+	// Rescheduling to a time the counter already reached forces the event.
+	timer.CNT = 1600;
+	ASSERT(!RLM3_Timer_ScheduleCompare(&timer, 1600));
+	ASSERT(timer.CCR1 == 1600);
+	ASSERT(timer.EGR == TIM_EGR_CC1G);
+
+	// Times across the counter wrap are still in the future.
+	timer.EGR = 0;
+	timer.CNT = 0xFFFFFF00;
+	ASSERT(RLM3_Timer_ScheduleCompare(&timer, 0x00000100));
+	ASSERT(timer.EGR == 0);
+
+	// The horizon is the last time still ahead.  One tick further looks passed.
+	timer.CNT = 1000;
+	ASSERT(RLM3_Timer_ScheduleCompare(&timer, 1000 + RLM3_TIMER_COMPARE_MAX_AHEAD));
+	ASSERT(timer.EGR == 0);
+	ASSERT(!RLM3_Timer_ScheduleCompare(&timer, 1000 + RLM3_TIMER_COMPARE_MAX_AHEAD + 1));
+	ASSERT(timer.EGR == TIM_EGR_CC1G);
+}
+
+TEST_CASE(RLM3_Timer2_GetClockFrequency_HappyCase)
+{
+	ASSERT(RLM3_Timer2_GetClockFrequency() == 90000000);
+}
+
+TEST_CASE(RLM3_Timer2_SetFrequency_HappyCase)
+{
+	static size_t g_count = 0;
+	SetTimer2Callback([] { g_count++; });
+
+	RLM3_Timer2_Init(1000);
+	RLM3_Delay(50);
+	RLM3_Timer2_SetFrequency(5000);
+	size_t switch_count = g_count;
+	RLM3_Delay(100);
+	RLM3_Timer2_Deinit();
+
+	size_t fast_count = g_count - switch_count;
+	ASSERT(switch_count >= 49 && switch_count <= 52);
+	ASSERT(fast_count >= 498 && fast_count <= 502);
+}
+
+TEST_CASE(RLM3_Timer2_ScheduleAt_HappyCase)
+{
+	static volatile uint32_t g_event_cycles[3] = {};
+	static volatile size_t g_count = 0;
+	SetTimer2Callback([] {
+		if (g_count < 3)
+			g_event_cycles[g_count] = RLM3_Timer2_GetCycles();
+		g_count++;
+	});
+
+	RLM3_Timer2_InitOneShot();
+	uint32_t start = RLM3_Timer2_GetCycles();
+	RLM3_Timer2_ScheduleAt(start + 90000);
+	RLM3_Delay(2);
+	RLM3_Timer2_ScheduleAt(start + 900000);
+	RLM3_Timer2_ScheduleAt(start + 450000);
+	RLM3_Delay(10);
+	RLM3_Timer2_ScheduleAt(RLM3_Timer2_GetCycles() - 1);
+	RLM3_Delay(1);
+	RLM3_Timer2_Deinit();
+
+	ASSERT(g_count == 3);
+	ASSERT(g_event_cycles[0] - start >= 90000 && g_event_cycles[0] - start < 90000 + 500);
+	ASSERT(g_event_cycles[1] - start >= 450000 && g_event_cycles[1] - start < 450000 + 500);
+}
+
+TEST_CASE(RLM3_Timer2_ScheduleAfter_HappyCase)
+{
+	static volatile uint32_t g_event_cycles = 0;
+	static volatile size_t g_count = 0;
+	g_count = 0;
+	SetTimer2Callback([] {
+		g_event_cycles = RLM3_Timer2_GetCycles();
+		g_count++;
+	});
+
+	RLM3_Timer2_InitOneShot();
+	uint32_t start = RLM3_Timer2_GetCycles();
+	RLM3_Timer2_ScheduleAfter(90000);
+	RLM3_Delay(2);
+	RLM3_Timer2_Deinit();
+
+	ASSERT(g_count == 1);
+	ASSERT(g_event_cycles - start >= 90000 && g_event_cycles - start < 90000 + 500);
+}
+
+TEST_CASE(RLM3_Timer2_Capture_HappyCase)
+{
+	RLM3_Timer2_InitOneShot();
+	RLM3_Timer2_Capture_Start(3, RLM3_TIMER2_CAPTURE_RISING, RLM3_GetCurrentTask());
+	ASSERT(RLM3_Timer2_Capture_IsActive(3));
+
+	// A software capture event latches the counter the same way an edge on the pin would.
+	for (size_t i = 0; i < RLM3_CAPTURE_BATCH_SIZE; i++)
+	{
+		TIM2->EGR = TIM_EGR_CC3G;
+		RLM3_Delay(2);
+	}
+	ASSERT(RLM3_TakeWithTimeout(100));
+
+	const RLM3_CaptureBatch* batch = RLM3_Timer2_Capture_Acquire(3);
+	ASSERT(batch != nullptr);
+	ASSERT(batch->count == RLM3_CAPTURE_BATCH_SIZE);
+	for (size_t i = 1; i < batch->count; i++)
+		ASSERT(batch->timestamps[i] - batch->timestamps[i - 1] >= 45000);
+	RLM3_Timer2_Capture_Release(3);
+	ASSERT(RLM3_Timer2_Capture_GetDroppedCount(3) == 0);
+
+	TIM2->EGR = TIM_EGR_CC3G;
+	RLM3_Delay(2);
+	RLM3_Timer2_Capture_Flush(3);
+	batch = RLM3_Timer2_Capture_Acquire(3);
+	ASSERT(batch != nullptr && batch->count == 1);
+	RLM3_Timer2_Capture_Release(3);
+
+	RLM3_Timer2_Capture_Stop(3);
+	ASSERT(!RLM3_Timer2_Capture_IsActive(3));
+	RLM3_Timer2_Deinit();
+}
+
+TEST_CASE(RLM3_Timer2_Wheel_Lifecycle)
+{
+	ASSERT(!RLM3_Timer2_Wheel_IsInit());
+	RLM3_Timer2_Wheel_Init();
+	ASSERT(RLM3_Timer2_Wheel_IsInit());
+	RLM3_Timer2_Wheel_Deinit();
+	ASSERT(!RLM3_Timer2_Wheel_IsInit());
+	ASSERT(!RLM3_Timer2_IsInit());
+}
+
+TEST_CASE(RLM3_Timer2_Wheel_OneShot)
+{
+	static volatile uint32_t g_fire_time = 0;
+	static volatile size_t g_fire_count = 0;
+	auto callback = [](RLM3_TimerWheel_Entry* entry, void* context)
+	{
+		g_fire_time = RLM3_Timer2_Wheel_GetTime();
+		g_fire_count++;
+	};
+
+	RLM3_Timer2_Wheel_Init();
+	RLM3_TimerWheel_Entry entry;
+	RLM3_TimerWheel_InitEntry(&entry, callback, nullptr, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+	uint32_t start_time = RLM3_Timer2_Wheel_GetTime();
+	RLM3_Timer2_Wheel_Start(&entry, 2500, 0);
+	RLM3_Delay(10);
+	RLM3_Timer2_Wheel_Deinit();
+
+	uint32_t elapsed = g_fire_time - start_time;
+	ASSERT(g_fire_count == 1);
+	ASSERT(elapsed >= 2500 && elapsed <= 2510);
+}
+
+TEST_CASE(RLM3_Timer2_Wheel_ManyPeriodic)
+{
+	static const size_t COUNT = 100;
+	static volatile size_t g_counts[COUNT] = {};
+	static RLM3_TimerWheel_Entry g_entries[COUNT];
+	auto callback = [](RLM3_TimerWheel_Entry* entry, void* context)
+	{
+		g_counts[(size_t)context]++;
+	};
+
+	RLM3_Timer2_Wheel_Init();
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		RLM3_TimerWheel_InitEntry(&g_entries[i], callback, (void*)i, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+		RLM3_Timer2_Wheel_Start(&g_entries[i], 1000, 1000 * (i % 10 + 1));
+	}
+	RLM3_Delay(100);
+	for (size_t i = 0; i < COUNT; i++)
+		RLM3_Timer2_Wheel_Cancel(&g_entries[i]);
+	RLM3_Timer2_Wheel_Deinit();
+
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		size_t expected = 100 / (i % 10 + 1);
+		ASSERT(g_counts[i] + 1 >= expected && g_counts[i] <= expected + 1);
+	}
+}
+
+TEST_CASE(RLM3_Timer2_Wheel_Deferred)
+{
+	static volatile size_t g_count = 0;
+	static volatile bool g_is_task = false;
+	auto callback = [](RLM3_TimerWheel_Entry* entry, void* context)
+	{
+		g_is_task = !RLM3_IsIRQ();
+		g_count++;
+	};
+
+	RLM3_Timer2_Wheel_Init();
+	RLM3_Timer2_Wheel_SetDeferredTask(RLM3_GetCurrentTask());
+	RLM3_TimerWheel_Entry entry;
+	RLM3_TimerWheel_InitEntry(&entry, callback, nullptr, RLM3_TIMER_WHEEL_DISPATCH_TASK);
+	RLM3_Timer2_Wheel_Start(&entry, 500, 0);
+
+	bool was_woken = RLM3_TakeWithTimeout(10);
+	size_t run_count = RLM3_Timer2_Wheel_RunDeferred();
+	RLM3_Timer2_Wheel_Deinit();
+
+	ASSERT(was_woken);
+	ASSERT(run_count == 1);
+	ASSERT(g_count == 1);
+	ASSERT(g_is_task);
+}
+
 TEST_TEARDOWN(TIMER_CLEANUP)
 {
 	g_timer_fn = nullptr;
+	if (RLM3_Timer2_Wheel_IsInit())
+		RLM3_Timer2_Wheel_Deinit();
 	if (RLM3_Timer2_IsInit())
 		RLM3_Timer2_Deinit();
 }
@@ -0,0 +1,251 @@
+#include "Test.hpp"
+#include "rlm3-timer-wheel.h"
+#include <vector>
+
+
+struct FiredEvent
+{
+	int id;
+	uint32_t time;
+};
+
+static RLM3_TimerWheel g_wheel;
+static uint32_t g_now = 0;
+static std::vector<FiredEvent> g_fired;
+
+
+static void RecordCallback(RLM3_TimerWheel_Entry* entry, void* context)
+{
+	g_fired.push_back({ (int)(intptr_t)context, g_now });
+}
+
+static void ResetWheel(uint32_t now)
+{
+	g_now = now;
+	g_fired.clear();
+	RLM3_TimerWheel_Init(&g_wheel, now);
+}
+
+static void AdvanceTo(uint32_t target)
+{
+	// Simulate a tickless clock that only wakes up when the wheel asks for it.
+	while (g_now != target)
+	{
+		uint32_t next = target;
+		uint32_t expiry = 0;
+		if (RLM3_TimerWheel_GetNextExpiry(&g_wheel, &expiry) && expiry - g_now <= target - g_now)
+			next = expiry;
+		g_now = next;
+		RLM3_TimerWheel_Advance(&g_wheel, g_now);
+	}
+}
+
+
+TEST_CASE(TimerWheel_OneShot_HappyCase)
+{
+	ResetWheel(0);
+	RLM3_TimerWheel_Entry entry;
+	RLM3_TimerWheel_InitEntry(&entry, RecordCallback, (void*)1, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+
+	RLM3_TimerWheel_Schedule(&g_wheel, &entry, 100, 0);
+	ASSERT(RLM3_TimerWheel_IsScheduled(&entry));
+	AdvanceTo(99);
+	ASSERT(g_fired.empty());
+	AdvanceTo(100);
+	ASSERT(g_fired.size() == 1);
+	ASSERT(g_fired[0].id == 1 && g_fired[0].time == 100);
+	ASSERT(!RLM3_TimerWheel_IsScheduled(&entry));
+	AdvanceTo(10000);
+	ASSERT(g_fired.size() == 1);
+}
+
+TEST_CASE(TimerWheel_Periodic_HappyCase)
+{
+	ResetWheel(5);
+	RLM3_TimerWheel_Entry entry;
+	RLM3_TimerWheel_InitEntry(&entry, RecordCallback, (void*)2, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+
+	RLM3_TimerWheel_Schedule(&g_wheel, &entry, 15, 250);
+	AdvanceTo(1015);
+
+	ASSERT(g_fired.size() == 5);
+	for (size_t i = 0; i < 5; i++)
+		ASSERT(g_fired[i].time == 15 + 250 * i);
+	ASSERT(RLM3_TimerWheel_IsScheduled(&entry));
+	RLM3_TimerWheel_Cancel(&g_wheel, &entry);
+	ASSERT(!RLM3_TimerWheel_IsScheduled(&entry));
+}
+
+TEST_CASE(TimerWheel_Cancel_HappyCase)
+{
+	ResetWheel(0);
+	RLM3_TimerWheel_Entry entries[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		RLM3_TimerWheel_InitEntry(&entries[i], RecordCallback, (void*)i, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+		RLM3_TimerWheel_Schedule(&g_wheel, &entries[i], 50, 0);
+	}
+
+	RLM3_TimerWheel_Cancel(&g_wheel, &entries[1]);
+	AdvanceTo(50);
+
+	ASSERT(g_fired.size() == 2);
+	ASSERT(g_fired[0].id != 1 && g_fired[1].id != 1);
+}
+
+TEST_CASE(TimerWheel_Reschedule)
+{
+	ResetWheel(0);
+	RLM3_TimerWheel_Entry entry;
+	RLM3_TimerWheel_InitEntry(&entry, RecordCallback, (void*)3, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+
+	RLM3_TimerWheel_Schedule(&g_wheel, &entry, 1000000, 0);
+	RLM3_TimerWheel_Schedule(&g_wheel, &entry, 20, 0);
+	AdvanceTo(2000000);
+
+	ASSERT(g_fired.size() == 1);
+	ASSERT(g_fired[0].time == 20);
+}
+
+TEST_CASE(TimerWheel_LongDelays)
+{
+	ResetWheel(0);
+	static const uint32_t DELAYS[] = { 63, 64, 4095, 4096, 262143, 262144, 16777216, 1073741823, 1073741824, RLM3_TIMER_WHEEL_MAX_DELAY };
+	static const size_t COUNT = sizeof(DELAYS) / sizeof(DELAYS[0]);
+	RLM3_TimerWheel_Entry entries[COUNT];
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		RLM3_TimerWheel_InitEntry(&entries[i], RecordCallback, (void*)i, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+		RLM3_TimerWheel_Schedule(&g_wheel, &entries[i], DELAYS[i], 0);
+	}
+
+	AdvanceTo(RLM3_TIMER_WHEEL_MAX_DELAY);
+
+	ASSERT(g_fired.size() == COUNT);
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		ASSERT(g_fired[i].id == (int)i);
+		ASSERT(g_fired[i].time == DELAYS[i]);
+	}
+}
+
+TEST_CASE(TimerWheel_ClockWrap)
+{
+	ResetWheel(0xFFFFFF00);
+	RLM3_TimerWheel_Entry entry;
+	RLM3_TimerWheel_InitEntry(&entry, RecordCallback, (void*)4, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+
+	RLM3_TimerWheel_Schedule(&g_wheel, &entry, 0xFFFFFF80, 0x100);
+	AdvanceTo(0x00000280);
+
+	ASSERT(g_fired.size() == 4);
+	ASSERT(g_fired[0].time == 0xFFFFFF80);
+	ASSERT(g_fired[1].time == 0x00000080);
+	ASSERT(g_fired[2].time == 0x00000180);
+	ASSERT(g_fired[3].time == 0x00000280);
+}
+
+TEST_CASE(TimerWheel_LargeAdvance)
+{
+	// Advancing past several expirations at once must still expire entries in order.
+	ResetWheel(0);
+	RLM3_TimerWheel_Entry entries[4];
+	static const uint32_t EXPIRIES[] = { 300000, 7, 4100, 70 };
+	for (size_t i = 0; i < 4; i++)
+	{
+		RLM3_TimerWheel_InitEntry(&entries[i], RecordCallback, (void*)i, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+		RLM3_TimerWheel_Schedule(&g_wheel, &entries[i], EXPIRIES[i], 0);
+	}
+
+	g_now = 500000;
+	RLM3_TimerWheel_Advance(&g_wheel, g_now);
+
+	ASSERT(g_fired.size() == 4);
+	ASSERT(g_fired[0].id == 1);
+	ASSERT(g_fired[1].id == 3);
+	ASSERT(g_fired[2].id == 2);
+	ASSERT(g_fired[3].id == 0);
+}
+
+TEST_CASE(TimerWheel_Deferred)
+{
+	ResetWheel(0);
+	RLM3_TimerWheel_Entry deferred;
+	RLM3_TimerWheel_Entry immediate;
+	RLM3_TimerWheel_InitEntry(&deferred, RecordCallback, (void*)5, RLM3_TIMER_WHEEL_DISPATCH_TASK);
+	RLM3_TimerWheel_InitEntry(&immediate, RecordCallback, (void*)6, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+	RLM3_TimerWheel_Schedule(&g_wheel, &deferred, 10, 10);
+	RLM3_TimerWheel_Schedule(&g_wheel, &immediate, 10, 0);
+
+	ASSERT(!RLM3_TimerWheel_Advance(&g_wheel, 9));
+	ASSERT(RLM3_TimerWheel_Advance(&g_wheel, 10));
+	ASSERT(g_fired.size() == 1 && g_fired[0].id == 6);
+
+	// A deferred entry that expires again before it runs is only reported once.
+	ASSERT(RLM3_TimerWheel_Advance(&g_wheel, 35));
+	RLM3_TimerWheel_Entry* entry = RLM3_TimerWheel_PopDeferred(&g_wheel);
+	ASSERT(entry == &deferred);
+	ASSERT(RLM3_TimerWheel_PopDeferred(&g_wheel) == nullptr);
+
+	// Cancelling removes a pending deferred callback.
+	ASSERT(RLM3_TimerWheel_Advance(&g_wheel, 40));
+	RLM3_TimerWheel_Cancel(&g_wheel, &deferred);
+	ASSERT(RLM3_TimerWheel_PopDeferred(&g_wheel) == nullptr);
+	ASSERT(!RLM3_TimerWheel_Advance(&g_wheel, 100));
+}
+
+TEST_CASE(TimerWheel_Collect)
+{
+	ResetWheel(0);
+	RLM3_TimerWheel_Entry entries[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		RLM3_TimerWheel_InitEntry(&entries[i], RecordCallback, (void*)i, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+		RLM3_TimerWheel_Schedule(&g_wheel, &entries[i], 10 + (uint32_t)i, (i == 0) ? 5 : 0);
+	}
+
+	// Nothing is called while collecting.  The entries come back in the order they expired.
+	ASSERT(!RLM3_TimerWheel_Collect(&g_wheel, 12));
+	ASSERT(g_fired.empty());
+	ASSERT(RLM3_TimerWheel_IsScheduled(&entries[2]));
+	RLM3_TimerWheel_Cancel(&g_wheel, &entries[1]);
+	ASSERT(RLM3_TimerWheel_PopExpired(&g_wheel) == &entries[0]);
+	ASSERT(RLM3_TimerWheel_PopExpired(&g_wheel) == &entries[2]);
+	ASSERT(RLM3_TimerWheel_PopExpired(&g_wheel) == nullptr);
+	ASSERT(!RLM3_TimerWheel_IsScheduled(&entries[2]));
+
+	// A repeating entry is rescheduled when it is collected.
+	ASSERT(RLM3_TimerWheel_IsScheduled(&entries[0]));
+	ASSERT(!RLM3_TimerWheel_Collect(&g_wheel, 15));
+	ASSERT(RLM3_TimerWheel_PopExpired(&g_wheel) == &entries[0]);
+	RLM3_TimerWheel_Cancel(&g_wheel, &entries[0]);
+}
+
+TEST_CASE(TimerWheel_ManyEntries)
+{
+	static const size_t COUNT = 2000;
+	static RLM3_TimerWheel_Entry entries[COUNT];
+	ResetWheel(12345);
+
+	for (size_t i = 0; i < COUNT; i++)
+	{
+		RLM3_TimerWheel_InitEntry(&entries[i], RecordCallback, (void*)i, RLM3_TIMER_WHEEL_DISPATCH_ISR);
+		RLM3_TimerWheel_Schedule(&g_wheel, &entries[i], 12345 + (i * 7919) % 100000, 0);
+	}
+	for (size_t i = 0; i < COUNT; i += 2)
+		RLM3_TimerWheel_Cancel(&g_wheel, &entries[i]);
+
+	AdvanceTo(12345 + 100000);
+
+	ASSERT(g_fired.size() == COUNT / 2);
+	for (size_t i = 0; i < g_fired.size(); i++)
+	{
+		size_t id = g_fired[i].id;
+		ASSERT(id % 2 == 1);
+		ASSERT(g_fired[i].time == 12345 + (id * 7919) % 100000);
+		if (i > 0)
+			ASSERT(g_fired[i - 1].time <= g_fired[i].time);
+	}
+	uint32_t expiry = 0;
+	ASSERT(!RLM3_TimerWheel_GetNextExpiry(&g_wheel, &expiry));
+}
@@ -1,6 +1,7 @@
 #include "Test.hpp"
-#include "rlm3-uart.h"
+#include "rlm3-uart.hpp"
 #include "rlm3-task.h"
+#include "rlm3-base.h"
 #include "main.h"
 #include <cctype>
 #include "logger.h"
@@ -44,6 +45,26 @@ TEST_CASE(UART4_Lifecycle_HappyCase)
 	ASSERT(!RLM3_UART4_IsInit());
 }
 
+TEST_CASE(UART4_SetBaudRate_HappyCase)
+{
+	RLM3_UART4_Init(115200);
+
+	RLM3_UART_BaudInfo info;
+	RLM3_UART_GetBaudInfo(RLM3_UART_4, &info);
+	ASSERT(info.requested_baud_rate == 115200);
+	ASSERT(!info.is_oversample_8);
+	ASSERT(info.error_ppm > -1000 && info.error_ppm < 1000);
+
+	RLM3_UART_SetBaudRate(RLM3_UART_4, 3000000);
+	RLM3_UART_GetBaudInfo(RLM3_UART_4, &info);
+	ASSERT(info.requested_baud_rate == 3000000);
+	ASSERT(info.is_oversample_8);
+	ASSERT(info.error_ppm > -1000 && info.error_ppm < 1000);
+	ASSERT(RLM3_UART4_IsInit());
+
+	RLM3_UART4_Deinit();
+}
+
 TEST_CASE(UART2_Transmit_HappyCase)
 {
 	uint8_t buffer[26];
@@ -130,7 +151,7 @@ TEST_CASE(UART2_Receive_HappyCase)
 	ASSERT(g_uart2_error_count == 0);
 }
 
-extern void RLM3_UART2_ReceiveCallback(uint8_t data)
+static inline void UART2_Receive(uint8_t data)
 {
 	if (g_uart2_buffer_rx != nullptr && g_uart2_size_rx != 0)
 	{
@@ -143,7 +164,7 @@ extern void RLM3_UART2_ReceiveCallback(uint8_t data)
 	}
 }
 
-extern bool RLM3_UART2_TransmitCallback(uint8_t* data_to_send)
+static inline bool UART2_Transmit(uint8_t* data_to_send)
 {
 	if (g_uart2_buffer_tx == nullptr || g_uart2_size_tx == 0)
 		return false;
@@ -156,11 +177,91 @@ extern bool RLM3_UART2_TransmitCallback(uint8_t* data_to_send)
 	return true;
 }
 
-extern void RLM3_UART2_ErrorCallback(uint32_t status_flags)
+static inline void UART2_Error(uint32_t status_flags)
 {
 	g_uart2_error_count++;
 }
 
+// Calls out to the UART2 callbacks for every byte, the way the weak callback interface does.  The callbacks are defined
+// below and kept out of line, so the call is not folded away.
+struct UART2_CallbackHandler
+{
+	static void Receive(uint8_t data) { RLM3_UART2_ReceiveCallback(data); }
+	static bool Transmit(uint8_t* data_to_send) { return RLM3_UART2_TransmitCallback(data_to_send); }
+	static void Error(uint32_t status_flags) { RLM3_UART2_ErrorCallback(status_flags); }
+};
+
+// The same work as the UART2 callbacks, in a policy the driver can inline.
+struct UART2_InlineHandler
+{
+	static void Receive(uint8_t data) { UART2_Receive(data); }
+	static bool Transmit(uint8_t* data_to_send) { return UART2_Transmit(data_to_send); }
+	static void Error(uint32_t status_flags) { UART2_Error(status_flags); }
+};
+
+static const size_t DISPATCH_COUNT = 1000;
+
+template <typename Driver>
+static uint32_t MeasureDispatchCycles()
+{
+	static uint8_t g_tx[DISPATCH_COUNT + 1];
+	static uint8_t g_rx[DISPATCH_COUNT + 1];
+
+	// A copy of the registers with a byte received and the transmit register empty, so every pass moves a byte each way.
+	static USART_TypeDef g_registers;
+	g_registers.SR = USART_SR_RXNE | USART_SR_TXE;
+	g_registers.CR1 = USART_CR1_RXNEIE | USART_CR1_TXEIE;
+	g_registers.DR = 0x5A;
+
+	// One byte more than the passes, so no pass reaches the end of a buffer and wakes a task.
+	g_uart2_buffer_tx = g_tx;
+	g_uart2_size_tx = DISPATCH_COUNT + 1;
+	g_uart2_buffer_rx = g_rx;
+	g_uart2_size_rx = DISPATCH_COUNT + 1;
+
+	uint32_t start = RLM3_GetCycleCount();
+	for (size_t i = 0; i < DISPATCH_COUNT; i++)
+		Driver::Dispatch(&g_registers, start);
+	uint32_t cycles = RLM3_GetCycleCount() - start;
+
+	ASSERT(g_uart2_size_tx == 1 && g_uart2_size_rx == 1);
+	ASSERT(g_rx[0] == 0x5A && g_rx[DISPATCH_COUNT - 1] == 0x5A);
+	g_uart2_buffer_tx = nullptr;
+	g_uart2_size_tx = 0;
+	g_uart2_buffer_rx = nullptr;
+	g_uart2_size_rx = 0;
+	return cycles;
+}
+
+TEST_CASE(UART2_Dispatch_Benchmark)
+{
+	// The dispatches count bytes and time bursts on UART2.  Put the statistics back afterwards.
+	RLM3_UART_Counters saved_counters = g_rlm3_uart_counters[RLM3_UART_2];
+	RLM3_UART_ReceiveTiming saved_timing = g_rlm3_uart_timing[RLM3_UART_2];
+	uint32_t callback_cycles = MeasureDispatchCycles<RLM3_UART<RLM3_UART_2, UART2_CallbackHandler>>();
+	uint32_t inline_cycles = MeasureDispatchCycles<RLM3_UART<RLM3_UART_2, UART2_InlineHandler>>();
+	g_rlm3_uart_counters[RLM3_UART_2] = saved_counters;
+	g_rlm3_uart_timing[RLM3_UART_2] = saved_timing;
+
+	LOG_ALWAYS("UART2 ISR cycles per byte callback: %u inline: %u", (int)(callback_cycles / DISPATCH_COUNT), (int)(inline_cycles / DISPATCH_COUNT));
+	ASSERT(g_uart2_error_count == 0);
+}
+
+extern __attribute__((noinline)) void RLM3_UART2_ReceiveCallback(uint8_t data)
+{
+	UART2_Receive(data);
+}
+
+extern __attribute__((noinline)) bool RLM3_UART2_TransmitCallback(uint8_t* data_to_send)
+{
+	return UART2_Transmit(data_to_send);
+}
+
+extern __attribute__((noinline)) void RLM3_UART2_ErrorCallback(uint32_t status_flags)
+{
+	UART2_Error(status_flags);
+}
+
 extern void RLM3_UART4_ReceiveCallback(uint8_t data)
 {
 	if (g_uart4_buffer_rx != nullptr && g_uart4_size_rx != 0)
@@ -0,0 +1,181 @@
+#include "Test.hpp"
+#include "rlm3-work-queue.h"
+#include "rlm3-timer.h"
+#include "rlm3-base.h"
+#include "logger.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <vector>
+
+
+LOGGER_ZONE(TEST_WORK);
+
+
+typedef void (*TimerFn)();
+extern void SetTimer2Callback(TimerFn timer_fn);
+
+
+static RLM3_WorkQueue g_queue;
+static std::vector<int> g_order;
+
+
+static void RecordCallback(RLM3_WorkItem* item, void* context)
+{
+	g_order.push_back((int)(intptr_t)context);
+}
+
+
+TEST_CASE(RLM3_WorkQueue_RunPending_Order)
+{
+	RLM3_WorkQueue_Init(&g_queue);
+	g_order.clear();
+	RLM3_WorkItem items[5];
+	for (size_t i = 0; i < 5; i++)
+		RLM3_WorkItem_Init(&items[i], RecordCallback, (void*)i);
+
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 0);
+	for (size_t i = 0; i < 5; i++)
+		ASSERT(RLM3_WorkQueue_Post(&g_queue, &items[i]));
+	ASSERT(RLM3_WorkItem_IsPending(&items[3]));
+
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 5);
+	ASSERT(g_order.size() == 5);
+	for (size_t i = 0; i < 5; i++)
+		ASSERT(g_order[i] == (int)i);
+	ASSERT(!RLM3_WorkItem_IsPending(&items[3]));
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 0);
+}
+
+TEST_CASE(RLM3_WorkQueue_Post_Coalesce)
+{
+	RLM3_WorkQueue_Init(&g_queue);
+	g_order.clear();
+	RLM3_WorkItem a;
+	RLM3_WorkItem b;
+	RLM3_WorkItem_Init(&a, RecordCallback, (void*)1);
+	RLM3_WorkItem_Init(&b, RecordCallback, (void*)2);
+
+	ASSERT(RLM3_WorkQueue_Post(&g_queue, &a));
+	ASSERT(RLM3_WorkQueue_Post(&g_queue, &b));
+	ASSERT(!RLM3_WorkQueue_Post(&g_queue, &a));
+	ASSERT(!RLM3_WorkQueue_Post(&g_queue, &a));
+
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 2);
+	ASSERT(g_order.size() == 2 && g_order[0] == 1 && g_order[1] == 2);
+	ASSERT(g_queue.posted_count == 2);
+	ASSERT(g_queue.coalesced_count == 2);
+}
+
+TEST_CASE(RLM3_WorkQueue_Post_FromCallback)
+{
+	// An item that posts itself runs again on the next pass rather than looping forever.
+	static size_t g_runs = 0;
+	g_runs = 0;
+	RLM3_WorkQueue_Init(&g_queue);
+	RLM3_WorkItem item;
+	RLM3_WorkItem_Init(&item, [](RLM3_WorkItem* item, void* context) {
+		if (++g_runs < 3)
+			ASSERT(RLM3_WorkQueue_Post(&g_queue, item));
+	}, nullptr);
+
+	RLM3_WorkQueue_Post(&g_queue, &item);
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 1);
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 1);
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 1);
+	ASSERT(RLM3_WorkQueue_RunPending(&g_queue) == 0);
+	ASSERT(g_runs == 3);
+}
+
+TEST_CASE(RLM3_WorkQueue_Worker_HappyCase)
+{
+	static RLM3_Task g_test_task = NULL;
+	g_test_task = RLM3_GetCurrentTask();
+	RLM3_WorkQueue_Init(&g_queue);
+	RLM3_WorkItem item;
+	RLM3_WorkItem_Init(&item, [](RLM3_WorkItem* item, void* context) {
+		RLM3_Give(g_test_task);
+	}, nullptr);
+
+	RLM3_WorkQueue_Start(&g_queue, "work", tskIDLE_PRIORITY + 2, 128 * 2);
+	ASSERT(RLM3_WorkQueue_IsRunning(&g_queue));
+	for (size_t i = 0; i < 10; i++)
+	{
+		RLM3_WorkQueue_Post(&g_queue, &item);
+		ASSERT(RLM3_TakeWithTimeout(10));
+	}
+	RLM3_WorkQueue_Stop(&g_queue);
+	ASSERT(!RLM3_WorkQueue_IsRunning(&g_queue));
+}
+
+TEST_CASE(RLM3_WorkQueue_Benchmark)
+{
+	// Compare doing a small job inline in an interrupt with posting it to a high priority worker.
+	static const size_t COUNT = 100;
+	static const size_t WORK_SIZE = 256;
+	static volatile uint32_t g_post_cycles = 0;
+	static volatile uint32_t g_isr_cycles_total = 0;
+	static volatile uint32_t g_latency_cycles_total = 0;
+	static volatile uint32_t g_latency_cycles_max = 0;
+	static volatile size_t g_runs = 0;
+	static volatile bool g_is_inline = false;
+	static volatile uint32_t g_checksum = 0;
+	static uint8_t g_buffer[WORK_SIZE];
+	static RLM3_WorkItem g_item;
+
+	static auto DoWork = [] {
+		uint32_t sum = 0;
+		for (size_t i = 0; i < WORK_SIZE; i++)
+			sum = sum * 31 + g_buffer[i];
+		g_checksum = sum;
+	};
+	RLM3_WorkItem_Init(&g_item, [](RLM3_WorkItem* item, void* context) {
+		uint32_t latency = RLM3_GetCycleCount() - g_post_cycles;
+		DoWork();
+		g_latency_cycles_total += latency;
+		if (latency > g_latency_cycles_max)
+			g_latency_cycles_max = latency;
+		g_runs++;
+	}, nullptr);
+	SetTimer2Callback([] {
+		uint32_t start = RLM3_GetCycleCount();
+		if (g_is_inline)
+		{
+			DoWork();
+			g_runs++;
+		}
+		else
+		{
+			g_post_cycles = start;
+			RLM3_WorkQueue_Post(&g_queue, &g_item);
+		}
+		g_isr_cycles_total += RLM3_GetCycleCount() - start;
+	});
+
+	RLM3_WorkQueue_Init(&g_queue);
+	RLM3_WorkQueue_Start(&g_queue, "work", configMAX_PRIORITIES - 1, 128 * 2);
+
+	g_is_inline = true;
+	g_runs = 0;
+	g_isr_cycles_total = 0;
+	RLM3_Timer2_Init(1000);
+	while (g_runs < COUNT)
+		RLM3_Delay(1);
+	RLM3_Timer2_Deinit();
+	uint32_t inline_isr_cycles = g_isr_cycles_total / g_runs;
+
+	g_is_inline = false;
+	g_runs = 0;
+	g_isr_cycles_total = 0;
+	RLM3_Timer2_Init(1000);
+	while (g_runs < COUNT)
+		RLM3_Delay(1);
+	RLM3_Timer2_Deinit();
+	uint32_t posted_isr_cycles = g_isr_cycles_total / g_runs;
+	uint32_t latency_cycles = g_latency_cycles_total / g_runs;
+
+	RLM3_WorkQueue_Stop(&g_queue);
+
+	LOG_ALWAYS("ISR cycles inline: %u posted: %u", (int)inline_isr_cycles, (int)posted_isr_cycles);
+	LOG_ALWAYS("Post to execute cycles avg: %u max: %u checksum: %x", (int)latency_cycles, (int)g_latency_cycles_max, (int)g_checksum);
+	ASSERT(posted_isr_cycles < inline_isr_cycles);
+}